@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Benchmark /upload_url time-to-first-byte with cold and warm connections
+Usage: python bench_download.py <device_ip> [--rounds N] [--no-keepalive] [images...]
+Example: python bench_download.py 192.168.1.100 --rounds 20
+
+Starts a local HTTP/1.1 server (stand-in for the dashboard image hosts) that
+serves the given images, makes the device download them one after another and
+reads the device's time-to-first-byte from /status. The first download opens
+a new connection (cold), the following ones should reuse it (warm).
+--no-keepalive makes the server close every connection, for comparison.
+"""
+
+import os
+import sys
+import time
+import socket
+import argparse
+import threading
+import statistics
+import requests
+from http.server import ThreadingHTTPServer, SimpleHTTPRequestHandler
+
+DEFAULT_IMAGES = ['mengm.jpg', 'mengm2.jpg', 'rs2026.jpg', 'hss_320_240.jpg']
+
+class Handler(SimpleHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    keep_alive = True
+    connections = 0
+
+    def setup(self):
+        super().setup()
+        Handler.connections += 1
+
+    def end_headers(self):
+        if not Handler.keep_alive:
+            self.send_header('Connection', 'close')
+            self.close_connection = True
+        super().end_headers()
+
+    def log_message(self, format, *args):
+        pass
+
+def local_ip_for(device_ip):
+    """IP of the interface that routes to the device"""
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        s.connect((device_ip, 80))
+        return s.getsockname()[0]
+    finally:
+        s.close()
+
+def get_status(device_ip):
+    response = requests.get(f"http://{device_ip}/status", timeout=5)
+    response.raise_for_status()
+    return response.json()
+
+def download(device_ip, url, timeout=30):
+    """Queue url on the device and wait until it is shown, return /status"""
+    shown = get_status(device_ip)['images_shown']
+    response = requests.post(f"http://{device_ip}/upload_url", json={'url': url}, timeout=5)
+    if response.status_code != 200:
+        raise RuntimeError(f"/upload_url returned {response.status_code}: {response.text}")
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        status = get_status(device_ip)
+        if status['images_shown'] > shown:
+            return status
+        time.sleep(0.05)
+    raise RuntimeError(f"Timed out waiting for {url}")
+
+def summary(name, values):
+    if not values:
+        return f"{name}: -"
+    return (f"{name}: n={len(values)} avg={statistics.mean(values):.1f}ms "
+            f"min={min(values)}ms max={max(values)}ms")
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark /upload_url time-to-first-byte')
+    parser.add_argument('device_ip', help='Device IP address')
+    parser.add_argument('images', nargs='*', default=DEFAULT_IMAGES, help='Images to serve')
+    parser.add_argument('--rounds', type=int, default=20, help='Number of downloads (default: 20)')
+    parser.add_argument('--port', type=int, default=8080, help='Local server port (default: 8080)')
+    parser.add_argument('--no-keepalive', action='store_true', help='Close the connection after every response')
+    args = parser.parse_args()
+
+    Handler.keep_alive = not args.no_keepalive
+    directory = os.path.dirname(os.path.abspath(args.images[0]))
+    server = ThreadingHTTPServer(('', args.port), lambda *a: Handler(*a, directory=directory))
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    base = f"http://{local_ip_for(args.device_ip)}:{args.port}"
+    print(f"Serving {len(args.images)} images at {base} (keep-alive {'on' if Handler.keep_alive else 'off'})")
+
+    cold, warm = [], []
+    try:
+        for i in range(args.rounds):
+            name = os.path.basename(args.images[i % len(args.images)])
+            status = download(args.device_ip, f"{base}/{name}")
+            ttfb = status['download_ttfb_ms']
+            (warm if status['download_reused'] else cold).append(ttfb)
+            print(f"{i + 1:3d} {name:20s} {ttfb:5d}ms {'warm' if status['download_reused'] else 'cold'}")
+    except (requests.exceptions.RequestException, RuntimeError) as e:
+        print(f"✗ {e}")
+        return 1
+    finally:
+        server.shutdown()
+
+    print(summary("Cold", cold))
+    print(summary("Warm", warm))
+    print(f"Server accepted {Handler.connections} connections for {args.rounds} downloads")
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
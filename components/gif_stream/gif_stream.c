@@ -0,0 +1,625 @@
+/*
+ * GIF Stream Decoder Component
+ * Splits animated GIF playback into LZW decoding (any task) and dirty-rectangle
+ * composition onto an RGB565 canvas (the display task)
+ */
+
+#include "gif_stream.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "gif_stream";
+
+#define GIF_MAX_SIZE        2047
+#define GIF_LZW_CODES       4096
+#define GIF_NO_CODE         0xFFFF
+
+/* Block introducers and extension labels */
+#define GIF_EXTENSION       0x21
+#define GIF_IMAGE           0x2C
+#define GIF_TRAILER         0x3B
+#define GIF_GCE             0xF9
+#define GIF_APPLICATION     0xFF
+
+// Browsers show frames with a delay of 0 or 10 ms for 100 ms, and so do we
+#define GIF_MIN_DELAY_CS    2
+#define GIF_SHORT_DELAY_MS  100
+
+/* Graphic control extension, applies to the next image */
+typedef struct {
+    uint16_t delay_cs;
+    uint8_t disposal;
+    int16_t transparent;
+} gif_gce_t;
+
+/* LSB-first code reader over the data sub-blocks of an image */
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t bits;
+    uint8_t nbits;
+    uint8_t block_left;         // Bytes left in the current sub-block
+    bool done;                  // Block terminator or end of data reached
+} gif_bits_t;
+
+struct gif_stream {
+    const uint8_t *data;
+    size_t end;                 // End of the last complete frame
+    size_t first;               // First block after the global colour table
+    size_t pos;                 // Next block
+    bool swap_bytes;
+    uint16_t width;
+    uint16_t height;
+    uint16_t frames;
+    uint16_t index;             // Number of the next frame
+    uint16_t global[256];       // Global colour table as RGB565
+    uint16_t global_size;       // 0 without a global colour table
+    uint16_t prefix[GIF_LZW_CODES];
+    uint16_t length[GIF_LZW_CODES];
+    uint8_t suffix[GIF_LZW_CODES];
+    uint8_t first_byte[GIF_LZW_CODES];
+};
+
+static inline uint16_t gif_stream_le16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static inline uint16_t gif_stream_rgb565(bool swap, const uint8_t *rgb)
+{
+    uint16_t c = (rgb[0] & 0xF8) << 8 | (rgb[1] & 0xFC) << 3 | rgb[2] >> 3;
+    return swap ? (uint16_t)(c << 8 | c >> 8) : c;
+}
+
+static void gif_stream_palette(bool swap, const uint8_t *table, uint16_t count, uint16_t *out)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = gif_stream_rgb565(swap, table + i * 3);
+    }
+    memset(out + count, 0, (256 - count) * sizeof(uint16_t));
+}
+
+/**
+ * @brief Skip data sub-blocks up to and including the terminator
+ * @return Offset after the terminator, 0 if the data ends first
+ */
+static size_t gif_stream_skip_blocks(const uint8_t *data, size_t size, size_t pos)
+{
+    while (pos < size) {
+        uint8_t len = data[pos++];
+        if (len == 0) {
+            return pos;
+        }
+        pos += len;
+    }
+    return 0;
+}
+
+static void gif_stream_parse_gce(const uint8_t *data, size_t size, size_t pos, gif_gce_t *gce)
+{
+    // data[pos] is the sub-block size, 4 for a valid extension
+    if (pos + 5 > size || data[pos] < 4) {
+        return;
+    }
+    const uint8_t flags = data[pos + 1];
+    gce->disposal = (flags >> 2) & 0x07;
+    gce->delay_cs = gif_stream_le16(data + pos + 2);
+    gce->transparent = (flags & 0x01) ? data[pos + 4] : -1;
+}
+
+bool gif_stream_is(const uint8_t *data, size_t size)
+{
+    return size >= 6 && (memcmp(data, "GIF87a", 6) == 0 || memcmp(data, "GIF89a", 6) == 0);
+}
+
+/**
+ * @brief Walk every block once: count complete frames, find the loop count and whether alpha is needed
+ */
+static void gif_stream_scan(gif_stream_t *gif, size_t size, gif_stream_info_t *info)
+{
+    const uint8_t *data = gif->data;
+    size_t pos = gif->first;
+    gif_gce_t gce = { .transparent = -1 };
+    info->plays = 1;
+    gif->end = pos;
+
+    while (pos < size && data[pos] != GIF_TRAILER) {
+        const uint8_t block = data[pos++];
+        if (block == GIF_EXTENSION && pos < size) {
+            const uint8_t label = data[pos++];
+            if (label == GIF_GCE) {
+                gif_stream_parse_gce(data, size, pos, &gce);
+            } else if (label == GIF_APPLICATION && pos + 16 <= size && data[pos] == 11 &&
+                       (memcmp(data + pos + 1, "NETSCAPE2.0", 11) == 0 || memcmp(data + pos + 1, "ANIMEXTS1.0", 11) == 0) &&
+                       data[pos + 12] >= 3 && data[pos + 13] == 1) {
+                // Loop count: how often the animation repeats after the first run
+                const uint16_t loops = gif_stream_le16(data + pos + 14);
+                info->plays = loops ? loops + 1 : 0;
+            }
+            pos = gif_stream_skip_blocks(data, size, pos);
+        } else if (block == GIF_IMAGE && pos + 9 <= size) {
+            const uint8_t flags = data[pos + 8];
+            pos += 9;
+            if (flags & 0x80) {
+                pos += 3 << ((flags & 0x07) + 1);
+            }
+            pos = pos < size ? gif_stream_skip_blocks(data, size, pos + 1) : 0;  // LZW code size, then data
+            if (!pos) {
+                break;
+            }
+            if (gce.disposal == 2 && gce.transparent >= 0) {
+                info->has_alpha = true;
+            }
+            gce = (gif_gce_t) { .transparent = -1 };
+            gif->frames++;
+            gif->end = pos;
+        } else {
+            break;
+        }
+        if (!pos) {
+            break;
+        }
+    }
+}
+
+esp_err_t gif_stream_open(const uint8_t *data, size_t size, const gif_stream_cfg_t *cfg,
+                          gif_stream_t **gif, gif_stream_info_t *info)
+{
+    if (data == NULL || gif == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *gif = NULL;
+    if (!gif_stream_is(data, size) || size < 13) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint16_t width = gif_stream_le16(data + 6);
+    const uint16_t height = gif_stream_le16(data + 8);
+    const uint8_t flags = data[10];
+    if (width == 0 || height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (width > GIF_MAX_SIZE || height > GIF_MAX_SIZE) {
+        ESP_LOGE(TAG, "GIF is %ux%u, at most %ux%u is supported", width, height, GIF_MAX_SIZE, GIF_MAX_SIZE);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // The LZW tables are used for every pixel, keep them in internal RAM
+    gif_stream_t *g = heap_caps_calloc(1, sizeof(*g), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!g) {
+        g = heap_caps_calloc(1, sizeof(*g), MALLOC_CAP_DEFAULT);
+    }
+    if (!g) {
+        return ESP_ERR_NO_MEM;
+    }
+    g->data = data;
+    g->swap_bytes = cfg && cfg->swap_bytes;
+    g->width = width;
+    g->height = height;
+    g->first = 13;
+    if (flags & 0x80) {
+        g->global_size = 2 << (flags & 0x07);
+        g->first += g->global_size * 3;
+        if (g->first > size) {
+            heap_caps_free(g);
+            return ESP_ERR_INVALID_ARG;
+        }
+        gif_stream_palette(g->swap_bytes, data + 13, g->global_size, g->global);
+    }
+    g->pos = g->first;
+
+    gif_stream_info_t scan = {0};
+    gif_stream_scan(g, size, &scan);
+    if (g->frames == 0) {
+        ESP_LOGE(TAG, "GIF has no complete frame");
+        heap_caps_free(g);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (info) {
+        *info = scan;
+        info->width = width;
+        info->height = height;
+        info->frames = g->frames;
+        info->background = data[11] < g->global_size ? g->global[data[11]] : 0;
+    }
+    *gif = g;
+    return ESP_OK;
+}
+
+static inline bool gif_bits_fill(gif_bits_t *br, uint8_t need)
+{
+    while (br->nbits < need) {
+        if (br->block_left == 0) {
+            if (br->done || br->p >= br->end || *br->p == 0) {
+                // Terminator: leave it for gif_stream_skip_blocks()
+                br->done = true;
+                return false;
+            }
+            br->block_left = *br->p++;
+        }
+        if (br->p >= br->end) {
+            br->done = true;
+            return false;
+        }
+        br->bits |= (uint32_t)*br->p++ << br->nbits;
+        br->nbits += 8;
+        br->block_left--;
+    }
+    return true;
+}
+
+/**
+ * @brief Decode the LZW data at gif->pos into out
+ *
+ * Each code's string is written back to front by following the prefix
+ * chain, so no stack is needed and every output byte is stored once.
+ * Pixels the data does not cover are set to fill.
+ */
+static esp_err_t gif_stream_lzw(gif_stream_t *gif, uint8_t *out, size_t count, uint8_t fill)
+{
+    const uint8_t *data = gif->data;
+    const uint8_t min_size = data[gif->pos];
+    if (min_size < 2 || min_size > 11) {
+        ESP_LOGE(TAG, "Invalid LZW code size %u", min_size);
+        return ESP_FAIL;
+    }
+    gif_bits_t br = { .p = data + gif->pos + 1, .end = data + gif->end };
+
+    const uint16_t clear = 1 << min_size;
+    const uint16_t eoi = clear + 1;
+    for (uint16_t i = 0; i < clear; i++) {
+        gif->prefix[i] = GIF_NO_CODE;
+        gif->suffix[i] = gif->first_byte[i] = (uint8_t)i;
+        gif->length[i] = 1;
+    }
+    uint16_t next = eoi + 1;
+    uint8_t code_size = min_size + 1;
+    uint16_t prev = GIF_NO_CODE;
+    size_t pos = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (pos < count && gif_bits_fill(&br, code_size)) {
+        const uint16_t code = br.bits & ((1 << code_size) - 1);
+        br.bits >>= code_size;
+        br.nbits -= code_size;
+
+        if (code == clear) {
+            next = eoi + 1;
+            code_size = min_size + 1;
+            prev = GIF_NO_CODE;
+            continue;
+        }
+        if (code == eoi) {
+            break;
+        }
+
+        if (prev == GIF_NO_CODE) {
+            // First code after a clear must be a single byte
+            if (code > clear) {
+                ret = ESP_FAIL;
+                break;
+            }
+        } else if (code > next) {
+            ret = ESP_FAIL;
+            break;
+        } else if (next < GIF_LZW_CODES) {
+            // New entry: prev's string plus the first byte of code's string, which for
+            // code == next (KwKwK) is the entry being added, starting with prev's first byte
+            gif->prefix[next] = prev;
+            gif->suffix[next] = gif->first_byte[code < next ? code : prev];
+            gif->first_byte[next] = gif->first_byte[prev];
+            gif->length[next] = gif->length[prev] + 1;
+            next++;
+            if (next == (1u << code_size) && code_size < 12) {
+                code_size++;
+            }
+        }
+
+        const uint16_t len = gif->length[code];
+        if (pos + len <= count) {
+            uint8_t *q = out + pos + len;
+            for (uint16_t c = code; c != GIF_NO_CODE; c = gif->prefix[c]) {
+                *--q = gif->suffix[c];
+            }
+        } else {
+            // The last string may run past the frame, keep what fits
+            size_t i = pos + len;
+            for (uint16_t c = code; c != GIF_NO_CODE; c = gif->prefix[c]) {
+                if (--i < count) {
+                    out[i] = gif->suffix[c];
+                }
+            }
+        }
+        pos += len;
+        prev = code;
+    }
+
+    if (pos < count) {
+        memset(out + pos, fill, count - pos);
+    }
+    // Skip what is left of the sub-blocks and the terminator
+    size_t rest = (br.p - data) + br.block_left;
+    size_t after = gif_stream_skip_blocks(data, gif->end, rest);
+    gif->pos = after ? after : gif->end;
+    return ret;
+}
+
+esp_err_t gif_stream_next_frame(gif_stream_t *gif, gif_stream_frame_t *frame)
+{
+    const uint8_t *data = gif->data;
+    gif_gce_t gce = { .transparent = -1 };
+    bool wrapped = false;
+
+    for (;;) {
+        if (gif->pos >= gif->end || data[gif->pos] == GIF_TRAILER) {
+            if (wrapped) {
+                return ESP_FAIL;
+            }
+            // Start the next play
+            wrapped = true;
+            gif->pos = gif->first;
+            gif->index = 0;
+            gce = (gif_gce_t) { .transparent = -1 };
+            continue;
+        }
+
+        const uint8_t block = data[gif->pos++];
+        if (block == GIF_EXTENSION) {
+            const uint8_t label = data[gif->pos++];
+            if (label == GIF_GCE) {
+                gif_stream_parse_gce(data, gif->end, gif->pos, &gce);
+            }
+            size_t after = gif_stream_skip_blocks(data, gif->end, gif->pos);
+            gif->pos = after ? after : gif->end;
+            continue;
+        }
+        if (block != GIF_IMAGE) {
+            // Unknown block: the scan stopped before it, so this cannot happen in a scanned file
+            gif->pos = gif->end;
+            continue;
+        }
+
+        const uint8_t *d = data + gif->pos;
+        const uint16_t x = gif_stream_le16(d);
+        const uint16_t y = gif_stream_le16(d + 2);
+        const uint16_t w = gif_stream_le16(d + 4);
+        const uint16_t h = gif_stream_le16(d + 6);
+        const uint8_t flags = d[8];
+        gif->pos += 9;
+        if (flags & 0x80) {
+            const uint16_t n = 2 << (flags & 0x07);
+            gif_stream_palette(gif->swap_bytes, data + gif->pos, n, frame->palette);
+            gif->pos += n * 3;
+        } else {
+            memcpy(frame->palette, gif->global, sizeof(frame->palette));
+        }
+
+        frame->index = gif->index++;
+        frame->stride = w;
+        frame->rows = h;
+        frame->interlaced = flags & 0x40;
+        frame->rect.x = x;
+        frame->rect.y = y;
+        frame->rect.w = x < gif->width ? (w < gif->width - x ? w : gif->width - x) : 0;
+        frame->rect.h = y < gif->height ? (h < gif->height - y ? h : gif->height - y) : 0;
+        if (frame->rect.w == 0 || frame->rect.h == 0) {
+            frame->rect.w = frame->rect.h = 0;
+        }
+        frame->disposal = gce.disposal;
+        frame->transparent = gce.transparent;
+        frame->delay_ms = gce.delay_cs < GIF_MIN_DELAY_CS ? GIF_SHORT_DELAY_MS : gce.delay_cs * 10;
+
+        // Frames bigger than the canvas would not fit in indices (and are invalid anyway)
+        const size_t count = (size_t)w * h;
+        if (count > (size_t)gif->width * gif->height) {
+            ESP_LOGE(TAG, "Frame %u is %ux%u, larger than the %ux%u canvas", frame->index, w, h, gif->width, gif->height);
+            return ESP_FAIL;
+        }
+        esp_err_t ret = gif_stream_lzw(gif, frame->indices, count, gce.transparent >= 0 ? gce.transparent : 0);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Corrupt LZW data in frame %u", frame->index);
+        }
+        return ret;
+    }
+}
+
+void gif_stream_close(gif_stream_t *gif)
+{
+    if (gif) {
+        heap_caps_free(gif);
+    }
+}
+
+esp_err_t gif_stream_canvas_init(gif_stream_canvas_t *canvas, const gif_stream_info_t *info, uint32_t fb_caps)
+{
+    memset(canvas, 0, sizeof(*canvas));
+    const size_t px = (size_t)info->width * info->height;
+    const size_t size = px * (info->has_alpha ? 3 : 2);
+    uint32_t caps = fb_caps ? fb_caps : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *pixels = heap_caps_malloc(size, caps);
+    if (!pixels) {
+        pixels = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+    }
+    if (!pixels) {
+        ESP_LOGE(TAG, "Failed to allocate %zu byte canvas", size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    canvas->pixels = pixels;
+    canvas->size = size;
+    canvas->width = info->width;
+    canvas->height = info->height;
+    canvas->has_alpha = info->has_alpha;
+    canvas->background = info->background;
+    uint16_t *colors = (uint16_t *)pixels;
+    for (size_t i = 0; i < px; i++) {
+        colors[i] = info->background;
+    }
+    if (info->has_alpha) {
+        memset(pixels + px * 2, 0xFF, px);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Copy rect between the canvas and a packed buffer (colours, then alpha)
+ */
+static void gif_stream_canvas_copy(gif_stream_canvas_t *canvas, const gif_stream_rect_t *r, uint8_t *buf, bool save)
+{
+    const size_t px = (size_t)canvas->width * canvas->height;
+    uint16_t *colors = (uint16_t *)canvas->pixels;
+    uint16_t *saved = (uint16_t *)buf;
+    uint8_t *saved_alpha = buf + (size_t)r->w * r->h * 2;
+    for (uint16_t row = 0; row < r->h; row++) {
+        const size_t at = (size_t)(r->y + row) * canvas->width + r->x;
+        uint16_t *c = colors + at;
+        uint16_t *s = saved + (size_t)row * r->w;
+        if (save) {
+            memcpy(s, c, r->w * 2);
+        } else {
+            memcpy(c, s, r->w * 2);
+        }
+        if (canvas->has_alpha) {
+            uint8_t *a = canvas->pixels + px * 2 + at;
+            uint8_t *sa = saved_alpha + (size_t)row * r->w;
+            if (save) {
+                memcpy(sa, a, r->w);
+            } else {
+                memcpy(a, sa, r->w);
+            }
+        }
+    }
+}
+
+static void gif_stream_rect_union(gif_stream_rect_t *a, const gif_stream_rect_t *b)
+{
+    if (b->w == 0) {
+        return;
+    }
+    if (a->w == 0) {
+        *a = *b;
+        return;
+    }
+    const uint16_t x2 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    const uint16_t y2 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    a->x = a->x < b->x ? a->x : b->x;
+    a->y = a->y < b->y ? a->y : b->y;
+    a->w = x2 - a->x;
+    a->h = y2 - a->y;
+}
+
+/**
+ * @brief Write one row of indices to canvas row y
+ */
+static inline void gif_stream_canvas_row(gif_stream_canvas_t *canvas, const gif_stream_frame_t *frame,
+                                         const uint8_t *src, uint16_t y)
+{
+    const size_t at = (size_t)y * canvas->width + frame->rect.x;
+    uint16_t *dst = (uint16_t *)canvas->pixels + at;
+    const uint16_t *pal = frame->palette;
+    const uint16_t w = frame->rect.w;
+    if (frame->transparent < 0) {
+        for (uint16_t x = 0; x < w; x++) {
+            dst[x] = pal[src[x]];
+        }
+        if (canvas->has_alpha) {
+            memset(canvas->pixels + (size_t)canvas->width * canvas->height * 2 + at, 0xFF, w);
+        }
+        return;
+    }
+    const uint8_t key = (uint8_t)frame->transparent;
+    uint8_t *alpha = canvas->has_alpha ? canvas->pixels + (size_t)canvas->width * canvas->height * 2 + at : NULL;
+    for (uint16_t x = 0; x < w; x++) {
+        if (src[x] != key) {
+            dst[x] = pal[src[x]];
+            if (alpha) {
+                alpha[x] = 0xFF;
+            }
+        }
+    }
+}
+
+void gif_stream_canvas_draw(gif_stream_canvas_t *canvas, const gif_stream_frame_t *frame, gif_stream_rect_t *dirty)
+{
+    gif_stream_rect_t changed = {0};
+    const gif_stream_rect_t *prev = &canvas->prev;
+
+    // Dispose of the previous frame
+    if (prev->w && canvas->prev_disposal == 2) {
+        // Restore to background; a frame with transparency leaves transparent pixels (as gifdec does)
+        const size_t px = (size_t)canvas->width * canvas->height;
+        uint16_t *colors = (uint16_t *)canvas->pixels;
+        for (uint16_t row = 0; row < prev->h; row++) {
+            const size_t at = (size_t)(prev->y + row) * canvas->width + prev->x;
+            for (uint16_t x = 0; x < prev->w; x++) {
+                colors[at + x] = canvas->background;
+            }
+            if (canvas->has_alpha) {
+                memset(canvas->pixels + px * 2 + at, canvas->prev_transparent ? 0x00 : 0xFF, prev->w);
+            }
+        }
+        changed = *prev;
+    } else if (prev->w && canvas->prev_disposal == 3 && canvas->backup) {
+        gif_stream_canvas_copy(canvas, prev, canvas->backup, false);
+        changed = *prev;
+    }
+
+    canvas->prev = frame->rect;
+    canvas->prev_disposal = frame->disposal;
+    canvas->prev_transparent = frame->transparent >= 0;
+    if (frame->rect.w == 0) {
+        if (dirty) {
+            *dirty = changed;
+        }
+        return;
+    }
+
+    // Keep what the frame covers if it is to be restored afterwards
+    if (frame->disposal == 3) {
+        if (!canvas->backup) {
+            canvas->backup = heap_caps_malloc(canvas->size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!canvas->backup) {
+                canvas->backup = heap_caps_malloc(canvas->size, MALLOC_CAP_DEFAULT);
+            }
+        }
+        if (canvas->backup) {
+            gif_stream_canvas_copy(canvas, &frame->rect, canvas->backup, true);
+        } else {
+            ESP_LOGW(TAG, "No memory to restore frame %u, keeping it", frame->index);
+            canvas->prev_disposal = 1;
+        }
+    }
+
+    const uint16_t y_end = frame->rect.y + frame->rect.h;
+    if (!frame->interlaced) {
+        for (uint16_t row = 0; row < frame->rect.h; row++) {
+            gif_stream_canvas_row(canvas, frame, frame->indices + (size_t)row * frame->stride, frame->rect.y + row);
+        }
+    } else {
+        // Rows are stored as passes: every 8th from 0, every 8th from 4, every 4th from 2, every 2nd from 1
+        static const uint8_t start[4] = {0, 4, 2, 1};
+        static const uint8_t step[4] = {8, 8, 4, 2};
+        const uint8_t *src = frame->indices;
+        for (int pass = 0; pass < 4; pass++) {
+            for (uint32_t row = start[pass]; row < frame->rows; row += step[pass], src += frame->stride) {
+                if (frame->rect.y + row < y_end) {
+                    gif_stream_canvas_row(canvas, frame, src, frame->rect.y + row);
+                }
+            }
+        }
+    }
+
+    gif_stream_rect_union(&changed, &frame->rect);
+    if (dirty) {
+        *dirty = changed;
+    }
+}
+
+void gif_stream_canvas_deinit(gif_stream_canvas_t *canvas)
+{
+    if (canvas->backup) {
+        heap_caps_free(canvas->backup);
+        canvas->backup = NULL;
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * GIF Stream Decoder Component
+ * Splits animated GIF playback into LZW decoding (any task) and dirty-rectangle
+ * composition onto an RGB565 canvas (the display task)
+ */
+
+#ifndef GIF_STREAM_H
+#define GIF_STREAM_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief GIF decoder configuration
+ */
+typedef struct {
+    bool swap_bytes;                // Emit big-endian RGB565 (LV_COLOR_16_SWAP)
+} gif_stream_cfg_t;
+
+/**
+ * @brief Animation properties known after gif_stream_open()
+ */
+typedef struct {
+    uint16_t width;                 // Logical screen size, the canvas size
+    uint16_t height;
+    uint16_t frames;                // Number of complete frames in the file
+    uint16_t plays;                 // How often the animation runs, 0 for forever
+    uint16_t background;            // Background colour as RGB565 in cfg->swap_bytes order
+    bool has_alpha;                 // Some frame clears to transparent, the canvas needs an A8 plane
+} gif_stream_info_t;
+
+/**
+ * @brief Rectangle on the canvas
+ */
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;                     // 0 for an empty rectangle
+    uint16_t h;
+} gif_stream_rect_t;
+
+/**
+ * @brief One LZW-decoded frame, everything gif_stream_canvas_draw() needs
+ */
+typedef struct {
+    uint8_t *indices;               // Set by the caller: at least width * height bytes of the info size
+    uint16_t palette[256];          // RGB565 in cfg->swap_bytes order
+    gif_stream_rect_t rect;         // Frame position, clipped to the canvas
+    uint16_t stride;                // Indices per row (the unclipped frame width)
+    uint16_t rows;                  // Index rows (the unclipped frame height)
+    bool interlaced;                // Rows are stored in the four GIF interlace passes
+    uint16_t index;                 // Frame number, 0 again when the animation restarts
+    uint16_t delay_ms;              // How long the frame stays on screen
+    uint8_t disposal;               // What happens to rect before the next frame (GIF disposal method)
+    int16_t transparent;            // Transparent colour index, -1 for none
+} gif_stream_frame_t;
+
+/**
+ * @brief Canvas the frames are composed on, with the state of the previous frame
+ */
+typedef struct {
+    uint8_t *pixels;                // width * height RGB565, then width * height alpha bytes if has_alpha
+    size_t size;                    // Buffer size in bytes
+    uint16_t width;
+    uint16_t height;
+    bool has_alpha;                 // Layout matches LV_IMG_CF_RGB565A8
+    uint16_t background;
+    gif_stream_rect_t prev;         // Previous frame and how it is disposed of
+    uint8_t prev_disposal;
+    bool prev_transparent;
+    uint8_t *backup;                // Pixels under prev for disposal 3, allocated on first use
+} gif_stream_canvas_t;
+
+/**
+ * @brief LZW decoder state
+ */
+typedef struct gif_stream gif_stream_t;
+
+/**
+ * @brief Whether data starts with a GIF87a/GIF89a signature
+ */
+bool gif_stream_is(const uint8_t *data, size_t size);
+
+/**
+ * @brief Parse the header and walk all blocks to count frames
+ *
+ * The data is read in place and must stay valid until gif_stream_close().
+ * A truncated file plays the frames it has.
+ *
+ * @param data GIF file
+ * @param size Size of data in bytes
+ * @param cfg Decoder configuration (may be NULL)
+ * @param[out] gif Decoder, free with gif_stream_close()
+ * @param[out] info Animation properties (may be NULL)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if data is not a GIF or has no frame
+ *      - ESP_ERR_NOT_SUPPORTED for sizes over 2047 (the LVGL image limit)
+ *      - ESP_ERR_NO_MEM if the decoder state could not be allocated
+ */
+esp_err_t gif_stream_open(const uint8_t *data, size_t size, const gif_stream_cfg_t *cfg,
+                          gif_stream_t **gif, gif_stream_info_t *info);
+
+/**
+ * @brief LZW-decode the next frame into frame->indices
+ *
+ * Only touches the decoder and frame, so it can run in another task than
+ * the one that draws. After the last frame the animation starts over with
+ * frame->index 0; counting plays is up to the caller.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_FAIL if the frame data is corrupt
+ */
+esp_err_t gif_stream_next_frame(gif_stream_t *gif, gif_stream_frame_t *frame);
+
+/**
+ * @brief Free a decoder (NULL is ignored)
+ */
+void gif_stream_close(gif_stream_t *gif);
+
+/**
+ * @brief Allocate a canvas filled with the background colour
+ *
+ * The pixels are owned by the caller once allocated (free with
+ * heap_caps_free()), gif_stream_canvas_deinit() only frees the backup.
+ *
+ * @param fb_caps Heap caps for the pixels (0: PSRAM)
+ * @return ESP_ERR_NO_MEM if the pixels could not be allocated
+ */
+esp_err_t gif_stream_canvas_init(gif_stream_canvas_t *canvas, const gif_stream_info_t *info, uint32_t fb_caps);
+
+/**
+ * @brief Dispose of the previous frame and draw frame on the canvas
+ *
+ * Only the previous frame's rectangle (for disposal 2 and 3) and the new
+ * frame's rectangle are written.
+ *
+ * @param[out] dirty Bounding box of the pixels that may have changed (may be NULL)
+ */
+void gif_stream_canvas_draw(gif_stream_canvas_t *canvas, const gif_stream_frame_t *frame, gif_stream_rect_t *dirty);
+
+/**
+ * @brief Free the canvas state, not the pixels
+ */
+void gif_stream_canvas_deinit(gif_stream_canvas_t *canvas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GIF_STREAM_H
@@ -0,0 +1,397 @@
+/*
+ * IMG565 image container
+ * Tile decompression (RLE, LZ4) and whole-image decode into an RGB565 framebuffer
+ */
+
+#include "img565.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "img565";
+
+static inline uint16_t img565_le16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static inline uint32_t img565_le32(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool img565_is(const uint8_t *data, size_t size)
+{
+    return data && size >= 4 && memcmp(data, IMG565_MAGIC, 4) == 0;
+}
+
+esp_err_t img565_parse_header(const uint8_t *data, size_t size, img565_header_t *hdr)
+{
+    if (size < IMG565_HEADER_SIZE || !img565_is(data, size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (data[4] != IMG565_VERSION || data[6] > IMG565_LZ4) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    hdr->flags = data[5];
+    hdr->compression = data[6];
+    hdr->width = img565_le16(data + 8);
+    hdr->height = img565_le16(data + 10);
+    hdr->tile_rows = img565_le16(data + 12);
+    if (!hdr->width || !hdr->height || !hdr->tile_rows) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    hdr->tiles = (hdr->height + hdr->tile_rows - 1) / hdr->tile_rows;
+    return ESP_OK;
+}
+
+uint16_t img565_tile_rows(const img565_header_t *hdr, uint16_t tile)
+{
+    uint32_t top = (uint32_t)tile * hdr->tile_rows;
+    return top + hdr->tile_rows <= hdr->height ? hdr->tile_rows : hdr->height - top;
+}
+
+size_t img565_tile_size(const img565_header_t *hdr, uint16_t tile)
+{
+    size_t px = (size_t)hdr->width * img565_tile_rows(hdr, tile);
+    return px * ((hdr->flags & IMG565_FLAG_ALPHA) ? 3 : 2);
+}
+
+/**
+ * @brief Expand one RLE plane of 1- or 2-byte units
+ * @return First byte after the plane, NULL if the packets do not add up to units
+ */
+static const uint8_t *img565_rle(const uint8_t *src, const uint8_t *end, uint8_t *dst, size_t units, size_t unit)
+{
+    while (units > 0) {
+        if (src >= end) {
+            return NULL;
+        }
+        uint8_t c = *src++;
+        size_t n;
+        if (c & 0x80) {
+            n = (c & 0x7F) + 2;
+            if (n > units || (size_t)(end - src) < unit) {
+                return NULL;
+            }
+            if (unit == 1) {
+                memset(dst, *src, n);
+            } else {
+                uint16_t px;
+                memcpy(&px, src, 2);
+                uint16_t *d = (uint16_t *)dst;     // colors are 2-byte aligned
+                for (size_t i = 0; i < n; i++) {
+                    d[i] = px;
+                }
+            }
+            src += unit;
+        } else {
+            n = c + 1;
+            if (n > units || (size_t)(end - src) < n * unit) {
+                return NULL;
+            }
+            memcpy(dst, src, n * unit);
+            src += n * unit;
+        }
+        dst += n * unit;
+        units -= n;
+    }
+    return src;
+}
+
+/**
+ * @brief Read an LZ4 length extension (bytes of 255 end with a smaller one)
+ */
+static inline bool img565_lz4_len(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+    uint8_t b;
+    do {
+        if (*ip >= iend) {
+            return false;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+/**
+ * @brief Decompress one LZ4 block that must fill dst exactly
+ */
+static bool img565_lz4(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len)
+{
+    const uint8_t *ip = src, *iend = src + src_len;
+    uint8_t *op = dst, *oend = dst + dst_len;
+
+    while (ip < iend) {
+        const unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !img565_lz4_len(&ip, iend, &lit)) {
+            return false;
+        }
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == iend) {
+            break;      // The last sequence has literals only
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t off = ip[0] | ip[1] << 8;
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && !img565_lz4_len(&ip, iend, &len)) {
+            return false;
+        }
+        len += 4;
+        if (off == 0 || off > (size_t)(op - dst) || len > (size_t)(oend - op)) {
+            return false;
+        }
+        // Overlapping matches repeat the last off bytes; copy in doubling
+        // non-overlapping chunks instead of byte by byte (runs have off = 2)
+        const uint8_t *m = op - off;
+        while (len > off) {
+            memcpy(op, m, off);
+            op += off;
+            len -= off;
+            off *= 2;
+        }
+        memcpy(op, m, len);
+        op += len;
+    }
+    return op == oend;
+}
+
+static void img565_swap(uint8_t *colors, size_t px)
+{
+    uint16_t *p = (uint16_t *)colors;
+    for (size_t i = 0; i < px; i++) {
+        p[i] = (uint16_t)(p[i] << 8 | p[i] >> 8);
+    }
+}
+
+esp_err_t img565_decode_tile(const img565_header_t *hdr, uint16_t tile, const uint8_t *src, size_t src_len,
+                             uint8_t *colors, uint8_t *alpha, bool swap_bytes)
+{
+    const size_t px = (size_t)hdr->width * img565_tile_rows(hdr, tile);
+    const bool has_alpha = hdr->flags & IMG565_FLAG_ALPHA;
+    const uint8_t *end = src + src_len;
+
+    switch (hdr->compression) {
+    case IMG565_RAW:
+        if (src_len != img565_tile_size(hdr, tile)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(colors, src, px * 2);
+        if (has_alpha) {
+            memcpy(alpha, src + px * 2, px);
+        }
+        break;
+    case IMG565_RLE:
+        src = img565_rle(src, end, colors, px, 2);
+        if (src && has_alpha) {
+            src = img565_rle(src, end, alpha, px, 1);
+        }
+        if (src != end) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        break;
+    case IMG565_LZ4: {
+        // u32 size of the color block, the color block, then the alpha block
+        if (src_len < 4 || img565_le32(src) > src_len - 4) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        const size_t n = img565_le32(src);
+        src += 4;
+        if (!img565_lz4(src, n, colors, px * 2)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        src += n;
+        if (has_alpha ? !img565_lz4(src, end - src, alpha, px) : src != end) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        break;
+    }
+    default:
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    if (!swap_bytes) {
+        img565_swap(colors, px);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Read exactly len bytes from the stream
+ */
+static bool img565_read_full(const img565_cfg_t *cfg, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int n = cfg->read(cfg->read_ctx, buf, len);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief Decode from memory (mem != NULL) or from cfg->read
+ */
+static esp_err_t img565_decode_src(const img565_cfg_t *cfg, const uint8_t *mem, size_t mem_size, img565_image_t *out)
+{
+    uint8_t head[IMG565_HEADER_SIZE];
+    img565_header_t hdr;
+    esp_err_t ret;
+
+    if (mem) {
+        ret = img565_parse_header(mem, mem_size, &hdr);
+    } else if (img565_read_full(cfg, head, sizeof(head))) {
+        ret = img565_parse_header(head, sizeof(head), &hdr);
+    } else {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Not an IMG565 image");
+        return ret;
+    }
+
+    // Tile table: payload end offsets, never decreasing
+    uint8_t *table;
+    const size_t table_size = img565_table_size(&hdr);
+    if (mem) {
+        if (mem_size - IMG565_HEADER_SIZE < table_size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        table = (uint8_t *)mem + IMG565_HEADER_SIZE;
+    } else {
+        table = heap_caps_malloc(table_size, MALLOC_CAP_DEFAULT);
+        if (!table) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (!img565_read_full(cfg, table, table_size)) {
+            heap_caps_free(table);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    size_t max_payload = 0;
+    uint32_t prev = 0;
+    for (int i = 0; i < hdr.tiles && ret == ESP_OK; i++) {
+        uint32_t end = img565_le32(table + i * 4);
+        if (end < prev) {
+            ret = ESP_ERR_INVALID_SIZE;
+        } else if (end - prev > max_payload) {
+            max_payload = end - prev;
+        }
+        prev = end;
+    }
+    const uint8_t *payload = mem ? mem + IMG565_HEADER_SIZE + table_size : NULL;
+    if (ret == ESP_OK && mem && prev > mem_size - IMG565_HEADER_SIZE - table_size) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+
+    const bool has_alpha = hdr.flags & IMG565_FLAG_ALPHA;
+    const size_t px = (size_t)hdr.width * hdr.height;
+    const size_t fb_size = px * (has_alpha ? 3 : 2);
+    uint8_t *fb = NULL;
+    uint8_t *scratch = NULL;
+    if (ret == ESP_OK) {
+        uint32_t caps = cfg->fb_caps ? cfg->fb_caps : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        fb = heap_caps_malloc(fb_size, caps);
+        if (!fb) {
+            fb = heap_caps_malloc(fb_size, MALLOC_CAP_DEFAULT);
+        }
+        // Compressed tiles from a stream need their payload in one piece
+        if (!mem && hdr.compression != IMG565_RAW) {
+            scratch = heap_caps_malloc(max_payload, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!scratch) {
+                scratch = heap_caps_malloc(max_payload, MALLOC_CAP_DEFAULT);
+            }
+        }
+        if (!fb || (!mem && hdr.compression != IMG565_RAW && !scratch)) {
+            ESP_LOGE(TAG, "Failed to allocate %zu byte framebuffer", fb_size);
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+
+    prev = 0;
+    for (int i = 0; i < hdr.tiles && ret == ESP_OK; i++) {
+        const uint32_t end = img565_le32(table + i * 4);
+        const size_t len = end - prev;
+        const uint16_t y = i * hdr.tile_rows;
+        const uint16_t rows = img565_tile_rows(&hdr, i);
+        uint8_t *colors = fb + (size_t)y * hdr.width * 2;
+        uint8_t *alpha = has_alpha ? fb + px * 2 + (size_t)y * hdr.width : NULL;
+
+        if (mem) {
+            ret = img565_decode_tile(&hdr, i, payload + prev, len, colors, alpha, cfg->swap_bytes);
+        } else if (hdr.compression == IMG565_RAW) {
+            // Nothing to decode: the payload is read straight into place
+            const size_t n = (size_t)hdr.width * rows;
+            if (len != img565_tile_size(&hdr, i)) {
+                ret = ESP_ERR_INVALID_SIZE;
+            } else if (!img565_read_full(cfg, colors, n * 2) || (has_alpha && !img565_read_full(cfg, alpha, n))) {
+                ret = ESP_FAIL;
+            } else if (!cfg->swap_bytes) {
+                img565_swap(colors, n);
+            }
+        } else if (!img565_read_full(cfg, scratch, len)) {
+            ret = ESP_FAIL;
+        } else {
+            ret = img565_decode_tile(&hdr, i, scratch, len, colors, alpha, cfg->swap_bytes);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Tile %d (rows %u-%u) is corrupt or truncated", i, y, y + rows - 1);
+        } else if (cfg->on_band && !has_alpha) {
+            cfg->on_band(cfg->band_ctx, colors, hdr.width, hdr.height, y, rows);
+        }
+        prev = end;
+    }
+
+    if (!mem) {
+        heap_caps_free(table);
+    }
+    heap_caps_free(scratch);
+    if (ret != ESP_OK) {
+        heap_caps_free(fb);
+        return ret;
+    }
+
+    out->pixels = fb;
+    out->width = hdr.width;
+    out->height = hdr.height;
+    out->size = fb_size;
+    out->has_alpha = has_alpha;
+    ESP_LOGI(TAG, "Decoded %ux%u IMG565 (%s%s)", hdr.width, hdr.height,
+             hdr.compression == IMG565_LZ4 ? "LZ4" : hdr.compression == IMG565_RLE ? "RLE" : "raw",
+             has_alpha ? ", alpha" : "");
+    return ESP_OK;
+}
+
+esp_err_t img565_decode(const img565_cfg_t *cfg, img565_image_t *out)
+{
+    if (!cfg || !cfg->read || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return img565_decode_src(cfg, NULL, 0, out);
+}
+
+esp_err_t img565_decode_mem(const uint8_t *data, size_t size, const img565_cfg_t *cfg, img565_image_t *out)
+{
+    if (!data || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    img565_cfg_t mem_cfg = {0};
+    if (cfg) {
+        mem_cfg = *cfg;
+    }
+    return img565_decode_src(&mem_cfg, data, size, out);
+}
@@ -0,0 +1,164 @@
+/*
+ * IMG565 image container
+ * Panel-native RGB565 tiles (optionally RLE or LZ4 compressed) that display without a decode step
+ *
+ * Layout, all integers little-endian:
+ *
+ *   0   "I565"             magic
+ *   4   u8  version        IMG565_VERSION
+ *   5   u8  flags          IMG565_FLAG_ALPHA: every tile carries an A8 plane after its colors
+ *   6   u8  compression    img565_compression_t, same for every tile
+ *   7   u8  reserved       0
+ *   8   u16 width
+ *   10  u16 height
+ *   12  u16 tile_rows      Rows per tile, the last tile may be shorter
+ *   14  u16 reserved       0
+ *   16  u32 tile_end[n]    End of each tile's payload, counted from the first payload byte
+ *   ..  payloads           n = ceil(height / tile_rows)
+ *
+ * A tile is a full-width band of rows, so it maps onto LVGL lines and panel
+ * flush bands. Decompressed it is width * rows big-endian RGB565 pixels (the
+ * byte order SPI panels expect, LV_COLOR_16_SWAP) followed by width * rows
+ * alpha bytes if IMG565_FLAG_ALPHA is set. Tiles are compressed independently.
+ *
+ * RLE: a stream of packets over 2-byte pixels (colors) or bytes (alpha), one
+ * stream per plane. Control byte c < 0x80: c + 1 literal units follow;
+ * c >= 0x80: one unit follows, repeated (c & 0x7F) + 2 times.
+ * LZ4: u32 length of the color block, the color plane as one LZ4 block
+ * (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), then the
+ * alpha plane as a second block.
+ *
+ * img565.py in the repository root encodes images on the host.
+ */
+
+#ifndef IMG565_H
+#define IMG565_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMG565_MAGIC            "I565"
+#define IMG565_VERSION          1
+#define IMG565_HEADER_SIZE      16
+#define IMG565_FLAG_ALPHA       0x01
+
+typedef enum {
+    IMG565_RAW = 0,             // Tiles stored as-is
+    IMG565_RLE = 1,             // Run-length packets, good for flat UI graphics
+    IMG565_LZ4 = 2,             // LZ4 blocks, good for screenshots with repeated patterns
+} img565_compression_t;
+
+/**
+ * @brief Parsed file header
+ */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t tile_rows;
+    uint16_t tiles;             // Number of tiles
+    uint8_t flags;              // IMG565_FLAG_*
+    uint8_t compression;        // img565_compression_t
+} img565_header_t;
+
+/**
+ * @brief Stream read callback, same contract as jpeg_stream_read_cb_t
+ * @return Number of bytes read (>0), 0 on end of stream, <0 on error
+ */
+typedef int (*img565_read_cb_t)(void *ctx, uint8_t *buf, size_t len);
+
+/**
+ * @brief Band callback, called after each tile with its RGB565 rows (same contract as jpeg_stream_band_cb_t)
+ */
+typedef void (*img565_band_cb_t)(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height,
+                                 uint16_t y, uint16_t rows);
+
+/**
+ * @brief Stream decoder configuration
+ */
+typedef struct {
+    img565_read_cb_t read;      // Source of the file bytes, starting at the magic
+    void *read_ctx;             // Passed to read()
+    bool swap_bytes;            // Emit big-endian RGB565 (LV_COLOR_16_SWAP)
+    uint32_t fb_caps;           // Heap caps for the framebuffer (0: PSRAM)
+    img565_band_cb_t on_band;   // Optional, called for every finished tile
+    void *band_ctx;             // Passed to on_band()
+} img565_cfg_t;
+
+/**
+ * @brief Decoded image
+ */
+typedef struct {
+    uint8_t *pixels;            // width * height RGB565 pixels, then width * height alpha bytes if has_alpha
+    uint16_t width;
+    uint16_t height;
+    size_t size;                // Buffer size in bytes
+    bool has_alpha;             // Layout matches LV_IMG_CF_RGB565A8
+} img565_image_t;
+
+/**
+ * @brief Whether data starts with the IMG565 magic
+ */
+bool img565_is(const uint8_t *data, size_t size);
+
+/**
+ * @brief Parse and validate the 16-byte file header
+ * @return ESP_ERR_INVALID_VERSION for an unknown version or compression,
+ *         ESP_ERR_INVALID_ARG for anything else that is not a valid header
+ */
+esp_err_t img565_parse_header(const uint8_t *data, size_t size, img565_header_t *hdr);
+
+/**
+ * @brief Size of the tile table that follows the header
+ */
+static inline size_t img565_table_size(const img565_header_t *hdr)
+{
+    return (size_t)hdr->tiles * 4;
+}
+
+/**
+ * @brief Rows in tile i (the last tile may be shorter)
+ */
+uint16_t img565_tile_rows(const img565_header_t *hdr, uint16_t tile);
+
+/**
+ * @brief Decompressed size of tile i in bytes
+ */
+size_t img565_tile_size(const img565_header_t *hdr, uint16_t tile);
+
+/**
+ * @brief Decompress one tile
+ *
+ * @param src Tile payload
+ * @param src_len Payload length (tile_end[i] - tile_end[i - 1])
+ * @param colors Receives width * rows RGB565 pixels (2-byte aligned)
+ * @param alpha Receives width * rows alpha bytes, ignored without IMG565_FLAG_ALPHA
+ * @param swap_bytes Emit big-endian RGB565 (the stored order); false swaps to native order
+ * @return ESP_ERR_INVALID_SIZE if the payload does not decompress to exactly one tile
+ */
+esp_err_t img565_decode_tile(const img565_header_t *hdr, uint16_t tile, const uint8_t *src, size_t src_len,
+                             uint8_t *colors, uint8_t *alpha, bool swap_bytes);
+
+/**
+ * @brief Decode an IMG565 stream into a newly allocated framebuffer
+ *
+ * Raw tiles are read straight into the framebuffer; compressed tiles go
+ * through one payload-sized scratch buffer.
+ */
+esp_err_t img565_decode(const img565_cfg_t *cfg, img565_image_t *out);
+
+/**
+ * @brief img565_decode() for a file that is already in memory
+ */
+esp_err_t img565_decode_mem(const uint8_t *data, size_t size, const img565_cfg_t *cfg, img565_image_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMG565_H
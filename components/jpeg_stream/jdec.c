@@ -0,0 +1,1725 @@
+/*----------------------------------------------------------------------------/
+/ TJpgDec - Tiny JPEG Decompressor R0.03                      (C)ChaN, 2021
+/-----------------------------------------------------------------------------/
+/ The TJpgDec is a generic JPEG decompressor module for tiny embedded systems.
+/ This is a free software that opened for education, research and commercial
+/  developments under license policy of following terms.
+/
+/  Copyright (C) 2021, ChaN, all right reserved.
+/
+/ * The TJpgDec module is a free software and there is NO WARRANTY.
+/ * No restriction on use. You can use, modify and redistribute it for
+/   personal, non-profit or commercial products UNDER YOUR RESPONSIBILITY.
+/ * Redistributions of source code must retain the above copyright notice.
+/
+/-----------------------------------------------------------------------------/
+/ Oct 04, 2011 R0.01  First release.
+/ Feb 19, 2012 R0.01a Fixed decompression fails when scan starts with an escape seq.
+/ Sep 03, 2012 R0.01b Added JD_TBLCLIP option.
+/ Mar 16, 2019 R0.01c Supprted stdint.h.
+/ Jul 01, 2020 R0.01d Fixed wrong integer type usage.
+/ May 08, 2021 R0.02  Supprted grayscale image. Separated configuration options.
+/ Jun 11, 2021 R0.02a Some performance improvement.
+/ Jul 01, 2021 R0.03  Added JD_FASTDECODE option.
+/                     Some performance improvement.
+/-----------------------------------------------------------------------------/
+/ jpeg_stream fork (jdec): JD_FASTDECODE 1, JD_USE_SCALE 1 and table clipping
+/ are fixed, output format is chosen per decode (RGB888 or RGB565, optionally
+/ byte-swapped) and the IDCT / colour conversion live in jdec_kernels.c.
+/ Additions: restart-interval slicing (jdec_decomp_range/jdec_clone) and
+/ progressive Huffman JPEG with a scale-dependent coefficient buffer.
+/----------------------------------------------------------------------------*/
+
+#include "jdec.h"
+#include "jdec_kernels.h"
+#include "sdkconfig.h"
+
+#if CONFIG_JPEG_STREAM_OPT_KERNELS
+#define JDEC_IDCT           jdec_idct_fast
+#define JDEC_MCU_RGB565     jdec_mcu_rgb565_fast
+#else
+#define JDEC_IDCT           jdec_idct_ref
+#define JDEC_MCU_RGB565     jdec_mcu_rgb565_ref
+#endif
+
+#define LDB_WORD(ptr)       (uint16_t)(((uint16_t)*((uint8_t*)(ptr))<<8)|(uint16_t)*(uint8_t*)((ptr)+1))
+
+
+/*-----------------------------------------------*/
+/* Zigzag-order to raster-order conversion table */
+/*-----------------------------------------------*/
+
+static const uint8_t Zig[64] = {    /* Zigzag-order to raster-order conversion table */
+    0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+
+
+/*-------------------------------------------------*/
+/* Input scale factor of Arai algorithm            */
+/* (scaled up 16 bits for fixed point operations)  */
+/*-------------------------------------------------*/
+
+static const uint16_t Ipsf[64] = {  /* See also aa_idct.png */
+    (uint16_t)(1.00000 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(1.00000 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.27590 * 8192),
+    (uint16_t)(1.38704 * 8192), (uint16_t)(1.92388 * 8192), (uint16_t)(1.81226 * 8192), (uint16_t)(1.63099 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.08979 * 8192), (uint16_t)(0.75066 * 8192), (uint16_t)(0.38268 * 8192),
+    (uint16_t)(1.30656 * 8192), (uint16_t)(1.81226 * 8192), (uint16_t)(1.70711 * 8192), (uint16_t)(1.53636 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.02656 * 8192), (uint16_t)(0.70711 * 8192), (uint16_t)(0.36048 * 8192),
+    (uint16_t)(1.17588 * 8192), (uint16_t)(1.63099 * 8192), (uint16_t)(1.53636 * 8192), (uint16_t)(1.38268 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(0.92388 * 8192), (uint16_t)(0.63638 * 8192), (uint16_t)(0.32442 * 8192),
+    (uint16_t)(1.00000 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(1.00000 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.27590 * 8192),
+    (uint16_t)(0.78570 * 8192), (uint16_t)(1.08979 * 8192), (uint16_t)(1.02656 * 8192), (uint16_t)(0.92388 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.61732 * 8192), (uint16_t)(0.42522 * 8192), (uint16_t)(0.21677 * 8192),
+    (uint16_t)(0.54120 * 8192), (uint16_t)(0.75066 * 8192), (uint16_t)(0.70711 * 8192), (uint16_t)(0.63638 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.42522 * 8192), (uint16_t)(0.29290 * 8192), (uint16_t)(0.14932 * 8192),
+    (uint16_t)(0.27590 * 8192), (uint16_t)(0.38268 * 8192), (uint16_t)(0.36048 * 8192), (uint16_t)(0.32442 * 8192), (uint16_t)(0.27590 * 8192), (uint16_t)(0.21678 * 8192), (uint16_t)(0.14932 * 8192), (uint16_t)(0.07612 * 8192)
+};
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Allocate a memory block from memory pool                              */
+/*-----------------------------------------------------------------------*/
+
+static void *alloc_pool (   /* Pointer to allocated memory block (NULL:no memory available) */
+    JDEC *jd,               /* Pointer to the decompressor object */
+    size_t ndata            /* Number of bytes to allocate */
+)
+{
+    char *rp = 0;
+
+
+    ndata = (ndata + 3) & ~3;           /* Align block size to the word boundary */
+
+    if (jd->sz_pool >= ndata) {
+        jd->sz_pool -= ndata;
+        rp = (char *)jd->pool;          /* Get start of available memory pool */
+        jd->pool = (void *)(rp + ndata); /* Allocate requierd bytes */
+    }
+
+    return (void *)rp;  /* Return allocated memory block (NULL:no memory to allocate) */
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Create de-quantization and prescaling tables with a DQT segment       */
+/*-----------------------------------------------------------------------*/
+
+static JRESULT create_qt_tbl (  /* 0:OK, !0:Failed */
+    JDEC *jd,               /* Pointer to the decompressor object */
+    const uint8_t *data,    /* Pointer to the quantizer tables */
+    size_t ndata            /* Size of input data */
+)
+{
+    unsigned int i, zi;
+    uint8_t d;
+    int32_t *pb;
+
+
+    while (ndata) { /* Process all tables in the segment */
+        if (ndata < 65) {
+            return JDR_FMT1;    /* Err: table size is unaligned */
+        }
+        ndata -= 65;
+        d = *data++;                            /* Get table property */
+        if (d & 0xF0) {
+            return JDR_FMT1;    /* Err: not 8-bit resolution */
+        }
+        i = d & 3;                              /* Get table ID */
+        pb = jd->qttbl[i];                      /* A redefined table reuses its memory block */
+        if (!pb) {
+            pb = alloc_pool(jd, 64 * sizeof (int32_t));/* Allocate a memory block for the table */
+        }
+        if (!pb) {
+            return JDR_MEM1;    /* Err: not enough memory */
+        }
+        jd->qttbl[i] = pb;                      /* Register the table */
+        for (i = 0; i < 64; i++) {              /* Load the table */
+            zi = Zig[i];                        /* Zigzag-order to raster-order conversion */
+            pb[zi] = (int32_t)((uint32_t) * data++ * Ipsf[zi]); /* Apply scale factor of Arai algorithm to the de-quantizers */
+        }
+    }
+
+    return JDR_OK;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Create huffman code tables with a DHT segment                         */
+/*-----------------------------------------------------------------------*/
+
+static JRESULT create_huffman_tbl ( /* 0:OK, !0:Failed */
+    JDEC *jd,                   /* Pointer to the decompressor object */
+    const uint8_t *data,        /* Pointer to the packed huffman tables */
+    size_t ndata                /* Size of input data */
+)
+{
+    unsigned int i, j, b, cls, num;
+    size_t np;
+    uint8_t d, *pb, *pd;
+    uint16_t hc, *ph;
+
+
+    while (ndata) { /* Process all tables in the segment */
+        if (ndata < 17) {
+            return JDR_FMT1;    /* Err: wrong data size */
+        }
+        ndata -= 17;
+        d = *data++;                        /* Get table number and class */
+        if (d & 0xEE) {
+            return JDR_FMT1;    /* Err: invalid class/number */
+        }
+        cls = d >> 4; num = d & 0x0F;       /* class = dc(0)/ac(1), table number = 0/1 */
+        for (np = i = 0; i < 16; i++) {     /* Get sum of code words for each code */
+            np += data[i];
+        }
+        if (np > 256) {
+            return JDR_FMT1;    /* Err: more codes than symbols */
+        }
+        if (np > jd->huffcap[num][cls]) {   /* Allocate the table unless a redefined one fits (progressive JPEGs send one per scan) */
+            b = cls ? 256 : 16;             /* Room for any AC table / the usual DC table */
+            if (b < np) {
+                b = np;
+            }
+            pb = alloc_pool(jd, 16);        /* Allocate a memory block for the bit distribution table */
+            ph = alloc_pool(jd, b * sizeof (uint16_t)); /* Allocate a memory block for the code word table */
+            pd = alloc_pool(jd, b);         /* Allocate a memory block for the decoded data */
+            if (!pb || !ph || !pd) {
+                return JDR_MEM1;    /* Err: not enough memory */
+            }
+#if JDEC_HUFF_LUT_BITS
+            if (!jd->hufflut[num][cls]) {
+                jd->hufflut[num][cls] = alloc_pool(jd, (1U << JDEC_HUFF_LUT_BITS) * sizeof (uint16_t));
+                if (!jd->hufflut[num][cls]) {
+                    return JDR_MEM1;
+                }
+            }
+#endif
+            jd->huffbits[num][cls] = pb;
+            jd->huffcode[num][cls] = ph;
+            jd->huffdata[num][cls] = pd;
+            jd->huffcap[num][cls] = (uint16_t)b;
+        }
+        pb = jd->huffbits[num][cls];
+        ph = jd->huffcode[num][cls];
+        pd = jd->huffdata[num][cls];
+        for (i = 0; i < 16; i++) {          /* Load number of patterns for 1 to 16-bit code */
+            pb[i] = *data++;
+        }
+        hc = 0;
+        for (j = i = 0; i < 16; i++) {      /* Re-build huffman code word table */
+            b = pb[i];
+            while (b--) {
+                ph[j++] = hc++;
+            }
+            hc <<= 1;
+        }
+#if JDEC_HUFF_LUT_BITS
+        for (j = i = 0; i < JDEC_HUFF_LUT_BITS; i++) {  /* Number of codes short enough for the lookup table */
+            j += pb[i];
+        }
+        jd->huffshort[num][cls] = (uint16_t)j;
+#endif
+
+        if (ndata < np) {
+            return JDR_FMT1;    /* Err: wrong data size */
+        }
+        ndata -= np;
+        for (i = 0; i < np; i++) {          /* Load decoded data corresponds to each code word */
+            d = *data++;
+            if (!cls && d > 11) {
+                return JDR_FMT1;
+            }
+            pd[i] = d;
+        }
+#if JDEC_HUFF_LUT_BITS
+        {   /* Every LUT index that starts with a short code maps to its length and data */
+            uint16_t *lut = jd->hufflut[num][cls];
+            unsigned int len, span;
+
+            memset(lut, 0, (1U << JDEC_HUFF_LUT_BITS) * sizeof (uint16_t));
+            for (j = 0, len = 1; len <= JDEC_HUFF_LUT_BITS; len++) {
+                span = 1U << (JDEC_HUFF_LUT_BITS - len);
+                for (b = pb[len - 1]; b; b--, j++) {
+                    if (ph[j] >> len) {
+                        continue;   /* Overfull table, the code does not fit its length */
+                    }
+                    for (i = 0; i < span; i++) {
+                        lut[(ph[j] << (JDEC_HUFF_LUT_BITS - len)) + i] = (uint16_t)(len << 8 | pd[j]);
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    return JDR_OK;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Extract a huffman decoded data from input stream                      */
+/*-----------------------------------------------------------------------*/
+
+static int huffext (    /* >=0: decoded data, <0: error code */
+    JDEC *jd,           /* Pointer to the decompressor object */
+    unsigned int id,    /* Table ID (0:Y, 1:C) */
+    unsigned int cls    /* Table class (0:DC, 1:AC) */
+)
+{
+    size_t dc = jd->dctr;
+    uint8_t *dp = jd->dptr;
+    unsigned int d, flg = 0;
+
+    const uint8_t *hb, *hd;
+    const uint16_t *hc;
+    unsigned int nc, bl, wbit = jd->dbit % 32;
+    uint32_t w = jd->wreg & ((1UL << wbit) - 1);
+
+
+    while (wbit < 16) { /* Prepare 16 bits into the working register */
+        if (jd->marker) {
+            d = 0xFF;   /* Input stream has stalled for a marker. Generate stuff bits */
+        } else {
+            if (!dc) {  /* Buffer empty, re-fill input buffer */
+                dp = jd->inbuf;                     /* Top of input buffer */
+                dc = jd->infunc(jd, dp, JD_SZBUF);
+                if (!dc) {
+                    return 0 - (int)JDR_INP;    /* Err: read error or wrong stream termination */
+                }
+            }
+            d = *dp++; dc--;
+            if (flg) {      /* In flag sequence? */
+                flg = 0;    /* Exit flag sequence */
+                if (d != 0) {
+                    jd->marker = d;    /* Not an escape of 0xFF but a marker */
+                }
+                d = 0xFF;
+            } else {
+                if (d == 0xFF) {        /* Is start of flag sequence? */
+                    flg = 1; continue;  /* Enter flag sequence, get trailing byte */
+                }
+            }
+        }
+        w = w << 8 | d; /* Shift 8 bits in the working register */
+        wbit += 8;
+    }
+    jd->dctr = dc; jd->dptr = dp;
+    jd->wreg = w;
+
+#if JDEC_HUFF_LUT_BITS
+    /* Short codes (nearly all of them): one lookup */
+    d = jd->hufflut[id][cls][w >> (wbit - JDEC_HUFF_LUT_BITS)];
+    if (d) {
+        jd->dbit = wbit - (d >> 8);
+        return d & 0xFF;
+    }
+
+    /* Incremental serch for the codes longer than the lookup table */
+    nc = jd->huffshort[id][cls];
+    hb = jd->huffbits[id][cls] + JDEC_HUFF_LUT_BITS;
+    hc = jd->huffcode[id][cls] + nc;
+    hd = jd->huffdata[id][cls] + nc;
+    bl = JDEC_HUFF_LUT_BITS + 1;
+#else
+    /* Incremental serch for all codes */
+    hb = jd->huffbits[id][cls]; /* Bit distribution table */
+    hc = jd->huffcode[id][cls]; /* Code word table */
+    hd = jd->huffdata[id][cls]; /* Data table */
+    bl = 1;
+#endif
+    for ( ; bl <= 16; bl++) {   /* Incremental search */
+        nc = *hb++;
+        if (nc) {
+            d = w >> (wbit - bl);
+            do {    /* Search the code word in this bit length */
+                if (d == *hc++) {       /* Matched? */
+                    jd->dbit = wbit - bl;   /* Snip the huffman code */
+                    return *hd;         /* Return the decoded data */
+                }
+                hd++;
+            } while (--nc);
+        }
+    }
+
+    return 0 - (int)JDR_FMT1;   /* Err: code not found (may be collapted data) */
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Extract N bits from input stream                                      */
+/*-----------------------------------------------------------------------*/
+
+static int bitext ( /* >=0: extracted data, <0: error code */
+    JDEC *jd,           /* Pointer to the decompressor object */
+    unsigned int nbit   /* Number of bits to extract (1 to 16) */
+)
+{
+    size_t dc = jd->dctr;
+    uint8_t *dp = jd->dptr;
+    unsigned int d, flg = 0;
+
+    unsigned int wbit = jd->dbit % 32;
+    uint32_t w = jd->wreg & ((1UL << wbit) - 1);
+
+
+    while (wbit < nbit) {   /* Prepare nbit bits into the working register */
+        if (jd->marker) {
+            d = 0xFF;   /* Input stream stalled, generate stuff bits */
+        } else {
+            if (!dc) {  /* Buffer empty, re-fill input buffer */
+                dp = jd->inbuf; /* Top of input buffer */
+                dc = jd->infunc(jd, dp, JD_SZBUF);
+                if (!dc) {
+                    return 0 - (int)JDR_INP;    /* Err: read error or wrong stream termination */
+                }
+            }
+            d = *dp++; dc--;
+            if (flg) {      /* In flag sequence? */
+                flg = 0;    /* Exit flag sequence */
+                if (d != 0) {
+                    jd->marker = d;    /* Not an escape of 0xFF but a marker */
+                }
+                d = 0xFF;
+            } else {
+                if (d == 0xFF) {        /* Is start of flag sequence? */
+                    flg = 1; continue;  /* Enter flag sequence, get trailing byte */
+                }
+            }
+        }
+        w = w << 8 | d; /* Get 8 bits into the working register */
+        wbit += 8;
+    }
+    jd->wreg = w; jd->dbit = wbit - nbit;
+    jd->dctr = dc; jd->dptr = dp;
+
+    return (int)(w >> ((wbit - nbit) % 32));
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Process restart interval                                              */
+/*-----------------------------------------------------------------------*/
+
+static JRESULT restart (
+    JDEC *jd,       /* Pointer to the decompressor object */
+    uint16_t rstn   /* Expected restert sequense number */
+)
+{
+    unsigned int i;
+    uint8_t *dp = jd->dptr;
+    size_t dc = jd->dctr;
+
+    uint16_t marker;
+
+
+    if (jd->marker) {   /* Generate a maker if it has been detected */
+        marker = 0xFF00 | jd->marker;
+        jd->marker = 0;
+    } else {
+        marker = 0;
+        for (i = 0; i < 2; i++) {   /* Get a restart marker */
+            if (!dc) {      /* No input data is available, re-fill input buffer */
+                dp = jd->inbuf;
+                dc = jd->infunc(jd, dp, JD_SZBUF);
+                if (!dc) {
+                    return JDR_INP;
+                }
+            }
+            marker = (marker << 8) | *dp++; /* Get a byte */
+            dc--;
+        }
+        jd->dptr = dp; jd->dctr = dc;
+    }
+
+    /* Check the marker */
+    if ((marker & 0xFFD8) != 0xFFD0 || (marker & 7) != (rstn & 7)) {
+        return JDR_FMT1;    /* Err: expected RSTn marker was not detected (may be collapted data) */
+    }
+
+    jd->dbit = 0;           /* Discard stuff bits */
+
+    jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;   /* Reset DC offset */
+    return JDR_OK;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Load all blocks in an MCU into working buffer                         */
+/*-----------------------------------------------------------------------*/
+
+static JRESULT mcu_load (
+    JDEC *jd        /* Pointer to the decompressor object */
+)
+{
+    int32_t *tmp = (int32_t *)jd->workbuf;  /* Block working buffer for de-quantize and IDCT */
+    int d, e;
+    unsigned int blk, nby, i, bc, z, id, cmp;
+    jd_yuv_t *bp;
+    const int32_t *dqf;
+
+
+    nby = jd->msx * jd->msy;    /* Number of Y blocks (1, 2 or 4) */
+    bp = jd->mcubuf;            /* Pointer to the first block of MCU */
+
+    for (blk = 0; blk < nby + 2; blk++) {   /* Get nby Y blocks and two C blocks */
+        cmp = (blk < nby) ? 0 : blk - nby + 1;  /* Component number 0:Y, 1:Cb, 2:Cr */
+
+        if (cmp && jd->ncomp != 3) {        /* Clear C blocks if not exist (monochrome image) */
+            for (i = 0; i < 64; bp[i++] = 128) ;
+
+        } else {                            /* Load Y/C blocks from input stream */
+            id = cmp ? 1 : 0;                       /* Huffman table ID of this component */
+
+            /* Extract a DC element from input stream */
+            d = huffext(jd, id, 0);                 /* Extract a huffman coded data (bit length) */
+            if (d < 0) {
+                return (JRESULT)(0 - d);    /* Err: invalid code or input */
+            }
+            bc = (unsigned int)d;
+            d = jd->dcv[cmp];                       /* DC value of previous block */
+            if (bc) {                               /* If there is any difference from previous block */
+                e = bitext(jd, bc);                 /* Extract data bits */
+                if (e < 0) {
+                    return (JRESULT)(0 - e);    /* Err: input */
+                }
+                bc = 1 << (bc - 1);                 /* MSB position */
+                if (!(e & bc)) {
+                    e -= (bc << 1) - 1;    /* Restore negative value if needed */
+                }
+                d += e;                             /* Get current value */
+                jd->dcv[cmp] = (int16_t)d;          /* Save current DC value for next block */
+            }
+            dqf = jd->qttbl[jd->qtid[cmp]];         /* De-quantizer table ID for this component */
+            tmp[0] = d * dqf[0] >> 8;               /* De-quantize, apply scale factor of Arai algorithm and descale 8 bits */
+
+            /* Extract following 63 AC elements from input stream */
+            memset(&tmp[1], 0, 63 * sizeof (int32_t));  /* Initialize all AC elements */
+            z = 1;      /* Top of the AC elements (in zigzag-order) */
+            do {
+                d = huffext(jd, id, 1);             /* Extract a huffman coded value (zero runs and bit length) */
+                if (d == 0) {
+                    break;    /* EOB? */
+                }
+                if (d < 0) {
+                    return (JRESULT)(0 - d);    /* Err: invalid code or input error */
+                }
+                bc = (unsigned int)d;
+                z += bc >> 4;                       /* Skip leading zero run */
+                if (z >= 64) {
+                    return JDR_FMT1;    /* Too long zero run */
+                }
+                if (bc &= 0x0F) {                   /* Bit length? */
+                    d = bitext(jd, bc);             /* Extract data bits */
+                    if (d < 0) {
+                        return (JRESULT)(0 - d);    /* Err: input device */
+                    }
+                    bc = 1 << (bc - 1);             /* MSB position */
+                    if (!(d & bc)) {
+                        d -= (bc << 1) - 1;    /* Restore negative value if needed */
+                    }
+                    i = Zig[z];                     /* Get raster-order index */
+                    tmp[i] = d * dqf[i] >> 8;       /* De-quantize, apply scale factor of Arai algorithm and descale 8 bits */
+                }
+            } while (++z < 64);     /* Next AC element */
+
+            if (z == 1 || jd->scale == 3) {     /* If no AC element or scale ratio is 1/8, IDCT can be ommited and the block is filled with DC value */
+                d = (jd_yuv_t)((*tmp / 256) + 128);
+                for (i = 0; i < 64; bp[i++] = d) ;
+            } else {
+                JDEC_IDCT(tmp, bp);     /* Apply IDCT and store the block to the MCU buffer */
+            }
+        }
+
+        bp += 64;               /* Next block */
+    }
+
+    return JDR_OK;  /* All blocks have been loaded successfully */
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Output an MCU: Convert YCrCb to RGB and output it in RGB form         */
+/*-----------------------------------------------------------------------*/
+
+static JRESULT mcu_output (
+    JDEC *jd,           /* Pointer to the decompressor object */
+    int (*outfunc)(JDEC *, void *, JRECT *), /* RGB output function */
+    unsigned int x,     /* MCU location in the image */
+    unsigned int y      /* MCU location in the image */
+)
+{
+    const int CVACC = 1024;
+    unsigned int ix, iy, mx, my, rx, ry, bpp;
+    int yy, cb, cr;
+    jd_yuv_t *py, *pc;
+    uint8_t *pix;
+    JRECT rect;
+
+
+    mx = jd->msx * 8; my = jd->msy * 8;                 /* MCU size (pixel) */
+    rx = (x + mx <= jd->width) ? mx : jd->width - x;    /* Output rectangular size (it may be clipped at right/bottom end of image) */
+    ry = (y + my <= jd->height) ? my : jd->height - y;
+    rx >>= jd->scale; ry >>= jd->scale;
+    if (!rx || !ry) {
+        return JDR_OK;    /* Skip this MCU if all pixel is to be rounded off */
+    }
+    x >>= jd->scale; y >>= jd->scale;
+    rect.left = x; rect.right = x + rx - 1;             /* Rectangular area in the frame buffer */
+    rect.top = y; rect.bottom = y + ry - 1;
+
+
+    if (jd->scale == 0 && jd->format != JDEC_RGB888) {     /* Full size RGB565: convert in one pass */
+        JDEC_MCU_RGB565(jd->mcubuf, jd->msx, jd->msy, (uint16_t *)jd->workbuf, jd->format == JDEC_RGB565_SWAP);
+        bpp = 2;
+
+    } else {
+        if (jd->scale != 3) {   /* Not for 1/8 scaling */
+            jdec_mcu_rgb888_ref(jd->mcubuf, jd->msx, jd->msy, (uint8_t *)jd->workbuf);
+
+            /* Descale the MCU rectangular if needed */
+            if (jd->scale) {
+                unsigned int x, y, r, g, b, s, w, a;
+                uint8_t *op;
+
+                /* Get averaged RGB value of each square correcponds to a pixel */
+                s = jd->scale * 2;  /* Number of shifts for averaging */
+                w = 1 << jd->scale; /* Width of square */
+                a = (mx - w) * 3;   /* Bytes to skip for next line in the square */
+                op = (uint8_t *)jd->workbuf;
+                for (iy = 0; iy < my; iy += w) {
+                    for (ix = 0; ix < mx; ix += w) {
+                        pix = (uint8_t *)jd->workbuf + (iy * mx + ix) * 3;
+                        r = g = b = 0;
+                        for (y = 0; y < w; y++) {   /* Accumulate RGB value in the square */
+                            for (x = 0; x < w; x++) {
+                                r += *pix++;    /* Accumulate R */
+                                g += *pix++;    /* Accumulate G */
+                                b += *pix++;    /* Accumulate B */
+                            }
+                            pix += a;
+                        }                           /* Put the averaged pixel value */
+                        *op++ = (uint8_t)(r >> s);  /* Put R */
+                        *op++ = (uint8_t)(g >> s);  /* Put G */
+                        *op++ = (uint8_t)(b >> s);  /* Put B */
+                    }
+                }
+            }
+
+        } else {    /* For only 1/8 scaling (left-top pixel in each block are the DC value of the block) */
+
+            /* Build a 1/8 descaled RGB MCU from discrete comopnents */
+            pix = (uint8_t *)jd->workbuf;
+            pc = jd->mcubuf + mx * my;
+            cb = pc[0] - 128;       /* Get Cb/Cr component and restore right level */
+            cr = pc[64] - 128;
+            for (iy = 0; iy < my; iy += 8) {
+                py = jd->mcubuf;
+                if (iy == 8) {
+                    py += 64 * 2;
+                }
+                for (ix = 0; ix < mx; ix += 8) {
+                    yy = *py;   /* Get Y component */
+                    py += 64;
+                    *pix++ = /*R*/ JDEC_CLIP8(yy + ((int)(1.402 * CVACC) * cr / CVACC));
+                    *pix++ = /*G*/ JDEC_CLIP8(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
+                    *pix++ = /*B*/ JDEC_CLIP8(yy + ((int)(1.772 * CVACC) * cb / CVACC));
+                }
+            }
+        }
+        bpp = 3;
+    }
+
+    /* Squeeze up pixel table if a part of MCU is to be truncated */
+    mx >>= jd->scale;
+    if (rx < mx) {  /* Is the MCU spans rigit edge? */
+        uint8_t *s, *d;
+        unsigned int x, y;
+
+        s = d = (uint8_t *)jd->workbuf;
+        for (y = 0; y < ry; y++) {
+            for (x = 0; x < rx * bpp; x++) {    /* Copy effective pixels */
+                *d++ = *s++;
+            }
+            s += (mx - rx) * bpp;   /* Skip truncated pixels */
+        }
+    }
+
+    /* Convert RGB888 to RGB565 if needed */
+    if (bpp == 3 && jd->format != JDEC_RGB888) {
+        uint8_t *s = (uint8_t *)jd->workbuf;
+        uint16_t w, *d = (uint16_t *)s;
+        unsigned int n = rx * ry;
+
+        do {
+            w = (*s++ & 0xF8) << 8;     /* RRRRR----------- */
+            w |= (*s++ & 0xFC) << 3;    /* -----GGGGGG----- */
+            w |= *s++ >> 3;             /* -----------BBBBB */
+            if (jd->format == JDEC_RGB565_SWAP) {
+                w = (uint16_t)((w << 8) | (w >> 8));
+            }
+            *d++ = w;
+        } while (--n);
+    }
+
+    /* Output the rectangular */
+    return outfunc(jd, jd->workbuf, &rect) ? JDR_OK : JDR_INTR;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Progressive JPEG (fork addition)                                      */
+/*-----------------------------------------------------------------------*/
+/* All scans are decoded into a coefficient buffer first, then the image is
+/  output MCU by MCU through the same IDCT and mcu_output() as a baseline
+/  image. Each block keeps only a zigzag prefix of its coefficients: all 64 at
+/  1/1, the ones the 1/2 and 1/4 output depend on (u, v < 4 and u, v < 2) and
+/  just DC at 1/8. For the others the scans only need a bit map of which are
+/  non-zero, to interpret AC refinement bits; at 1/8 the AC scans are skipped
+/  without decoding. */
+
+/* Parse an SOS segment of a progressive image into the scan parameters */
+static JRESULT prog_scan_header (
+    JDEC *jd,               /* Pointer to the decompressor object */
+    const uint8_t *seg,     /* SOS segment data */
+    size_t len              /* Size of the segment data */
+)
+{
+    unsigned int i, j, ns, b;
+
+
+    ns = seg[0];
+    if (ns < 1 || ns > jd->ncomp || len < 4 + 2 * ns) {
+        return JDR_FMT1;    /* Err: wrong scan header */
+    }
+    for (i = 0; i < ns; i++) {
+        for (j = 0; j < jd->ncomp && jd->cid[j] != seg[1 + 2 * i]; j++) ;
+        if (j == jd->ncomp) {
+            return JDR_FMT1;    /* Err: unknown component */
+        }
+        b = seg[2 + 2 * i];
+        if (b & 0xEE) {
+            return JDR_FMT3;    /* Err: only huffman tables 0 and 1 are supported */
+        }
+        jd->scomp[i] = (uint8_t)j;
+        jd->stbl[i] = (uint8_t)b;
+    }
+    jd->ns = (uint8_t)ns;
+    jd->ss = seg[1 + 2 * ns];
+    jd->se = seg[2 + 2 * ns];
+    jd->ah = seg[3 + 2 * ns] >> 4;
+    jd->al = seg[3 + 2 * ns] & 15;
+    if (jd->se > 63 || jd->ss > jd->se || (jd->ss == 0 && jd->se) || (jd->ss && ns != 1) || jd->al > 13) {
+        return JDR_FMT1;    /* Err: invalid spectral selection or successive approximation */
+    }
+
+    for (i = 0; i < ns; i++) {  /* Check the tables this scan decodes with */
+        b = jd->stbl[i];
+        if (jd->ss == 0 && !jd->ah && !jd->huffbits[b >> 4][0]) {
+            return JDR_FMT1;    /* Err: DC table not loaded */
+        }
+        if (jd->ss && !jd->huffbits[b & 15][1]) {
+            return JDR_FMT1;    /* Err: AC table not loaded */
+        }
+    }
+
+    return JDR_OK;
+}
+
+
+#if CONFIG_JPEG_STREAM_PROGRESSIVE
+
+static const uint8_t ProgKeep[4] = { 64, 25, 5, 1 };   /* Coefficients kept per block for scale 0..3 */
+
+typedef struct {
+    unsigned int keep;      /* Number of coefficients stored per block (zigzag prefix) */
+    unsigned int masked;    /* Each block starts with a 64-bit map of its non-zero coefficients */
+    unsigned int rec;       /* Bytes per block */
+    unsigned int bw[3];     /* Blocks per row of each component (MCU aligned) */
+    uint8_t *base[3];       /* First block of each component */
+    unsigned int eobrun;    /* Remaining end-of-band run */
+} JPROG;
+
+
+static unsigned int prog_rec_size (unsigned int keep)
+{
+    if (keep > 1 && keep < 64) {
+        return (8 + keep * 2 + 3) & ~3;     /* Non-zero map + coefficients, word aligned */
+    }
+    return keep * 2;
+}
+
+
+size_t jdec_coef_size (
+    const JDEC *jd,         /* Prepared decompression object */
+    uint8_t scale           /* Output de-scaling factor (0 to 3) */
+)
+{
+    if (!jd->progressive || scale > 3) {
+        return 0;
+    }
+
+    return (size_t)jdec_mcu_count(jd) * (jd->msx * jd->msy + (jd->ncomp == 3 ? 2 : 0)) * prog_rec_size(ProgKeep[scale]);
+}
+
+
+static uint8_t *prog_block (JPROG *p, unsigned int c, unsigned int bx, unsigned int by)
+{
+    return p->base[c] + ((size_t)by * p->bw[c] + bx) * p->rec;
+}
+
+
+static int16_t *prog_coef (const JPROG *p, uint8_t *blk)
+{
+    return (int16_t *)(blk + (p->masked ? 8 : 0));
+}
+
+
+static int prog_nonzero (const JPROG *p, uint8_t *blk, unsigned int k)
+{
+    if (p->masked) {
+        return (((uint32_t *)blk)[k >> 5] >> (k & 31)) & 1;
+    }
+    return k < p->keep && prog_coef(p, blk)[k] != 0;
+}
+
+
+static void prog_set (const JPROG *p, uint8_t *blk, unsigned int k, int v)
+{
+    if (p->masked) {
+        ((uint32_t *)blk)[k >> 5] |= 1UL << (k & 31);
+    }
+    if (k < p->keep) {
+        prog_coef(p, blk)[k] = (int16_t)v;
+    }
+}
+
+
+/* Extract nbit bits and restore the sign as in the baseline decoder */
+static int prog_extend (
+    JDEC *jd,
+    unsigned int nbit,
+    int *val
+)
+{
+    int d = bitext(jd, nbit);
+
+
+    if (d < 0) {
+        return d;
+    }
+    if (!(d & (1 << (nbit - 1)))) {
+        d -= (1 << nbit) - 1;
+    }
+    *val = d;
+    return 0;
+}
+
+
+/* Read the correction bit of an already non-zero coefficient */
+static JRESULT prog_correct (
+    JDEC *jd,
+    const JPROG *p,
+    uint8_t *blk,
+    unsigned int k
+)
+{
+    int d = bitext(jd, 1), p1 = 1 << jd->al;
+    int16_t *cf;
+
+
+    if (d < 0) {
+        return (JRESULT)(0 - d);
+    }
+    if (d && k < p->keep) {
+        cf = &prog_coef(p, blk)[k];
+        if (!(*cf & p1)) {
+            *cf += *cf >= 0 ? p1 : -p1;
+        }
+    }
+    return JDR_OK;
+}
+
+
+/* Decode one block of the current scan */
+static JRESULT prog_unit (
+    JDEC *jd,
+    JPROG *p,
+    uint8_t *blk,
+    unsigned int c,         /* Component index */
+    unsigned int tbl        /* Huffman table IDs of the component in this scan */
+)
+{
+    unsigned int k, s;
+    int d, r, v;
+    JRESULT rc;
+
+
+    if (jd->ss == 0) {      /* DC scan */
+        if (jd->ah) {       /* Refinement: one bit */
+            d = bitext(jd, 1);
+            if (d < 0) {
+                return (JRESULT)(0 - d);
+            }
+            if (d) {
+                prog_coef(p, blk)[0] |= 1 << jd->al;
+            }
+            return JDR_OK;
+        }
+        d = huffext(jd, tbl >> 4, 0);
+        if (d < 0) {
+            return (JRESULT)(0 - d);
+        }
+        v = 0;
+        if (d && (d = prog_extend(jd, (unsigned int)d, &v)) < 0) {
+            return (JRESULT)(0 - d);
+        }
+        jd->dcv[c] += v;
+        prog_coef(p, blk)[0] = (int16_t)(jd->dcv[c] * (1 << jd->al));
+        return JDR_OK;
+    }
+
+    k = jd->ss;
+    if (!jd->ah) {          /* First AC scan of this band */
+        if (p->eobrun) {
+            p->eobrun--;
+            return JDR_OK;
+        }
+        for ( ; k <= jd->se; k++) {
+            d = huffext(jd, tbl & 15, 1);
+            if (d < 0) {
+                return (JRESULT)(0 - d);
+            }
+            r = d >> 4; s = d & 15;
+            if (s) {
+                k += r;
+                if (k > jd->se) {
+                    return JDR_FMT1;    /* Err: too long zero run */
+                }
+                if ((d = prog_extend(jd, s, &v)) < 0) {
+                    return (JRESULT)(0 - d);
+                }
+                prog_set(p, blk, k, v * (1 << jd->al));
+            } else if (r == 15) {
+                k += 15;    /* 16 zeros */
+            } else {        /* End of band run */
+                p->eobrun = 1U << r;
+                if (r) {
+                    if ((d = bitext(jd, r)) < 0) {
+                        return (JRESULT)(0 - d);
+                    }
+                    p->eobrun += d;
+                }
+                p->eobrun--;
+                break;
+            }
+        }
+        return JDR_OK;
+    }
+
+    /* AC refinement: correction bits for non-zero coefficients, new ones are +-1 << al */
+    if (!p->eobrun) {
+        for ( ; k <= jd->se; k++) {
+            d = huffext(jd, tbl & 15, 1);
+            if (d < 0) {
+                return (JRESULT)(0 - d);
+            }
+            r = d >> 4; s = d & 15;
+            v = 0;
+            if (s) {
+                if (s != 1 || (d = bitext(jd, 1)) < 0) {
+                    return s != 1 ? JDR_FMT1 : (JRESULT)(0 - d);
+                }
+                v = d ? 1 << jd->al : -(1 << jd->al);
+            } else if (r != 15) {   /* End of band run, finished below */
+                p->eobrun = 1U << r;
+                if (r) {
+                    if ((d = bitext(jd, r)) < 0) {
+                        return (JRESULT)(0 - d);
+                    }
+                    p->eobrun += d;
+                }
+                break;
+            }
+            for ( ; k <= jd->se; k++) { /* Skip r zero coefficients, correcting the non-zero ones on the way */
+                if (prog_nonzero(p, blk, k)) {
+                    if ((rc = prog_correct(jd, p, blk, k)) != JDR_OK) {
+                        return rc;
+                    }
+                } else if (--r < 0) {
+                    break;
+                }
+            }
+            if (v) {
+                if (k > jd->se) {
+                    return JDR_FMT1;
+                }
+                prog_set(p, blk, k, v);
+            }
+        }
+    }
+    if (p->eobrun) {        /* Rest of the band is in an end of band run */
+        for ( ; k <= jd->se; k++) {
+            if (prog_nonzero(p, blk, k) && (rc = prog_correct(jd, p, blk, k)) != JDR_OK) {
+                return rc;
+            }
+        }
+        p->eobrun--;
+    }
+
+    return JDR_OK;
+}
+
+
+/* Get a byte from the stream outside of the entropy-coded data (-1: end of stream) */
+static int prog_byte (JDEC *jd)
+{
+    if (!jd->dctr) {
+        jd->dptr = jd->inbuf;
+        jd->dctr = jd->infunc(jd, jd->inbuf, JD_SZBUF);
+        if (!jd->dctr) {
+            return -1;
+        }
+    }
+    jd->dctr--;
+    return *jd->dptr++;
+}
+
+
+static JRESULT prog_read (JDEC *jd, uint8_t *buf, size_t n)
+{
+    int d;
+
+
+    while (n--) {
+        if ((d = prog_byte(jd)) < 0) {
+            return JDR_INP;
+        }
+        if (buf) {
+            *buf++ = (uint8_t)d;
+        }
+    }
+    return JDR_OK;
+}
+
+
+/* Find the marker after the current scan; RSTn and the data of a skipped scan are passed over (-1: end of stream) */
+static int prog_marker (JDEC *jd)
+{
+    int d;
+
+
+    jd->dbit = 0;           /* Discard the padding bits */
+    if (jd->marker) {       /* The bit reader has stopped at it */
+        d = jd->marker;
+        jd->marker = 0;
+        if (d < 0xD0 || d > 0xD7) {
+            return d;
+        }
+    }
+    for (;;) {
+        do {
+            if ((d = prog_byte(jd)) < 0) {
+                return -1;
+            }
+        } while (d != 0xFF);
+        do {
+            if ((d = prog_byte(jd)) < 0) {
+                return -1;
+            }
+        } while (d == 0xFF);
+        if (d && (d < 0xD0 || d > 0xD7)) {
+            return d;
+        }
+    }
+}
+
+
+/* Decode (or skip) the current scan into the coefficient buffer */
+static JRESULT prog_scan (
+    JDEC *jd,
+    JPROG *p
+)
+{
+    unsigned int i, c, n, total, bw, mcux, bx, by;
+    uint16_t rst = 0, rsc = 0;
+    JRESULT rc;
+
+
+    if (jd->ss && p->keep == 1) {
+        return JDR_OK;      /* AC scan at 1/8 (DC only), prog_marker() skips the data */
+    }
+
+    mcux = (jd->width + jd->msx * 8 - 1) / (jd->msx * 8);
+    jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;
+    p->eobrun = 0;
+    if (jd->ns > 1) {       /* Interleaved (DC) scan: MCUs of all scan components */
+        total = jdec_mcu_count(jd);
+        bw = 0;
+    } else {                /* Single component: blocks that cover the component */
+        c = jd->scomp[0];
+        bw = c ? (jd->width + jd->msx - 1) / jd->msx : jd->width;
+        bw = (bw + 7) / 8;
+        n = c ? (jd->height + jd->msy - 1) / jd->msy : jd->height;
+        total = bw * ((n + 7) / 8);
+    }
+
+    for (n = 0; n < total; n++) {
+        if (jd->nrst && rst++ == jd->nrst) {    /* Restart interval (counted in blocks in a single component scan) */
+            rc = restart(jd, rsc++);
+            if (rc != JDR_OK) {
+                return rc;
+            }
+            p->eobrun = 0;
+            rst = 1;
+        }
+        if (jd->ns > 1) {
+            for (i = 0; i < jd->ns; i++) {
+                c = jd->scomp[i];
+                if (c == 0) {
+                    for (by = 0; by < jd->msy; by++) {
+                        for (bx = 0; bx < jd->msx; bx++) {
+                            rc = prog_unit(jd, p, prog_block(p, 0, n % mcux * jd->msx + bx, n / mcux * jd->msy + by), 0, jd->stbl[i]);
+                            if (rc != JDR_OK) {
+                                return rc;
+                            }
+                        }
+                    }
+                } else {
+                    rc = prog_unit(jd, p, prog_block(p, c, n % mcux, n / mcux), c, jd->stbl[i]);
+                    if (rc != JDR_OK) {
+                        return rc;
+                    }
+                }
+            }
+        } else {
+            rc = prog_unit(jd, p, prog_block(p, jd->scomp[0], n % bw, n / bw), jd->scomp[0], jd->stbl[0]);
+            if (rc != JDR_OK) {
+                return rc;
+            }
+        }
+    }
+
+    return JDR_OK;
+}
+
+
+/* Process the segments up to the next SOS (*eoi = 0) or the end of the image (*eoi = 1) */
+static JRESULT prog_segments (
+    JDEC *jd,
+    int *eoi
+)
+{
+    uint8_t seg[17 + 256];  /* One DHT table, DQT table or SOS */
+    unsigned int i, np;
+    size_t len;
+    int m;
+    JRESULT rc;
+
+
+    for (;;) {
+        m = prog_marker(jd);
+        if (m < 0 || m == 0xD9) {   /* EOI, or a truncated file: output what has arrived */
+            *eoi = 1;
+            return JDR_OK;
+        }
+        if ((rc = prog_read(jd, seg, 2)) != JDR_OK) {
+            return rc;
+        }
+        len = LDB_WORD(seg);
+        if (len < 2) {
+            return JDR_FMT1;
+        }
+        len -= 2;
+
+        switch (m) {
+        case 0xDA:  /* SOS */
+            if (len > 16 || (rc = prog_read(jd, seg, len)) != JDR_OK) {
+                return len > 16 ? JDR_FMT1 : rc;
+            }
+            *eoi = 0;
+            return prog_scan_header(jd, seg, len);
+
+        case 0xC4:  /* DHT: new tables for the next scan */
+            while (len) {
+                if (len < 17 || (rc = prog_read(jd, seg, 17)) != JDR_OK) {
+                    return len < 17 ? JDR_FMT1 : rc;
+                }
+                for (np = 0, i = 1; i < 17; i++) {
+                    np += seg[i];
+                }
+                if (np > 256 || len < 17 + np) {
+                    return JDR_FMT1;
+                }
+                if ((rc = prog_read(jd, seg + 17, np)) != JDR_OK ||
+                        (rc = create_huffman_tbl(jd, seg, 17 + np)) != JDR_OK) {
+                    return rc;
+                }
+                len -= 17 + np;
+            }
+            break;
+
+        case 0xDB:  /* DQT */
+            while (len) {
+                if (len < 65 || (rc = prog_read(jd, seg, 65)) != JDR_OK) {
+                    return len < 65 ? JDR_FMT1 : rc;
+                }
+                if ((rc = create_qt_tbl(jd, seg, 65)) != JDR_OK) {
+                    return rc;
+                }
+                len -= 65;
+            }
+            break;
+
+        case 0xDD:  /* DRI */
+            if (len != 2 || (rc = prog_read(jd, seg, 2)) != JDR_OK) {
+                return len != 2 ? JDR_FMT1 : rc;
+            }
+            jd->nrst = LDB_WORD(seg);
+            break;
+
+        default:    /* APPn, COM etc. */
+            if ((rc = prog_read(jd, 0, len)) != JDR_OK) {
+                return rc;
+            }
+        }
+    }
+}
+
+
+/* Dequantize and transform the coefficients of one MCU into the MCU buffer */
+static JRESULT prog_mcu_load (
+    JDEC *jd,
+    JPROG *p,
+    unsigned int mx,        /* MCU column */
+    unsigned int my         /* MCU row */
+)
+{
+    int32_t *tmp = (int32_t *)jd->workbuf;
+    unsigned int blk, nby, cmp, i, k, ac;
+    const int16_t *cf;
+    const int32_t *dqf;
+    jd_yuv_t *bp = jd->mcubuf;
+    int d;
+
+
+    nby = jd->msx * jd->msy;
+    for (blk = 0; blk < nby + 2; blk++, bp += 64) {
+        cmp = (blk < nby) ? 0 : blk - nby + 1;
+        if (cmp && jd->ncomp != 3) {        /* Monochrome image */
+            for (i = 0; i < 64; bp[i++] = 128) ;
+            continue;
+        }
+        if (cmp) {
+            cf = prog_coef(p, prog_block(p, cmp, mx, my));
+        } else {
+            cf = prog_coef(p, prog_block(p, 0, mx * jd->msx + blk % jd->msx, my * jd->msy + blk / jd->msx));
+        }
+        dqf = jd->qttbl[jd->qtid[cmp]];
+        if (!dqf) {
+            return JDR_FMT1;    /* Err: dequantizer table not loaded */
+        }
+
+        tmp[0] = cf[0] * dqf[0] >> 8;
+        memset(&tmp[1], 0, 63 * sizeof (int32_t));
+        for (ac = 0, k = 1; k < p->keep; k++) {
+            if (cf[k]) {
+                i = Zig[k];
+                tmp[i] = cf[k] * dqf[i] >> 8;
+                ac = 1;
+            }
+        }
+        if (!ac || jd->scale == 3) {        /* Block filled with the DC value, as in mcu_load() */
+            d = (jd_yuv_t)((*tmp / 256) + 128);
+            for (i = 0; i < 64; bp[i++] = d) ;
+        } else {
+            JDEC_IDCT(tmp, bp);
+        }
+    }
+
+    return JDR_OK;
+}
+
+
+static JRESULT prog_decomp (
+    JDEC *jd,
+    int (*outfunc)(JDEC *, void *, JRECT *),
+    uint8_t scale
+)
+{
+    JPROG p;
+    unsigned int mx, my, mcux, mcuy, scans;
+    int eoi;
+    JRESULT rc;
+
+
+    if (scale > 3) {
+        return JDR_PAR;
+    }
+    if (!jd->coef) {
+        return JDR_MEM1;    /* Err: no coefficient buffer given */
+    }
+    jd->scale = scale;
+
+    mcux = (jd->width + jd->msx * 8 - 1) / (jd->msx * 8);
+    mcuy = (jd->height + jd->msy * 8 - 1) / (jd->msy * 8);
+    p.keep = ProgKeep[scale];
+    p.masked = p.keep > 1 && p.keep < 64;
+    p.rec = prog_rec_size(p.keep);
+    p.bw[0] = mcux * jd->msx;
+    p.bw[1] = p.bw[2] = mcux;
+    p.base[0] = (uint8_t *)jd->coef;
+    p.base[1] = p.base[0] + (size_t)p.bw[0] * mcuy * jd->msy * p.rec;
+    p.base[2] = p.base[1] + (size_t)mcux * mcuy * p.rec;
+    memset(jd->coef, 0, jdec_coef_size(jd, scale));
+
+    for (scans = 1; ; scans++) {
+        rc = prog_scan(jd, &p);
+        if (rc == JDR_INP && scans > 1) {
+            break;          /* Truncated in a later scan: show the coarser image */
+        }
+        if (rc != JDR_OK) {
+            return rc;
+        }
+        rc = prog_segments(jd, &eoi);
+        if (rc != JDR_OK) {
+            return rc;
+        }
+        if (eoi) {
+            break;
+        }
+    }
+
+    for (my = 0; my < mcuy; my++) {
+        for (mx = 0; mx < mcux; mx++) {
+            rc = prog_mcu_load(jd, &p, mx, my);
+            if (rc == JDR_OK) {
+                rc = mcu_output(jd, outfunc, mx * jd->msx * 8, my * jd->msy * 8);
+            }
+            if (rc != JDR_OK) {
+                return rc;
+            }
+        }
+    }
+
+    return JDR_OK;
+}
+
+#else
+
+size_t jdec_coef_size (const JDEC *jd, uint8_t scale)
+{
+    (void)jd; (void)scale;
+    return 0;
+}
+
+#endif
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Analyze the JPEG image and Initialize decompressor object             */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jdec_prepare (
+    JDEC *jd,               /* Blank decompressor object */
+    size_t (*infunc)(JDEC *, uint8_t *, size_t), /* JPEG strem input function */
+    void *pool,             /* Working buffer for the decompression session */
+    size_t sz_pool,         /* Size of working buffer */
+    void *dev               /* I/O device identifier for the session */
+)
+{
+    uint8_t *seg, b;
+    uint16_t marker;
+    unsigned int n, i, ofs;
+    size_t len;
+    JRESULT rc;
+
+
+    memset(jd, 0, sizeof (JDEC));   /* Clear decompression object (this might be a problem if machine's null pointer is not all bits zero) */
+    jd->pool = pool;        /* Work memroy */
+    jd->sz_pool = sz_pool;  /* Size of given work memory */
+    jd->infunc = infunc;    /* Stream input function */
+    jd->device = dev;       /* I/O device identifier */
+
+    jd->inbuf = seg = alloc_pool(jd, JD_SZBUF);     /* Allocate stream input buffer */
+    if (!seg) {
+        return JDR_MEM1;
+    }
+
+    ofs = marker = 0;       /* Find SOI marker */
+    do {
+        if (jd->infunc(jd, seg, 1) != 1) {
+            return JDR_INP;    /* Err: SOI was not detected */
+        }
+        ofs++;
+        marker = marker << 8 | seg[0];
+    } while (marker != 0xFFD8);
+
+    for (;;) {              /* Parse JPEG segments */
+        /* Get a JPEG marker */
+        if (jd->infunc(jd, seg, 4) != 4) {
+            return JDR_INP;
+        }
+        marker = LDB_WORD(seg);     /* Marker */
+        len = LDB_WORD(seg + 2);    /* Length field */
+
+        /*
+        In the baseline JPEG specification, 0xFF is always used as the "marker prefix," and the byte that follows determines
+        the marker type (e.g., 0xD8 for SOI, 0xD9 for EOI, 0xDA for SOS, etc.).
+        A 0xFFFF sequence, however, does not correspond to any valid, standard JPEG marker.
+
+        In JPEG-compressed data, any single 0xFF in the entropy-coded segment is supposed to be followed by 0x00 if it is not a marker.
+        Sometimes, encoders or hardware incorrectly insert repeated 0xFF bytes without the 0x00 "stuffing" byte.
+        This confuses decoders that strictly follow the JPEG standard.
+        */
+        if (marker == 0xFFFF) {
+            // Check if ignoring seg[0] byte gives us valid marker
+            // We must read 1 more byte from the input stream
+            if (jd->infunc(jd, &seg[4], 1) != 1) {
+                return JDR_INP;
+            }
+            marker = LDB_WORD(seg + 1);
+            len = LDB_WORD(seg + 3);
+        }
+        if (len <= 2 || (marker >> 8) != 0xFF) {
+            return JDR_FMT1;
+        }
+        len -= 2;           /* Segent content size */
+        ofs += 4 + len;     /* Number of bytes loaded */
+
+        switch (marker & 0xFF) {
+        case 0xC0:  /* SOF0 (baseline JPEG) */
+#if CONFIG_JPEG_STREAM_PROGRESSIVE
+        case 0xC2:  /* SOF2 (progressive JPEG, huffman coded) */
+#endif
+            jd->progressive = (marker & 0xFF) == 0xC2;
+            if (len > JD_SZBUF) {
+                return JDR_MEM2;
+            }
+            if (jd->infunc(jd, seg, len) != len) {
+                return JDR_INP;    /* Load segment data */
+            }
+
+            jd->width = LDB_WORD(&seg[3]);      /* Image width in unit of pixel */
+            jd->height = LDB_WORD(&seg[1]);     /* Image height in unit of pixel */
+            jd->ncomp = seg[5];                 /* Number of color components */
+            if (jd->ncomp != 3 && jd->ncomp != 1) {
+                return JDR_FMT3;    /* Err: Supports only Grayscale and Y/Cb/Cr */
+            }
+
+            /* Check each image component */
+            for (i = 0; i < jd->ncomp; i++) {
+                b = seg[7 + 3 * i];                         /* Get sampling factor */
+                if (i == 0) {   /* Y component */
+                    if (b != 0x11 && b != 0x22 && b != 0x21) {  /* Check sampling factor */
+                        return JDR_FMT3;                    /* Err: Supports only 4:4:4, 4:2:0 or 4:2:2 */
+                    }
+                    jd->msx = b >> 4; jd->msy = b & 15;     /* Size of MCU [blocks] */
+                } else {        /* Cb/Cr component */
+                    if (b != 0x11) {
+                        return JDR_FMT3;    /* Err: Sampling factor of Cb/Cr must be 1 */
+                    }
+                }
+                jd->cid[i] = seg[6 + 3 * i];                /* Get component identifier */
+                jd->qtid[i] = seg[8 + 3 * i];               /* Get dequantizer table ID for this component */
+                if (jd->qtid[i] > 3) {
+                    return JDR_FMT3;    /* Err: Invalid ID */
+                }
+            }
+            break;
+
+        case 0xDD:  /* DRI - Define Restart Interval */
+            if (len > JD_SZBUF) {
+                return JDR_MEM2;
+            }
+            if (jd->infunc(jd, seg, len) != len) {
+                return JDR_INP;    /* Load segment data */
+            }
+
+            jd->nrst = LDB_WORD(seg);   /* Get restart interval (MCUs) */
+            break;
+
+        case 0xC4:  /* DHT - Define Huffman Tables */
+            if (len > JD_SZBUF) {
+                return JDR_MEM2;
+            }
+            if (jd->infunc(jd, seg, len) != len) {
+                return JDR_INP;    /* Load segment data */
+            }
+
+            rc = create_huffman_tbl(jd, seg, len);  /* Create huffman tables */
+            if (rc) {
+                return rc;
+            }
+            break;
+
+        case 0xDB:  /* DQT - Define Quaitizer Tables */
+            if (len > JD_SZBUF) {
+                return JDR_MEM2;
+            }
+            if (jd->infunc(jd, seg, len) != len) {
+                return JDR_INP;    /* Load segment data */
+            }
+
+            rc = create_qt_tbl(jd, seg, len);   /* Create de-quantizer tables */
+            if (rc) {
+                return rc;
+            }
+            break;
+
+        case 0xDA:  /* SOS - Start of Scan */
+            if (len > JD_SZBUF) {
+                return JDR_MEM2;
+            }
+            if (jd->infunc(jd, seg, len) != len) {
+                return JDR_INP;    /* Load segment data */
+            }
+
+            if (!jd->width || !jd->height) {
+                return JDR_FMT1;    /* Err: Invalid image size */
+            }
+            if (jd->progressive) {  /* First scan of a progressive image, tables are checked per scan */
+                rc = prog_scan_header(jd, seg, len);
+                if (rc) {
+                    return rc;
+                }
+            } else if (seg[0] != jd->ncomp) {
+                return JDR_FMT3;    /* Err: Wrong color components */
+            }
+
+            /* Check if all tables corresponding to each components have been loaded */
+            for (i = 0; i < jd->ncomp && !jd->progressive; i++) {
+                b = seg[2 + 2 * i]; /* Get huffman table ID */
+                if (b != 0x00 && b != 0x11) {
+                    return JDR_FMT3;    /* Err: Different table number for DC/AC element */
+                }
+                n = i ? 1 : 0;                          /* Component class */
+                if (!jd->huffbits[n][0] || !jd->huffbits[n][1]) {   /* Check huffman table for this component */
+                    return JDR_FMT1;                    /* Err: Nnot loaded */
+                }
+                if (!jd->qttbl[jd->qtid[i]]) {          /* Check dequantizer table for this component */
+                    return JDR_FMT1;                    /* Err: Not loaded */
+                }
+            }
+
+            /* Allocate working buffer for MCU and pixel output */
+            n = jd->msy * jd->msx;                      /* Number of Y blocks in the MCU */
+            if (!n) {
+                return JDR_FMT1;    /* Err: SOF0 has not been loaded */
+            }
+            len = n * 64 * 2 + 64;                      /* Allocate buffer for IDCT and RGB output */
+            if (len < 256) {
+                len = 256;    /* but at least 256 byte is required for IDCT */
+            }
+            jd->workbuf = alloc_pool(jd, len);          /* and it may occupy a part of following MCU working buffer for RGB output */
+            if (!jd->workbuf) {
+                return JDR_MEM1;    /* Err: not enough memory */
+            }
+            jd->mcubuf = alloc_pool(jd, (n + 2) * 64 * sizeof (jd_yuv_t));  /* Allocate MCU working buffer */
+            if (!jd->mcubuf) {
+                return JDR_MEM1;    /* Err: not enough memory */
+            }
+
+            /* Align stream read offset to JD_SZBUF */
+            if (ofs %= JD_SZBUF) {
+                jd->dctr = jd->infunc(jd, seg + ofs, (size_t)(JD_SZBUF - ofs));
+            }
+            jd->dptr = seg + ofs;
+
+            return JDR_OK;      /* Initialization succeeded. Ready to decompress the JPEG image. */
+
+        case 0xC1:  /* SOF1 */
+#if !CONFIG_JPEG_STREAM_PROGRESSIVE
+        case 0xC2:  /* SOF2 */
+#endif
+        case 0xC3:  /* SOF3 */
+        case 0xC5:  /* SOF5 */
+        case 0xC6:  /* SOF6 */
+        case 0xC7:  /* SOF7 */
+        case 0xC9:  /* SOF9 */
+        case 0xCA:  /* SOF10 */
+        case 0xCB:  /* SOF11 */
+        case 0xCD:  /* SOF13 */
+        case 0xCE:  /* SOF14 */
+        case 0xCF:  /* SOF15 */
+        case 0xD9:  /* EOI */
+            return JDR_FMT3;    /* Unsuppoted JPEG standard (extended, lossless or arithmetic coded) */
+
+        default:    /* Unknown segment (comment, exif or etc..) */
+            /* Skip segment data (null pointer specifies to remove data from the stream) */
+            if (jd->infunc(jd, 0, len) != len) {
+                return JDR_INP;
+            }
+        }
+    }
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Start to decompress the JPEG picture                                  */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jdec_decomp (
+    JDEC *jd,                               /* Initialized decompression object */
+    int (*outfunc)(JDEC *, void *, JRECT *), /* RGB output function */
+    uint8_t scale                           /* Output de-scaling factor (0 to 3) */
+)
+{
+#if CONFIG_JPEG_STREAM_PROGRESSIVE
+    if (jd->progressive) {
+        return prog_decomp(jd, outfunc, scale);
+    }
+#endif
+    return jdec_decomp_range(jd, outfunc, scale, 0, jdec_mcu_count(jd));
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Decompress a run of MCUs (fork addition)                              */
+/*-----------------------------------------------------------------------*/
+
+uint32_t jdec_mcu_count (
+    const JDEC *jd          /* Prepared decompression object */
+)
+{
+    unsigned int mx = jd->msx * 8, my = jd->msy * 8;
+
+
+    return ((jd->width + mx - 1) / mx) * ((jd->height + my - 1) / my);
+}
+
+
+static JRESULT decomp_run (
+    JDEC *jd,                               /* Decompression object positioned at jd->mcunext */
+    int (*outfunc)(JDEC *, void *, JRECT *), /* RGB output function */
+    uint32_t end                            /* MCU to stop before */
+)
+{
+    unsigned int mx, my, mcux;
+    JRESULT rc;
+
+
+    mx = jd->msx * 8; my = jd->msy * 8;         /* Size of the MCU (pixel) */
+    mcux = (jd->width + mx - 1) / mx;           /* MCUs per row */
+
+    rc = JDR_OK;
+    while (jd->mcunext < end) {
+        if (jd->nrst && jd->rst++ == jd->nrst) {    /* Process restart interval if enabled */
+            rc = restart(jd, jd->rsc++);
+            if (rc != JDR_OK) {
+                return rc;
+            }
+            jd->rst = 1;
+        }
+        rc = mcu_load(jd);                      /* Load an MCU (decompress huffman coded stream, dequantize and apply IDCT) */
+        if (rc != JDR_OK) {
+            return rc;
+        }
+        rc = mcu_output(jd, outfunc, (jd->mcunext % mcux) * mx, (jd->mcunext / mcux) * my);  /* Output the MCU (YCbCr to RGB, scaling and output) */
+        if (rc != JDR_OK) {
+            return rc;
+        }
+        jd->mcunext++;
+    }
+
+    return rc;
+}
+
+
+JRESULT jdec_decomp_range (
+    JDEC *jd,                               /* Initialized decompression object */
+    int (*outfunc)(JDEC *, void *, JRECT *), /* RGB output function */
+    uint8_t scale,                          /* Output de-scaling factor (0 to 3) */
+    uint32_t first,                         /* First MCU, a restart interval boundary unless 0 */
+    uint32_t count                          /* Number of MCUs to decode */
+)
+{
+    if (scale > 3) {
+        return JDR_PAR;
+    }
+    if (jd->progressive || (first && (!jd->nrst || first % jd->nrst))) {
+        return JDR_PAR;     /* Entropy data can only be entered at a restart marker */
+    }
+    jd->scale = scale;
+
+    jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;   /* Initialize DC values */
+    jd->mcunext = first;
+    jd->rst = 0;
+    jd->rsc = jd->nrst ? first / jd->nrst : 0;  /* Next RSTn follows the current interval */
+
+    return decomp_run(jd, outfunc, first + count);
+}
+
+
+JRESULT jdec_decomp_resume (
+    JDEC *jd,                               /* Object stopped by jdec_decomp_range/resume */
+    int (*outfunc)(JDEC *, void *, JRECT *), /* RGB output function */
+    uint32_t count                          /* Number of MCUs to decode */
+)
+{
+    if (jd->progressive || jd->mcunext + count > jdec_mcu_count(jd)) {
+        return JDR_PAR;
+    }
+
+    return decomp_run(jd, outfunc, jd->mcunext + count);
+}
+
+
+JRESULT jdec_clone (
+    JDEC *jd,               /* Blank decompressor object */
+    const JDEC *src,        /* Prepared object to share the tables with */
+    size_t (*infunc)(JDEC *, uint8_t *, size_t), /* Input function, positioned at entropy data */
+    void *pool,             /* Working buffer for the stream and MCU buffers */
+    size_t sz_pool,         /* Size of working buffer */
+    void *dev               /* I/O device identifier for the session */
+)
+{
+    unsigned int n;
+    size_t len;
+
+
+    *jd = *src;             /* Tables, image geometry and output format */
+    jd->pool = pool;
+    jd->sz_pool = sz_pool;
+    jd->infunc = infunc;
+    jd->device = dev;
+    jd->dctr = 0;           /* Empty bit stream */
+    jd->dbit = 0;
+    jd->wreg = 0;
+    jd->marker = 0;
+
+    n = jd->msy * jd->msx;
+    len = n * 64 * 2 + 64;
+    if (len < 256) {
+        len = 256;
+    }
+    jd->inbuf = alloc_pool(jd, JD_SZBUF);
+    jd->workbuf = alloc_pool(jd, len);
+    jd->mcubuf = alloc_pool(jd, (n + 2) * 64 * sizeof (jd_yuv_t));
+    if (!jd->inbuf || !jd->workbuf || !jd->mcubuf) {
+        return JDR_MEM1;
+    }
+    jd->dptr = jd->inbuf;
+
+    return JDR_OK;
+}
@@ -0,0 +1,139 @@
+/*----------------------------------------------------------------------------/
+/ TJpgDec - Tiny JPEG Decompressor R0.03 include file         (C)ChaN, 2021
+/-----------------------------------------------------------------------------/
+/ jpeg_stream fork: 32-bit bit reader only, output format selected per decode
+/ and IDCT / colour conversion moved to jdec_kernels.c. Public functions are
+/ renamed (jdec_*) so they do not clash with the TJpgDec copies in ROM/LVGL.
+/----------------------------------------------------------------------------*/
+#ifndef JDEC_H
+#define JDEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#define JD_SZBUF    512     /* Size of stream input buffer */
+
+/* Huffman codes up to this many bits are decoded with one table lookup (0: bit-serial search only) */
+#ifdef CONFIG_JPEG_STREAM_HUFF_LUT_BITS
+#define JDEC_HUFF_LUT_BITS  CONFIG_JPEG_STREAM_HUFF_LUT_BITS
+#else
+#define JDEC_HUFF_LUT_BITS  0
+#endif
+/* Extra pool the lookup tables take (four tables, 2 bytes per entry) */
+#define JDEC_HUFF_LUT_POOL  (JDEC_HUFF_LUT_BITS ? 4 * (2U << JDEC_HUFF_LUT_BITS) : 0)
+
+/* Work pool for jdec_prepare(): input buffer, tables and one MCU, independent of the image size */
+#define JDEC_WORK_POOL      (4800 + JDEC_HUFF_LUT_POOL)
+
+typedef int16_t jd_yuv_t;
+
+
+/* Error code */
+typedef enum {
+    JDR_OK = 0, /* 0: Succeeded */
+    JDR_INTR,   /* 1: Interrupted by output function */
+    JDR_INP,    /* 2: Device error or wrong termination of input stream */
+    JDR_MEM1,   /* 3: Insufficient memory pool for the image */
+    JDR_MEM2,   /* 4: Insufficient stream input buffer */
+    JDR_PAR,    /* 5: Parameter error */
+    JDR_FMT1,   /* 6: Data format error (may be broken data) */
+    JDR_FMT2,   /* 7: Right format but not supported */
+    JDR_FMT3    /* 8: Not supported JPEG standard */
+} JRESULT;
+
+
+/* Output pixel format */
+typedef enum {
+    JDEC_RGB888 = 0,    /* 3 bytes per pixel, R first */
+    JDEC_RGB565,        /* Native (little-endian) RGB565 */
+    JDEC_RGB565_SWAP,   /* Byte-swapped RGB565, as SPI panels expect it */
+} jdec_format_t;
+
+
+/* Rectangular region in the output image */
+typedef struct {
+    uint16_t left;      /* Left end */
+    uint16_t right;     /* Right end */
+    uint16_t top;       /* Top end */
+    uint16_t bottom;    /* Bottom end */
+} JRECT;
+
+
+/* Decompressor object structure */
+typedef struct JDEC JDEC;
+struct JDEC {
+    size_t dctr;                /* Number of bytes available in the input buffer */
+    uint8_t *dptr;              /* Current data read ptr */
+    uint8_t *inbuf;             /* Bit stream input buffer */
+    uint8_t dbit;               /* Number of bits availavble in wreg */
+    uint8_t scale;              /* Output scaling ratio */
+    uint8_t format;             /* Output pixel format (jdec_format_t) */
+    uint8_t msx, msy;           /* MCU size in unit of block (width, height) */
+    uint8_t qtid[3];            /* Quantization table ID of each component, Y, Cb, Cr */
+    uint8_t ncomp;              /* Number of color components 1:grayscale, 3:color */
+    int16_t dcv[3];             /* Previous DC element of each component */
+    uint16_t nrst;              /* Restart inverval */
+    uint16_t width, height;     /* Size of the input image (pixel) */
+    uint8_t progressive;        /* SOF2: coefficients are collected over several scans */
+    uint8_t cid[3];             /* Component identifiers (SOF) */
+    uint8_t ns;                 /* Current scan: number of components */
+    uint8_t scomp[3];           /* Current scan: component index of each scan component */
+    uint8_t stbl[3];            /* Current scan: DC/AC huffman table IDs (Td << 4 | Ta) */
+    uint8_t ss, se, ah, al;     /* Current scan: spectral selection and successive approximation */
+    void *coef;                 /* Coefficient buffer of a progressive image (jdec_coef_size() bytes) */
+    uint32_t mcunext;           /* Next MCU of the current jdec_decomp_range() run */
+    uint16_t rst, rsc;          /* MCUs since the last RSTn, index of the next RSTn */
+    uint8_t *huffbits[2][2];    /* Huffman bit distribution tables [id][dcac] */
+    uint16_t huffcap[2][2];     /* Capacity of the code/data tables, reused when a table is redefined */
+    uint16_t *hufflut[2][2];    /* Short code lookup tables [id][dcac]: code length << 8 | data, 0 = longer code */
+    uint16_t huffshort[2][2];   /* Number of codes the lookup table resolves */
+    uint16_t *huffcode[2][2];   /* Huffman code word tables [id][dcac] */
+    uint8_t *huffdata[2][2];    /* Huffman decoded data tables [id][dcac] */
+    int32_t *qttbl[4];          /* Dequantizer tables [id] */
+    uint32_t wreg;              /* Working shift register */
+    uint8_t marker;             /* Detected marker (0:None) */
+    void *workbuf;              /* Working buffer for IDCT and RGB output */
+    jd_yuv_t *mcubuf;           /* Working buffer for the MCU */
+    void *pool;                 /* Pointer to available memory pool */
+    size_t sz_pool;             /* Size of momory pool (bytes available) */
+    size_t (*infunc)(JDEC *, uint8_t *, size_t); /* Pointer to jpeg stream input function */
+    void *device;               /* Pointer to I/O device identifiler for the session */
+};
+
+
+/* Decompressor API functions */
+JRESULT jdec_prepare (JDEC *jd, size_t (*infunc)(JDEC *, uint8_t *, size_t), void *pool, size_t sz_pool, void *dev);
+JRESULT jdec_decomp (JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *), uint8_t scale);
+
+/* Restart-interval slicing (fork addition)
+ * jdec_clone() makes a second decoder that shares the tables of a prepared one
+ * and reads from its own input function, positioned just after an RSTn marker.
+ * jdec_decomp_range() decodes MCUs [first, first + count) in raster order;
+ * first must be a multiple of nrst. jdec_decomp_resume() carries on with the
+ * next count MCUs after a completed range, so an image can be decoded a band
+ * at a time. */
+#define JDEC_CLONE_POOL     (JD_SZBUF + (4 * 64 * 2 + 64) + 6 * 64 * sizeof(jd_yuv_t))  /* Worst case, 4:2:0 */
+uint32_t jdec_mcu_count (const JDEC *jd);
+JRESULT jdec_decomp_range (JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *), uint8_t scale, uint32_t first, uint32_t count);
+JRESULT jdec_decomp_resume (JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *), uint32_t count);
+JRESULT jdec_clone (JDEC *jd, const JDEC *src, size_t (*infunc)(JDEC *, uint8_t *, size_t), void *pool, size_t sz_pool, void *dev);
+
+/* Progressive JPEG (fork addition, CONFIG_JPEG_STREAM_PROGRESSIVE)
+ * jdec_prepare() accepts SOF2 and sets jd->progressive. Before jdec_decomp() the
+ * caller sets jd->coef to a buffer of jdec_coef_size() bytes (PSRAM is fine).
+ * Only the coefficients the scaled output needs are kept, so the buffer shrinks
+ * with the scale: 128, 60, 20 and 2 bytes per 8x8 block for 1/1 to 1/8. */
+size_t jdec_coef_size (const JDEC *jd, uint8_t scale);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JDEC_H */
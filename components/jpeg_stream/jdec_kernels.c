@@ -0,0 +1,397 @@
+/*
+ * JPEG decoder kernels
+ * IDCT and YCbCr -> RGB conversion used by jdec.c
+ */
+
+#include "jdec_kernels.h"
+
+/* Fixed point colour conversion factors of TJpgDec (CVACC = 1024) */
+#define CVACC       1024
+#define CV_CR_R     ((int)(1.402 * CVACC))
+#define CV_CB_G     ((int)(0.344 * CVACC))
+#define CV_CR_G     ((int)(0.714 * CVACC))
+#define CV_CB_B     ((int)(1.772 * CVACC))
+
+/* Arai IDCT multipliers (x4096) */
+#define M13     ((int32_t)(1.41421 * 4096))
+#define M2      ((int32_t)(1.08239 * 4096))
+#define M4      ((int32_t)(2.61313 * 4096))
+#define M5      ((int32_t)(1.84776 * 4096))
+
+const uint8_t jdec_clip8_tbl[1024] = {
+    /* 0..255 */
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63,
+    64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95,
+    96, 97, 98, 99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127,
+    128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157, 158, 159,
+    160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191,
+    192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223,
+    224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 254, 255,
+    /* 256..511 */
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    /* -512..-257 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* -256..-1 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static inline uint16_t jdec_pack565(unsigned int r, unsigned int g, unsigned int b)
+{
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+/*-----------------------------------------------------------------------*/
+/* Reference kernels: TJpgDec R0.03 arithmetic, one value at a time      */
+/*-----------------------------------------------------------------------*/
+
+void jdec_idct_ref(int32_t *src, jd_yuv_t *dst)
+{
+    int32_t v0, v1, v2, v3, v4, v5, v6, v7;
+    int32_t t10, t11, t12, t13;
+    int i;
+
+    /* Process columns */
+    for (i = 0; i < 8; i++) {
+        v0 = src[8 * 0];    /* Get even elements */
+        v1 = src[8 * 2];
+        v2 = src[8 * 4];
+        v3 = src[8 * 6];
+
+        t10 = v0 + v2;      /* Process the even elements */
+        t12 = v0 - v2;
+        t11 = (v1 - v3) * M13 >> 12;
+        v3 += v1;
+        t11 -= v3;
+        v0 = t10 + v3;
+        v3 = t10 - v3;
+        v1 = t11 + t12;
+        v2 = t12 - t11;
+
+        v4 = src[8 * 7];    /* Get odd elements */
+        v5 = src[8 * 1];
+        v6 = src[8 * 5];
+        v7 = src[8 * 3];
+
+        t10 = v5 - v4;      /* Process the odd elements */
+        t11 = v5 + v4;
+        t12 = v6 - v7;
+        v7 += v6;
+        v5 = (t11 - v7) * M13 >> 12;
+        v7 += t11;
+        t13 = (t10 + t12) * M5 >> 12;
+        v4 = t13 - (t10 * M2 >> 12);
+        v6 = t13 - (t12 * M4 >> 12) - v7;
+        v5 -= v6;
+        v4 -= v5;
+
+        src[8 * 0] = v0 + v7;   /* Write-back transformed values */
+        src[8 * 7] = v0 - v7;
+        src[8 * 1] = v1 + v6;
+        src[8 * 6] = v1 - v6;
+        src[8 * 2] = v2 + v5;
+        src[8 * 5] = v2 - v5;
+        src[8 * 3] = v3 + v4;
+        src[8 * 4] = v3 - v4;
+
+        src++;  /* Next column */
+    }
+
+    /* Process rows */
+    src -= 8;
+    for (i = 0; i < 8; i++) {
+        v0 = src[0] + (128L << 8);  /* Get even elements (remove DC offset (-128) here) */
+        v1 = src[2];
+        v2 = src[4];
+        v3 = src[6];
+
+        t10 = v0 + v2;              /* Process the even elements */
+        t12 = v0 - v2;
+        t11 = (v1 - v3) * M13 >> 12;
+        v3 += v1;
+        t11 -= v3;
+        v0 = t10 + v3;
+        v3 = t10 - v3;
+        v1 = t11 + t12;
+        v2 = t12 - t11;
+
+        v4 = src[7];                /* Get odd elements */
+        v5 = src[1];
+        v6 = src[5];
+        v7 = src[3];
+
+        t10 = v5 - v4;              /* Process the odd elements */
+        t11 = v5 + v4;
+        t12 = v6 - v7;
+        v7 += v6;
+        v5 = (t11 - v7) * M13 >> 12;
+        v7 += t11;
+        t13 = (t10 + t12) * M5 >> 12;
+        v4 = t13 - (t10 * M2 >> 12);
+        v6 = t13 - (t12 * M4 >> 12) - v7;
+        v5 -= v6;
+        v4 -= v5;
+
+        /* Descale the transformed values 8 bits and output a row */
+        dst[0] = (int16_t)((v0 + v7) >> 8);
+        dst[7] = (int16_t)((v0 - v7) >> 8);
+        dst[1] = (int16_t)((v1 + v6) >> 8);
+        dst[6] = (int16_t)((v1 - v6) >> 8);
+        dst[2] = (int16_t)((v2 + v5) >> 8);
+        dst[5] = (int16_t)((v2 - v5) >> 8);
+        dst[3] = (int16_t)((v3 + v4) >> 8);
+        dst[4] = (int16_t)((v3 - v4) >> 8);
+
+        dst += 8; src += 8; /* Next row */
+    }
+}
+
+/* Walk the MCU in output order and call PIXEL(yy, cb, cr) for every pixel */
+#define JDEC_MCU_FOREACH(mcu, msx, msy, PIXEL) do {                 \
+    unsigned int mx = (msx) * 8, my = (msy) * 8, ix, iy;            \
+    const jd_yuv_t *py, *pc;                                        \
+    for (iy = 0; iy < my; iy++) {                                   \
+        pc = py = (mcu);                                            \
+        if (my == 16) {             /* Double block height? */      \
+            pc += 64 * 4 + (iy >> 1) * 8;                           \
+            if (iy >= 8) {                                          \
+                py += 64;                                           \
+            }                                                       \
+        } else {                    /* Single block height */       \
+            pc += mx * 8 + iy * 8;                                  \
+        }                                                           \
+        py += iy * 8;                                               \
+        for (ix = 0; ix < mx; ix++) {                               \
+            int cb = pc[0] - 128;   /* Get Cb/Cr, remove offset */  \
+            int cr = pc[64] - 128;                                  \
+            if (mx == 16) {         /* Double block width? */       \
+                if (ix == 8) {                                      \
+                    py += 64 - 8;   /* Jump to next block */        \
+                }                                                   \
+                if (ix % 2) {       /* Chroma every two pixels */   \
+                    pc++;                                           \
+                }                                                   \
+            } else {                                                \
+                pc++;                                               \
+            }                                                       \
+            int yy = *py++;                                         \
+            PIXEL(yy, cb, cr);                                      \
+        }                                                           \
+    }                                                               \
+} while (0)
+
+void jdec_mcu_rgb888_ref(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint8_t *out)
+{
+#define JDEC_PIXEL_888(yy, cb, cr) do {                                     \
+        *out++ = /*R*/ JDEC_CLIP8(yy + (CV_CR_R * cr) / CVACC);             \
+        *out++ = /*G*/ JDEC_CLIP8(yy - (CV_CB_G * cb + CV_CR_G * cr) / CVACC); \
+        *out++ = /*B*/ JDEC_CLIP8(yy + (CV_CB_B * cb) / CVACC);             \
+    } while (0)
+    JDEC_MCU_FOREACH(mcu, msx, msy, JDEC_PIXEL_888);
+#undef JDEC_PIXEL_888
+}
+
+void jdec_mcu_rgb565_ref(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint16_t *out, bool swap)
+{
+#define JDEC_PIXEL_565(yy, cb, cr) do {                                     \
+        uint16_t w = jdec_pack565(JDEC_CLIP8(yy + (CV_CR_R * cr) / CVACC),  \
+                                  JDEC_CLIP8(yy - (CV_CB_G * cb + CV_CR_G * cr) / CVACC), \
+                                  JDEC_CLIP8(yy + (CV_CB_B * cb) / CVACC)); \
+        *out++ = swap ? (uint16_t)((w << 8) | (w >> 8)) : w;                \
+    } while (0)
+    JDEC_MCU_FOREACH(mcu, msx, msy, JDEC_PIXEL_565);
+#undef JDEC_PIXEL_565
+}
+
+/*-----------------------------------------------------------------------*/
+/* Fast kernels                                                          */
+/*-----------------------------------------------------------------------*/
+
+/*
+ * Same butterflies as jdec_idct_ref(). Most columns and rows of a photo
+ * have no AC energy left after quantization; for those all eight outputs
+ * equal the DC input, which is exactly what the full butterfly computes.
+ */
+void jdec_idct_fast(int32_t *src, jd_yuv_t *dst)
+{
+    int32_t v0, v1, v2, v3, v4, v5, v6, v7;
+    int32_t t10, t11, t12, t13;
+    int i;
+
+    for (i = 0; i < 8; i++, src++) {
+        if (!(src[8 * 1] | src[8 * 2] | src[8 * 3] | src[8 * 4] | src[8 * 5] | src[8 * 6] | src[8 * 7])) {
+            v0 = src[0];
+            src[8 * 1] = src[8 * 2] = src[8 * 3] = src[8 * 4] = src[8 * 5] = src[8 * 6] = src[8 * 7] = v0;
+            continue;
+        }
+        v0 = src[8 * 0];
+        v1 = src[8 * 2];
+        v2 = src[8 * 4];
+        v3 = src[8 * 6];
+
+        t10 = v0 + v2;
+        t12 = v0 - v2;
+        t11 = (v1 - v3) * M13 >> 12;
+        v3 += v1;
+        t11 -= v3;
+        v0 = t10 + v3;
+        v3 = t10 - v3;
+        v1 = t11 + t12;
+        v2 = t12 - t11;
+
+        v4 = src[8 * 7];
+        v5 = src[8 * 1];
+        v6 = src[8 * 5];
+        v7 = src[8 * 3];
+
+        t10 = v5 - v4;
+        t11 = v5 + v4;
+        t12 = v6 - v7;
+        v7 += v6;
+        v5 = (t11 - v7) * M13 >> 12;
+        v7 += t11;
+        t13 = (t10 + t12) * M5 >> 12;
+        v4 = t13 - (t10 * M2 >> 12);
+        v6 = t13 - (t12 * M4 >> 12) - v7;
+        v5 -= v6;
+        v4 -= v5;
+
+        src[8 * 0] = v0 + v7;
+        src[8 * 7] = v0 - v7;
+        src[8 * 1] = v1 + v6;
+        src[8 * 6] = v1 - v6;
+        src[8 * 2] = v2 + v5;
+        src[8 * 5] = v2 - v5;
+        src[8 * 3] = v3 + v4;
+        src[8 * 4] = v3 - v4;
+    }
+
+    src -= 8;
+    for (i = 0; i < 8; i++, src += 8, dst += 8) {
+        v0 = src[0] + (128L << 8);
+        if (!(src[1] | src[2] | src[3] | src[4] | src[5] | src[6] | src[7])) {
+            jd_yuv_t d = (jd_yuv_t)(v0 >> 8);
+            dst[0] = dst[1] = dst[2] = dst[3] = dst[4] = dst[5] = dst[6] = dst[7] = d;
+            continue;
+        }
+        v1 = src[2];
+        v2 = src[4];
+        v3 = src[6];
+
+        t10 = v0 + v2;
+        t12 = v0 - v2;
+        t11 = (v1 - v3) * M13 >> 12;
+        v3 += v1;
+        t11 -= v3;
+        v0 = t10 + v3;
+        v3 = t10 - v3;
+        v1 = t11 + t12;
+        v2 = t12 - t11;
+
+        v4 = src[7];
+        v5 = src[1];
+        v6 = src[5];
+        v7 = src[3];
+
+        t10 = v5 - v4;
+        t11 = v5 + v4;
+        t12 = v6 - v7;
+        v7 += v6;
+        v5 = (t11 - v7) * M13 >> 12;
+        v7 += t11;
+        t13 = (t10 + t12) * M5 >> 12;
+        v4 = t13 - (t10 * M2 >> 12);
+        v6 = t13 - (t12 * M4 >> 12) - v7;
+        v5 -= v6;
+        v4 -= v5;
+
+        dst[0] = (int16_t)((v0 + v7) >> 8);
+        dst[7] = (int16_t)((v0 - v7) >> 8);
+        dst[1] = (int16_t)((v1 + v6) >> 8);
+        dst[6] = (int16_t)((v1 - v6) >> 8);
+        dst[2] = (int16_t)((v2 + v5) >> 8);
+        dst[5] = (int16_t)((v2 - v5) >> 8);
+        dst[3] = (int16_t)((v3 + v4) >> 8);
+        dst[4] = (int16_t)((v3 - v4) >> 8);
+    }
+}
+
+/* Two RGB565 pixels in one word, first pixel at the lower address */
+static inline uint32_t jdec_pair565(int y0, int y1, int dr, int dg, int db, bool swap)
+{
+    uint32_t w = jdec_pack565(JDEC_CLIP8(y0 + dr), JDEC_CLIP8(y0 - dg), JDEC_CLIP8(y0 + db)) |
+                 (uint32_t)jdec_pack565(JDEC_CLIP8(y1 + dr), JDEC_CLIP8(y1 - dg), JDEC_CLIP8(y1 + db)) << 16;
+    if (swap) {
+        w = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+    }
+    return w;
+}
+
+/*
+ * The chroma terms are computed once per chroma sample and shared by the
+ * 2 (4:2:2) or 4 (4:2:0) luma samples it covers, and pixels are stored two
+ * at a time. Each pixel still sees the same integer expressions as the
+ * reference, so the output is identical.
+ */
+void jdec_mcu_rgb565_fast(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint16_t *out, bool swap)
+{
+    const jd_yuv_t *pcb = mcu + msx * msy * 64;
+    const jd_yuv_t *pcr = pcb + 64;
+    uint32_t *o = (uint32_t *)out;
+
+    if (msx == 1) {
+        /* 4:4:4: one chroma sample per pixel */
+        for (unsigned int i = 0; i < 64; i += 2) {
+            int cb0 = pcb[i] - 128, cr0 = pcr[i] - 128;
+            int cb1 = pcb[i + 1] - 128, cr1 = pcr[i + 1] - 128;
+            uint32_t w = jdec_pack565(JDEC_CLIP8(mcu[i] + (CV_CR_R * cr0) / CVACC),
+                                      JDEC_CLIP8(mcu[i] - (CV_CB_G * cb0 + CV_CR_G * cr0) / CVACC),
+                                      JDEC_CLIP8(mcu[i] + (CV_CB_B * cb0) / CVACC)) |
+                         (uint32_t)jdec_pack565(JDEC_CLIP8(mcu[i + 1] + (CV_CR_R * cr1) / CVACC),
+                                                JDEC_CLIP8(mcu[i + 1] - (CV_CB_G * cb1 + CV_CR_G * cr1) / CVACC),
+                                                JDEC_CLIP8(mcu[i + 1] + (CV_CB_B * cb1) / CVACC)) << 16;
+            if (swap) {
+                w = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+            }
+            o[i / 2] = w;
+        }
+        return;
+    }
+
+    /* 4:2:2 (msy == 1) or 4:2:0 (msy == 2): 16 pixels wide, 8 words per row */
+    for (unsigned int cy = 0; cy < 8; cy++) {
+        for (unsigned int cx = 0; cx < 8; cx++) {
+            int cb = pcb[cy * 8 + cx] - 128;
+            int cr = pcr[cy * 8 + cx] - 128;
+            int dr = (CV_CR_R * cr) / CVACC;
+            int dg = (CV_CB_G * cb + CV_CR_G * cr) / CVACC;
+            int db = (CV_CB_B * cb) / CVACC;
+            for (unsigned int sy = 0; sy < msy; sy++) {
+                unsigned int py = cy * msy + sy;                /* Pixel row in the MCU */
+                const jd_yuv_t *y = mcu + (py >= 8 ? 128 : 0) + (cx >= 4 ? 64 : 0) + (py & 7) * 8 + (cx & 3) * 2;
+                o[py * 8 + cx] = jdec_pair565(y[0], y[1], dr, dg, db, swap);
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * JPEG decoder kernels
+ * IDCT and YCbCr -> RGB conversion used by jdec.c
+ *
+ * Every kernel has a *_ref version that is a straight copy of the TJpgDec
+ * R0.03 arithmetic and a *_fast version that must produce bit-identical
+ * output; both are portable C (there is no PIE/SIMD version).
+ * CONFIG_JPEG_STREAM_OPT_KERNELS picks which one the decoder uses.
+ */
+
+#ifndef JDEC_KERNELS_H
+#define JDEC_KERNELS_H
+
+#include "jdec.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Inverse DCT of one 8x8 block (Arai algorithm)
+ *
+ * @param src De-quantized and pre-scaled coefficients in raster order, used as scratch
+ * @param dst 64 output samples (level shifted, not clipped)
+ */
+void jdec_idct_ref(int32_t *src, jd_yuv_t *dst);
+void jdec_idct_fast(int32_t *src, jd_yuv_t *dst);
+
+/**
+ * @brief Convert an MCU (Y blocks followed by Cb and Cr) to RGB888
+ *
+ * @param mcu MCU buffer, msx * msy Y blocks + 2 chroma blocks
+ * @param msx MCU width in blocks (1 or 2)
+ * @param msy MCU height in blocks (1 or 2)
+ * @param out msx * 8 x msy * 8 pixels, 3 bytes each
+ */
+void jdec_mcu_rgb888_ref(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint8_t *out);
+
+/**
+ * @brief Convert an MCU straight to RGB565, without an RGB888 intermediate
+ *
+ * @param swap Byte-swap each pixel (big-endian RGB565)
+ * @param out msx * 8 x msy * 8 pixels, 4-byte aligned
+ */
+void jdec_mcu_rgb565_ref(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint16_t *out, bool swap);
+void jdec_mcu_rgb565_fast(const jd_yuv_t *mcu, unsigned int msx, unsigned int msy, uint16_t *out, bool swap);
+
+/* Saturate an intermediate sample to 0..255 (valid for -512..511) */
+extern const uint8_t jdec_clip8_tbl[1024];
+#define JDEC_CLIP8(v)   jdec_clip8_tbl[(unsigned int)(v) & 0x3FF]
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JDEC_KERNELS_H
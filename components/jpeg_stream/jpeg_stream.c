@@ -0,0 +1,616 @@
+/*
+ * JPEG Stream Decoder Component
+ * Decodes a JPEG byte stream straight into a single RGB565 framebuffer
+ */
+
+#include "jpeg_stream.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if CONFIG_JPEG_STREAM_PARALLEL
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#endif
+
+#include "jdec.h"
+
+static const char *TAG = "jpeg_stream";
+
+/* How many bytes may precede SOI (multipart headers etc.) before giving up */
+#define JPEG_STREAM_SOI_SCAN_MAX    4096
+
+#define JPEG_STREAM_HEAD_SIZE       256
+
+/* The downscale path averages RGB888 decoder output */
+#define JPEG_STREAM_IN_BYTES    3
+
+/* Stack of the task decoding the second slice on the other core */
+#define JPEG_STREAM_SLICE_STACK     4096
+
+typedef struct {
+    const jpeg_stream_cfg_t *cfg;
+    uint8_t head[JPEG_STREAM_HEAD_SIZE + 1];  // Bytes read while looking for SOI
+    size_t head_pos;
+    size_t head_len;
+    bool read_error;
+    uint8_t *fb;
+    uint16_t fb_w;
+    uint16_t fb_h;
+    /* Area-average downscale from the TJpgDec output (src) to fb, NULL band = off */
+    uint16_t src_w;
+    uint16_t src_h;
+    uint8_t *band;              // One MCU row of decoder output
+    uint16_t band_top;          // Source row of band[0]
+    uint32_t *acc;              // r, g, b, count sums per fb column of the current row
+    int acc_row;                // fb row being accumulated, -1 = none
+    uint16_t emitted;           // fb rows already passed to cfg->on_band
+} jpeg_stream_ctx_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+} jpeg_stream_mem_t;
+
+static int jpeg_stream_mem_read(void *ctx, uint8_t *buf, size_t len);
+
+#if CONFIG_JPEG_STREAM_PARALLEL
+/* Second half of a restart-marked scan, decoded on the other core */
+typedef struct {
+    JDEC jd;
+    jpeg_stream_ctx_t ctx;      // Same framebuffer, own input, no on_band
+    jpeg_stream_cfg_t cfg;
+    jpeg_stream_mem_t mem;      // Entropy data after the RSTn marker the slice starts at
+    uint8_t scale;
+    uint32_t first;
+    uint32_t count;
+    JRESULT res;
+    SemaphoreHandle_t done;
+    uint8_t pool[JDEC_CLONE_POOL];
+} jpeg_stream_slice_t;
+#endif
+
+/**
+ * @brief Read up to len bytes, serving the SOI look-ahead first
+ */
+static int jpeg_stream_pull(jpeg_stream_ctx_t *ctx, uint8_t *buf, size_t len)
+{
+    if (ctx->head_pos < ctx->head_len) {
+        size_t n = ctx->head_len - ctx->head_pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(buf, ctx->head + ctx->head_pos, n);
+        ctx->head_pos += n;
+        return (int)n;
+    }
+
+    int n = ctx->cfg->read(ctx->cfg->read_ctx, buf, len);
+    if (n < 0) {
+        ctx->read_error = true;
+    }
+    return n;
+}
+
+/**
+ * @brief Skip everything before the 0xFFD8 SOI marker and keep SOI buffered
+ */
+static esp_err_t jpeg_stream_find_soi(jpeg_stream_ctx_t *ctx)
+{
+    size_t scanned = 0;
+    uint8_t prev = 0;
+
+    while (scanned < JPEG_STREAM_SOI_SCAN_MAX) {
+        int n = ctx->cfg->read(ctx->cfg->read_ctx, ctx->head, JPEG_STREAM_HEAD_SIZE);
+        if (n <= 0) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        for (int i = 0; i < n; i++) {
+            if (prev == 0xFF && ctx->head[i] == 0xD8) {
+                // Re-emit SOI followed by whatever is left of this chunk
+                size_t rest = n - i - 1;
+                memmove(ctx->head + 2, ctx->head + i + 1, rest);
+                ctx->head[0] = 0xFF;
+                ctx->head[1] = 0xD8;
+                ctx->head_pos = 0;
+                ctx->head_len = rest + 2;
+                if (scanned + i > 1) {
+                    ESP_LOGI(TAG, "Skipped %zu bytes before SOI", scanned + i - 1);
+                }
+                return ESP_OK;
+            }
+            prev = ctx->head[i];
+        }
+        scanned += n;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static size_t jpeg_stream_in_cb(JDEC *jd, uint8_t *buff, size_t nbyte)
+{
+    jpeg_stream_ctx_t *ctx = (jpeg_stream_ctx_t *)jd->device;
+    uint8_t scratch[64];
+    size_t done = 0;
+
+    while (done < nbyte) {
+        uint8_t *dst = buff ? buff + done : scratch;
+        size_t want = nbyte - done;
+        if (!buff && want > sizeof(scratch)) {
+            want = sizeof(scratch);  // buff == NULL means "skip nbyte bytes"
+        }
+        int n = jpeg_stream_pull(ctx, dst, want);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static inline void jpeg_stream_rgb888(const uint8_t *in, uint32_t *r, uint32_t *g, uint32_t *b)
+{
+    *r = in[0];
+    *g = in[1];
+    *b = in[2];
+}
+
+static inline void jpeg_stream_store(const jpeg_stream_ctx_t *ctx, uint8_t *dst, uint16_t color)
+{
+    if (ctx->cfg->swap_bytes) {
+        dst[0] = color >> 8;
+        dst[1] = color & 0xFF;
+    } else {
+        dst[0] = color & 0xFF;
+        dst[1] = color >> 8;
+    }
+}
+
+/**
+ * @brief Pass the framebuffer rows that became final since the last call to cfg->on_band
+ */
+static void jpeg_stream_emit(jpeg_stream_ctx_t *ctx, int ready)
+{
+    if (ready > ctx->fb_h) {
+        ready = ctx->fb_h;
+    }
+    if (!ctx->cfg->on_band || ready <= ctx->emitted) {
+        return;
+    }
+    ctx->cfg->on_band(ctx->cfg->band_ctx, ctx->fb + (size_t)ctx->emitted * ctx->fb_w * 2,
+                      ctx->fb_w, ctx->fb_h, ctx->emitted, ready - ctx->emitted);
+    ctx->emitted = ready;
+}
+
+/**
+ * @brief Write the averaged output row to the framebuffer
+ */
+static void jpeg_stream_flush_row(jpeg_stream_ctx_t *ctx)
+{
+    if (ctx->acc_row < 0) {
+        return;
+    }
+    uint8_t *dst = ctx->fb + (size_t)ctx->acc_row * ctx->fb_w * 2;
+    for (int x = 0; x < ctx->fb_w; x++, dst += 2) {
+        uint32_t *a = &ctx->acc[x * 4];
+        uint32_t n = a[3] ? a[3] : 1;
+        uint16_t color = (((a[0] / n) & 0xF8) << 8) | (((a[1] / n) & 0xFC) << 3) | ((a[2] / n) >> 3);
+        jpeg_stream_store(ctx, dst, color);
+    }
+    ctx->acc_row = -1;
+}
+
+/**
+ * @brief Accumulate one decoded source row into the output row it maps to
+ */
+static void jpeg_stream_resample_row(jpeg_stream_ctx_t *ctx, const uint8_t *in, int sy)
+{
+    int dy = (uint32_t)sy * ctx->fb_h / ctx->src_h;
+    if (dy != ctx->acc_row) {
+        jpeg_stream_flush_row(ctx);
+        memset(ctx->acc, 0, (size_t)ctx->fb_w * 4 * sizeof(uint32_t));
+        ctx->acc_row = dy;
+    }
+    for (int sx = 0; sx < ctx->src_w; sx++, in += JPEG_STREAM_IN_BYTES) {
+        uint32_t *a = &ctx->acc[((uint32_t)sx * ctx->fb_w / ctx->src_w) * 4];
+        uint32_t r, g, b;
+        jpeg_stream_rgb888(in, &r, &g, &b);
+        a[0] += r;
+        a[1] += g;
+        a[2] += b;
+        a[3]++;
+    }
+}
+
+/**
+ * @brief Collect MCUs into the band and resample it once an MCU row is complete
+ */
+static void jpeg_stream_out_band(jpeg_stream_ctx_t *ctx, const uint8_t *in, const JRECT *rect)
+{
+    const size_t stride = (size_t)ctx->src_w * JPEG_STREAM_IN_BYTES;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        for (int x = rect->left; x <= rect->right; x++) {
+            if (y < ctx->src_h && x < ctx->src_w) {
+                memcpy(ctx->band + (y - ctx->band_top) * stride + x * JPEG_STREAM_IN_BYTES, in, JPEG_STREAM_IN_BYTES);
+            }
+            in += JPEG_STREAM_IN_BYTES;
+        }
+    }
+    if (rect->right + 1 >= ctx->src_w) {
+        for (int y = ctx->band_top; y <= rect->bottom && y < ctx->src_h; y++) {
+            jpeg_stream_resample_row(ctx, ctx->band + (y - ctx->band_top) * stride, y);
+        }
+        ctx->band_top = rect->bottom + 1;
+        // Rows above the one still being accumulated are final
+        jpeg_stream_emit(ctx, ctx->acc_row);
+    }
+}
+
+static int jpeg_stream_out_cb(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    jpeg_stream_ctx_t *ctx = (jpeg_stream_ctx_t *)jd->device;
+    const uint8_t *in = (const uint8_t *)bitmap;
+
+    if (ctx->band) {
+        jpeg_stream_out_band(ctx, in, rect);
+        return 1;
+    }
+
+    // The decoder already produced RGB565 in the framebuffer byte order
+    const size_t row = (size_t)(rect->right - rect->left + 1) * 2;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        memcpy(ctx->fb + ((size_t)y * ctx->fb_w + rect->left) * 2, in, row);
+        in += row;
+    }
+    if (rect->right + 1 >= ctx->fb_w) {
+        jpeg_stream_emit(ctx, rect->bottom + 1);
+    }
+    return 1;
+}
+
+/**
+ * @brief Pick the output size and TJpgDec scale for cfg->max_width/max_height
+ * @return Scale (0..3) to pass to jd_decomp()
+ */
+static uint8_t jpeg_stream_fit(const jpeg_stream_cfg_t *cfg, uint16_t w, uint16_t h, uint16_t *out_w, uint16_t *out_h)
+{
+    *out_w = w;
+    *out_h = h;
+    if (!cfg->max_width || !cfg->max_height || (w <= cfg->max_width && h <= cfg->max_height)) {
+        return 0;
+    }
+
+    // Fit inside max_width x max_height, keeping the aspect ratio
+    if ((uint32_t)w * cfg->max_height > (uint32_t)h * cfg->max_width) {
+        *out_w = cfg->max_width;
+        *out_h = (uint32_t)h * cfg->max_width / w;
+    } else {
+        *out_h = cfg->max_height;
+        *out_w = (uint32_t)w * cfg->max_height / h;
+    }
+    if (*out_w == 0) {
+        *out_w = 1;
+    }
+    if (*out_h == 0) {
+        *out_h = 1;
+    }
+
+    // Largest reduction that does not go below the fitted size
+    uint8_t scale = 3;
+    while (scale > 0 && ((w >> scale) < *out_w || (h >> scale) < *out_h)) {
+        scale--;
+    }
+    return scale;
+}
+
+#if CONFIG_JPEG_STREAM_PARALLEL
+static void jpeg_stream_slice_task(void *arg)
+{
+    jpeg_stream_slice_t *slice = (jpeg_stream_slice_t *)arg;
+    slice->res = jdec_decomp_range(&slice->jd, jpeg_stream_out_cb, slice->scale, slice->first, slice->count);
+    xSemaphoreGive(slice->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Offset of the entropy data following the n-th (0-based) RSTn marker
+ * @return 0 if the scan ends first
+ */
+static size_t jpeg_stream_find_rst(const uint8_t *data, size_t len, size_t pos, uint32_t n)
+{
+    while (pos + 1 < len) {
+        if (data[pos] != 0xFF) {
+            pos++;
+            continue;
+        }
+        uint8_t m = data[pos + 1];
+        if (m == 0xFF) {
+            pos++;  // Fill byte
+        } else if (m == 0x00) {
+            pos += 2;  // Stuffed 0xFF in entropy data
+        } else if (m >= 0xD0 && m <= 0xD7) {
+            pos += 2;
+            if (n-- == 0) {
+                return pos;
+            }
+        } else {
+            return 0;  // EOI or any other marker ends the scan
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Hand the second half of a restart-marked scan to a task on the other core
+ *
+ * The slices write disjoint MCUs of the same framebuffer. Only the calling task
+ * reports bands, so on_band still sees the rows top to bottom: the top slice as
+ * it is decoded, the bottom slice once both are done.
+ *
+ * @return Slice to wait for, NULL to decode the whole scan on this core
+ */
+static jpeg_stream_slice_t *jpeg_stream_split(jpeg_stream_ctx_t *ctx, const JDEC *jd, const jpeg_stream_mem_t *mem,
+                                              uint8_t scale, uint32_t *first_count)
+{
+    uint32_t total = jdec_mcu_count(jd);
+    uint32_t intervals = jd->nrst ? (total + jd->nrst - 1) / jd->nrst : 0;
+    if (intervals < 2 || jd->progressive) {
+        return NULL;
+    }
+
+    // Entropy data starts where the decoder has read up to, minus what it buffered
+    size_t scan = mem->pos - (ctx->head_len - ctx->head_pos) - jd->dctr;
+    uint32_t split = intervals / 2;
+    size_t start = jpeg_stream_find_rst(mem->data, mem->len, scan, split - 1);
+    if (!start) {
+        ESP_LOGW(TAG, "Restart marker %u not found, decoding on one core", (unsigned)(split - 1));
+        return NULL;
+    }
+
+    jpeg_stream_slice_t *slice = heap_caps_malloc(sizeof(*slice), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!slice) {
+        return NULL;
+    }
+    slice->cfg = *ctx->cfg;
+    slice->cfg.read = jpeg_stream_mem_read;
+    slice->cfg.read_ctx = &slice->mem;
+    slice->cfg.on_band = NULL;
+    slice->mem = (jpeg_stream_mem_t) { .data = mem->data + start, .len = mem->len - start, .pos = 0 };
+    slice->ctx = *ctx;
+    slice->ctx.cfg = &slice->cfg;
+    slice->ctx.head_pos = slice->ctx.head_len = 0;
+    slice->scale = scale;
+    slice->first = split * jd->nrst;
+    slice->count = total - slice->first;
+    slice->done = xSemaphoreCreateBinary();
+    if (!slice->done || jdec_clone(&slice->jd, jd, jpeg_stream_in_cb, slice->pool, sizeof(slice->pool), &slice->ctx) != JDR_OK) {
+        goto fail;
+    }
+
+    BaseType_t core = xPortGetCoreID() ? 0 : 1;
+    if (xTaskCreatePinnedToCore(jpeg_stream_slice_task, "jpeg_slice", JPEG_STREAM_SLICE_STACK, slice,
+                                uxTaskPriorityGet(NULL), NULL, core) != pdPASS) {
+        goto fail;
+    }
+    *first_count = slice->first;
+    ESP_LOGD(TAG, "MCUs %u..%u on core %d", (unsigned)slice->first, (unsigned)(total - 1), (int)core);
+    return slice;
+
+fail:
+    ESP_LOGW(TAG, "Could not start slice task, decoding on one core");
+    if (slice->done) {
+        vSemaphoreDelete(slice->done);
+    }
+    heap_caps_free(slice);
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Free the framebuffer after an error, unless the caller provided it
+ */
+static void jpeg_stream_free_fb(jpeg_stream_ctx_t *ctx)
+{
+    if (ctx->fb != ctx->cfg->fb) {
+        heap_caps_free(ctx->fb);
+    }
+    ctx->fb = NULL;
+}
+
+/**
+ * @brief Decode from cfg->read; mem is the same data when it is all in memory
+ */
+static esp_err_t jpeg_stream_decode_src(const jpeg_stream_cfg_t *cfg, const jpeg_stream_mem_t *mem,
+                                        jpeg_stream_image_t *out)
+{
+    if (cfg == NULL || cfg->read == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(out, 0, sizeof(*out));
+
+    jpeg_stream_ctx_t ctx = { .cfg = cfg };
+    esp_err_t ret = jpeg_stream_find_soi(&ctx);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "No JPEG SOI marker found in stream");
+        return ret;
+    }
+
+    uint8_t *workbuf = heap_caps_malloc(JDEC_WORK_POOL, MALLOC_CAP_DEFAULT);
+    if (!workbuf) {
+        ESP_LOGE(TAG, "No memory for JPEG work buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    void *coef = NULL;
+    JDEC jd;
+    JRESULT res = jdec_prepare(&jd, jpeg_stream_in_cb, workbuf, JDEC_WORK_POOL, &ctx);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "Error in preparing JPEG image! %d%s", res,
+                 ctx.read_error ? " (read error)" : res == JDR_FMT3 ? " (unsupported JPEG type)" : "");
+        ret = ESP_FAIL;
+        goto err;
+    }
+
+    uint8_t scale = jpeg_stream_fit(cfg, jd.width, jd.height, &ctx.fb_w, &ctx.fb_h);
+#if CONFIG_JPEG_STREAM_PROGRESSIVE
+    // All scans are collected before any pixel is output; the buffer only keeps
+    // the coefficients the chosen scale needs, so it tracks the output size.
+    // Checked before anything image-sized is allocated
+    size_t coef_size = jdec_coef_size(&jd, scale);
+    if (coef_size > (size_t)CONFIG_JPEG_STREAM_PROGRESSIVE_MAX_KB * 1024) {
+        ESP_LOGE(TAG, "Progressive %ux%u JPEG needs %zu KB of coefficients (limit %d KB)",
+                 jd.width, jd.height, coef_size / 1024, CONFIG_JPEG_STREAM_PROGRESSIVE_MAX_KB);
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+#endif
+    ctx.src_w = jd.width >> scale;
+    ctx.src_h = jd.height >> scale;
+    ctx.acc_row = -1;
+    if (ctx.src_w != ctx.fb_w || ctx.src_h != ctx.fb_h) {
+        // One MCU row of scaled decoder output plus one output row of sums
+        uint16_t band_h = (jd.msy * 8) >> scale;
+        size_t band_size = (size_t)ctx.src_w * (band_h ? band_h : 1) * JPEG_STREAM_IN_BYTES;
+        ctx.band = heap_caps_malloc(band_size, MALLOC_CAP_DEFAULT);
+        if (!ctx.band) {
+            ctx.band = heap_caps_malloc(band_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        ctx.acc = heap_caps_malloc((size_t)ctx.fb_w * 4 * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+        if (!ctx.band || !ctx.acc) {
+            ESP_LOGE(TAG, "No memory for %ux%u -> %ux%u downscale", ctx.src_w, ctx.src_h, ctx.fb_w, ctx.fb_h);
+            ret = ESP_ERR_NO_MEM;
+            goto err;
+        }
+        ESP_LOGI(TAG, "Scaling %ux%u JPEG by 1/%d and area-averaging to %ux%u",
+                 jd.width, jd.height, 1 << scale, ctx.fb_w, ctx.fb_h);
+    }
+
+    size_t fb_size = (size_t)ctx.fb_w * ctx.fb_h * 2;
+    if (cfg->fb) {
+        if (fb_size > cfg->fb_size) {
+            ESP_LOGE(TAG, "%ux%u output does not fit in the %zu byte framebuffer", ctx.fb_w, ctx.fb_h, cfg->fb_size);
+            ret = ESP_ERR_INVALID_SIZE;
+            goto err;
+        }
+        ctx.fb = cfg->fb;
+    } else {
+        uint32_t caps = cfg->fb_caps ? cfg->fb_caps : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ctx.fb = heap_caps_malloc(fb_size, caps);
+        if (!ctx.fb) {
+            ctx.fb = heap_caps_malloc(fb_size, MALLOC_CAP_DEFAULT);
+        }
+        if (!ctx.fb) {
+            ESP_LOGE(TAG, "Framebuffer allocation failed for %ux%u (%zu bytes)", ctx.fb_w, ctx.fb_h, fb_size);
+            ret = ESP_ERR_NO_MEM;
+            goto err;
+        }
+    }
+
+#if CONFIG_JPEG_STREAM_PROGRESSIVE
+    if (jd.progressive) {
+        coef = heap_caps_malloc(coef_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!coef) {
+            coef = heap_caps_malloc(coef_size, MALLOC_CAP_DEFAULT);
+        }
+        if (!coef) {
+            ESP_LOGE(TAG, "No memory for %zu byte progressive coefficient buffer", coef_size);
+            jpeg_stream_free_fb(&ctx);
+            ret = ESP_ERR_NO_MEM;
+            goto err;
+        }
+        jd.coef = coef;
+        ESP_LOGI(TAG, "Progressive %ux%u JPEG, %zu byte coefficient buffer", jd.width, jd.height, coef_size);
+    }
+#endif
+
+    // Full-size output is converted straight to RGB565, the downscale path averages RGB888
+    if (ctx.band) {
+        jd.format = JDEC_RGB888;
+    } else {
+        jd.format = cfg->swap_bytes ? JDEC_RGB565_SWAP : JDEC_RGB565;
+    }
+    uint32_t count = 0;         // MCUs left for this core when the scan is split, 0 = all
+#if CONFIG_JPEG_STREAM_PARALLEL
+    // Restart markers let the bottom half be decoded on the other core; this
+    // needs random access to the data and is left out of the downscale path,
+    // which resamples MCU rows strictly in order
+    jpeg_stream_slice_t *slice = NULL;
+    if (mem && !ctx.band) {
+        slice = jpeg_stream_split(&ctx, &jd, mem, scale, &count);
+    }
+#endif
+    if (count) {
+        res = jdec_decomp_range(&jd, jpeg_stream_out_cb, scale, 0, count);
+    } else {
+        res = jdec_decomp(&jd, jpeg_stream_out_cb, scale);
+    }
+#if CONFIG_JPEG_STREAM_PARALLEL
+    if (slice) {
+        // Always wait, the slice task writes into ctx.fb
+        xSemaphoreTake(slice->done, portMAX_DELAY);
+        if (res == JDR_OK) {
+            res = slice->res;
+        }
+        vSemaphoreDelete(slice->done);
+        heap_caps_free(slice);
+    }
+#endif
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "Error in decoding JPEG image! %d%s", res, ctx.read_error ? " (read error)" : "");
+        jpeg_stream_free_fb(&ctx);
+        ret = ESP_FAIL;
+        goto err;
+    }
+    if (ctx.band) {
+        jpeg_stream_flush_row(&ctx);
+    }
+    jpeg_stream_emit(&ctx, ctx.fb_h);
+
+    out->pixels = ctx.fb;
+    out->width = ctx.fb_w;
+    out->height = ctx.fb_h;
+    out->size = fb_size;
+    ESP_LOGI(TAG, "Decoded %ux%u JPEG into %zu byte framebuffer", ctx.fb_w, ctx.fb_h, fb_size);
+
+err:
+    heap_caps_free(ctx.band);
+    heap_caps_free(ctx.acc);
+    heap_caps_free(coef);
+    heap_caps_free(workbuf);
+    return ret;
+}
+
+esp_err_t jpeg_stream_decode(const jpeg_stream_cfg_t *cfg, jpeg_stream_image_t *out)
+{
+    return jpeg_stream_decode_src(cfg, NULL, out);
+}
+
+static int jpeg_stream_mem_read(void *ctx, uint8_t *buf, size_t len)
+{
+    jpeg_stream_mem_t *mem = (jpeg_stream_mem_t *)ctx;
+    size_t n = mem->len - mem->pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buf, mem->data + mem->pos, n);
+    mem->pos += n;
+    return (int)n;
+}
+
+esp_err_t jpeg_stream_decode_mem(const uint8_t *data, size_t len, const jpeg_stream_cfg_t *cfg, jpeg_stream_image_t *out)
+{
+    if (data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    jpeg_stream_mem_t mem = { .data = data, .len = len, .pos = 0 };
+    jpeg_stream_cfg_t mem_cfg = {0};
+    if (cfg) {
+        mem_cfg = *cfg;
+    }
+    mem_cfg.read = jpeg_stream_mem_read;
+    mem_cfg.read_ctx = &mem;
+    return jpeg_stream_decode_src(&mem_cfg, &mem, out);
+}
@@ -0,0 +1,130 @@
+/*
+ * JPEG Stream Decoder Component
+ * Decodes a JPEG byte stream straight into a single RGB565 framebuffer
+ */
+
+#ifndef JPEG_STREAM_H
+#define JPEG_STREAM_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stream read callback
+ *
+ * @param ctx User context from jpeg_stream_cfg_t
+ * @param buf Destination buffer
+ * @param len Maximum number of bytes to read
+ * @return Number of bytes read (>0), 0 on end of stream, <0 on error
+ */
+typedef int (*jpeg_stream_read_cb_t)(void *ctx, uint8_t *buf, size_t len);
+
+/**
+ * @brief Band callback, called as soon as output rows are final
+ *
+ * Rows arrive top to bottom, one MCU row (or less when downscaling) at a time,
+ * and stay valid in the framebuffer after the callback returns.
+ *
+ * @param ctx User context from jpeg_stream_cfg_t
+ * @param pixels RGB565 pixels of row y, rows * width pixels
+ * @param width Output width in pixels
+ * @param height Output height in pixels
+ * @param y First row in this band
+ * @param rows Number of rows in this band
+ */
+typedef void (*jpeg_stream_band_cb_t)(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height,
+                                      uint16_t y, uint16_t rows);
+
+/**
+ * @brief JPEG stream decoder configuration
+ */
+typedef struct {
+    jpeg_stream_read_cb_t read;     // Source of the compressed bytes
+    void *read_ctx;                 // Passed to read()
+    bool swap_bytes;                // Emit big-endian RGB565 (LV_COLOR_16_SWAP)
+    uint32_t fb_caps;               // Heap caps for the framebuffer (0: PSRAM)
+    uint16_t max_width;             // Shrink larger images to fit max_width x max_height
+    uint16_t max_height;            // (0: decode at full size)
+    jpeg_stream_band_cb_t on_band;  // Optional, called for every finished band
+    void *band_ctx;                 // Passed to on_band()
+    uint8_t *fb;                    // Optional framebuffer to decode into instead of allocating one
+    size_t fb_size;                 // Size of fb in bytes
+} jpeg_stream_cfg_t;
+
+/**
+ * @brief Decoded image
+ */
+typedef struct {
+    uint8_t *pixels;                // RGB565 framebuffer, free with heap_caps_free() (cfg->fb if set)
+    uint16_t width;                 // Width in pixels
+    uint16_t height;                // Height in pixels
+    size_t size;                    // Framebuffer size in bytes
+} jpeg_stream_image_t;
+
+/**
+ * @brief Decode a JPEG stream into a newly allocated RGB565 framebuffer
+ *
+ * Compressed data is pulled through cfg->read() in small chunks and MCU blocks
+ * are written straight into the framebuffer, so the only image-sized
+ * allocation is the output itself. Any bytes before the SOI marker (e.g. a
+ * multipart/form-data preamble) are skipped.
+ *
+ * If cfg->max_width/max_height are set and the image is larger, it is shrunk
+ * to fit while keeping its aspect ratio: TJpgDec decodes at the largest
+ * 1/2, 1/4 or 1/8 scale that is still at least the fitted size and an
+ * area-average filter finishes the fit one MCU row at a time, so memory and
+ * time are bounded by the output size rather than the photo size.
+ *
+ * Progressive JPEGs (CONFIG_JPEG_STREAM_PROGRESSIVE) are detected from the
+ * header. Their scans are first collected in a coefficient buffer that only
+ * holds what the chosen scale needs, so output (and on_band) starts after the
+ * last scan has arrived.
+ *
+ * If cfg->on_band is set it sees every output row as soon as it is final,
+ * e.g. to send the image to the display while the rest is still decoding.
+ *
+ * If cfg->fb is set the image is decoded into it and nothing image-sized is
+ * allocated, e.g. to reuse the same framebuffers for every frame of a video.
+ * fb stays owned by the caller, also on error.
+ *
+ * @param cfg Decoder configuration
+ * @param out Decoded image, out->pixels is owned by the caller on success
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if cfg or out is NULL
+ *      - ESP_ERR_NOT_FOUND if no SOI marker was found in the stream
+ *      - ESP_ERR_INVALID_SIZE if the output does not fit in cfg->fb
+ *      - ESP_ERR_NO_MEM if the framebuffer or the progressive coefficient buffer
+ *        could not be allocated
+ *      - ESP_FAIL if the JPEG data could not be decoded
+ */
+esp_err_t jpeg_stream_decode(const jpeg_stream_cfg_t *cfg, jpeg_stream_image_t *out);
+
+/**
+ * @brief Decode a JPEG that is already in memory
+ *
+ * Same as jpeg_stream_decode() but reads from data/len; cfg->read and
+ * cfg->read_ctx are ignored and cfg may be NULL for default settings.
+ * With CONFIG_JPEG_STREAM_PARALLEL, a full-size JPEG with restart markers (DRI)
+ * is split at the middle RSTn marker and the bottom half is decoded on the
+ * other core at the same time.
+ *
+ * @param data JPEG data
+ * @param len Length of data in bytes
+ * @param cfg Decoder configuration (may be NULL)
+ * @param out Decoded image, out->pixels is owned by the caller on success
+ * @return Same as jpeg_stream_decode()
+ */
+esp_err_t jpeg_stream_decode_mem(const uint8_t *data, size_t len, const jpeg_stream_cfg_t *cfg, jpeg_stream_image_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JPEG_STREAM_H
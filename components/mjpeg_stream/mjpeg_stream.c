@@ -0,0 +1,340 @@
+/*
+ * MJPEG Stream Component
+ * Splits a Motion-JPEG byte stream (multipart/x-mixed-replace or length-prefixed)
+ * into single JPEG frames
+ */
+
+#include "mjpeg_stream.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "mjpeg_stream";
+
+/* Bytes pulled from the read callback at a time for headers and boundary scans */
+#define MJPEG_STREAM_CHUNK          512
+/* RFC 2046 limit */
+#define MJPEG_STREAM_BOUNDARY_MAX   70
+/* Header lines are cut to this length, enough for the boundary and Content-Length */
+#define MJPEG_STREAM_LINE_MAX       128
+
+typedef enum {
+    MJPEG_STREAM_SEEK,              // Reading lines up to the next delimiter
+    MJPEG_STREAM_DELIM,             // Delimiter found by a scan, the rest of its line follows
+    MJPEG_STREAM_HEADERS,           // At the headers of a part
+    MJPEG_STREAM_END,               // Closing delimiter, zero length or end of data seen
+} mjpeg_stream_state_t;
+
+struct mjpeg_stream {
+    mjpeg_stream_cfg_t cfg;
+    mjpeg_stream_format_t format;
+    mjpeg_stream_state_t state;
+    char delim[4 + MJPEG_STREAM_BOUNDARY_MAX + 1];  // "\r\n--" + boundary
+    size_t delim_len;
+    uint8_t ahead[MJPEG_STREAM_CHUNK];
+    size_t ahead_pos;
+    size_t ahead_len;
+};
+
+/**
+ * @brief Refill the look-ahead buffer once it is empty
+ * @return Bytes available, 0 at the end of the stream, <0 on a read error
+ */
+static int mjpeg_stream_fill(mjpeg_stream_t *s)
+{
+    if (s->ahead_pos < s->ahead_len) {
+        return (int)(s->ahead_len - s->ahead_pos);
+    }
+    s->ahead_pos = s->ahead_len = 0;
+    int n = s->cfg.read(s->cfg.read_ctx, s->ahead, sizeof(s->ahead));
+    if (n > 0) {
+        s->ahead_len = n;
+    }
+    return n;
+}
+
+static esp_err_t mjpeg_stream_fill_err(int n)
+{
+    return n < 0 ? ESP_FAIL : ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief Read exactly len bytes into dst (NULL skips them)
+ */
+static esp_err_t mjpeg_stream_read(mjpeg_stream_t *s, uint8_t *dst, size_t len)
+{
+    while (len > 0) {
+        size_t n;
+        if (s->ahead_pos < s->ahead_len) {
+            n = s->ahead_len - s->ahead_pos;
+            if (n > len) {
+                n = len;
+            }
+            if (dst) {
+                memcpy(dst, s->ahead + s->ahead_pos, n);
+            }
+            s->ahead_pos += n;
+        } else if (dst && len >= MJPEG_STREAM_CHUNK) {
+            // Frame data goes straight into the caller's buffer
+            int r = s->cfg.read(s->cfg.read_ctx, dst, len);
+            if (r <= 0) {
+                return mjpeg_stream_fill_err(r);
+            }
+            n = r;
+        } else {
+            int r = mjpeg_stream_fill(s);
+            if (r <= 0) {
+                return mjpeg_stream_fill_err(r);
+            }
+            continue;
+        }
+        if (dst) {
+            dst += n;
+        }
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Read one line without the line break and trailing blanks, cut to cap - 1 characters
+ */
+static esp_err_t mjpeg_stream_read_line(mjpeg_stream_t *s, char *line, size_t cap)
+{
+    size_t n = 0;
+    while (true) {
+        int r = mjpeg_stream_fill(s);
+        if (r <= 0) {
+            return mjpeg_stream_fill_err(r);
+        }
+        char c = (char)s->ahead[s->ahead_pos++];
+        if (c == '\n') {
+            break;
+        }
+        if (n + 1 < cap) {
+            line[n++] = c;
+        }
+    }
+    while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == ' ' || line[n - 1] == '\t')) {
+        n--;
+    }
+    line[n] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t mjpeg_stream_open(const mjpeg_stream_cfg_t *cfg, mjpeg_stream_t **stream)
+{
+    if (!cfg || !cfg->read || !stream) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stream = NULL;
+    mjpeg_stream_t *s = heap_caps_calloc(1, sizeof(*s), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!s) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->cfg = *cfg;
+
+    // Some servers send a line break before the first boundary. A length
+    // prefix never starts with one: that would be a frame of over 160 MB
+    int r;
+    while ((r = mjpeg_stream_fill(s)) > 0 && (s->ahead[s->ahead_pos] == '\r' || s->ahead[s->ahead_pos] == '\n')) {
+        s->ahead_pos++;
+    }
+    if (r <= 0) {
+        heap_caps_free(s);
+        return mjpeg_stream_fill_err(r);
+    }
+
+    if (s->ahead[s->ahead_pos] == '-') {
+        char line[MJPEG_STREAM_LINE_MAX];
+        esp_err_t err = mjpeg_stream_read_line(s, line, sizeof(line));
+        size_t len = strlen(line);
+        if (err == ESP_OK && (len < 3 || line[1] != '-' || len - 2 > MJPEG_STREAM_BOUNDARY_MAX)) {
+            ESP_LOGE(TAG, "Invalid multipart boundary line");
+            err = ESP_ERR_INVALID_ARG;
+        }
+        if (err != ESP_OK) {
+            heap_caps_free(s);
+            return err;
+        }
+        memcpy(s->delim, "\r\n", 2);
+        memcpy(s->delim + 2, line, len + 1);
+        s->delim_len = len + 2;
+        s->format = MJPEG_STREAM_MULTIPART;
+        s->state = MJPEG_STREAM_HEADERS;
+        ESP_LOGI(TAG, "Multipart stream, boundary %s", line + 2);
+    } else {
+        s->format = MJPEG_STREAM_LENGTH_PREFIXED;
+        ESP_LOGI(TAG, "Length-prefixed stream");
+    }
+    *stream = s;
+    return ESP_OK;
+}
+
+/**
+ * @brief Read a frame of known size, skipping it if it does not fit
+ */
+static esp_err_t mjpeg_stream_read_frame(mjpeg_stream_t *s, uint8_t *buf, size_t cap, size_t size, size_t *len)
+{
+    *len = size;
+    if (size > cap) {
+        ESP_LOGW(TAG, "Skipping %zu byte frame (limit %zu)", size, cap);
+        esp_err_t err = mjpeg_stream_read(s, NULL, size);
+        return err == ESP_OK ? ESP_ERR_INVALID_SIZE : err;
+    }
+    return mjpeg_stream_read(s, buf, size);
+}
+
+/**
+ * @brief First occurrence of pat in data, NULL if none
+ */
+static const uint8_t *mjpeg_stream_find(const uint8_t *data, size_t len, const char *pat, size_t pat_len)
+{
+    const uint8_t *end = data + len;
+    while ((size_t)(end - data) >= pat_len) {
+        const uint8_t *p = memchr(data, pat[0], end - data - pat_len + 1);
+        if (!p) {
+            return NULL;
+        }
+        if (memcmp(p, pat, pat_len) == 0) {
+            return p;
+        }
+        data = p + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Copy a part without Content-Length into buf until the next delimiter
+ *
+ * The look-ahead buffer is searched chunk by chunk, together with the last
+ * delim_len - 1 bytes of the previous chunk so a delimiter split between two
+ * reads is still found. The delimiter always ends inside the current chunk,
+ * so reading continues right after it.
+ */
+static esp_err_t mjpeg_stream_scan_part(mjpeg_stream_t *s, uint8_t *buf, size_t cap, size_t *len)
+{
+    const size_t dlen = s->delim_len;
+    size_t n = 0;
+    bool overflow = false;
+    *len = 0;
+    if (cap < MJPEG_STREAM_CHUNK + dlen) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    while (true) {
+        int r = mjpeg_stream_fill(s);
+        if (r <= 0) {
+            return mjpeg_stream_fill_err(r);
+        }
+        size_t chunk = r;
+        if (n + chunk > cap) {
+            // Too large for buf: keep scanning with only the tail a delimiter could start in
+            overflow = true;
+            memmove(buf, buf + n - (dlen - 1), dlen - 1);
+            n = dlen - 1;
+        }
+        memcpy(buf + n, s->ahead + s->ahead_pos, chunk);
+        const size_t from = n > dlen - 1 ? n - (dlen - 1) : 0;
+        const uint8_t *hit = mjpeg_stream_find(buf + from, n + chunk - from, s->delim, dlen);
+        if (!hit) {
+            s->ahead_pos += chunk;
+            n += chunk;
+            continue;
+        }
+        const size_t end = hit - buf;
+        s->ahead_pos += end + dlen - n;
+        s->state = MJPEG_STREAM_DELIM;
+        if (overflow) {
+            ESP_LOGW(TAG, "Skipping frame larger than %zu bytes", cap);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *len = end;
+        return ESP_OK;
+    }
+}
+
+static esp_err_t mjpeg_stream_next_part(mjpeg_stream_t *s, uint8_t *buf, size_t cap, size_t *len)
+{
+    char line[MJPEG_STREAM_LINE_MAX];
+    const char *boundary = s->delim + 2;
+    const size_t blen = s->delim_len - 2;
+    esp_err_t err;
+
+    while (s->state != MJPEG_STREAM_HEADERS) {
+        err = mjpeg_stream_read_line(s, line, sizeof(line));
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (s->state == MJPEG_STREAM_DELIM) {
+            // Rest of a delimiter line: "--" closes the stream
+            if (strcmp(line, "--") == 0) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            s->state = MJPEG_STREAM_HEADERS;
+        } else if (strncmp(line, boundary, blen) == 0) {
+            if (strcmp(line + blen, "--") == 0) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            if (line[blen] == '\0') {
+                s->state = MJPEG_STREAM_HEADERS;
+            }
+        }
+    }
+
+    // Part headers up to the empty line
+    long size = -1;
+    do {
+        err = mjpeg_stream_read_line(s, line, sizeof(line));
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            size = strtol(line + 15, NULL, 10);
+        }
+    } while (line[0]);
+
+    if (size >= 0) {
+        s->state = MJPEG_STREAM_SEEK;
+        return mjpeg_stream_read_frame(s, buf, cap, size, len);
+    }
+    return mjpeg_stream_scan_part(s, buf, cap, len);
+}
+
+esp_err_t mjpeg_stream_next_frame(mjpeg_stream_t *stream, uint8_t *buf, size_t cap, size_t *len)
+{
+    if (!stream || !buf || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *len = 0;
+    if (stream->state == MJPEG_STREAM_END) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err;
+    if (stream->format == MJPEG_STREAM_MULTIPART) {
+        err = mjpeg_stream_next_part(stream, buf, cap, len);
+    } else {
+        uint8_t prefix[4];
+        err = mjpeg_stream_read(stream, prefix, sizeof(prefix));
+        if (err == ESP_OK) {
+            size_t size = ((size_t)prefix[0] << 24) | ((size_t)prefix[1] << 16) | ((size_t)prefix[2] << 8) | prefix[3];
+            err = size ? mjpeg_stream_read_frame(stream, buf, cap, size, len) : ESP_ERR_NOT_FOUND;
+        }
+    }
+    if (err == ESP_ERR_NOT_FOUND || err == ESP_FAIL) {
+        stream->state = MJPEG_STREAM_END;
+    }
+    return err;
+}
+
+mjpeg_stream_format_t mjpeg_stream_format(const mjpeg_stream_t *stream)
+{
+    return stream->format;
+}
+
+void mjpeg_stream_close(mjpeg_stream_t *stream)
+{
+    heap_caps_free(stream);
+}
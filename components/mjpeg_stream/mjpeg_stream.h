@@ -0,0 +1,96 @@
+/*
+ * MJPEG Stream Component
+ * Splits a Motion-JPEG byte stream (multipart/x-mixed-replace or length-prefixed)
+ * into single JPEG frames
+ */
+
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stream read callback, same contract as jpeg_stream_read_cb_t
+ * @return Number of bytes read (>0), 0 on end of stream, <0 on error
+ */
+typedef int (*mjpeg_stream_read_cb_t)(void *ctx, uint8_t *buf, size_t len);
+
+/**
+ * @brief MJPEG stream configuration
+ */
+typedef struct {
+    mjpeg_stream_read_cb_t read;    // Source of the stream bytes
+    void *read_ctx;                 // Passed to read()
+} mjpeg_stream_cfg_t;
+
+/**
+ * @brief How frames are delimited, detected from the first bytes
+ */
+typedef enum {
+    MJPEG_STREAM_MULTIPART,         // "--boundary" lines between parts, Content-Length header optional
+    MJPEG_STREAM_LENGTH_PREFIXED,   // 32-bit big-endian length before each frame, 0 ends the stream
+} mjpeg_stream_format_t;
+
+/**
+ * @brief Parser state
+ */
+typedef struct mjpeg_stream mjpeg_stream_t;
+
+/**
+ * @brief Read the start of the stream and detect its format
+ *
+ * A stream starting with "--" is multipart and its first line is the
+ * boundary, so the Content-Type header is not needed.
+ *
+ * @param cfg Stream configuration
+ * @param[out] stream Parser, free with mjpeg_stream_close()
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if cfg is NULL or the boundary is longer than 70 characters
+ *      - ESP_ERR_NOT_FOUND if the stream is empty
+ *      - ESP_ERR_NO_MEM if the parser could not be allocated
+ *      - ESP_FAIL on a read error
+ */
+esp_err_t mjpeg_stream_open(const mjpeg_stream_cfg_t *cfg, mjpeg_stream_t **stream);
+
+/**
+ * @brief Read the next frame into buf
+ *
+ * Parts with a Content-Length header (and length-prefixed frames) are read
+ * straight into buf; other parts are scanned for the next boundary.
+ *
+ * @param buf Frame buffer, at least 1 KB
+ * @param cap Size of buf in bytes
+ * @param[out] len Frame size in bytes
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND at the end of the stream (closing boundary, zero length,
+ *        or the data ends between or inside frames)
+ *      - ESP_ERR_INVALID_SIZE if the frame is larger than cap; it is skipped and
+ *        the next call reads the frame after it
+ *      - ESP_FAIL on a read error
+ */
+esp_err_t mjpeg_stream_next_frame(mjpeg_stream_t *stream, uint8_t *buf, size_t cap, size_t *len);
+
+/**
+ * @brief Detected stream format
+ */
+mjpeg_stream_format_t mjpeg_stream_format(const mjpeg_stream_t *stream);
+
+/**
+ * @brief Free a parser (NULL is ignored)
+ */
+void mjpeg_stream_close(mjpeg_stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJPEG_STREAM_H
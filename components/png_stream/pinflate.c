@@ -0,0 +1,449 @@
+/*
+ * Streaming zlib inflate for png_stream
+ * Pulls compressed bytes through a callback and hands out the decompressed
+ * stream in caller-sized pieces, keeping only the LZ77 window in memory
+ */
+
+#include "pinflate.h"
+#include <string.h>
+
+/* Base lengths and extra bits of length symbols 257..285 */
+static const uint16_t s_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t s_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+/* Base distances and extra bits of distance symbols 0..29 */
+static const uint16_t s_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t s_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/* Order in which the code length code lengths are stored */
+static const uint8_t s_clen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+/**
+ * @brief Top the bit buffer up to more than 24 bits
+ *
+ * Past the end of the input zero bytes are fed in so the last codes can be
+ * looked up with a full-width index; consuming any of them means the stream
+ * was truncated.
+ */
+static bool pinf_fill(pinf_t *inf)
+{
+    if (inf->nbits < inf->pad * 8u) {
+        return false;
+    }
+    while (inf->nbits <= 24) {
+        uint32_t b = 0;
+        if (inf->in_pos < inf->in_len) {
+            b = inf->in[inf->in_pos++];
+        } else if (!inf->pad) {
+            int n = inf->read(inf->read_ctx, inf->in, sizeof(inf->in));
+            if (n < 0) {
+                return false;
+            }
+            if (n > 0) {
+                inf->in_len = n;
+                inf->in_pos = 1;
+                b = inf->in[0];
+            } else {
+                inf->pad = 1;
+            }
+        } else {
+            inf->pad++;
+        }
+        inf->bits |= b << inf->nbits;
+        inf->nbits += 8;
+    }
+    return true;
+}
+
+static inline uint32_t pinf_bits(pinf_t *inf, unsigned n)
+{
+    uint32_t v = inf->bits & ((1u << n) - 1);
+    inf->bits >>= n;
+    inf->nbits -= n;
+    return v;
+}
+
+/**
+ * @brief Decode a code longer than PINF_FAST_BITS one bit at a time (needs 15 bits buffered)
+ */
+static int pinf_decode_slow(pinf_t *inf, const pinf_huff_t *h)
+{
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= 15; len++) {
+        code |= pinf_bits(inf, 1);
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static inline int pinf_decode(pinf_t *inf, const pinf_huff_t *h)
+{
+    uint16_t e = h->fast[inf->bits & ((1u << PINF_FAST_BITS) - 1)];
+    if (e) {
+        inf->bits >>= e & 15;
+        inf->nbits -= e & 15;
+        return e >> 4;
+    }
+    return pinf_decode_slow(inf, h);
+}
+
+/**
+ * @brief Build a canonical Huffman code from code lengths
+ * @return <0 if the lengths over-subscribe the code space
+ */
+static int pinf_build(pinf_huff_t *h, const uint8_t *lengths, int n)
+{
+    uint16_t offs[16];
+
+    memset(h->count, 0, sizeof(h->count));
+    for (int i = 0; i < n; i++) {
+        h->count[lengths[i]]++;
+    }
+    h->count[0] = 0;
+    int left = 1;
+    for (int len = 1; len <= 15; len++) {
+        left = (left << 1) - h->count[len];
+        if (left < 0) {
+            return -1;
+        }
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len < 15; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for (int i = 0; i < n; i++) {
+        if (lengths[i]) {
+            h->symbol[offs[lengths[i]]++] = i;
+        }
+    }
+
+    // Every table slot whose low bits start with a short code maps to it.
+    // Codes are stored MSB first in an LSB-first stream, so index by the reversed code.
+    memset(h->fast, 0, sizeof(h->fast));
+    uint32_t code = 0;
+    int index = 0;
+    for (int len = 1; len <= PINF_FAST_BITS; len++) {
+        for (int k = 0; k < h->count[len]; k++, code++) {
+            uint32_t rev = 0;
+            for (int b = 0; b < len; b++) {
+                rev |= ((code >> b) & 1) << (len - 1 - b);
+            }
+            uint16_t e = h->symbol[index++] << 4 | len;
+            for (uint32_t j = rev; j < (1u << PINF_FAST_BITS); j += 1u << len) {
+                h->fast[j] = e;
+            }
+        }
+        code <<= 1;
+    }
+    return left;
+}
+
+static int pinf_fixed(pinf_t *inf)
+{
+    uint8_t lengths[288];
+
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    pinf_build(&inf->lit, lengths, 288);
+    memset(lengths, 5, 30);
+    pinf_build(&inf->dist, lengths, 30);
+    return 0;
+}
+
+static int pinf_dynamic(pinf_t *inf)
+{
+    uint8_t lengths[286 + 30];
+
+    const int hlit = pinf_bits(inf, 5) + 257;
+    const int hdist = pinf_bits(inf, 5) + 1;
+    const int hclen = pinf_bits(inf, 4) + 4;
+    if (hlit > 286 || hdist > 30) {
+        return -1;
+    }
+
+    // Code length code, decoded with the distance table as scratch
+    memset(lengths, 0, 19);
+    for (int i = 0; i < hclen; i++) {
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        lengths[s_clen_order[i]] = pinf_bits(inf, 3);
+    }
+    if (pinf_build(&inf->dist, lengths, 19) < 0) {
+        return -1;
+    }
+
+    for (int index = 0; index < hlit + hdist;) {
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        int sym = pinf_decode(inf, &inf->dist);
+        if (sym < 0) {
+            return -1;
+        }
+        if (sym < 16) {
+            lengths[index++] = sym;
+            continue;
+        }
+        uint8_t len = 0;
+        int rep;
+        if (sym == 16) {
+            if (index == 0) {
+                return -1;
+            }
+            len = lengths[index - 1];
+            rep = 3 + pinf_bits(inf, 2);
+        } else if (sym == 17) {
+            rep = 3 + pinf_bits(inf, 3);
+        } else {
+            rep = 11 + pinf_bits(inf, 7);
+        }
+        if (index + rep > hlit + hdist) {
+            return -1;
+        }
+        memset(lengths + index, len, rep);
+        index += rep;
+    }
+    if (lengths[256] == 0) {
+        return -1;  // No end-of-block code
+    }
+    if (pinf_build(&inf->lit, lengths, hlit) < 0 || pinf_build(&inf->dist, lengths + hlit, hdist) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int pinf_block(pinf_t *inf)
+{
+    if (inf->nbits <= 24 && !pinf_fill(inf)) {
+        return -1;
+    }
+    inf->last = pinf_bits(inf, 1);
+    switch (pinf_bits(inf, 2)) {
+    case 0: {
+        pinf_bits(inf, inf->nbits & 7);
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        uint32_t len = pinf_bits(inf, 16);
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        if ((pinf_bits(inf, 16) ^ 0xFFFF) != len) {
+            return -1;
+        }
+        inf->stored_left = len;
+        inf->state = PINF_STORED;
+        return 0;
+    }
+    case 1:
+        inf->state = PINF_CODES;
+        return pinf_fixed(inf);
+    case 2:
+        inf->state = PINF_CODES;
+        return pinf_dynamic(inf);
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Continue the pending match
+ */
+static size_t pinf_copy(pinf_t *inf, uint8_t *out, size_t len)
+{
+    const uint32_t mask = inf->win_mask;
+    size_t n = inf->copy_len < len ? inf->copy_len : len;
+    uint32_t from = (inf->win_pos - inf->copy_dist) & mask;
+    uint32_t to = inf->win_pos & mask;
+
+    if (inf->copy_dist >= n && from + n <= mask + 1 && to + n <= mask + 1) {
+        // Source and destination do not overlap and neither wraps around the ring
+        memcpy(out, inf->win + from, n);
+        memcpy(inf->win + to, out, n);
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            uint8_t c = inf->win[(from + i) & mask];
+            out[i] = c;
+            inf->win[(to + i) & mask] = c;
+        }
+    }
+    inf->win_pos += n;
+    inf->copy_len -= n;
+    return n;
+}
+
+static int pinf_stored(pinf_t *inf, uint8_t *out, size_t len)
+{
+    size_t n = inf->stored_left < len ? inf->stored_left : len;
+    size_t done = 0;
+
+    // Whole bytes still in the bit buffer come first
+    while (done < n && inf->nbits >= 8) {
+        if (inf->nbits <= inf->pad * 8u) {
+            return -1;
+        }
+        out[done++] = pinf_bits(inf, 8);
+    }
+    while (done < n) {
+        if (inf->in_pos == inf->in_len) {
+            int r = inf->pad ? 0 : inf->read(inf->read_ctx, inf->in, sizeof(inf->in));
+            if (r <= 0) {
+                return -1;
+            }
+            inf->in_pos = 0;
+            inf->in_len = r;
+        }
+        size_t m = inf->in_len - inf->in_pos;
+        if (m > n - done) {
+            m = n - done;
+        }
+        memcpy(out + done, inf->in + inf->in_pos, m);
+        inf->in_pos += m;
+        done += m;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        inf->win[(inf->win_pos + i) & inf->win_mask] = out[i];
+    }
+    inf->win_pos += n;
+    inf->stored_left -= n;
+    if (!inf->stored_left) {
+        inf->state = PINF_BLOCK;
+    }
+    return n;
+}
+
+static int pinf_codes(pinf_t *inf, uint8_t *out, size_t len)
+{
+    uint8_t *const win = inf->win;
+    const uint32_t mask = inf->win_mask;
+    size_t done = 0;
+
+    while (done < len) {
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        int sym = pinf_decode(inf, &inf->lit);
+        if (sym < 256) {
+            if (sym < 0) {
+                return -1;
+            }
+            out[done++] = sym;
+            win[inf->win_pos++ & mask] = sym;
+            continue;
+        }
+        if (sym == 256) {
+            inf->state = PINF_BLOCK;
+            break;
+        }
+        sym -= 257;
+        if (sym >= 29) {
+            return -1;
+        }
+        uint32_t n = s_len_base[sym] + pinf_bits(inf, s_len_extra[sym]);
+
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        int ds = pinf_decode(inf, &inf->dist);
+        if (ds < 0 || ds >= 30) {
+            return -1;
+        }
+        if (inf->nbits <= 24 && !pinf_fill(inf)) {
+            return -1;
+        }
+        uint32_t d = s_dist_base[ds] + pinf_bits(inf, s_dist_extra[ds]);
+        if (d > inf->win_pos || d > mask + 1) {
+            return -1;
+        }
+        inf->copy_len = n;
+        inf->copy_dist = d;
+        done += pinf_copy(inf, out + done, len - done);
+    }
+    return done;
+}
+
+int pinf_init(pinf_t *inf, pinf_read_cb_t read, void *read_ctx, uint32_t *window)
+{
+    memset(inf, 0, sizeof(*inf));
+    inf->read = read;
+    inf->read_ctx = read_ctx;
+    if (!pinf_fill(inf)) {
+        return -1;
+    }
+    uint32_t cmf = pinf_bits(inf, 8);
+    uint32_t flg = pinf_bits(inf, 8);
+    // Deflate only, no preset dictionary, check bits valid
+    if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (flg & 0x20) || (cmf << 8 | flg) % 31 != 0) {
+        return -1;
+    }
+    *window = 1u << ((cmf >> 4) + 8);
+    return 0;
+}
+
+void pinf_start(pinf_t *inf, uint8_t *win, uint32_t window_size)
+{
+    inf->win = win;
+    inf->win_mask = window_size - 1;
+    inf->win_pos = 0;
+    inf->state = PINF_BLOCK;
+}
+
+int pinf_read(pinf_t *inf, uint8_t *out, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        if (inf->copy_len) {
+            done += pinf_copy(inf, out + done, len - done);
+            continue;
+        }
+        int n = 0;
+        switch (inf->state) {
+        case PINF_BLOCK:
+            if (inf->last) {
+                inf->state = PINF_DONE;
+            } else if (pinf_block(inf) < 0) {
+                return -1;
+            }
+            break;
+        case PINF_STORED:
+            n = pinf_stored(inf, out + done, len - done);
+            break;
+        case PINF_CODES:
+            n = pinf_codes(inf, out + done, len - done);
+            break;
+        case PINF_DONE:
+            return done;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,96 @@
+/*
+ * Streaming zlib inflate for png_stream
+ * Pulls compressed bytes through a callback and hands out the decompressed
+ * stream in caller-sized pieces, keeping only the LZ77 window in memory
+ */
+
+#ifndef PINFLATE_H
+#define PINFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Huffman codes up to this many bits are decoded with one table lookup */
+#define PINF_FAST_BITS      9
+
+/* Compressed input is pulled in chunks of this size */
+#define PINF_IN_SIZE        512
+
+/* Largest LZ77 window zlib allows (CINFO = 7) */
+#define PINF_MAX_WINDOW     32768
+
+/**
+ * @brief Input callback, same contract as png_stream_read_cb_t
+ * @return Number of bytes read (>0), 0 at the end of the compressed data, <0 on error
+ */
+typedef int (*pinf_read_cb_t)(void *ctx, uint8_t *buf, size_t len);
+
+/* Canonical Huffman code: one-lookup table for short codes, counts/symbols for the rest */
+typedef struct {
+    uint16_t fast[1 << PINF_FAST_BITS];     // symbol << 4 | length, 0 = code longer than PINF_FAST_BITS
+    uint16_t count[16];                     // Number of codes of each length
+    uint16_t symbol[288];                   // Symbols in canonical code order
+} pinf_huff_t;
+
+typedef enum {
+    PINF_BLOCK = 0,     // At a block header
+    PINF_STORED,        // Inside a stored block
+    PINF_CODES,         // Inside a fixed or dynamic Huffman block
+    PINF_DONE,          // Last block finished
+} pinf_state_t;
+
+typedef struct {
+    pinf_read_cb_t read;
+    void *read_ctx;
+    uint8_t in[PINF_IN_SIZE];
+    uint16_t in_pos;
+    uint16_t in_len;
+    uint8_t pad;                // Zero bytes fed in after the end of the input
+    uint32_t bits;              // Bit buffer, next bit in bit 0
+    uint32_t nbits;
+    uint8_t *win;               // Ring of the last win_mask + 1 output bytes
+    uint32_t win_mask;
+    uint32_t out_total;         // Bytes output so far (saturates at the window size)
+    uint32_t win_pos;
+    pinf_state_t state;
+    bool last;                  // Current block is the final one
+    uint32_t stored_left;       // Bytes left in the stored block
+    uint32_t copy_len;          // Bytes left of the current match
+    uint32_t copy_dist;
+    pinf_huff_t lit;
+    pinf_huff_t dist;
+} pinf_t;
+
+/**
+ * @brief Read the two-byte zlib header
+ *
+ * @param[out] window Window size the header announces (256 to 32768 bytes)
+ * @return 0 on success, <0 if the header is missing or not deflate
+ */
+int pinf_init(pinf_t *inf, pinf_read_cb_t read, void *read_ctx, uint32_t *window);
+
+/**
+ * @brief Start decompressing into a window ring
+ *
+ * @param win Window of window_size bytes (a power of two). It may be smaller
+ *            than the header announced when the whole stream is known to be
+ *            shorter; distances beyond it are reported as errors.
+ */
+void pinf_start(pinf_t *inf, uint8_t *win, uint32_t window_size);
+
+/**
+ * @brief Decompress the next len bytes into out
+ * @return len, fewer at the end of the stream, <0 on corrupt or truncated data
+ */
+int pinf_read(pinf_t *inf, uint8_t *out, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PINFLATE_H
@@ -0,0 +1,553 @@
+/*
+ * PNG Stream Decoder Component
+ * Inflates a PNG one scanline at a time straight into RGB565 (plus an A8 plane)
+ */
+
+#include "png_stream.h"
+#include "pinflate.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "png_stream";
+
+static const uint8_t s_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+/* PNG colour types */
+#define PNG_GRAY            0
+#define PNG_RGB             2
+#define PNG_PALETTE         3
+#define PNG_GRAY_ALPHA      4
+#define PNG_RGBA            6
+
+struct png_stream {
+    png_stream_read_cb_t read;
+    void *read_ctx;
+    bool swap_bytes;
+    uint32_t idat_left;         // Bytes left in the current IDAT chunk
+    bool idat_end;              // Past the last IDAT chunk
+    uint16_t width;
+    uint16_t height;
+    uint8_t depth;              // Bits per sample
+    uint8_t color;              // PNG_* colour type
+    uint8_t bpp;                // Bytes per pixel for the filters, at least 1
+    bool has_alpha;
+    bool has_key;               // tRNS colour key for gray / RGB
+    uint16_t key[3];
+    uint32_t stride;            // Bytes per row without the filter byte
+    uint16_t row;               // Next row
+    uint32_t window;            // LZ77 window to allocate
+    uint8_t *win;
+    uint8_t *cur;               // Filter byte and the row being decoded
+    uint8_t *prev;              // Previous row, unfiltered
+    uint16_t palette[256];      // RGB565 in output byte order
+    uint8_t pal_alpha[256];
+    pinf_t inf;
+};
+
+static inline uint32_t png_stream_be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static inline uint16_t png_stream_rgb565(const png_stream_t *png, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint16_t c = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
+    return png->swap_bytes ? (uint16_t)(c << 8 | c >> 8) : c;
+}
+
+bool png_stream_is(const uint8_t *data, size_t size)
+{
+    return data && size >= sizeof(s_signature) && memcmp(data, s_signature, sizeof(s_signature)) == 0;
+}
+
+/**
+ * @brief Read exactly len bytes (buf NULL: skip them)
+ */
+static bool png_stream_read_full(png_stream_t *png, uint8_t *buf, size_t len)
+{
+    uint8_t skip[64];
+    while (len > 0) {
+        size_t n = len;
+        uint8_t *dst = buf;
+        if (!buf) {
+            dst = skip;
+            n = n < sizeof(skip) ? n : sizeof(skip);
+        }
+        int r = png->read(png->read_ctx, dst, n);
+        if (r <= 0) {
+            return false;
+        }
+        if (buf) {
+            buf += r;
+        }
+        len -= r;
+    }
+    return true;
+}
+
+/**
+ * @brief Inflater input: the data of consecutive IDAT chunks
+ */
+static int png_stream_idat_read(void *ctx, uint8_t *buf, size_t len)
+{
+    png_stream_t *png = (png_stream_t *)ctx;
+    while (png->idat_left == 0) {
+        uint8_t head[12];  // CRC of the previous chunk, length and type of the next
+        if (png->idat_end || !png_stream_read_full(png, head, sizeof(head)) || memcmp(head + 8, "IDAT", 4) != 0) {
+            png->idat_end = true;
+            return 0;
+        }
+        png->idat_left = png_stream_be32(head + 4);
+    }
+    if (len > png->idat_left) {
+        len = png->idat_left;
+    }
+    int n = png->read(png->read_ctx, buf, len);
+    if (n <= 0) {
+        return -1;
+    }
+    png->idat_left -= n;
+    return n;
+}
+
+static esp_err_t png_stream_ihdr(png_stream_t *png, const uint8_t *d)
+{
+    const uint32_t w = png_stream_be32(d), h = png_stream_be32(d + 4);
+    png->depth = d[8];
+    png->color = d[9];
+    if (!w || !h || d[10] != 0 || d[11] != 0 || d[12] > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (d[12] == 1 || w > UINT16_MAX || h > UINT16_MAX) {
+        ESP_LOGW(TAG, "%s PNG is not supported", d[12] ? "Interlaced" : "Huge");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    int channels;
+    bool depth_ok;
+    switch (png->color) {
+    case PNG_GRAY:
+        channels = 1;
+        depth_ok = png->depth == 1 || png->depth == 2 || png->depth == 4 || png->depth == 8 || png->depth == 16;
+        break;
+    case PNG_PALETTE:
+        channels = 1;
+        depth_ok = png->depth == 1 || png->depth == 2 || png->depth == 4 || png->depth == 8;
+        break;
+    case PNG_RGB:
+        channels = 3;
+        depth_ok = png->depth == 8 || png->depth == 16;
+        break;
+    case PNG_GRAY_ALPHA:
+        channels = 2;
+        depth_ok = png->depth == 8 || png->depth == 16;
+        break;
+    case PNG_RGBA:
+        channels = 4;
+        depth_ok = png->depth == 8 || png->depth == 16;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!depth_ok) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint32_t bits = channels * png->depth;
+    png->width = w;
+    png->height = h;
+    png->bpp = bits < 8 ? 1 : bits / 8;
+    png->stride = (w * bits + 7) / 8;
+    png->has_alpha = png->color == PNG_GRAY_ALPHA || png->color == PNG_RGBA;
+    return ESP_OK;
+}
+
+/**
+ * @brief Chunks between IHDR and the first IDAT
+ */
+static esp_err_t png_stream_header(png_stream_t *png)
+{
+    uint8_t buf[13];
+    bool have_ihdr = false, have_plte = false;
+
+    if (!png_stream_read_full(png, buf, sizeof(s_signature))) {
+        return ESP_FAIL;
+    }
+    if (!png_stream_is(buf, sizeof(s_signature))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < 256; i++) {
+        png->palette[i] = 0;
+        png->pal_alpha[i] = 0xFF;
+    }
+
+    while (true) {
+        if (!png_stream_read_full(png, buf, 8)) {
+            return ESP_FAIL;
+        }
+        const uint32_t len = png_stream_be32(buf);
+        char type[4];
+        memcpy(type, buf + 4, 4);
+        if (!have_ihdr && memcmp(type, "IHDR", 4) != 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (have_ihdr || len != 13 || !png_stream_read_full(png, buf, 13)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            esp_err_t err = png_stream_ihdr(png, buf);
+            if (err != ESP_OK) {
+                return err;
+            }
+            have_ihdr = true;
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            if (len % 3 || len > 256 * 3) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            for (uint32_t i = 0; i < len / 3; i++) {
+                if (!png_stream_read_full(png, buf, 3)) {
+                    return ESP_FAIL;
+                }
+                png->palette[i] = png_stream_rgb565(png, buf[0], buf[1], buf[2]);
+            }
+            have_plte = true;
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (png->color == PNG_PALETTE && len <= 256) {
+                if (!png_stream_read_full(png, png->pal_alpha, len)) {
+                    return ESP_FAIL;
+                }
+                png->has_alpha = true;
+            } else if ((png->color == PNG_GRAY && len == 2) || (png->color == PNG_RGB && len == 6)) {
+                if (!png_stream_read_full(png, buf, len)) {
+                    return ESP_FAIL;
+                }
+                for (uint32_t i = 0; i < len / 2; i++) {
+                    png->key[i] = buf[i * 2] << 8 | buf[i * 2 + 1];
+                }
+                png->has_key = png->has_alpha = true;
+            } else if (!png_stream_read_full(png, NULL, len)) {
+                return ESP_FAIL;
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            png->idat_left = len;
+            break;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            return ESP_ERR_INVALID_ARG;
+        } else if (!png_stream_read_full(png, NULL, len)) {
+            return ESP_FAIL;
+        }
+        if (!png_stream_read_full(png, NULL, 4)) {  // CRC
+            return ESP_FAIL;
+        }
+    }
+
+    if (png->color == PNG_PALETTE && !have_plte) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t png_stream_open(const png_stream_cfg_t *cfg, png_stream_t **out, png_stream_info_t *info)
+{
+    if (!cfg || !cfg->read || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    png_stream_t *png = heap_caps_calloc(1, sizeof(*png), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!png) {
+        png = heap_caps_calloc(1, sizeof(*png), MALLOC_CAP_DEFAULT);
+    }
+    if (!png) {
+        return ESP_ERR_NO_MEM;
+    }
+    png->read = cfg->read;
+    png->read_ctx = cfg->read_ctx;
+    png->swap_bytes = cfg->swap_bytes;
+
+    esp_err_t err = png_stream_header(png);
+    if (err == ESP_OK && pinf_init(&png->inf, png_stream_idat_read, png, &png->window) != 0) {
+        err = ESP_ERR_INVALID_ARG;
+    }
+    if (err == ESP_OK) {
+        // Images that inflate to less than the announced window need less
+        const uint64_t total = (uint64_t)png->height * (png->stride + 1);
+        while (png->window > 256 && png->window / 2 >= total) {
+            png->window /= 2;
+        }
+        png->cur = heap_caps_malloc(png->stride + 1, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        png->prev = heap_caps_calloc(1, png->stride + 1, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!png->cur || !png->prev) {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    if (err != ESP_OK) {
+        png_stream_close(png);
+        return err;
+    }
+
+    if (info) {
+        info->width = png->width;
+        info->height = png->height;
+        info->has_alpha = png->has_alpha;
+    }
+    *out = png;
+    return ESP_OK;
+}
+
+void png_stream_close(png_stream_t *png)
+{
+    if (png) {
+        heap_caps_free(png->win);
+        heap_caps_free(png->cur);
+        heap_caps_free(png->prev);
+        heap_caps_free(png);
+    }
+}
+
+static inline uint8_t png_stream_paeth(int a, int b, int c)
+{
+    // p = a + b - c; the predictor nearest to p wins, a before b before c
+    int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/**
+ * @brief Undo the row filter in place
+ */
+static bool png_stream_unfilter(uint8_t *row, const uint8_t *prev, size_t n, size_t bpp, uint8_t type)
+{
+    size_t i;
+    switch (type) {
+    case 0:
+        break;
+    case 1:
+        for (i = bpp; i < n; i++) {
+            row[i] += row[i - bpp];
+        }
+        break;
+    case 2:
+        for (i = 0; i < n; i++) {
+            row[i] += prev[i];
+        }
+        break;
+    case 3:
+        for (i = 0; i < bpp; i++) {
+            row[i] += prev[i] >> 1;
+        }
+        for (; i < n; i++) {
+            row[i] += (row[i - bpp] + prev[i]) >> 1;
+        }
+        break;
+    case 4:
+        for (i = 0; i < bpp; i++) {
+            row[i] += prev[i];
+        }
+        for (; i < n; i++) {
+            row[i] += png_stream_paeth(row[i - bpp], prev[i], prev[i - bpp]);
+        }
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Palette indices and gray samples of 1, 2, 4 (or for palettes 8) bits
+ */
+static void png_stream_convert_packed(const png_stream_t *png, const uint8_t *s, uint16_t *colors, uint8_t *alpha)
+{
+    const int depth = png->depth;
+    const int mask = (1 << depth) - 1;
+    const bool gray = png->color == PNG_GRAY;
+    for (int x = 0; x < png->width; x++) {
+        const int bit = x * depth;
+        const int v = (s[bit >> 3] >> (8 - depth - (bit & 7))) & mask;
+        if (gray) {
+            const uint8_t g = v * (255 / mask);
+            colors[x] = png_stream_rgb565(png, g, g, g);
+            if (alpha && png->has_key) {
+                alpha[x] = v == png->key[0] ? 0 : 0xFF;
+            }
+        } else {
+            colors[x] = png->palette[v];
+            if (alpha) {
+                alpha[x] = png->pal_alpha[v];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Convert one unfiltered row to RGB565 and alpha
+ */
+static void png_stream_convert(const png_stream_t *png, const uint8_t *s, uint16_t *colors, uint8_t *alpha)
+{
+    const int w = png->width;
+    const bool wide = png->depth == 16;
+    const int step = wide ? 2 : 1;  // Sample stride in bytes, 16-bit samples keep their high byte
+
+    switch (png->color) {
+    case PNG_RGBA:
+        for (int x = 0; x < w; x++, s += 4 * step) {
+            colors[x] = png_stream_rgb565(png, s[0], s[step], s[2 * step]);
+            if (alpha) {
+                alpha[x] = s[3 * step];
+            }
+        }
+        break;
+    case PNG_RGB:
+        for (int x = 0; x < w; x++, s += 3 * step) {
+            colors[x] = png_stream_rgb565(png, s[0], s[step], s[2 * step]);
+            if (alpha && png->has_key) {
+                const bool key = wide ? ((s[0] << 8 | s[1]) == png->key[0] && (s[2] << 8 | s[3]) == png->key[1] &&
+                                         (s[4] << 8 | s[5]) == png->key[2])
+                                      : (s[0] == png->key[0] && s[1] == png->key[1] && s[2] == png->key[2]);
+                alpha[x] = key ? 0 : 0xFF;
+            }
+        }
+        break;
+    case PNG_GRAY_ALPHA:
+        for (int x = 0; x < w; x++, s += 2 * step) {
+            colors[x] = png_stream_rgb565(png, s[0], s[0], s[0]);
+            if (alpha) {
+                alpha[x] = s[step];
+            }
+        }
+        break;
+    case PNG_GRAY:
+        if (png->depth < 8) {
+            png_stream_convert_packed(png, s, colors, alpha);
+            break;
+        }
+        for (int x = 0; x < w; x++, s += step) {
+            colors[x] = png_stream_rgb565(png, s[0], s[0], s[0]);
+            if (alpha && png->has_key) {
+                alpha[x] = (wide ? (s[0] << 8 | s[1]) : s[0]) == png->key[0] ? 0 : 0xFF;
+            }
+        }
+        break;
+    case PNG_PALETTE:
+        png_stream_convert_packed(png, s, colors, alpha);
+        break;
+    }
+}
+
+esp_err_t png_stream_read_row(png_stream_t *png, uint8_t *colors, uint8_t *alpha)
+{
+    if (png->row >= png->height) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!png->win) {
+        png->win = heap_caps_malloc(png->window, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!png->win) {
+            png->win = heap_caps_malloc(png->window, MALLOC_CAP_DEFAULT);
+        }
+        if (!png->win) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte window", (unsigned)png->window);
+            return ESP_ERR_NO_MEM;
+        }
+        pinf_start(&png->inf, png->win, png->window);
+    }
+
+    const size_t n = png->stride + 1;
+    if (pinf_read(&png->inf, png->cur, n) != (int)n ||
+        !png_stream_unfilter(png->cur + 1, png->prev + 1, png->stride, png->bpp, png->cur[0])) {
+        ESP_LOGE(TAG, "Image data corrupt or truncated at row %u", png->row);
+        return ESP_FAIL;
+    }
+    png_stream_convert(png, png->cur + 1, (uint16_t *)colors, png->has_alpha ? alpha : NULL);
+
+    uint8_t *t = png->prev;
+    png->prev = png->cur;
+    png->cur = t;
+    png->row++;
+    return ESP_OK;
+}
+
+esp_err_t png_stream_decode(const png_stream_cfg_t *cfg, png_stream_image_t *out)
+{
+    if (!cfg || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    png_stream_t *png;
+    png_stream_info_t info;
+    esp_err_t ret = png_stream_open(cfg, &png, &info);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Not a supported PNG: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const size_t px = (size_t)info.width * info.height;
+    const size_t fb_size = px * (info.has_alpha ? 3 : 2);
+    uint32_t caps = cfg->fb_caps ? cfg->fb_caps : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *fb = heap_caps_malloc(fb_size, caps);
+    if (!fb) {
+        fb = heap_caps_malloc(fb_size, MALLOC_CAP_DEFAULT);
+    }
+    if (!fb) {
+        ESP_LOGE(TAG, "Failed to allocate %zu byte framebuffer", fb_size);
+        ret = ESP_ERR_NO_MEM;
+    }
+
+    for (uint16_t y = 0; y < info.height && ret == ESP_OK; y++) {
+        uint8_t *colors = fb + (size_t)y * info.width * 2;
+        ret = png_stream_read_row(png, colors, info.has_alpha ? fb + px * 2 + (size_t)y * info.width : NULL);
+        const uint16_t rows = y % PNG_STREAM_BAND_ROWS + 1;
+        if (ret == ESP_OK && cfg->on_band && !info.has_alpha && (rows == PNG_STREAM_BAND_ROWS || y == info.height - 1)) {
+            const uint16_t top = y + 1 - rows;
+            cfg->on_band(cfg->band_ctx, fb + (size_t)top * info.width * 2, info.width, info.height, top, rows);
+        }
+    }
+    png_stream_close(png);
+    if (ret != ESP_OK) {
+        heap_caps_free(fb);
+        return ret;
+    }
+
+    out->pixels = fb;
+    out->width = info.width;
+    out->height = info.height;
+    out->size = fb_size;
+    out->has_alpha = info.has_alpha;
+    ESP_LOGI(TAG, "Decoded %ux%u PNG%s", info.width, info.height, info.has_alpha ? " (alpha)" : "");
+    return ESP_OK;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+} png_stream_mem_t;
+
+static int png_stream_mem_read(void *ctx, uint8_t *buf, size_t len)
+{
+    png_stream_mem_t *mem = (png_stream_mem_t *)ctx;
+    size_t n = mem->len - mem->pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buf, mem->data + mem->pos, n);
+    mem->pos += n;
+    return n;
+}
+
+esp_err_t png_stream_decode_mem(const uint8_t *data, size_t size, const png_stream_cfg_t *cfg,
+                                png_stream_image_t *out)
+{
+    if (!data || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    png_stream_mem_t mem = {.data = data, .len = size};
+    png_stream_cfg_t mem_cfg = {0};
+    if (cfg) {
+        mem_cfg = *cfg;
+    }
+    mem_cfg.read = png_stream_mem_read;
+    mem_cfg.read_ctx = &mem;
+    return png_stream_decode(&mem_cfg, out);
+}
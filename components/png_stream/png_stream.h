@@ -0,0 +1,135 @@
+/*
+ * PNG Stream Decoder Component
+ * Inflates a PNG one scanline at a time straight into RGB565 (plus an A8 plane)
+ */
+
+#ifndef PNG_STREAM_H
+#define PNG_STREAM_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stream read callback, same contract as jpeg_stream_read_cb_t
+ * @return Number of bytes read (>0), 0 on end of stream, <0 on error
+ */
+typedef int (*png_stream_read_cb_t)(void *ctx, uint8_t *buf, size_t len);
+
+/**
+ * @brief Band callback, same contract as jpeg_stream_band_cb_t
+ *
+ * Called every PNG_STREAM_BAND_ROWS rows (and for the last, shorter band)
+ * of opaque images.
+ */
+typedef void (*png_stream_band_cb_t)(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height,
+                                     uint16_t y, uint16_t rows);
+
+#define PNG_STREAM_BAND_ROWS    16
+
+/**
+ * @brief PNG stream decoder configuration
+ */
+typedef struct {
+    png_stream_read_cb_t read;      // Source of the file bytes, starting at the signature
+    void *read_ctx;                 // Passed to read()
+    bool swap_bytes;                // Emit big-endian RGB565 (LV_COLOR_16_SWAP)
+    uint32_t fb_caps;               // Heap caps for the framebuffer (0: PSRAM)
+    png_stream_band_cb_t on_band;   // Optional, called for finished bands of opaque images
+    void *band_ctx;                 // Passed to on_band()
+} png_stream_cfg_t;
+
+/**
+ * @brief Image properties known after png_stream_open()
+ */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    bool has_alpha;                 // Alpha channel or tRNS chunk present
+} png_stream_info_t;
+
+/**
+ * @brief Decoded image
+ */
+typedef struct {
+    uint8_t *pixels;                // width * height RGB565 pixels, then width * height alpha bytes if has_alpha
+    uint16_t width;
+    uint16_t height;
+    size_t size;                    // Buffer size in bytes
+    bool has_alpha;                 // Layout matches LV_IMG_CF_RGB565A8
+} png_stream_image_t;
+
+/**
+ * @brief Row-by-row decoder state
+ */
+typedef struct png_stream png_stream_t;
+
+/**
+ * @brief Whether data starts with the PNG signature
+ */
+bool png_stream_is(const uint8_t *data, size_t size);
+
+/**
+ * @brief Read the chunks up to the first IDAT and prepare to decode rows
+ *
+ * Needs about 5 KB of state; the LZ77 window (the size the zlib header
+ * announces, at most 32 KB, less for images that inflate to less) is
+ * allocated with the first row.
+ *
+ * @param cfg Decoder configuration, cfg->read is required
+ * @param[out] png Decoder, free with png_stream_close()
+ * @param[out] info Image size and whether it has alpha (may be NULL)
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the stream is not a valid PNG
+ *      - ESP_ERR_NOT_SUPPORTED for interlaced (Adam7) PNGs and sizes over 65535
+ *      - ESP_ERR_NO_MEM if the decoder state could not be allocated
+ *      - ESP_FAIL if the stream ended or failed before the image data
+ */
+esp_err_t png_stream_open(const png_stream_cfg_t *cfg, png_stream_t **png, png_stream_info_t *info);
+
+/**
+ * @brief Decode the next row
+ *
+ * @param colors Receives width RGB565 pixels in the cfg->swap_bytes order (2-byte aligned)
+ * @param alpha Receives width alpha bytes, ignored (may be NULL) for opaque images
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE after the last row
+ *      - ESP_ERR_NO_MEM if the window could not be allocated
+ *      - ESP_FAIL if the image data is corrupt or truncated
+ */
+esp_err_t png_stream_read_row(png_stream_t *png, uint8_t *colors, uint8_t *alpha);
+
+/**
+ * @brief Free a decoder (NULL is ignored)
+ */
+void png_stream_close(png_stream_t *png);
+
+/**
+ * @brief Decode a PNG stream into a newly allocated framebuffer
+ *
+ * Rows are inflated and unfiltered one at a time and written straight to the
+ * framebuffer, so the only image-sized allocation is the output itself.
+ * CRCs and the Adler-32 checksum are not verified.
+ *
+ * @return png_stream_open() and png_stream_read_row() errors
+ */
+esp_err_t png_stream_decode(const png_stream_cfg_t *cfg, png_stream_image_t *out);
+
+/**
+ * @brief png_stream_decode() for a file that is already in memory (cfg may be NULL)
+ */
+esp_err_t png_stream_decode_mem(const uint8_t *data, size_t size, const png_stream_cfg_t *cfg,
+                                png_stream_image_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PNG_STREAM_H
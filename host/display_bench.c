@@ -0,0 +1,542 @@
+/*
+ * Display pipeline benchmark: main/display_pipeline.c against an in-memory panel
+ *
+ * Every image goes through display_pipeline_from_buffer() exactly as an
+ * /upload_url download does (hash, decoded image cache, decoder, photo mode
+ * or LVGL), then one LVGL refresh draws whatever LVGL still has to draw.
+ * Per image:
+ *   - decode: display_pipeline_from_buffer() with a cache miss (full-screen
+ *     images are sent to the panel band by band inside it)
+ *   - render: the LVGL refresh that follows (draw + flush)
+ *   - hit: both again for the same bytes, served from the decoded image cache
+ *   - panel KB: bytes written to the panel for one miss, SPI ms at --spi-mhz
+ *   - heap KB: peak heap above the idle level during a miss (decoder,
+ *     framebuffer, photo mode buffers; the LVGL draw buffers are idle memory)
+ *   - overlay: panel KB and LVGL refresh time for showing a status badge over
+ *     the image with display_pipeline_set_overlay() (hidden again afterwards)
+ * Misses are forced by appending a different trailer to the data every round,
+ * which every decoder ignores.
+ *
+ * Afterwards main/lvgl_wake.c takes over from a polling LVGL task, as with
+ * CONFIG_DISPLAY_LVGL_EVENT_TASK on the device, and nothing calls
+ * lv_refr_now() any more: every image is shown again and a badge is shown
+ * over it, and each must reach the panel through the event task alone. The
+ * task must also stay asleep while nothing changes. Last an animated GIF is
+ * started while the touch read timer is paused, as on the device between
+ * touches, after its first frame is on the panel and the task sleeps again:
+ * its frames come from an LVGL timer that invalidates nothing before it
+ * runs, so frame 2 only reaches the panel if the GIF player wakes the task
+ * itself. The invalidation latency (from the first invalidation by
+ * another task to the start of lv_timer_handler()) is reported per change;
+ * its median must stay under 1 ms.
+ *
+ * Usage: display_bench [--rounds N] [--buf-lines N] [--single-buffer] [--spi-mhz N] [--dump DIR] [image ...]
+ * Without images the repo's 320x240 sample JPEGs are used, plus two IMG565
+ * images LVGL has to draw (smaller than the screen, and one with alpha).
+ * --dump writes the panel contents after each image as a PPM file.
+ */
+
+#include "display_pipeline.h"
+#include "lvgl_wake.h"
+#include "gif_player.h"
+#include "gif_writer.h"
+#include "host_panel.h"
+#include "host_heap.h"
+#include "img565.h"
+#include "bsp/esp-box-3.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_IMAGES    32
+#define BENCH_TRAILER       8
+// Event task: how long a change may take to reach the panel, and the idle period checked
+#define BENCH_WAKE_TIMEOUT_MS   500
+#define BENCH_IDLE_MS           300
+// Wakeups allowed while idle (the deadline of a timer that was already due)
+#define BENCH_IDLE_MAX_WAKEUPS  5
+// Target for the median invalidation latency
+#define BENCH_LATENCY_US        1000
+// GIF for the event task: frame delay in centiseconds
+#define BENCH_GIF_DELAY_CS      5
+
+typedef struct {
+    char name[64];
+    uint8_t *data;          // BENCH_TRAILER spare bytes at the end
+    size_t size;
+} bench_image_t;
+
+typedef struct {
+    double decode_ms;
+    double render_ms;
+    double hit_ms;
+    uint64_t panel_bytes;
+    uint32_t flushes;
+    size_t peak;
+    uint64_t overlay_bytes;
+    double overlay_ms;
+    uint16_t width;
+    uint16_t height;
+    int failed;
+} bench_result_t;
+
+static int s_rounds = 5;
+static int s_buf_lines = CONFIG_DISPLAY_DRAW_BUF_LINES;
+static bool s_double_buffer = CONFIG_DISPLAY_DRAW_BUF_COUNT == 2;
+static double s_spi_mhz = 40;
+static const char *s_dump_dir;
+static lv_disp_t *s_disp;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static bool load_file(bench_image_t *img, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    img->data = malloc((size > 0 ? size : 0) + BENCH_TRAILER);
+    img->size = size > 0 && fread(img->data, 1, size, f) == (size_t)size ? size : 0;
+    fclose(f);
+    const char *base = strrchr(path, '/');
+    snprintf(img->name, sizeof(img->name), "%s", base ? base + 1 : path);
+    return img->size > 0;
+}
+
+/**
+ * @brief Raw IMG565 image with a colour gradient and, if alpha, a soft-edged disc
+ */
+static void make_img565(bench_image_t *img, const char *name, uint16_t w, uint16_t h, bool alpha)
+{
+    const uint16_t tile_rows = 16;
+    const uint16_t tiles = (h + tile_rows - 1) / tile_rows;
+    const size_t plane = alpha ? 3 : 2;
+    const size_t head = IMG565_HEADER_SIZE + (size_t)tiles * 4;
+    img->size = head + (size_t)w * h * plane;
+    img->data = calloc(1, img->size + BENCH_TRAILER);
+    snprintf(img->name, sizeof(img->name), "%s", name);
+
+    uint8_t *p = img->data;
+    memcpy(p, IMG565_MAGIC, 4);
+    p[4] = IMG565_VERSION;
+    p[5] = alpha ? IMG565_FLAG_ALPHA : 0;
+    p[6] = IMG565_RAW;
+    p[8] = w & 0xFF;
+    p[9] = w >> 8;
+    p[10] = h & 0xFF;
+    p[11] = h >> 8;
+    p[12] = tile_rows & 0xFF;
+    p[13] = tile_rows >> 8;
+    uint8_t *out = img->data + head;
+    uint32_t end = 0;
+    for (uint16_t t = 0; t < tiles; t++) {
+        const uint16_t y0 = t * tile_rows;
+        const uint16_t rows = h - y0 < tile_rows ? h - y0 : tile_rows;
+        end += (uint32_t)w * rows * plane;
+        memcpy(img->data + IMG565_HEADER_SIZE + t * 4, &end, 4);   // Little-endian host
+        uint8_t *a = out + (size_t)w * rows * 2;
+        for (uint16_t y = y0; y < y0 + rows; y++) {
+            for (uint16_t x = 0; x < w; x++) {
+                const uint16_t c = ((x * 31 / w) << 11) | ((y * 63 / h) << 5) | ((x + y) * 31 / (w + h));
+                *out++ = c >> 8;
+                *out++ = c & 0xFF;
+                if (alpha) {
+                    const int dx = x - w / 2, dy = y - h / 2, r = h / 2;
+                    const int d2 = dx * dx + dy * dy;
+                    *a++ = d2 < (r - 16) * (r - 16) ? 255 : d2 < r * r ? 128 : 0;
+                }
+            }
+        }
+        out = a > out ? a : out;
+    }
+}
+
+/**
+ * @brief Display data and refresh LVGL once
+ * @return false if the pipeline rejected the image
+ */
+static bool show(const uint8_t *data, size_t size, double *decode_ms, double *render_ms, image_buf_t **shown)
+{
+    uint8_t key[IMAGE_CACHE_KEY_LEN];
+    double t0 = now_ms();
+    image_buf_t *buf = display_pipeline_from_buffer(data, size, key);
+    double t1 = now_ms();
+    bsp_display_lock(0);
+    lv_refr_now(s_disp);
+    bsp_display_unlock();
+    double t2 = now_ms();
+    *decode_ms = t1 - t0;
+    *render_ms = t2 - t1;
+    if (shown) {
+        *shown = buf;
+    } else {
+        image_buf_unref(buf);
+    }
+    return buf != NULL;
+}
+
+static void dump_panel(const bench_image_t *img)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%.400s/%.63s.ppm", s_dump_dir, img->name);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", BSP_LCD_H_RES, BSP_LCD_V_RES);
+    const uint8_t *px = host_panel_pixels();
+    for (int i = 0; i < BSP_LCD_H_RES * BSP_LCD_V_RES; i++, px += 2) {
+#if LV_COLOR_16_SWAP
+        const uint16_t c = (px[0] << 8) | px[1];
+#else
+        const uint16_t c = px[0] | (px[1] << 8);
+#endif
+        const uint8_t rgb[3] = {(c >> 11) * 255 / 31, ((c >> 5) & 0x3F) * 255 / 63, (c & 0x1F) * 255 / 31};
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+}
+
+static bench_result_t bench_image(bench_image_t *img)
+{
+    bench_result_t r = {0};
+    for (int round = 0; round < s_rounds; round++) {
+        // A new trailer makes the content hash new, so the image is decoded again
+        static uint32_t serial;
+        serial++;
+        memcpy(img->data + img->size, &serial, sizeof(serial));
+        const size_t size = img->size + sizeof(serial);
+
+        host_panel_reset_stats();
+        const size_t base = host_heap_used();
+        host_heap_reset_peak();
+        double decode_ms, render_ms, hit_decode_ms, hit_render_ms;
+        image_buf_t *buf = NULL;
+        if (!show(img->data, size, &decode_ms, &render_ms, &buf)) {
+            r.failed++;
+            continue;
+        }
+        r.peak = host_heap_peak() - base > r.peak ? host_heap_peak() - base : r.peak;
+        host_panel_stats_t stats;
+        host_panel_get_stats(&stats);
+        r.panel_bytes = stats.bytes;
+        r.flushes = stats.flushes;
+        r.width = buf->width;
+        r.height = buf->height;
+        image_buf_unref(buf);
+        if (round == 0 && s_dump_dir) {
+            dump_panel(img);
+        }
+
+        // A badge over the image only redraws its own area
+        host_panel_reset_stats();
+        display_pipeline_set_overlay("12:34  Wi-Fi");
+        double t0 = now_ms();
+        bsp_display_lock(0);
+        lv_refr_now(s_disp);
+        bsp_display_unlock();
+        r.overlay_ms += now_ms() - t0;
+        host_panel_get_stats(&stats);
+        r.overlay_bytes = stats.bytes;
+        display_pipeline_set_overlay(NULL);
+        bsp_display_lock(0);
+        lv_refr_now(s_disp);
+        bsp_display_unlock();
+        if (!show(img->data, size, &hit_decode_ms, &hit_render_ms, NULL)) {
+            r.failed++;
+            continue;
+        }
+        r.decode_ms += decode_ms;
+        r.render_ms += render_ms;
+        r.hit_ms += hit_decode_ms + hit_render_ms;
+    }
+    const int ok = s_rounds - r.failed;
+    if (ok > 0) {
+        r.decode_ms /= ok;
+        r.render_ms /= ok;
+        r.hit_ms /= ok;
+        r.overlay_ms /= ok;
+    }
+    return r;
+}
+
+/**
+ * @brief Wait until the panel has received new data and no more arrives for a while
+ * @return ms from the call to the last panel write, -1 if nothing arrived
+ */
+static double wait_for_panel(void)
+{
+    const double t0 = now_ms();
+    double last = -1;
+    uint64_t bytes = 0;
+    while (now_ms() - t0 < BENCH_WAKE_TIMEOUT_MS) {
+        host_panel_stats_t stats;
+        host_panel_get_stats(&stats);
+        if (stats.bytes != bytes) {
+            bytes = stats.bytes;
+            last = now_ms() - t0;
+        } else if (last >= 0 && now_ms() - t0 > last + 20) {
+            break;
+        }
+        const struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+    }
+    return last;
+}
+
+/**
+ * @brief Two-frame 64x64 GIF, looping forever, that swaps two colours every BENCH_GIF_DELAY_CS
+ */
+static void make_gif(bench_image_t *img)
+{
+    const int s = 64;
+    uint8_t pal[768] = {0};
+    pal[3] = 0xFF;      // 1: red
+    pal[8] = 0xFF;      // 2: blue
+    uint8_t idx[64 * 64];
+    gif_writer_t gw = {0};
+    gif_writer_header(&gw, s, s, pal, 0);
+    for (int f = 0; f < 2; f++) {
+        memset(idx, f + 1, sizeof(idx));
+        gif_writer_frame(&gw, 0, 0, s, s, idx, BENCH_GIF_DELAY_CS, 1, -1, false);
+    }
+    gif_writer_end(&gw);
+    snprintf(img->name, sizeof(img->name), "anim 64x64.gif");
+    img->data = gw.buf;
+    img->size = gw.len;
+}
+
+/**
+ * @brief Show a GIF's first frame, let the event task go back to sleep, then start playback
+ * @return true if frame 2 reached the panel
+ */
+static bool bench_gif_wake(void)
+{
+    bench_image_t gif;
+    make_gif(&gif);
+    gif_player_t *player = NULL;
+    image_buf_t *canvas = NULL;
+    const esp_err_t err = gif_player_create(gif.data, gif.size, &player, &canvas);
+    free(gif.data);
+    if (err != ESP_OK || !player) {
+        image_buf_unref(canvas);
+        return false;
+    }
+    static lv_img_dsc_t dsc;
+    dsc.header.cf = canvas->cf;
+    dsc.header.w = canvas->width;
+    dsc.header.h = canvas->height;
+    dsc.data_size = canvas->size;
+    dsc.data = canvas->data;
+
+    host_panel_reset_stats();
+    bsp_display_lock(0);
+    lv_obj_t *obj = lv_img_create(lv_scr_act());
+    lv_img_set_src(obj, &dsc);
+    // A new object has no size until the next layout update and a layout change does not wake the
+    // event task: lay it out here, so it is invalidated with its real area
+    lv_obj_update_layout(obj);
+    bsp_display_unlock();
+    // The first frame is drawn, the refresh timer pauses itself and nothing else is scheduled
+    bool second = false;
+    if (wait_for_panel() >= 0) {
+        host_panel_reset_stats();
+        bsp_display_lock(0);
+        const esp_err_t started = gif_player_start(player, obj, tskNO_AFFINITY);
+        bsp_display_unlock();
+        second = started == ESP_OK && wait_for_panel() >= 0;
+    }
+
+    bsp_display_lock(0);
+    gif_player_delete(player);
+    lv_obj_del(obj);
+    bsp_display_unlock();
+    wait_for_panel();
+    bsp_display_lock(0);
+    lv_img_cache_invalidate_src(&dsc);
+    bsp_display_unlock();
+    image_buf_unref(canvas);
+    return second;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Record the invalidation latency of the change just drawn, if it counted as one
+ */
+static void note_latency(uint32_t *latency, int *count, int max)
+{
+    static uint32_t invalidations;
+    lvgl_wake_stats_t stats;
+    lvgl_wake_get_stats(&stats);
+    if (stats.invalidations != invalidations && *count < max) {
+        latency[(*count)++] = stats.latency_us;
+    }
+    invalidations = stats.invalidations;
+}
+
+/**
+ * @brief Show every image and a badge over it through lvgl_wake.c's task only, then play a GIF
+ * @return Number of checks that failed
+ */
+static int bench_event_task(bench_image_t *images, int count)
+{
+    const lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    bsp_display_lock(0);
+    lv_indev_t *touch = host_touch_start();
+    bsp_display_unlock();
+    if (!touch || host_lvgl_port_start(&port_cfg) != ESP_OK ||
+        lvgl_wake_start(s_disp, touch, &port_cfg) != ESP_OK) {
+        printf("\nevent task: failed to start\n");
+        return 1;
+    }
+    if (!touch->driver->read_timer->paused) {
+        printf("\nevent task: touch read timer not paused\n");
+        return 1;
+    }
+    uint32_t latency[BENCH_MAX_IMAGES * 3];
+    int latencies = 0;
+    const int max_latencies = sizeof(latency) / sizeof(latency[0]);
+    note_latency(latency, &latencies, 0);
+    int missed = 0;
+    double image_ms = 0, badge_ms = 0;
+    for (int i = 0; i < count; i++) {
+        host_panel_reset_stats();
+        uint8_t key[IMAGE_CACHE_KEY_LEN];
+        image_buf_unref(display_pipeline_from_buffer(images[i].data, images[i].size, key));
+        const double shown = wait_for_panel();
+        note_latency(latency, &latencies, max_latencies);
+        host_panel_reset_stats();
+        display_pipeline_set_overlay("12:34  Wi-Fi");
+        const double badge = wait_for_panel();
+        note_latency(latency, &latencies, max_latencies);
+        display_pipeline_set_overlay(NULL);
+        wait_for_panel();
+        note_latency(latency, &latencies, max_latencies);
+        if (shown < 0 || badge < 0) {
+            printf("event task: %s %s never reached the panel\n", images[i].name, shown < 0 ? "image" : "badge");
+            missed++;
+            continue;
+        }
+        image_ms = shown > image_ms ? shown : image_ms;
+        badge_ms = badge > badge_ms ? badge : badge_ms;
+    }
+
+    lvgl_wake_stats_t before, after;
+    lvgl_wake_get_stats(&before);
+    const struct timespec idle = { 0, BENCH_IDLE_MS * 1000000L };
+    nanosleep(&idle, NULL);
+    lvgl_wake_get_stats(&after);
+    const uint32_t idle_wakeups = after.wakeups - before.wakeups;
+    const bool busy = idle_wakeups > BENCH_IDLE_MAX_WAKEUPS;
+
+    const bool gif_stalled = !bench_gif_wake();
+
+    qsort(latency, latencies, sizeof(latency[0]), compare_u32);
+    const uint32_t median = latencies ? latency[latencies / 2] : 0;
+    const uint32_t max = latencies ? latency[latencies - 1] : 0;
+    const bool slow = median > BENCH_LATENCY_US;
+    printf("\nevent task: %d/%d images and badges drawn without lv_refr_now(), slowest %.1f ms / %.1f ms\n",
+           count - missed, count, image_ms, badge_ms);
+    printf("  %u wakeups in %d ms idle%s\n", idle_wakeups, BENCH_IDLE_MS, busy ? " (should sleep)" : "");
+    printf("  GIF with the touch read timer paused: frame 2 %s\n",
+           gif_stalled ? "never reached the panel" : "reached the panel");
+    printf("  invalidation latency over %d changes: median %u us, max %u us%s\n", latencies, median, max,
+           slow ? " (target 1 ms)" : "");
+    return missed + busy + gif_stalled + slow;
+}
+
+int main(int argc, char **argv)
+{
+    bench_image_t images[BENCH_MAX_IMAGES];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--buf-lines") == 0 && i + 1 < argc) {
+            s_buf_lines = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--single-buffer") == 0) {
+            s_double_buffer = false;
+        } else if (strcmp(argv[i], "--spi-mhz") == 0 && i + 1 < argc) {
+            s_spi_mhz = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            s_dump_dir = argv[++i];
+        } else if (count < BENCH_MAX_IMAGES && load_file(&images[count], argv[i])) {
+            count++;
+        } else {
+            fprintf(stderr, "Cannot read %s\n", argv[i]);
+        }
+    }
+    if (count == 0) {
+        static const char *const samples[] = {"hss_320_240.jpg", "mengm.jpg", "mengm2.jpg", "rs2026.jpg"};
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", BENCH_SAMPLES_DIR, samples[i]);
+            if (load_file(&images[count], path)) {
+                count++;
+            }
+        }
+        make_img565(&images[count++], "card 240x160.i565", 240, 160, false);
+        make_img565(&images[count++], "overlay alpha.i565", 320, 240, true);
+    }
+    if (s_rounds < 1 || s_buf_lines < 1 || s_buf_lines > BSP_LCD_V_RES) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+
+    s_disp = host_display_start(s_buf_lines, s_double_buffer);
+    if (!s_disp || display_pipeline_init(s_disp, tskNO_AFFINITY) != ESP_OK) {
+        fprintf(stderr, "Display init failed\n");
+        return 1;
+    }
+    // Draw the status label once, as after boot
+    bsp_display_lock(0);
+    lv_refr_now(s_disp);
+    bsp_display_unlock();
+    printf("%d rounds per image, %u x %d line draw buffers, panel at %.0f MHz\n\n", s_rounds,
+           s_double_buffer ? 2 : 1, s_buf_lines, s_spi_mhz);
+
+    printf("%-22s %8s %7s %6s %8s %8s %8s %9s %7s %8s %11s\n", "image", "KB", "size", "path", "decode", "render", "hit",
+           "panel KB", "SPI", "heap KB", "overlay");
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        bench_result_t r = bench_image(&images[i]);
+        if (r.failed == s_rounds) {
+            printf("%-22s %8.1f  failed\n", images[i].name, images[i].size / 1024.0);
+            failed++;
+            continue;
+        }
+        char dims[16];
+        snprintf(dims, sizeof(dims), "%ux%u", r.width, r.height);
+        // Photo mode writes the panel itself, LVGL does not flush afterwards
+        const char *path = r.flushes ? "lvgl" : "photo";
+        printf("%-22s %8.1f %7s %6s %6.2fms %6.2fms %6.2fms %9.1f %5.1fms %8.1f %4.1fKB/%.2fms\n", images[i].name,
+               images[i].size / 1024.0, dims, path, r.decode_ms, r.render_ms, r.hit_ms, r.panel_bytes / 1024.0,
+               r.panel_bytes * 8 / (s_spi_mhz * 1e3), r.peak / 1024.0, r.overlay_bytes / 1024.0, r.overlay_ms);
+    }
+    printf("\ndecode: display_pipeline_from_buffer() on a cache miss (photo mode sends bands inside it)\n"
+           "render: the LVGL refresh after it; hit: both again from the decoded image cache\n"
+           "panel KB: bytes written to the panel per miss; heap KB: peak above idle during a miss\n"
+           "overlay: panel bytes and refresh time for showing a status badge over the image\n");
+    failed += bench_event_task(images, count);
+
+    for (int i = 0; i < count; i++) {
+        free(images[i].data);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,360 @@
+/*
+ * GIF playback benchmark: gif_stream against gifdec / lv_gif
+ *
+ * Per frame, lv_gif calls gd_get_frame() (previous frame disposed of, LZW
+ * into a full-size index frame) and gd_render_frame() (the new frame drawn
+ * into the canvas it shows), then invalidates the whole widget.
+ * gif_player.c splits the work: gif_stream_next_frame() runs ahead on the
+ * other core, and gif_stream_canvas_draw() in the LVGL task only touches the
+ * previous and the new frame rectangle, which is all that is invalidated.
+ *
+ * Reported per frame: time of each step, pixels invalidated and the SPI time
+ * to send them at 40 MHz, and whether the canvases of both decoders match
+ * after every frame of the first play.
+ *
+ * Usage: gif_bench [--rounds N] [anim.gif ...]
+ * Without files, three synthetic animations are encoded by a small LZW writer.
+ */
+
+#include "gif_stream.h"
+#include "gif_writer.h"
+#include "host_heap.h"
+#include "lvgl.h"
+#include "src/extra/libs/gif/gifdec.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SPI_HZ      40000000.0
+
+typedef struct {
+    const char *name;
+    uint8_t *data;
+    size_t size;
+} bench_anim_t;
+
+static int s_rounds = 5;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double spi_ms(double px)
+{
+    return px * 16 / SPI_HZ * 1e3;
+}
+
+/* --- Synthetic animations --- */
+
+static void make_palette(uint8_t *pal)
+{
+    for (int i = 0; i < 256; i++) {
+        pal[i * 3] = (i & 0xE0) | 0x10;
+        pal[i * 3 + 1] = (i << 3 & 0xE0) | 0x10;
+        pal[i * 3 + 2] = (i << 6 & 0xC0) | 0x20;
+    }
+}
+
+/**
+ * @brief A static UI background as the first frame
+ */
+static void put_background(gif_writer_t *gw, int w, int h)
+{
+    uint8_t *idx = malloc((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            idx[y * w + x] = y < 20 ? 0x25 : (x / 40 + y / 40) % 2 ? 0x49 : 0x4A;
+        }
+    }
+    gif_writer_frame(gw, 0, 0, w, h, idx, 4, 1, -1, false);
+    free(idx);
+}
+
+/**
+ * @brief Loading spinner: a 48x48 arc rotating in the middle of a static screen
+ */
+static bench_anim_t make_spinner(void)
+{
+    gif_writer_t gw = {0};
+    uint8_t pal[768];
+    make_palette(pal);
+    const int w = 320, h = 240, s = 48;
+    gif_writer_header(&gw, w, h, pal, 0x49);
+    put_background(&gw, w, h);
+    uint8_t idx[48 * 48];
+    for (int f = 0; f < 24; f++) {
+        for (int y = 0; y < s; y++) {
+            for (int x = 0; x < s; x++) {
+                const int dx = x - s / 2, dy = y - s / 2, r2 = dx * dx + dy * dy;
+                const int seg = ((dx >= 0) * 2 + (dy >= 0) + f) % 4;
+                idx[y * s + x] = r2 > 20 * 20 || r2 < 12 * 12 ? 0x49 : seg == 0 ? 0xFF : 0x92 + seg;
+            }
+        }
+        gif_writer_frame(&gw, (w - s) / 2, (h - s) / 2, s, s, idx, 4, 1, -1, false);
+    }
+    gif_writer_end(&gw);
+    return (bench_anim_t) { "spinner_320x240", gw.buf, gw.len };
+}
+
+/**
+ * @brief Sprite moving over the screen, cleared to transparent behind it (disposal 2)
+ */
+static bench_anim_t make_sprite(void)
+{
+    gif_writer_t gw = {0};
+    uint8_t pal[768];
+    make_palette(pal);
+    const int w = 320, h = 240, s = 40;
+    gif_writer_header(&gw, w, h, pal, 0);
+    put_background(&gw, w, h);
+    uint8_t idx[40 * 40];
+    for (int f = 0; f < 30; f++) {
+        for (int y = 0; y < s; y++) {
+            for (int x = 0; x < s; x++) {
+                const int dx = x - s / 2, dy = y - s / 2;
+                idx[y * s + x] = dx * dx + dy * dy > 18 * 18 ? 0 : (uint8_t)(0xE0 + (x + y + f) % 16);
+            }
+        }
+        gif_writer_frame(&gw, 10 + f * 9, 30 + (f % 10) * 15, s, s, idx, 3, 2, 0, false);
+    }
+    gif_writer_end(&gw);
+    return (bench_anim_t) { "sprite_320x240", gw.buf, gw.len };
+}
+
+/**
+ * @brief Full-frame video-like content: every frame covers the screen, some interlaced or restored
+ */
+static bench_anim_t make_video(void)
+{
+    gif_writer_t gw = {0};
+    uint8_t pal[768];
+    make_palette(pal);
+    const int w = 240, h = 160;
+    gif_writer_header(&gw, w, h, pal, 0);
+    uint8_t *idx = malloc((size_t)w * h);
+    for (int f = 0; f < 16; f++) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const int v = (x + f * 7) / 12 + (y + f * 3) / 10;
+                idx[y * w + x] = (uint8_t)(v * 37 + ((x ^ y) & 3));
+            }
+        }
+        // Frame 5 is restored afterwards (disposal 3), so frame 6 draws over frame 4
+        gif_writer_frame(&gw, 0, 0, w, h - (f == 5 ? 40 : 0), idx, 5, f == 5 ? 3 : 1, -1, f % 4 == 2);
+    }
+    free(idx);
+    gif_writer_end(&gw);
+    return (bench_anim_t) { "video_240x160", gw.buf, gw.len };
+}
+
+static bool load_file(bench_anim_t *anim, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    anim->size = ftell(f);
+    rewind(f);
+    anim->data = malloc(anim->size);
+    bool ok = anim->data && fread(anim->data, 1, anim->size, f) == anim->size;
+    fclose(f);
+    const char *slash = strrchr(path, '/');
+    anim->name = slash ? slash + 1 : path;
+    return ok;
+}
+
+/* --- Playback --- */
+
+typedef struct {
+    double lzw_ms;              // Per frame: LZW decode (gif_stream: on the other core)
+    double draw_ms;             // Per frame: composition in the LVGL task
+    double px;                  // Per frame: pixels invalidated
+    size_t peak;
+    int frames;
+} bench_result_t;
+
+static bench_result_t bench_gifdec(const bench_anim_t *anim, uint16_t frames)
+{
+    bench_result_t r = {0};
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    gd_GIF *gif = gd_open_gif_data(anim->data);
+    if (!gif) {
+        r.frames = -1;
+        return r;
+    }
+    for (int i = 0; i < frames * s_rounds; i++) {
+        const double t0 = now_ms();
+        int got = gd_get_frame(gif);
+        if (got == 0) {
+            // Loop count used up, start over as the benchmark plays on
+            gd_rewind(gif);
+            got = gd_get_frame(gif);
+        }
+        if (got != 1) {
+            r.frames = -1;
+            break;
+        }
+        const double t1 = now_ms();
+        gd_render_frame(gif, gif->canvas);  // lv_gif shows the canvas itself
+        r.lzw_ms += t1 - t0;
+        r.draw_ms += now_ms() - t1;
+        r.px += (double)gif->width * gif->height;
+        r.frames++;
+    }
+    r.peak = host_heap_peak() - base;
+    gd_close_gif(gif);
+    return r;
+}
+
+static bench_result_t bench_gif_stream(const bench_anim_t *anim, const gif_stream_info_t *info)
+{
+    bench_result_t r = {0};
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    gif_stream_cfg_t cfg = {.swap_bytes = LV_COLOR_16_SWAP};
+    gif_stream_t *gif;
+    gif_stream_canvas_t canvas;
+    if (gif_stream_open(anim->data, anim->size, &cfg, &gif, NULL) != ESP_OK ||
+        gif_stream_canvas_init(&canvas, info, 0) != ESP_OK) {
+        r.frames = -1;
+        return r;
+    }
+    // Two frames in flight, as in gif_player.c
+    gif_stream_frame_t *frame = heap_caps_malloc(sizeof(*frame) * 2, MALLOC_CAP_DEFAULT);
+    frame[0].indices = heap_caps_malloc((size_t)info->width * info->height, MALLOC_CAP_DEFAULT);
+    frame[1].indices = heap_caps_malloc((size_t)info->width * info->height, MALLOC_CAP_DEFAULT);
+    for (int i = 0; i < info->frames * s_rounds; i++) {
+        gif_stream_frame_t *f = &frame[i & 1];
+        const double t0 = now_ms();
+        if (gif_stream_next_frame(gif, f) != ESP_OK) {
+            r.frames = -1;
+            break;
+        }
+        const double t1 = now_ms();
+        gif_stream_rect_t dirty;
+        gif_stream_canvas_draw(&canvas, f, &dirty);
+        r.lzw_ms += t1 - t0;
+        r.draw_ms += now_ms() - t1;
+        r.px += (double)dirty.w * dirty.h;
+        r.frames++;
+    }
+    r.peak = host_heap_peak() - base;
+    heap_caps_free(frame[0].indices);
+    heap_caps_free(frame[1].indices);
+    heap_caps_free(frame);
+    gif_stream_canvas_deinit(&canvas);
+    heap_caps_free(canvas.pixels);
+    gif_stream_close(gif);
+    return r;
+}
+
+/**
+ * @brief Play the first pass with both decoders and compare the canvases after every frame
+ * @return Number of the first differing frame, -1 if all match
+ */
+static int compare(const bench_anim_t *anim, const gif_stream_info_t *info)
+{
+    gd_GIF *gd = gd_open_gif_data(anim->data);
+    gif_stream_cfg_t cfg = {.swap_bytes = LV_COLOR_16_SWAP};
+    gif_stream_t *gif;
+    gif_stream_canvas_t canvas;
+    gif_stream_open(anim->data, anim->size, &cfg, &gif, NULL);
+    gif_stream_canvas_init(&canvas, info, 0);
+    const size_t px = (size_t)info->width * info->height;
+    gif_stream_frame_t *frame = malloc(sizeof(*frame));
+    frame->indices = malloc(px);
+    int bad = -1;
+
+    for (int i = 0; i < info->frames && bad < 0; i++) {
+        if (gd_get_frame(gd) != 1 || gif_stream_next_frame(gif, frame) != ESP_OK) {
+            bad = i;
+            break;
+        }
+        gd_render_frame(gd, gd->canvas);
+        const uint8_t *ref = gd->canvas;
+        gif_stream_canvas_draw(&canvas, frame, NULL);
+        const uint8_t *colors = canvas.pixels;
+        for (size_t p = 0; p < px; p++) {
+            const uint8_t a = canvas.has_alpha ? canvas.pixels[px * 2 + p] : 0xFF;
+            // Fully transparent pixels only need matching alpha
+            if (ref[p * 3 + 2] != a || (a && memcmp(ref + p * 3, colors + p * 2, 2) != 0)) {
+                bad = i;
+                break;
+            }
+        }
+    }
+    free(frame->indices);
+    free(frame);
+    gif_stream_canvas_deinit(&canvas);
+    heap_caps_free(canvas.pixels);
+    gif_stream_close(gif);
+    gd_close_gif(gd);
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    bench_anim_t anims[32];
+    int count = 0;
+    for (int i = 1; i < argc && count < 32; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (load_file(&anims[count], argv[i])) {
+            count++;
+        }
+    }
+    if (count == 0) {
+        anims[count++] = make_spinner();
+        anims[count++] = make_sprite();
+        anims[count++] = make_video();
+    }
+
+    lv_init();
+    printf("%d plays, per frame averages, SPI at %.0f MHz\n\n", s_rounds, SPI_HZ / 1e6);
+    printf("%-17s %7s %6s | %-37s | %-45s | %s\n", "", "", "", "gifdec / lv_gif", "gif_stream / gif_player", "");
+    printf("%-17s %7s %6s | %7s %7s %7s %6s %6s | %7s %7s %7s %6s %6s %6s | %s\n",
+           "animation", "bytes", "frames", "lzw", "render", "px", "SPI", "KB", "lzw", "draw", "px", "SPI", "KB",
+           "alpha", "canvas");
+    for (int i = 0; i < count; i++) {
+        const bench_anim_t *anim = &anims[i];
+        gif_stream_t *gif;
+        gif_stream_info_t info;
+        esp_err_t err = gif_stream_open(anim->data, anim->size, NULL, &gif, &info);
+        if (err != ESP_OK) {
+            printf("%-17s %s\n", anim->name, esp_err_to_name(err));
+            continue;
+        }
+        gif_stream_close(gif);
+
+        bench_result_t gd = bench_gifdec(anim, info.frames);
+        bench_result_t gs = bench_gif_stream(anim, &info);
+        const int bad = compare(anim, &info);
+        char verdict[32];
+        if (bad < 0) {
+            snprintf(verdict, sizeof(verdict), "identical");
+        } else {
+            snprintf(verdict, sizeof(verdict), "DIFFER at frame %d", bad);
+        }
+        if (gd.frames <= 0 || gs.frames <= 0) {
+            printf("%-17s decode failed (gifdec %d, gif_stream %d frames)\n", anim->name, gd.frames, gs.frames);
+            continue;
+        }
+        printf("%-17s %7zu %6u | %5.3fms %5.3fms %7.0f %4.1fms %6.1f | %5.3fms %5.3fms %7.0f %4.1fms %6.1f %6s | %s\n",
+               anim->name, anim->size, info.frames,
+               gd.lzw_ms / gd.frames, gd.draw_ms / gd.frames, gd.px / gd.frames, spi_ms(gd.px / gd.frames),
+               gd.peak / 1024.0,
+               gs.lzw_ms / gs.frames, gs.draw_ms / gs.frames, gs.px / gs.frames, spi_ms(gs.px / gs.frames),
+               gs.peak / 1024.0, info.has_alpha ? "yes" : "no", verdict);
+    }
+    printf("\nlzw: gd_get_frame() / gif_stream_next_frame(); render/draw: what runs in the LVGL timer\n"
+           "px / SPI: area invalidated per frame and the time to send it to the panel\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Minimal GIF writer for the host benchmarks and tests
+ */
+
+#include "gif_writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void put(gif_writer_t *gw, const void *p, size_t n)
+{
+    if (gw->len + n > gw->cap) {
+        gw->cap = (gw->len + n) * 2;
+        gw->buf = realloc(gw->buf, gw->cap);
+    }
+    memcpy(gw->buf + gw->len, p, n);
+    gw->len += n;
+}
+
+static void put8(gif_writer_t *gw, uint8_t v)
+{
+    put(gw, &v, 1);
+}
+
+static void put16(gif_writer_t *gw, uint16_t v)
+{
+    put8(gw, v & 0xFF);
+    put8(gw, v >> 8);
+}
+
+static void put_code(gif_writer_t *gw, uint16_t code, int size)
+{
+    gw->bits |= (uint32_t)code << gw->nbits;
+    gw->nbits += size;
+    while (gw->nbits >= 8) {
+        gw->block[++gw->block[0]] = gw->bits & 0xFF;
+        gw->bits >>= 8;
+        gw->nbits -= 8;
+        if (gw->block[0] == 255) {
+            put(gw, gw->block, 256);
+            gw->block[0] = 0;
+        }
+    }
+}
+
+/**
+ * @brief LZW-encode count indices as GIF image data (8-bit codes, dictionary reset when full)
+ */
+static void put_lzw(gif_writer_t *gw, const uint8_t *idx, size_t count)
+{
+    static uint16_t child[4096][256];   // Code for (prefix code, next byte), 0 for none
+    const int min_size = 8;
+    const uint16_t clear = 1 << min_size, eoi = clear + 1;
+    uint16_t next = eoi + 1;
+    int size = min_size + 1;
+    memset(child, 0, sizeof(child));
+
+    put8(gw, min_size);
+    gw->block[0] = 0;
+    gw->bits = 0;
+    gw->nbits = 0;
+    put_code(gw, clear, size);
+    uint16_t cur = idx[0];
+    for (size_t i = 1; i < count; i++) {
+        const uint8_t b = idx[i];
+        if (child[cur][b]) {
+            cur = child[cur][b];
+            continue;
+        }
+        put_code(gw, cur, size);
+        if (next < 4096) {
+            child[cur][b] = next++;
+            if (next - 1 == (1 << size) && size < 12) {
+                size++;
+            }
+        } else {
+            put_code(gw, clear, size);
+            memset(child, 0, sizeof(child));
+            next = eoi + 1;
+            size = min_size + 1;
+        }
+        cur = b;
+    }
+    put_code(gw, cur, size);
+    put_code(gw, eoi, size);
+    if (gw->nbits > 0) {
+        gw->block[++gw->block[0]] = gw->bits & 0xFF;
+    }
+    if (gw->block[0]) {
+        put(gw, gw->block, gw->block[0] + 1);
+    }
+    put8(gw, 0);
+}
+
+void gif_writer_header(gif_writer_t *gw, int w, int h, const uint8_t *palette, uint8_t bg)
+{
+    put(gw, "GIF89a", 6);
+    put16(gw, w);
+    put16(gw, h);
+    put8(gw, 0xF7);     // Global colour table of 256 entries
+    put8(gw, bg);
+    put8(gw, 0);
+    put(gw, palette, 768);
+    // NETSCAPE2.0, loop forever
+    static const uint8_t loop[] = {0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0};
+    put(gw, loop, sizeof(loop));
+}
+
+void gif_writer_frame(gif_writer_t *gw, int x, int y, int w, int h, const uint8_t *idx,
+                      int delay_cs, int disposal, int transparent, bool interlaced)
+{
+    put8(gw, 0x21);
+    put8(gw, 0xF9);
+    put8(gw, 4);
+    put8(gw, disposal << 2 | (transparent >= 0));
+    put16(gw, delay_cs);
+    put8(gw, transparent >= 0 ? transparent : 0);
+    put8(gw, 0);
+
+    put8(gw, 0x2C);
+    put16(gw, x);
+    put16(gw, y);
+    put16(gw, w);
+    put16(gw, h);
+    put8(gw, interlaced ? 0x40 : 0);
+    if (!interlaced) {
+        put_lzw(gw, idx, (size_t)w * h);
+        return;
+    }
+    uint8_t *rows = malloc((size_t)w * h);
+    static const int start[4] = {0, 4, 2, 1}, step[4] = {8, 8, 4, 2};
+    size_t n = 0;
+    for (int pass = 0; pass < 4; pass++) {
+        for (int r = start[pass]; r < h; r += step[pass], n += w) {
+            memcpy(rows + n, idx + (size_t)r * w, w);
+        }
+    }
+    put_lzw(gw, rows, n);
+    free(rows);
+}
+
+void gif_writer_end(gif_writer_t *gw)
+{
+    put8(gw, 0x3B);
+}
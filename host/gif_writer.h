@@ -0,0 +1,38 @@
+/*
+ * Minimal GIF writer for the host benchmarks and tests: 256-colour global
+ * palette, looping forever, one LZW-coded image per frame
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Writer state; start from {0}, the GIF is buf[0..len) (free buf afterwards)
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    uint8_t block[256];         // Data sub-block being filled, block[0] is its size
+    uint32_t bits;
+    int nbits;
+} gif_writer_t;
+
+/**
+ * @brief Logical screen, global palette (768 bytes of RGB) and the NETSCAPE2.0 loop extension
+ */
+void gif_writer_header(gif_writer_t *gw, int w, int h, const uint8_t *palette, uint8_t bg);
+
+/**
+ * @brief Write one frame; rows of idx are in display order, interlaced frames are reordered here
+ */
+void gif_writer_frame(gif_writer_t *gw, int x, int y, int w, int h, const uint8_t *idx,
+                      int delay_cs, int disposal, int transparent, bool interlaced);
+
+/**
+ * @brief Trailer, after the last frame
+ */
+void gif_writer_end(gif_writer_t *gw);
@@ -0,0 +1,218 @@
+/*
+ * In-memory panel, LVGL display and display lock for the host build
+ */
+
+#include "host_panel.h"
+#include "lvgl_port_ctx.h"
+#include "bsp/esp-box-3.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_touch.h"
+#include "esp_lvgl_port.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct esp_lcd_panel_t {
+    uint8_t gram[BSP_LCD_H_RES * BSP_LCD_V_RES * 2];
+};
+
+struct esp_lcd_panel_io_t {
+    int unused;
+};
+
+struct esp_lcd_touch_s {
+    esp_lcd_touch_interrupt_callback_t isr;
+};
+
+static struct esp_lcd_panel_t s_panel;
+static struct esp_lcd_panel_io_t s_io;
+static struct esp_lcd_touch_s s_touch;
+// Stands in for esp_lvgl_port's touch context, read through lvgl_port_ctx_touch()
+static lvgl_port_ctx_touch_t s_touch_port = { .handle = &s_touch };
+static lv_indev_drv_t s_touch_drv;
+// Stands in for esp_lvgl_port's display context, read through lvgl_port_ctx_disp()
+static lvgl_port_ctx_disp_t s_port = { .io_handle = &s_io, .panel_handle = &s_panel };
+static host_panel_stats_t s_stats;
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_drv_t s_disp_drv;
+static pthread_mutex_t s_lvgl_lock;
+// host_lvgl_port_start(): the tick and lv_timer_handler() run while this is set
+static volatile bool s_port_running;
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data)
+{
+    if (!panel || !color_data || x_start < 0 || y_start < 0 || x_end > BSP_LCD_H_RES || y_end > BSP_LCD_V_RES ||
+        x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const size_t row = (size_t)(x_end - x_start) * 2;
+    const uint8_t *src = (const uint8_t *)color_data;
+    for (int y = y_start; y < y_end; y++, src += row) {
+        memcpy(panel->gram + ((size_t)y * BSP_LCD_H_RES + x_start) * 2, src, row);
+    }
+    s_stats.draws++;
+    s_stats.bytes += row * (y_end - y_start);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    (void)lcd_cmd;
+    (void)param;
+    (void)param_size;
+    if (!io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_stats.commands++;
+    return ESP_OK;
+}
+
+/* Same as esp_lvgl_port's flush callback; the copy is synchronous, so the flush is ready at once */
+static void host_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const lvgl_port_ctx_disp_t *port = (const lvgl_port_ctx_disp_t *)drv->user_data;
+    esp_lcd_panel_draw_bitmap(port->panel_handle, area->x1, area->y1, area->x2 + 1, area->y2 + 1, color_map);
+    s_stats.flushes++;
+    lv_disp_flush_ready(drv);
+}
+
+lv_disp_t *host_display_start(uint16_t buf_lines, bool double_buffer)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_lvgl_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    lv_init();
+    // Internal DMA memory on the device, counted in the host heap too
+    const uint32_t pixels = (uint32_t)BSP_LCD_H_RES * buf_lines;
+    void *buf1 = heap_caps_malloc(pixels * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    void *buf2 = double_buffer ? heap_caps_malloc(pixels * sizeof(lv_color_t), MALLOC_CAP_DMA) : NULL;
+    if (!buf1 || (double_buffer && !buf2)) {
+        return NULL;
+    }
+    lv_disp_draw_buf_init(&s_draw_buf, buf1, buf2, pixels);
+    lv_disp_drv_init(&s_disp_drv);
+    s_disp_drv.hor_res = BSP_LCD_H_RES;
+    s_disp_drv.ver_res = BSP_LCD_V_RES;
+    s_disp_drv.flush_cb = host_flush_cb;
+    s_disp_drv.draw_buf = &s_draw_buf;
+    s_disp_drv.user_data = &s_port;
+    return lv_disp_drv_register(&s_disp_drv);
+}
+
+esp_err_t esp_lcd_touch_register_interrupt_callback(esp_lcd_touch_handle_t tp,
+                                                    esp_lcd_touch_interrupt_callback_t callback)
+{
+    if (!tp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    tp->isr = callback;
+    return ESP_OK;
+}
+
+/* Nobody touches the host panel */
+static void host_touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    data->state = LV_INDEV_STATE_RELEASED;
+}
+
+lv_indev_t *host_touch_start(void)
+{
+    lv_indev_drv_init(&s_touch_drv);
+    s_touch_drv.type = LV_INDEV_TYPE_POINTER;
+    s_touch_drv.read_cb = host_touch_read_cb;
+    s_touch_drv.user_data = &s_touch_port;
+    return lv_indev_drv_register(&s_touch_drv);
+}
+
+const uint8_t *host_panel_pixels(void)
+{
+    return s_panel.gram;
+}
+
+void host_panel_get_stats(host_panel_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void host_panel_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+bool bsp_display_lock(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    return pthread_mutex_lock(&s_lvgl_lock) == 0;
+}
+
+void bsp_display_unlock(void)
+{
+    pthread_mutex_unlock(&s_lvgl_lock);
+}
+
+/* esp_lvgl_port's task loop, with its tick timer folded in */
+static void host_port_task(void *arg)
+{
+    const lvgl_port_cfg_t *cfg = arg;
+    const uint32_t max_sleep_ms = cfg->task_max_sleep_ms;
+    free(arg);
+    int64_t tick_us = esp_timer_get_time();
+    for (;;) {
+        uint32_t delay_ms = max_sleep_ms;
+        if (bsp_display_lock(0)) {
+            const int64_t now = esp_timer_get_time();
+            if (s_port_running) {
+                lv_tick_inc((uint32_t)((now - tick_us) / 1000));
+            }
+            tick_us = now - (now - tick_us) % 1000;
+            delay_ms = lv_timer_handler();
+            bsp_display_unlock();
+        }
+        if (delay_ms > max_sleep_ms || delay_ms == 1) {
+            delay_ms = max_sleep_ms;
+        } else if (delay_ms < 1) {
+            delay_ms = 1;
+        }
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+}
+
+esp_err_t host_lvgl_port_start(const lvgl_port_cfg_t *cfg)
+{
+    lvgl_port_cfg_t *copy = malloc(sizeof(*copy));
+    if (!copy) {
+        return ESP_ERR_NO_MEM;
+    }
+    *copy = *cfg;
+    s_port_running = true;
+    if (xTaskCreatePinnedToCore(host_port_task, "taskLVGL", cfg->task_stack, copy, cfg->task_priority, NULL,
+                                tskNO_AFFINITY) != pdPASS) {
+        free(copy);
+        s_port_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t lvgl_port_stop(void)
+{
+    lv_timer_enable(false);
+    s_port_running = false;
+    return ESP_OK;
+}
+
+esp_err_t lvgl_port_resume(void)
+{
+    lv_timer_enable(true);
+    s_port_running = true;
+    return ESP_OK;
+}
@@ -0,0 +1,689 @@
+/*
+ * Host implementations of the ESP-IDF and FreeRTOS functions the decoders call
+ */
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "mbedtls/sha256.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Each block carries its size in front so frees can be counted
+#define HOST_HEAP_HEADER    16
+
+static size_t s_used;
+static size_t s_peak;
+// jpeg_stream decodes on two threads with CONFIG_JPEG_STREAM_PARALLEL
+static pthread_mutex_t s_heap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *host_malloc(size_t size)
+{
+    uint8_t *p = malloc(size + HOST_HEAP_HEADER);
+    if (!p) {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof(size));
+    pthread_mutex_lock(&s_heap_lock);
+    s_used += size;
+    if (s_used > s_peak) {
+        s_peak = s_used;
+    }
+    pthread_mutex_unlock(&s_heap_lock);
+    return p + HOST_HEAP_HEADER;
+}
+
+void host_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    uint8_t *p = (uint8_t *)ptr - HOST_HEAP_HEADER;
+    size_t size;
+    memcpy(&size, p, sizeof(size));
+    pthread_mutex_lock(&s_heap_lock);
+    s_used -= size;
+    pthread_mutex_unlock(&s_heap_lock);
+    free(p);
+}
+
+void *host_realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return host_malloc(size);
+    }
+    uint8_t *p = (uint8_t *)ptr - HOST_HEAP_HEADER;
+    size_t old;
+    memcpy(&old, p, sizeof(old));
+    uint8_t *q = realloc(p, size + HOST_HEAP_HEADER);
+    if (!q) {
+        return NULL;
+    }
+    memcpy(q, &size, sizeof(size));
+    pthread_mutex_lock(&s_heap_lock);
+    s_used = s_used - old + size;
+    if (s_used > s_peak) {
+        s_peak = s_used;
+    }
+    pthread_mutex_unlock(&s_heap_lock);
+    return q + HOST_HEAP_HEADER;
+}
+
+size_t host_heap_used(void)
+{
+    return s_used;
+}
+
+size_t host_heap_peak(void)
+{
+    return s_peak;
+}
+
+void host_heap_reset_peak(void)
+{
+    s_peak = s_used;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return host_malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = host_malloc(n * size);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return host_realloc(ptr, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    host_free(ptr);
+}
+
+/* --- FreeRTOS --- */
+
+struct host_task {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    bool suspended;
+};
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+    struct host_task *task;
+} host_task_start_t;
+
+static __thread struct host_task *s_current_task;
+
+static struct host_task *host_task_new(void)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task) {
+        pthread_mutex_init(&task->lock, NULL);
+        pthread_cond_init(&task->cond, NULL);
+    }
+    return task;
+}
+
+static void *host_task_main(void *arg)
+{
+    host_task_start_t start = *(host_task_start_t *)arg;
+    free(arg);
+    s_current_task = start.task;
+    start.fn(start.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+    (void)core;
+    host_task_start_t *start = malloc(sizeof(*start));
+    struct host_task *task = host_task_new();
+    pthread_t thread;
+    if (!start || !task) {
+        free(start);
+        free(task);
+        return pdFAIL;
+    }
+    start->fn = fn;
+    start->arg = arg;
+    start->task = task;
+    if (handle) {
+        *handle = task;     // Before the task runs, it may use the handle at once
+    }
+    if (pthread_create(&thread, NULL, host_task_main, start) != 0) {
+        free(start);
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+    // The task struct stays: other tasks may still notify it
+    pthread_exit(NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!s_current_task) {
+        s_current_task = host_task_new();
+    }
+    return s_current_task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    const struct timespec ts = { ticks / 1000, (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+    struct host_task *self = xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&self->lock);
+    while (self->suspended) {
+        pthread_cond_wait(&self->cond, &self->lock);
+    }
+    pthread_mutex_unlock(&self->lock);
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&task->lock);
+    task->suspended = true;
+    pthread_mutex_unlock(&task->lock);
+}
+
+void vTaskResume(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->suspended = false;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+/* Absolute CLOCK_REALTIME time us from now, for pthread_cond_timedwait() */
+static struct timespec host_deadline_us(int64_t us)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += us / 1000000;
+    ts.tv_nsec += (long)(us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *self = xTaskGetCurrentTaskHandle();
+    const struct timespec deadline = host_deadline_us((int64_t)ticks * 1000);
+    pthread_mutex_lock(&self->lock);
+    while (!self->notify && ticks) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&self->cond, &self->lock);
+        } else if (pthread_cond_timedwait(&self->cond, &self->lock, &deadline) != 0) {
+            break;
+        }
+    }
+    const uint32_t value = self->notify;
+    if (value) {
+        self->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return value;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    (void)task;
+    return 1;
+}
+
+static pthread_mutex_t s_critical;
+static pthread_once_t s_critical_once = PTHREAD_ONCE_INIT;
+
+static void host_critical_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void vTaskEnterCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_once(&s_critical_once, host_critical_init);
+    pthread_mutex_lock(&s_critical);
+}
+
+void vTaskExitCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    pthread_mutex_unlock(&s_critical);
+}
+
+/* --- esp_timer --- */
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+struct esp_timer {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    esp_timer_cb_t callback;
+    void *arg;
+    int64_t due_us;         // -1 while stopped
+    bool deleted;
+};
+
+static void *host_timer_main(void *arg)
+{
+    esp_timer_handle_t timer = arg;
+    pthread_mutex_lock(&timer->lock);
+    while (!timer->deleted) {
+        if (timer->due_us < 0) {
+            pthread_cond_wait(&timer->cond, &timer->lock);
+            continue;
+        }
+        const int64_t wait_us = timer->due_us - esp_timer_get_time();
+        if (wait_us > 0) {
+            const struct timespec until = host_deadline_us(wait_us);
+            // Woken early by a stop, restart or delete: look again
+            pthread_cond_timedwait(&timer->cond, &timer->lock, &until);
+            continue;
+        }
+        timer->due_us = -1;
+        pthread_mutex_unlock(&timer->lock);
+        timer->callback(timer->arg);
+        pthread_mutex_lock(&timer->lock);
+    }
+    pthread_mutex_unlock(&timer->lock);
+    pthread_cond_destroy(&timer->cond);
+    pthread_mutex_destroy(&timer->lock);
+    free(timer);
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (!args || !args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_mutex_init(&timer->lock, NULL);
+    pthread_cond_init(&timer->cond, NULL);
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    timer->due_us = -1;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, host_timer_main, timer) != 0) {
+        free(timer);
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_detach(thread);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    pthread_mutex_lock(&timer->lock);
+    const bool running = timer->due_us >= 0;
+    if (!running) {
+        timer->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+        pthread_cond_signal(&timer->cond);
+    }
+    pthread_mutex_unlock(&timer->lock);
+    return running ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer->lock);
+    const bool running = timer->due_us >= 0;
+    timer->due_us = -1;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return running ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    // The timer thread frees it
+    pthread_mutex_lock(&timer->lock);
+    timer->deleted = true;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return ESP_OK;
+}
+
+struct host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int given;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (sem) {
+        pthread_mutex_init(&sem->lock, NULL);
+        pthread_cond_init(&sem->cond, NULL);
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    if (sem) {
+        sem->given = 1;
+    }
+    return sem;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    BaseType_t ret = sem->given ? pdFALSE : pdTRUE;
+    sem->given = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    pthread_mutex_lock(&sem->lock);
+    while (!sem->given && ticks) {
+        pthread_cond_wait(&sem->cond, &sem->lock);
+    }
+    BaseType_t ret = sem->given ? pdTRUE : pdFALSE;
+    sem->given = 0;
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t items[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q) + (size_t)length * item_size);
+    if (q) {
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->changed, NULL);
+        q->length = length;
+        q->item_size = item_size;
+    }
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->length && ticks) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    BaseType_t ret = pdFALSE;
+    if (q->count < q->length) {
+        memcpy(q->items + (size_t)((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+        q->count++;
+        pthread_cond_broadcast(&q->changed);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && ticks) {
+        pthread_cond_wait(&q->changed, &q->lock);
+    }
+    BaseType_t ret = pdFALSE;
+    if (q->count > 0) {
+        memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_broadcast(&q->changed);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    pthread_cond_destroy(&q->changed);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
+
+/* --- mbedtls SHA-256 (FIPS 180-4) --- */
+
+static const uint32_t s_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define SHA256_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t state[8], const uint8_t *p)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 | (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = SHA256_ROR(w[i - 15], 7) ^ SHA256_ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = SHA256_ROR(w[i - 2], 17) ^ SHA256_ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (SHA256_ROR(e, 6) ^ SHA256_ROR(e, 11) ^ SHA256_ROR(e, 25)) + ((e & f) ^ (~e & g)) +
+                      s_sha256_k[i] + w[i];
+        uint32_t t2 = (SHA256_ROR(a, 2) ^ SHA256_ROR(a, 13) ^ SHA256_ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    if (is224) {
+        return -1;
+    }
+    memcpy(ctx->state, init, sizeof(init));
+    ctx->total = 0;
+    return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen)
+{
+    size_t fill = ctx->total % 64;
+    ctx->total += ilen;
+    if (fill && fill + ilen >= 64) {
+        memcpy(ctx->block + fill, input, 64 - fill);
+        sha256_block(ctx->state, ctx->block);
+        input += 64 - fill;
+        ilen -= 64 - fill;
+        fill = 0;
+    }
+    for (; ilen >= 64 && fill == 0; input += 64, ilen -= 64) {
+        sha256_block(ctx->state, input);
+    }
+    memcpy(ctx->block + fill, input, ilen);
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+    const uint64_t bits = ctx->total * 8;
+    uint8_t pad[72] = {0x80};
+    const size_t fill = ctx->total % 64;
+    const size_t pad_len = (fill < 56 ? 56 : 120) - fill;
+    for (int i = 0; i < 8; i++) {
+        pad[pad_len + i] = (uint8_t)(bits >> (56 - i * 8));
+    }
+    mbedtls_sha256_update(ctx, pad, pad_len + 8);
+    for (int i = 0; i < 8; i++) {
+        output[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+        output[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        output[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        output[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+    return 0;
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char output[32], int is224)
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    int ret = mbedtls_sha256_starts(&ctx, is224);
+    if (ret == 0) {
+        mbedtls_sha256_update(&ctx, input, ilen);
+        mbedtls_sha256_finish(&ctx, output);
+    }
+    mbedtls_sha256_free(&ctx);
+    return ret;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+    default: {
+        static char buf[16];
+        snprintf(buf, sizeof(buf), "0x%x", code);
+        return buf;
+    }
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * Huffman decoding benchmark: LVGL's TJpgDec against components/jpeg_stream's jdec
+ *
+ * Reproduces the table of the Huffman lookup table change: every JPEG is
+ * decoded at full size to RGB888 by
+ *   - FD0/FD1/FD2: LVGL's TJpgDec with JD_FASTDECODE 0, 1 and 2
+ *     (FD2 adds TJpgDec's own 10-bit Huffman tables, 6 KB)
+ *   - LUT0/8/9/10: jdec with CONFIG_JPEG_STREAM_HUFF_LUT_BITS 0 (bit-serial
+ *     search), 8, 9 (the default) and 10
+ * and the fastest of --rounds runs is printed in ms, since a busy host only
+ * ever makes a run slower. The lookup table must not change the output: the
+ * jdec builds are checked byte for byte against LUT0 and the program returns
+ * 1 if one differs. TJpgDec's output is only compared for information (FD0
+ * clips the YCbCr samples earlier).
+ *
+ * Usage: huff_bench [--rounds N] [image.jpg ...]
+ * Without images mengm.jpg, rs2026.jpg and hss_320_240.jpg are used.
+ */
+
+#include "huff_variant.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_IMAGES    32
+#define BENCH_RGB_MAX       (2048 * 2048 * 3)
+
+typedef struct {
+    const char *name;
+    huff_decode_fn_t decode;
+    bool jdec;                  // Output must match LUT0
+} bench_variant_t;
+
+static const bench_variant_t s_variants[] = {
+    { "FD0", huff_fd0_decode, false },
+    { "FD1", huff_fd1_decode, false },
+    { "FD2", huff_fd2_decode, false },
+    { "LUT0", huff_lut0_decode, true },
+    { "LUT8", huff_lut8_decode, true },
+    { "LUT9", huff_lut9_decode, true },
+    { "LUT10", huff_lut10_decode, true },
+};
+#define BENCH_VARIANTS  (sizeof(s_variants) / sizeof(s_variants[0]))
+#define BENCH_LUT0      3
+
+static int s_rounds = 20;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint8_t *load_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? malloc(len) : NULL;
+    if (data && fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+/**
+ * @brief Time every variant on one image
+ * @return Number of jdec builds whose output differs from LUT0's
+ */
+static int bench_image(const char *name, const uint8_t *data, size_t size, uint8_t *rgb[BENCH_VARIANTS])
+{
+    double best[BENCH_VARIANTS];
+    uint16_t w = 0, h = 0;
+    for (size_t v = 0; v < BENCH_VARIANTS; v++) {
+        best[v] = DBL_MAX;
+        for (int r = 0; r < s_rounds; r++) {
+            const double t0 = now_ms();
+            if (!s_variants[v].decode(data, size, rgb[v], BENCH_RGB_MAX, &w, &h)) {
+                best[v] = -1;
+                break;
+            }
+            const double ms = now_ms() - t0;
+            best[v] = ms < best[v] ? ms : best[v];
+        }
+    }
+
+    int differ = 0;
+    char same[BENCH_VARIANTS * 8] = "";
+    const size_t bytes = (size_t)w * h * 3;
+    printf("%-18s", name);
+    for (size_t v = 0; v < BENCH_VARIANTS; v++) {
+        if (best[v] < 0) {
+            printf(" %6s", "failed");
+        } else {
+            printf(" %6.2f", best[v]);
+        }
+        if (v != BENCH_LUT0 && best[v] >= 0 && best[BENCH_LUT0] >= 0 && memcmp(rgb[v], rgb[BENCH_LUT0], bytes)) {
+            strcat(same, " ");
+            strcat(same, s_variants[v].name);
+            differ += s_variants[v].jdec;
+        }
+        differ += best[v] < 0 && s_variants[v].jdec;
+    }
+    printf("  %s%s\n", same[0] ? "differ from LUT0:" : "all the same", same);
+    return differ;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const samples[] = {"mengm.jpg", "rs2026.jpg", "hss_320_240.jpg"};
+    const char *paths[BENCH_MAX_IMAGES];
+    char sample_paths[3][512];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (count < BENCH_MAX_IMAGES) {
+            paths[count++] = argv[i];
+        }
+    }
+    if (count == 0) {
+        for (int i = 0; i < 3; i++) {
+            snprintf(sample_paths[i], sizeof(sample_paths[i]), "%s/%s", BENCH_SAMPLES_DIR, samples[i]);
+            paths[count++] = sample_paths[i];
+        }
+    }
+    if (s_rounds < 1) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+
+    uint8_t *rgb[BENCH_VARIANTS];
+    for (size_t v = 0; v < BENCH_VARIANTS; v++) {
+        rgb[v] = malloc(BENCH_RGB_MAX);
+    }
+    printf("ms per full-size decode to RGB888, fastest of %d\n\n%-18s", s_rounds, "image");
+    for (size_t v = 0; v < BENCH_VARIANTS; v++) {
+        printf(" %6s", s_variants[v].name);
+    }
+    printf("  output\n");
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        size_t size;
+        uint8_t *data = load_file(paths[i], &size);
+        if (!data) {
+            fprintf(stderr, "Cannot read %s\n", paths[i]);
+            failed++;
+            continue;
+        }
+        const char *name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+        failed += bench_image(name, data, size, rgb);
+        free(data);
+    }
+    printf("\nFDn: LVGL TJpgDec with JD_FASTDECODE n; LUTn: jdec with JPEG_STREAM_HUFF_LUT_BITS n\n");
+    for (size_t v = 0; v < BENCH_VARIANTS; v++) {
+        free(rgb[v]);
+    }
+    return failed ? 1 : 0;
+}
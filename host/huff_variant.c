@@ -0,0 +1,78 @@
+/*
+ * One decoder build for huff_bench.c
+ *
+ * Compiled once per variant next to its own copy of the decoder, with the
+ * decoder's public functions renamed so the copies link into one program:
+ *   HUFF_TJPGD defined: LVGL's TJpgDec with the JD_FASTDECODE of the
+ *                       generated tjpgdcnf.h in front of the include path
+ *   otherwise:          components/jpeg_stream/jdec.c with the
+ *                       CONFIG_JPEG_STREAM_HUFF_LUT_BITS of the generated
+ *                       sdkconfig.h in front of the include path
+ * HUFF_DECODE names the function this file exports.
+ */
+
+#include "huff_variant.h"
+#include <string.h>
+
+#ifdef HUFF_TJPGD
+#include "tjpgd.h"
+#define HUFF_PREPARE    jd_prepare
+#define HUFF_DECOMP     jd_decomp
+#else
+#include "jdec.h"
+#define HUFF_PREPARE    jdec_prepare
+#define HUFF_DECOMP     jdec_decomp
+#endif
+
+// Enough for either decoder with any table option (TJpgDec FD2 wants the most)
+#define HUFF_POOL_SIZE  (32 * 1024)
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint8_t *rgb;
+    uint16_t width;
+} huff_src_t;
+
+static size_t huff_in(JDEC *jd, uint8_t *buf, size_t len)
+{
+    huff_src_t *src = jd->device;
+    if (len > src->size - src->pos) {
+        len = src->size - src->pos;
+    }
+    if (buf) {
+        memcpy(buf, src->data + src->pos, len);
+    }
+    src->pos += len;
+    return len;
+}
+
+static int huff_out(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    huff_src_t *src = jd->device;
+    const size_t row = (size_t)(rect->right - rect->left + 1) * 3;
+    const uint8_t *in = bitmap;
+    for (unsigned int y = rect->top; y <= rect->bottom; y++, in += row) {
+        memcpy(src->rgb + ((size_t)y * src->width + rect->left) * 3, in, row);
+    }
+    return 1;
+}
+
+bool HUFF_DECODE(const uint8_t *data, size_t size, uint8_t *rgb, size_t rgb_size, uint16_t *width, uint16_t *height)
+{
+    static uint8_t pool[HUFF_POOL_SIZE] __attribute__((aligned(8)));
+    huff_src_t src = { .data = data, .size = size, .rgb = rgb };
+    JDEC jd;
+    if (HUFF_PREPARE(&jd, huff_in, pool, sizeof(pool), &src) != JDR_OK ||
+        (size_t)jd.width * jd.height * 3 > rgb_size) {
+        return false;
+    }
+    src.width = jd.width;
+#ifndef HUFF_TJPGD
+    jd.format = JDEC_RGB888;
+#endif
+    *width = jd.width;
+    *height = jd.height;
+    return HUFF_DECOMP(&jd, huff_out, 0) == JDR_OK;
+}
@@ -0,0 +1,36 @@
+/*
+ * Decoder builds compared by huff_bench.c, one per Huffman decoding option
+ * (huff_variant.c compiled once for each, see host/CMakeLists.txt)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Decode a baseline JPEG at full size to RGB888
+ *
+ * @param rgb Output, width * height * 3 bytes
+ * @param rgb_size Size of rgb in bytes
+ * @param width Image width
+ * @param height Image height
+ * @return false if the image could not be decoded or does not fit in rgb
+ */
+typedef bool (*huff_decode_fn_t)(const uint8_t *data, size_t size, uint8_t *rgb, size_t rgb_size,
+                                 uint16_t *width, uint16_t *height);
+
+#define HUFF_VARIANT_DECLARE(name) \
+    bool huff_##name##_decode(const uint8_t *data, size_t size, uint8_t *rgb, size_t rgb_size, \
+                              uint16_t *width, uint16_t *height);
+
+/* LVGL's TJpgDec with JD_FASTDECODE 0, 1 and 2 */
+HUFF_VARIANT_DECLARE(fd0)
+HUFF_VARIANT_DECLARE(fd1)
+HUFF_VARIANT_DECLARE(fd2)
+/* jdec.c with CONFIG_JPEG_STREAM_HUFF_LUT_BITS 0, 8, 9 and 10 */
+HUFF_VARIANT_DECLARE(lut0)
+HUFF_VARIANT_DECLARE(lut8)
+HUFF_VARIANT_DECLARE(lut9)
+HUFF_VARIANT_DECLARE(lut10)
@@ -0,0 +1,381 @@
+/*
+ * IMG565 test of components/img565 against files written by img565.py
+ *
+ * host/testdata holds 67x37 source pixels (img565_src.bin) and the IMG565
+ * files img565.py encodes from them with every compression, with and without
+ * the alpha plane (host/testdata/make_fixtures.py). Each file must decode
+ * byte for byte to the source pixels, from memory and from a stream read in
+ * small pieces, in panel byte order and swapped to native order. Every
+ * truncated prefix must be refused, as must tiles that are cut short or
+ * carry extra bytes, a tile table that goes backwards and an LZ4 block
+ * length past the tile. Flipping any payload byte must give an error or an
+ * image of the right size, never a crash. No decode may leak heap.
+ *
+ * Usage: img565_test
+ * Exits with 1 if any check fails.
+ */
+
+#include "img565.h"
+#include "host_heap.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_WIDTH      67
+#define TEST_HEIGHT     37
+#define TEST_TILE_ROWS  16
+// Bytes per read() of the stream decodes, so reads end in the middle of tiles
+#define TEST_READ_CHUNK 7
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} test_file_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} test_stream_t;
+
+typedef struct {
+    uint32_t rows;              // Rows passed to on_band()
+    uint32_t next_y;            // Where the next band must start
+    bool ordered;
+} test_bands_t;
+
+static bool load_file(test_file_t *f, const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_TESTDATA_DIR, name);
+    FILE *fp = fopen(path, "rb");
+    f->data = NULL;
+    f->size = 0;
+    if (!fp) {
+        printf("Cannot read %s\n", path);
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    f->data = len > 0 ? malloc(len) : NULL;
+    if (f->data && fread(f->data, 1, len, fp) == (size_t)len) {
+        f->size = len;
+    }
+    fclose(fp);
+    return f->size > 0;
+}
+
+static int stream_read(void *ctx, uint8_t *buf, size_t len)
+{
+    test_stream_t *s = ctx;
+    size_t n = s->size - s->pos;
+    n = n < len ? n : len;
+    n = n < TEST_READ_CHUNK ? n : TEST_READ_CHUNK;
+    memcpy(buf, s->data + s->pos, n);
+    s->pos += n;
+    return (int)n;
+}
+
+static void on_band(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height, uint16_t y, uint16_t rows)
+{
+    test_bands_t *bands = ctx;
+    bands->ordered = bands->ordered && y == bands->next_y && width == TEST_WIDTH && height == TEST_HEIGHT;
+    bands->next_y = y + rows;
+    bands->rows += rows;
+}
+
+/**
+ * @brief Decode size bytes of data from memory (stream false) or through read() in small pieces
+ */
+static esp_err_t decode(const uint8_t *data, size_t size, bool stream, bool swap_bytes, img565_image_t *img,
+                        test_bands_t *bands)
+{
+    test_stream_t s = { data, size, 0 };
+    img565_cfg_t cfg = {
+        .read = stream_read,
+        .read_ctx = &s,
+        .swap_bytes = swap_bytes,
+        .on_band = bands ? on_band : NULL,
+        .band_ctx = bands,
+    };
+    memset(img, 0, sizeof(*img));
+    // An exactly sized copy, so nothing past the end is readable by accident
+    uint8_t *copy = malloc(size ? size : 1);
+    memcpy(copy, data, size);
+    s.data = copy;
+    const esp_err_t err = stream ? img565_decode(&cfg, img) : img565_decode_mem(copy, size, &cfg, img);
+    free(copy);
+    return err;
+}
+
+/**
+ * @brief Decoded image against the source pixels
+ */
+static bool same_pixels(const img565_image_t *img, const test_file_t *src, bool alpha, bool swap_bytes)
+{
+    const size_t px = (size_t)TEST_WIDTH * TEST_HEIGHT;
+    if (img->width != TEST_WIDTH || img->height != TEST_HEIGHT || img->has_alpha != alpha ||
+        img->size != px * (alpha ? 3 : 2)) {
+        return false;
+    }
+    for (size_t i = 0; i < px; i++) {
+        const uint8_t *c = img->pixels + i * 2;
+        const uint8_t *want = src->data + i * 2;
+        if (swap_bytes ? c[0] != want[0] || c[1] != want[1] : c[0] != want[1] || c[1] != want[0]) {
+            return false;
+        }
+    }
+    return !alpha || memcmp(img->pixels + px * 2, src->data + px * 2, px) == 0;
+}
+
+static uint32_t tile_end(const test_file_t *f, int tile)
+{
+    const uint8_t *p = f->data + IMG565_HEADER_SIZE + tile * 4;
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void set_tile_end(test_file_t *f, int tile, uint32_t end)
+{
+    uint8_t *p = f->data + IMG565_HEADER_SIZE + tile * 4;
+    p[0] = end & 0xFF;
+    p[1] = end >> 8 & 0xFF;
+    p[2] = end >> 16 & 0xFF;
+    p[3] = end >> 24;
+}
+
+/**
+ * @brief A damaged file must be refused from memory and from a stream
+ */
+static bool refused(const char *what, const uint8_t *data, size_t size)
+{
+    for (int stream = 0; stream < 2; stream++) {
+        img565_image_t img;
+        if (decode(data, size, stream, true, &img, NULL) == ESP_OK) {
+            printf("  accepted %s (%s)\n", what, stream ? "stream" : "memory");
+            heap_caps_free(img.pixels);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tiles cut short or carrying an extra byte, the table going backwards, an LZ4 length past the tile
+ */
+static int test_corrupt_tiles(const test_file_t *f, uint8_t compression)
+{
+    const int tiles = (TEST_HEIGHT + TEST_TILE_ROWS - 1) / TEST_TILE_ROWS;
+    const size_t payload = IMG565_HEADER_SIZE + tiles * 4;
+    test_file_t bad = { malloc(f->size), f->size };
+    int failed = 0;
+
+    // Tile 0 one byte short (tile 1 starts one byte early)
+    memcpy(bad.data, f->data, f->size);
+    set_tile_end(&bad, 0, tile_end(f, 0) - 1);
+    failed += !refused("tile 0 one byte short", bad.data, bad.size);
+    // Tile 1 one byte short at the end of the file
+    memcpy(bad.data, f->data, f->size);
+    for (int t = 1; t < tiles; t++) {
+        set_tile_end(&bad, t, tile_end(f, t) - 1);
+    }
+    failed += !refused("tile 1 one byte short", bad.data, bad.size - 1);
+    // Last tile with one extra byte
+    memcpy(bad.data, f->data, f->size);
+    bad.data = realloc(bad.data, f->size + 1);
+    bad.data[f->size] = 0x55;
+    set_tile_end(&bad, tiles - 1, tile_end(f, tiles - 1) + 1);
+    failed += !refused("last tile one byte long", bad.data, f->size + 1);
+    // Tile table going backwards
+    memcpy(bad.data, f->data, f->size);
+    set_tile_end(&bad, 1, tile_end(f, 0) - 1);
+    failed += !refused("tile table going backwards", bad.data, bad.size);
+    // Last tile ending past the file
+    memcpy(bad.data, f->data, f->size);
+    set_tile_end(&bad, tiles - 1, tile_end(f, tiles - 1) + 1);
+    failed += !refused("last tile past the end", bad.data, bad.size);
+    if (compression == IMG565_LZ4) {
+        // Colour block longer than the tile
+        memcpy(bad.data, f->data, f->size);
+        uint8_t *len = bad.data + payload + tile_end(f, 0);
+        len[0] = len[1] = len[2] = len[3] = 0xFF;
+        failed += !refused("LZ4 block length past the tile", bad.data, bad.size);
+    }
+    free(bad.data);
+    return failed;
+}
+
+/**
+ * @brief Flip every payload byte in turn: an error or a full-size image, never a crash
+ * @return Number of flips that were refused
+ */
+static int test_flips(const test_file_t *f, bool alpha, int *failed)
+{
+    const int tiles = (TEST_HEIGHT + TEST_TILE_ROWS - 1) / TEST_TILE_ROWS;
+    const size_t payload = IMG565_HEADER_SIZE + tiles * 4;
+    uint8_t *bad = malloc(f->size);
+    int refused = 0;
+    for (size_t i = payload; i < f->size; i++) {
+        memcpy(bad, f->data, f->size);
+        bad[i] ^= 0xFF;
+        img565_image_t img;
+        if (decode(bad, f->size, false, true, &img, NULL) != ESP_OK) {
+            refused++;
+            continue;
+        }
+        if (img.size != (size_t)TEST_WIDTH * TEST_HEIGHT * (alpha ? 3 : 2)) {
+            printf("  flipped byte %zu gave a %zu byte image\n", i, img.size);
+            (*failed)++;
+        }
+        heap_caps_free(img.pixels);
+    }
+    free(bad);
+    return refused;
+}
+
+static int test_file(const char *name, uint8_t compression, bool alpha, const test_file_t *src)
+{
+    test_file_t f;
+    if (!load_file(&f, name)) {
+        free(f.data);
+        return 1;
+    }
+    int failed = 0;
+    const size_t idle = host_heap_used();
+
+    // Byte for byte against the source, in both byte orders, from memory and from a stream
+    img565_header_t hdr;
+    if (img565_parse_header(f.data, f.size, &hdr) != ESP_OK || hdr.compression != compression ||
+        !!(hdr.flags & IMG565_FLAG_ALPHA) != alpha || hdr.tile_rows != TEST_TILE_ROWS) {
+        printf("%-22s header does not match the fixture\n", name);
+        free(f.data);
+        return 1;
+    }
+    const char *mismatch = NULL;
+    for (int stream = 0; stream < 2 && !mismatch; stream++) {
+        for (int swap = 0; swap < 2 && !mismatch; swap++) {
+            img565_image_t img;
+            test_bands_t bands = { .ordered = true };
+            if (decode(f.data, f.size, stream, swap, &img, &bands) != ESP_OK ||
+                !same_pixels(&img, src, alpha, swap)) {
+                mismatch = stream ? "stream decode differs from the source" : "memory decode differs from the source";
+            } else if (!alpha && (!bands.ordered || bands.rows != TEST_HEIGHT)) {
+                mismatch = "bands out of order or missing";
+            }
+            heap_caps_free(img.pixels);
+        }
+    }
+    failed += mismatch != NULL;
+
+    // Every truncated prefix
+    size_t accepted_cut = 0;
+    for (size_t len = 0; len < f.size && !accepted_cut; len++) {
+        for (int stream = 0; stream < 2; stream++) {
+            img565_image_t img;
+            if (decode(f.data, len, stream, true, &img, NULL) == ESP_OK) {
+                heap_caps_free(img.pixels);
+                accepted_cut = len ? len : 1;
+            }
+        }
+    }
+    failed += accepted_cut != 0;
+
+    const int corrupt = test_corrupt_tiles(&f, compression);
+    failed += corrupt;
+    int flip_failed = 0;
+    const int flips_refused = test_flips(&f, alpha, &flip_failed);
+    failed += flip_failed;
+    const bool leaked = host_heap_used() != idle;
+    failed += leaked;
+
+    const char *result = mismatch ? mismatch : accepted_cut ? "accepted a truncated file" :
+                         corrupt ? "accepted a corrupt tile" : flip_failed ? "wrong size after a flip" :
+                         leaked ? "leaked heap" : "ok";
+    printf("%-22s %6zu %9s %5s %12d/%-6zu %s\n", name, f.size, compression == IMG565_LZ4 ? "lz4" :
+           compression == IMG565_RLE ? "rle" : "raw", alpha ? "A8" : "-", flips_refused,
+           f.size - IMG565_HEADER_SIZE - img565_table_size(&hdr), result);
+    free(f.data);
+    return failed;
+}
+
+/**
+ * @brief Headers that must be refused before anything is allocated
+ */
+static int test_headers(const test_file_t *f)
+{
+    static const struct {
+        const char *what;
+        size_t offset;
+        uint8_t value;
+        esp_err_t err;
+    } cases[] = {
+        { "bad magic", 0, 'X', ESP_ERR_INVALID_ARG },
+        { "version 2", 4, 2, ESP_ERR_INVALID_VERSION },
+        { "compression 3", 6, 3, ESP_ERR_INVALID_VERSION },
+        { "width 0", 8, 0, ESP_ERR_INVALID_ARG },
+        { "height 0", 10, 0, ESP_ERR_INVALID_ARG },
+        { "tile rows 0", 12, 0, ESP_ERR_INVALID_ARG },
+    };
+    uint8_t *bad = malloc(f->size);
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        memcpy(bad, f->data, f->size);
+        bad[cases[i].offset] = cases[i].value;
+        if (cases[i].offset == 8 || cases[i].offset == 10 || cases[i].offset == 12) {
+            bad[cases[i].offset + 1] = 0;
+        }
+        img565_image_t img;
+        const esp_err_t err = decode(bad, f->size, false, true, &img, NULL);
+        if (err != cases[i].err) {
+            printf("header with %s: %s instead of %s\n", cases[i].what, esp_err_to_name(err),
+                   esp_err_to_name(cases[i].err));
+            if (err == ESP_OK) {
+                heap_caps_free(img.pixels);
+            }
+            failed++;
+        }
+    }
+    free(bad);
+    return failed;
+}
+
+int main(void)
+{
+    // The decoder logs every file it refuses, tens of thousands here
+    freopen("/dev/null", "w", stderr);
+    test_file_t src;
+    if (!load_file(&src, "img565_src.bin") || src.size != (size_t)TEST_WIDTH * TEST_HEIGHT * 3) {
+        free(src.data);
+        return 1;
+    }
+    static const struct {
+        const char *name;
+        uint8_t compression;
+        bool alpha;
+    } files[] = {
+        { "img565_none.i565", IMG565_RAW, false },
+        { "img565_none_a8.i565", IMG565_RAW, true },
+        { "img565_rle.i565", IMG565_RLE, false },
+        { "img565_rle_a8.i565", IMG565_RLE, true },
+        { "img565_lz4.i565", IMG565_LZ4, false },
+        { "img565_lz4_a8.i565", IMG565_LZ4, true },
+    };
+    printf("%-22s %6s %9s %5s %19s\n", "file", "bytes", "coding", "alpha", "flips refused");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        failed += test_file(files[i].name, files[i].compression, files[i].alpha, &src);
+    }
+    test_file_t f;
+    if (load_file(&f, "img565_rle.i565")) {
+        failed += test_headers(&f);
+    } else {
+        failed++;
+    }
+    free(f.data);
+    free(src.data);
+    printf("\nEach file must decode to img565_src.bin byte for byte (memory and stream, both byte orders),\n"
+           "every truncated prefix and each corrupt tile must be refused. flips refused: payload bytes\n"
+           "whose inversion the decoder detects (raw tiles have no structure to check)\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for the ESP-BOX-3 BSP: screen size and the LVGL display lock (host_panel.c)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BSP_LCD_H_RES       320
+#define BSP_LCD_V_RES       240
+
+/**
+ * @brief Recursive lock around LVGL, like esp_lvgl_port's; the timeout is ignored
+ */
+bool bsp_display_lock(uint32_t timeout_ms);
+void bsp_display_unlock(void);
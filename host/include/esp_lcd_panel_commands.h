@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for ESP-IDF's esp_lcd_panel_commands.h
+ */
+
+#pragma once
+
+#define LCD_CMD_NOP         0x00
+#define LCD_CMD_CASET       0x2A
+#define LCD_CMD_RASET       0x2B
+#define LCD_CMD_RAMWR       0x2C
+#define LCD_CMD_RAMRD       0x2E
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for ESP-IDF's esp_lcd_panel_io.h, backed by host_panel.c
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include <stddef.h>
+
+/**
+ * @brief Commands are counted and otherwise ignored; transfers complete synchronously
+ */
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size);
+
+/**
+ * @brief Pixel writes and reads, only implemented by lcd_clock_sim.c's mock panel
+ */
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size);
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size);
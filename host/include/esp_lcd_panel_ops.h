@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for ESP-IDF's esp_lcd_panel_ops.h, backed by host_panel.c
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+
+/**
+ * @brief Copy the pixels of [x_start, x_end) x [y_start, y_end) into the panel's framebuffer
+ */
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data);
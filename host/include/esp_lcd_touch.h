@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for esp_lcd_touch.h: the touch "controller" of
+ * host_touch_start() never reports a point; registering an interrupt
+ * callback succeeds for it
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_lcd_touch_s *esp_lcd_touch_handle_t;
+typedef void (*esp_lcd_touch_interrupt_callback_t)(esp_lcd_touch_handle_t tp);
+
+esp_err_t esp_lcd_touch_register_interrupt_callback(esp_lcd_touch_handle_t tp,
+                                                    esp_lcd_touch_interrupt_callback_t callback);
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for ESP-IDF's esp_lcd_types.h
+ */
+
+#pragma once
+
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
@@ -0,0 +1,37 @@
+/*
+ * Host stand-in for esp_lvgl_port.h: the port configuration and the calls
+ * main/lvgl_wake.c makes; host_lvgl_port_start() in host_panel.h starts the
+ * polling task
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+typedef struct {
+    int task_priority;
+    int task_stack;
+    int task_affinity;
+    int task_max_sleep_ms;
+    int timer_period_ms;
+} lvgl_port_cfg_t;
+
+#define ESP_LVGL_PORT_INIT_CONFIG() \
+    {                               \
+        .task_priority = 4,         \
+        .task_stack = 4096,         \
+        .task_affinity = -1,        \
+        .task_max_sleep_ms = 500,   \
+        .timer_period_ms = 5,       \
+    }
+
+/**
+ * @brief Stop the tick and call lv_timer_enable(false), as esp_lvgl_port 1.4.0 does
+ */
+esp_err_t lvgl_port_stop(void);
+
+/**
+ * @brief Call lv_timer_enable(true) and restart the tick
+ */
+esp_err_t lvgl_port_resume(void);
@@ -0,0 +1,36 @@
+/*
+ * Host stand-in for esp_timer.h: the clock, and one-shot timers whose
+ * callbacks run on a thread per timer
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+
+typedef struct esp_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+} esp_timer_create_args_t;
+
+/**
+ * @brief Microseconds of CLOCK_MONOTONIC
+ */
+int64_t esp_timer_get_time(void);
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle);
+
+/**
+ * @brief Run the callback once after timeout_us; restarting a running timer is an error, as on the device
+ */
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+
+/**
+ * @brief Cancel the timer; ESP_ERR_INVALID_STATE if it was not running
+ */
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
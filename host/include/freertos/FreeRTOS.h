@@ -0,0 +1,32 @@
+/*
+ * Host stand-in for FreeRTOS.h: the types and constants the components use
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdFAIL              0
+#define pdPASS              1
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define tskNO_AFFINITY      ((BaseType_t)0x7FFFFFFF)
+
+// Spinlocks of critical sections; the host uses one process-wide lock
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+#define portTICK_PERIOD_MS  1
+// Interrupts are ordinary threads on the host, there is nothing to yield to
+#define portYIELD_FROM_ISR(...) do {} while (0)
+
+// Like ESP-IDF's FreeRTOS.h, which pulls in esp_attr.h
+#include "esp_attr.h"
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for FreeRTOS queue.h: fixed-size item queues on a mutex and condition variable
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+
+/**
+ * @brief Copy an item to the back of the queue; only 0 and portMAX_DELAY are supported as timeouts
+ */
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+
+/**
+ * @brief Copy the front item out of the queue; only 0 and portMAX_DELAY are supported as timeouts
+ */
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for FreeRTOS semphr.h: binary semaphores on a mutex and condition variable,
+ * mutexes are binary semaphores that start given
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+/**
+ * @brief Wait until the semaphore is given; only 0 and portMAX_DELAY are supported as timeouts
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
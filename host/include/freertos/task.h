@@ -0,0 +1,56 @@
+/*
+ * Host stand-in for FreeRTOS task.h: tasks are detached POSIX threads, each
+ * with a notification counter and a suspend flag
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct host_task *TaskHandle_t;
+
+/**
+ * @brief Start fn(arg) in a new thread; name, stack, priority and core are ignored
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+
+/**
+ * @brief End the calling thread (only NULL, the calling task, is supported)
+ */
+void vTaskDelete(TaskHandle_t task);
+
+/**
+ * @brief Handle of the calling thread (threads not started as tasks get one on first use)
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+/**
+ * @brief Sleep for ticks milliseconds; a suspended task then waits for vTaskResume()
+ */
+void vTaskDelay(TickType_t ticks);
+
+/**
+ * @brief Suspend a task; unlike FreeRTOS it stops at its next vTaskDelay(), not at once
+ */
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+
+/**
+ * @brief Task notifications used as a counting semaphore
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+BaseType_t xPortGetCoreID(void);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+
+/**
+ * @brief Critical sections take one process-wide recursive mutex (the spinlock argument is ignored)
+ */
+void vTaskEnterCritical(portMUX_TYPE *mux);
+void vTaskExitCritical(portMUX_TYPE *mux);
+#define taskENTER_CRITICAL(mux) vTaskEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)  vTaskExitCritical(mux)
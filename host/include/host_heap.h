@@ -0,0 +1,34 @@
+/*
+ * Counting heap for the host build
+ * heap_caps_* and LVGL's lv_mem_* (LV_MEM_CUSTOM_*) both allocate here, so a
+ * benchmark can compare the peak memory of different decoders
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *host_malloc(size_t size);
+void *host_realloc(void *ptr, size_t size);
+void host_free(void *ptr);
+
+/**
+ * @brief Bytes currently allocated
+ */
+size_t host_heap_used(void);
+
+/**
+ * @brief Highest host_heap_used() since the last host_heap_reset_peak()
+ */
+size_t host_heap_peak(void);
+
+void host_heap_reset_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
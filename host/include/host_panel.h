@@ -0,0 +1,63 @@
+/*
+ * In-memory ST7789 for the host build
+ * esp_lcd_panel_draw_bitmap() copies into a 320x240 RGB565 "GRAM" and counts
+ * the bytes an SPI panel would have received; host_display_start() registers
+ * an LVGL display whose flush callback draws through it, laid out like
+ * esp_lvgl_port's so photo_mode_init() finds the panel handle, and
+ * host_touch_start() adds a touch input that is never pressed
+ */
+
+#pragma once
+
+#include "esp_lvgl_port.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t draws;             // esp_lcd_panel_draw_bitmap() calls
+    uint64_t bytes;             // RGB565 bytes sent to the panel
+    uint32_t commands;          // esp_lcd_panel_io_tx_param() calls
+    uint32_t flushes;           // LVGL flush callbacks (part of draws)
+} host_panel_stats_t;
+
+/**
+ * @brief Call lv_init() and register the display, like bsp_display_start_with_config()
+ * @param buf_lines Rows per LVGL draw buffer (DISPLAY_DRAW_BUF_LINES)
+ * @param double_buffer Two draw buffers (DISPLAY_DRAW_BUF_COUNT 2)
+ */
+lv_disp_t *host_display_start(uint16_t buf_lines, bool double_buffer);
+
+/**
+ * @brief Register a pointer input laid out like esp_lvgl_port's touch input
+ *
+ * Its controller accepts an interrupt callback, so lvgl_wake_start() pauses
+ * the read timer as on the device; it never reports a press.
+ */
+lv_indev_t *host_touch_start(void);
+
+/**
+ * @brief Start a task that polls lv_timer_handler() like esp_lvgl_port's
+ *
+ * Until then LVGL only refreshes when the caller runs lv_refr_now(), which
+ * keeps the timings of the benchmarks free of a second thread. lvgl_port_stop()
+ * and lvgl_port_resume() act on this task's tick and on lv_timer_enable().
+ */
+esp_err_t host_lvgl_port_start(const lvgl_port_cfg_t *cfg);
+
+/**
+ * @brief Panel contents, BSP_LCD_H_RES * BSP_LCD_V_RES pixels as sent (LV_COLOR_16_SWAP byte order)
+ */
+const uint8_t *host_panel_pixels(void);
+
+void host_panel_get_stats(host_panel_stats_t *stats);
+void host_panel_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
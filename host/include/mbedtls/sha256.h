@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for mbedtls/sha256.h: plain C SHA-256 (SHA-224 is not supported)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;
+    uint8_t block[64];
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen);
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char output[32], int is224);
@@ -0,0 +1,240 @@
+/*
+ * Benchmark of the jpeg_stream decoder kernels, *_ref against *_fast
+ *
+ * The blocks are the ones the decoder really sees: the coefficients of every
+ * block of the given JPEGs are captured through the IDCT while decoding, then
+ * each kernel runs over them in a tight loop. Reported per call in ns and, on
+ * x86, in TSC cycles; on the ESP32-S3 the ratio between the two versions is
+ * what carries over, not the absolute numbers.
+ *
+ * Usage: kernel_bench [--rounds N] [image.jpg ...]
+ * Without images the repo's 320x240 sample JPEGs are used.
+ */
+
+#include "jpeg_stream.h"
+#include "jdec_kernels.h"
+#include "esp_heap_caps.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#endif
+
+#define BENCH_MAX_BLOCKS    (64 * 1024)
+
+typedef struct {
+    int32_t (*blocks)[64];      // Captured de-quantized coefficients
+    uint32_t count;
+} bench_blocks_t;
+
+static int s_rounds = 20;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint8_t *load_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? malloc(len) : NULL;
+    if (data && fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+/*
+ * Linked with -Wl,--wrap=jdec_idct_fast: jdec.c's IDCT calls come here while
+ * capture_blocks() decodes, and the input of each one is kept
+ */
+static bench_blocks_t *s_capture;
+static pthread_mutex_t s_capture_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void __real_jdec_idct_fast(int32_t *src, jd_yuv_t *dst);
+
+void __wrap_jdec_idct_fast(int32_t *src, jd_yuv_t *dst)
+{
+    pthread_mutex_lock(&s_capture_lock);
+    if (s_capture && s_capture->count < BENCH_MAX_BLOCKS) {
+        memcpy(s_capture->blocks[s_capture->count++], src, 64 * sizeof(*src));
+    }
+    pthread_mutex_unlock(&s_capture_lock);
+    __real_jdec_idct_fast(src, dst);
+}
+
+/**
+ * @brief Decode data once at full size and keep the IDCT input of every block
+ */
+static bool capture_blocks(const uint8_t *data, size_t size, bench_blocks_t *out)
+{
+    jpeg_stream_image_t img;
+    s_capture = out;
+    const esp_err_t err = jpeg_stream_decode_mem(data, size, NULL, &img);
+    s_capture = NULL;
+    if (err != ESP_OK) {
+        return false;
+    }
+    heap_caps_free(img.pixels);
+    return true;
+}
+
+typedef struct {
+    double ns;
+    double cycles;
+} bench_time_t;
+
+#ifdef BENCH_CYCLES
+#define BENCH_RUN(result, calls, body)                              \
+    do {                                                            \
+        const double t0 = now_ns();                                 \
+        const unsigned long long c0 = BENCH_CYCLES();               \
+        for (int r = 0; r < s_rounds; r++) { body; }                \
+        (result).cycles = (double)(BENCH_CYCLES() - c0) / (calls);  \
+        (result).ns = (now_ns() - t0) / (calls);                    \
+    } while (0)
+#else
+#define BENCH_RUN(result, calls, body)                              \
+    do {                                                            \
+        const double t0 = now_ns();                                 \
+        for (int r = 0; r < s_rounds; r++) { body; }                \
+        (result).cycles = 0;                                        \
+        (result).ns = (now_ns() - t0) / (calls);                    \
+    } while (0)
+#endif
+
+static void print_pair(const char *what, const bench_time_t *ref, const bench_time_t *fast)
+{
+    printf("%-16s %9.1f %9.1f %9.1f %9.1f %7.2fx\n", what, ref->ns, fast->ns, ref->cycles, fast->cycles,
+           fast->ns > 0 ? ref->ns / fast->ns : 0);
+}
+
+static void bench_idct(const bench_blocks_t *b)
+{
+    int32_t tmp[64];
+    jd_yuv_t out[64];
+    volatile jd_yuv_t sink = 0;
+    bench_time_t ref, fast;
+    const double calls = (double)s_rounds * b->count;
+    BENCH_RUN(ref, calls, for (uint32_t i = 0; i < b->count; i++) {
+        memcpy(tmp, b->blocks[i], sizeof(tmp));
+        jdec_idct_ref(tmp, out);
+        sink += out[i & 63];
+    });
+    BENCH_RUN(fast, calls, for (uint32_t i = 0; i < b->count; i++) {
+        memcpy(tmp, b->blocks[i], sizeof(tmp));
+        __real_jdec_idct_fast(tmp, out);    // Past the capture wrapper
+        sink += out[i & 63];
+    });
+    (void)sink;
+    print_pair("idct", &ref, &fast);
+}
+
+/**
+ * @brief Colour conversion of MCUs built from the captured blocks' IDCT output
+ */
+static void bench_colour(const bench_blocks_t *b, unsigned int msx, unsigned int msy, bool swap)
+{
+    const unsigned int per_mcu = msx * msy + 2;
+    const uint32_t mcus = b->count / per_mcu;
+    if (!mcus) {
+        return;
+    }
+    jd_yuv_t *yuv = malloc((size_t)mcus * per_mcu * 64 * sizeof(jd_yuv_t));
+    for (uint32_t i = 0; i < mcus * per_mcu; i++) {
+        int32_t tmp[64];
+        memcpy(tmp, b->blocks[i], sizeof(tmp));
+        jdec_idct_ref(tmp, yuv + (size_t)i * 64);
+    }
+    uint16_t out[256];
+    volatile uint16_t sink = 0;
+    bench_time_t ref, fast;
+    const double calls = (double)s_rounds * mcus;
+    BENCH_RUN(ref, calls, for (uint32_t i = 0; i < mcus; i++) {
+        jdec_mcu_rgb565_ref(yuv + (size_t)i * per_mcu * 64, msx, msy, out, swap);
+        sink += out[i & 63];
+    });
+    BENCH_RUN(fast, calls, for (uint32_t i = 0; i < mcus; i++) {
+        jdec_mcu_rgb565_fast(yuv + (size_t)i * per_mcu * 64, msx, msy, out, swap);
+        sink += out[i & 63];
+    });
+    (void)sink;
+    char what[32];
+    snprintf(what, sizeof(what), "rgb565 %s%s", msx == 1 ? "4:4:4" : msy == 1 ? "4:2:2" : "4:2:0",
+             swap ? " swap" : "");
+    print_pair(what, &ref, &fast);
+    free(yuv);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const samples[] = {"hss_320_240.jpg", "mengm.jpg", "rs2026.jpg"};
+    const char *paths[32];
+    char sample_paths[3][512];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (count < 32) {
+            paths[count++] = argv[i];
+        }
+    }
+    if (count == 0) {
+        for (int i = 0; i < 3; i++) {
+            snprintf(sample_paths[i], sizeof(sample_paths[i]), "%s/%s", BENCH_SAMPLES_DIR, samples[i]);
+            paths[count++] = sample_paths[i];
+        }
+    }
+    if (s_rounds < 1) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+
+    bench_blocks_t blocks = { .blocks = malloc(BENCH_MAX_BLOCKS * sizeof(*blocks.blocks)) };
+    for (int i = 0; i < count; i++) {
+        size_t size;
+        uint8_t *data = load_file(paths[i], &size);
+        if (!data) {
+            fprintf(stderr, "Cannot read %s\n", paths[i]);
+            continue;
+        }
+        const uint32_t before = blocks.count;
+        const char *name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+        if (capture_blocks(data, size, &blocks)) {
+            printf("%-24s %6u blocks\n", name, blocks.count - before);
+        } else {
+            fprintf(stderr, "Cannot decode %s\n", name);
+        }
+        free(data);
+    }
+    if (!blocks.count) {
+        fprintf(stderr, "No blocks\n");
+        return 1;
+    }
+    printf("\n%u blocks x %d rounds\n%-16s %9s %9s %9s %9s %8s\n", blocks.count, s_rounds, "kernel", "ref ns",
+           "fast ns", "ref cyc", "fast cyc", "speedup");
+    bench_idct(&blocks);
+    static const unsigned int sampling[][2] = { { 1, 1 }, { 2, 1 }, { 2, 2 } };
+    for (int s = 0; s < 3; s++) {
+        for (int swap = 0; swap < 2; swap++) {
+            bench_colour(&blocks, sampling[s][0], sampling[s][1], swap);
+        }
+    }
+    free(blocks.blocks);
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Equivalence test of the jpeg_stream decoder kernels
+ *
+ * Every *_fast kernel in components/jpeg_stream/jdec_kernels.c must produce
+ * exactly what its *_ref version (the TJpgDec arithmetic) produces. The
+ * IDCT is fed random blocks shaped like real ones: DC only, a few low
+ * frequencies, dense blocks and blocks at the coefficient limits, de-quantized
+ * the way jdec.c does it. The colour conversion is fed MCUs of every
+ * sampling (4:4:4, 4:2:2, 4:2:0) built from IDCT output, plus samples at the
+ * limits of the clip table, with and without the byte swap. The RGB565
+ * reference is also checked against the RGB888 reference packed to RGB565.
+ *
+ * Usage: kernel_test [--blocks N] [--seed N]
+ * Exits with 1 on the first mismatch, after printing the input.
+ */
+
+#include "jdec_kernels.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MCU_MAX_BLOCKS 6
+
+/* Arai scale factors of the de-quantizer tables, as in jdec.c (x8192) */
+static const uint16_t s_ipsf[64] = {
+    (uint16_t)(1.00000 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(1.00000 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.27590 * 8192),
+    (uint16_t)(1.38704 * 8192), (uint16_t)(1.92388 * 8192), (uint16_t)(1.81226 * 8192), (uint16_t)(1.63099 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.08979 * 8192), (uint16_t)(0.75066 * 8192), (uint16_t)(0.38268 * 8192),
+    (uint16_t)(1.30656 * 8192), (uint16_t)(1.81226 * 8192), (uint16_t)(1.70711 * 8192), (uint16_t)(1.53636 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.02656 * 8192), (uint16_t)(0.70711 * 8192), (uint16_t)(0.36048 * 8192),
+    (uint16_t)(1.17588 * 8192), (uint16_t)(1.63099 * 8192), (uint16_t)(1.53636 * 8192), (uint16_t)(1.38268 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(0.92388 * 8192), (uint16_t)(0.63638 * 8192), (uint16_t)(0.32442 * 8192),
+    (uint16_t)(1.00000 * 8192), (uint16_t)(1.38704 * 8192), (uint16_t)(1.30656 * 8192), (uint16_t)(1.17588 * 8192), (uint16_t)(1.00000 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.27590 * 8192),
+    (uint16_t)(0.78570 * 8192), (uint16_t)(1.08979 * 8192), (uint16_t)(1.02656 * 8192), (uint16_t)(0.92388 * 8192), (uint16_t)(0.78570 * 8192), (uint16_t)(0.61732 * 8192), (uint16_t)(0.42522 * 8192), (uint16_t)(0.21677 * 8192),
+    (uint16_t)(0.54120 * 8192), (uint16_t)(0.75066 * 8192), (uint16_t)(0.70711 * 8192), (uint16_t)(0.63638 * 8192), (uint16_t)(0.54120 * 8192), (uint16_t)(0.42522 * 8192), (uint16_t)(0.29290 * 8192), (uint16_t)(0.14932 * 8192),
+    (uint16_t)(0.27590 * 8192), (uint16_t)(0.38268 * 8192), (uint16_t)(0.36048 * 8192), (uint16_t)(0.32442 * 8192), (uint16_t)(0.27590 * 8192), (uint16_t)(0.21678 * 8192), (uint16_t)(0.14932 * 8192), (uint16_t)(0.07612 * 8192)
+};
+
+static uint32_t s_rng = 0x9E3779B9;
+
+static uint32_t test_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static int test_range(int lo, int hi)
+{
+    return lo + (int)(test_rand() % (uint32_t)(hi - lo + 1));
+}
+
+/**
+ * @brief A de-quantized block in raster order, like jdec.c's mcu_load() builds it
+ * @param shape 0: DC only, 1: low frequencies, 2: first row or column, 3: dense, 4: coefficient limits
+ */
+static void test_block(int shape, int32_t *coef)
+{
+    memset(coef, 0, 64 * sizeof(*coef));
+    const int q = shape == 4 ? 255 : test_range(1, 64);
+    for (int i = 0; i < 64; i++) {
+        const int row = i / 8, col = i % 8;
+        int d = 0;
+        if (i == 0) {
+            d = shape == 4 ? (test_rand() & 1 ? 1023 : -1024) : test_range(-1024, 1023) / q;
+        } else if (shape == 1) {
+            d = row + col <= 2 && test_rand() % 2 ? test_range(-40, 40) : 0;
+        } else if (shape == 2) {
+            d = (row == 0 || col == 0) && test_rand() % 2 ? test_range(-60, 60) : 0;
+        } else if (shape == 3) {
+            d = test_rand() % 3 ? test_range(-120, 120) / (row + col + 1) : 0;
+        } else if (shape == 4) {
+            d = test_rand() % 8 ? 0 : (test_rand() & 1 ? 1023 : -1023) / q;
+        }
+        coef[i] = (int32_t)(d * (int32_t)(q * s_ipsf[i]) >> 8);
+    }
+}
+
+static void test_print_block(const char *name, const int32_t *coef)
+{
+    fprintf(stderr, "%s:\n", name);
+    for (int i = 0; i < 64; i++) {
+        fprintf(stderr, "%8" PRId32 "%s", coef[i], i % 8 == 7 ? "\n" : "");
+    }
+}
+
+static int test_idct(uint32_t blocks)
+{
+    int32_t coef[64], ref_in[64], fast_in[64];
+    jd_yuv_t ref_out[64], fast_out[64];
+    for (uint32_t n = 0; n < blocks; n++) {
+        test_block(n % 5, coef);
+        memcpy(ref_in, coef, sizeof(coef));
+        memcpy(fast_in, coef, sizeof(coef));
+        jdec_idct_ref(ref_in, ref_out);
+        jdec_idct_fast(fast_in, fast_out);
+        if (memcmp(ref_out, fast_out, sizeof(ref_out))) {
+            for (int i = 0; i < 64; i++) {
+                if (ref_out[i] != fast_out[i]) {
+                    fprintf(stderr, "jdec_idct_fast: block %" PRIu32 " sample %d is %d, reference %d\n", n, i,
+                            fast_out[i], ref_out[i]);
+                    break;
+                }
+            }
+            test_print_block("input", coef);
+            return 1;
+        }
+    }
+    printf("%-34s %8" PRIu32 " blocks  identical\n", "jdec_idct_fast", blocks);
+    return 0;
+}
+
+/**
+ * @brief msx * msy Y blocks and two chroma blocks; limits: samples at the ends of the clip table's range
+ */
+static void test_mcu(unsigned int msx, unsigned int msy, bool limits, jd_yuv_t *mcu)
+{
+    const unsigned int count = msx * msy + 2;
+    for (unsigned int b = 0; b < count; b++) {
+        jd_yuv_t *blk = mcu + b * 64;
+        if (limits) {
+            // Y and the chroma terms together must stay within -512..511 (JDEC_CLIP8)
+            for (int i = 0; i < 64; i++) {
+                blk[i] = (jd_yuv_t)(b < msx * msy ? test_range(-128, 383) : test_range(0, 255));
+            }
+        } else {
+            int32_t coef[64];
+            test_block(test_rand() % 4, coef);
+            jdec_idct_ref(coef, blk);
+        }
+    }
+}
+
+static int test_mcu_mismatch(const char *kernel, uint32_t n, unsigned int msx, unsigned int msy, bool swap,
+                             const uint16_t *got, const uint16_t *want)
+{
+    for (unsigned int i = 0; i < msx * msy * 64; i++) {
+        if (got[i] != want[i]) {
+            fprintf(stderr, "%s: MCU %" PRIu32 " (%ux%u blocks, swap %d) pixel %u is 0x%04x, expected 0x%04x\n",
+                    kernel, n, msx, msy, swap, i, got[i], want[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_colour(uint32_t mcus)
+{
+    static const unsigned int sampling[][2] = { { 1, 1 }, { 2, 1 }, { 2, 2 } };
+    jd_yuv_t mcu[TEST_MCU_MAX_BLOCKS * 64];
+    uint16_t ref[256], fast[256], packed[256];
+    uint8_t rgb[256 * 3];
+    for (uint32_t n = 0; n < mcus; n++) {
+        const unsigned int msx = sampling[n % 3][0], msy = sampling[n % 3][1];
+        const bool swap = n / 3 % 2;
+        test_mcu(msx, msy, n / 6 % 4 == 3, mcu);
+        // Fast kernels may store two pixels per word; 4-byte aligned like jdec.c's buffers
+        jdec_mcu_rgb565_ref(mcu, msx, msy, ref, swap);
+        jdec_mcu_rgb565_fast(mcu, msx, msy, fast, swap);
+        jdec_mcu_rgb888_ref(mcu, msx, msy, rgb);
+        for (unsigned int i = 0; i < msx * msy * 64; i++) {
+            const uint8_t *p = rgb + i * 3;
+            const uint16_t w = (uint16_t)(((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3));
+            packed[i] = swap ? (uint16_t)((w << 8) | (w >> 8)) : w;
+        }
+        if (test_mcu_mismatch("jdec_mcu_rgb565_fast", n, msx, msy, swap, fast, ref) ||
+            test_mcu_mismatch("jdec_mcu_rgb565_ref vs rgb888_ref", n, msx, msy, swap, ref, packed)) {
+            return 1;
+        }
+    }
+    printf("%-34s %8" PRIu32 " MCUs    identical\n", "jdec_mcu_rgb565_fast", mcus);
+    printf("%-34s %8" PRIu32 " MCUs    identical\n", "jdec_mcu_rgb565_ref vs rgb888_ref", mcus);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t blocks = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--blocks") && i + 1 < argc) {
+            blocks = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            s_rng = (uint32_t)strtoul(argv[++i], NULL, 0) | 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--blocks N] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (test_idct(blocks) || test_colour(blocks / 4)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Pixel clock calibration against a mock panel
+ *
+ * Runs main/lcd_clock_cal.c the way lcd_clock.c does on the device, but the
+ * panel IO is an in-memory ILI9342C/ST7789 model: CASET/RASET/RAMWR fill an
+ * RGB666 GRAM, RDID1-3 and RAMRD read it back with the panel's dummy bits and
+ * colour order, and writes above a panel's stable clock get bit errors
+ * (occasional ones in a marginal band, many above it). Each scenario checks
+ * the clock the calibration settles on, including panels that cannot be read
+ * back at all (the Box-3 without 3-wire readback) and the boot-time check of
+ * a stored clock that is no longer stable.
+ *
+ * Usage: lcd_clock_sim
+ * Exits with 1 if any scenario picks a different clock than expected.
+ */
+
+#include "lcd_clock_cal.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_commands.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_H_RES       320
+#define SIM_V_RES       240
+#define SIM_MHZ         (1000 * 1000)
+
+typedef struct {
+    const char *name;
+    uint8_t id[3];
+    bool readback;              // false: the data line cannot be read (reads return all ones)
+    bool bgr;                   // RAMRD returns B, G, R
+    int dummy_bits;             // Clocks before the first RAMRD byte
+    uint32_t stable_hz;         // Writes up to this clock have no errors
+    uint32_t marginal_hz;       // Up to this clock about one byte in 2000 gets a flipped bit
+} sim_panel_t;
+
+typedef struct {
+    const char *name;
+    const sim_panel_t *panel;
+    uint32_t steps_hz[8];
+    size_t step_count;
+    uint8_t rounds;
+    esp_err_t expect_err;
+    uint32_t expect_hz;
+} sim_scenario_t;
+
+struct esp_lcd_panel_io_t {
+    uint32_t pclk_hz;
+};
+
+static const sim_panel_t *s_panel;
+static struct esp_lcd_panel_io_t s_io;
+static uint8_t s_gram[SIM_H_RES * SIM_V_RES * 3];
+static int s_x0, s_x1, s_y0, s_y1;
+static uint64_t s_rng;
+static uint32_t s_opens;
+static uint64_t s_bytes_written;
+
+static uint32_t sim_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+/* A byte as the panel latched it at the current clock */
+static uint8_t sim_latch(uint8_t byte)
+{
+    const uint32_t hz = s_io.pclk_hz;
+    if (hz <= s_panel->stable_hz) {
+        return byte;
+    }
+    if (hz <= s_panel->marginal_hz) {
+        return sim_rand() % 2000 == 0 ? byte ^ (uint8_t)(1u << (sim_rand() % 8)) : byte;
+    }
+    for (int bit = 0; bit < 8; bit++) {
+        if (sim_rand() % 64 == 0) {
+            byte ^= (uint8_t)(1u << bit);
+        }
+    }
+    return byte;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    const uint8_t *p = (const uint8_t *)param;
+    if (!io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((lcd_cmd == LCD_CMD_CASET || lcd_cmd == LCD_CMD_RASET) && param_size == 4) {
+        const int start = p[0] << 8 | p[1];
+        const int end = p[2] << 8 | p[3];
+        if (lcd_cmd == LCD_CMD_CASET) {
+            s_x0 = start;
+            s_x1 = end < SIM_H_RES ? end : SIM_H_RES - 1;
+        } else {
+            s_y0 = start;
+            s_y1 = end < SIM_V_RES ? end : SIM_V_RES - 1;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    if (!io || lcd_cmd != LCD_CMD_RAMWR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *src = (const uint8_t *)color;
+    int x = s_x0, y = s_y0;
+    for (size_t i = 0; i + 1 < color_size && y <= s_y1; i += 2) {
+        const uint16_t c = (uint16_t)(sim_latch(src[i]) << 8 | sim_latch(src[i + 1]));
+        const uint8_t r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        uint8_t *px = s_gram + ((size_t)y * SIM_H_RES + x) * 3;
+        // 16 bits to the panel's 18: the red and blue MSB is repeated as LSB
+        px[0] = (uint8_t)(((r << 1) | (r >> 4)) << 2);
+        px[1] = (uint8_t)(g << 2);
+        px[2] = (uint8_t)(((b << 1) | (b >> 4)) << 2);
+        if (++x > s_x1) {
+            x = s_x0;
+            y++;
+        }
+    }
+    s_bytes_written += color_size;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    uint8_t *dst = (uint8_t *)param;
+    if (!io || !param) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(dst, 0xFF, param_size);
+    if (!s_panel->readback) {
+        return ESP_OK;
+    }
+    if (lcd_cmd >= 0xDA && lcd_cmd <= 0xDC) {
+        dst[0] = s_panel->id[lcd_cmd - 0xDA];
+        return ESP_OK;
+    }
+    if (lcd_cmd != LCD_CMD_RAMRD) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    // Serial stream: dummy bits (low), then R, G, B (or B, G, R) per pixel from the window start
+    memset(dst, 0, param_size);
+    size_t bit = (size_t)s_panel->dummy_bits;
+    int x = s_x0, y = s_y0;
+    while (y <= s_y1 && bit / 8 < param_size) {
+        const uint8_t *px = s_gram + ((size_t)y * SIM_H_RES + x) * 3;
+        for (int k = 0; k < 3; k++) {
+            const uint8_t v = px[s_panel->bgr ? 2 - k : k];
+            for (int b = 7; b >= 0 && bit / 8 < param_size; b--, bit++) {
+                if (v >> b & 1) {
+                    dst[bit / 8] |= (uint8_t)(0x80 >> (bit % 8));
+                }
+            }
+        }
+        if (++x > s_x1) {
+            x = s_x0;
+            y++;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_open(uint32_t pclk_hz, esp_lcd_panel_io_handle_t *io, void *ctx)
+{
+    s_io.pclk_hz = pclk_hz;
+    s_opens++;
+    *io = &s_io;
+    return ESP_OK;
+}
+
+static void sim_close(esp_lcd_panel_io_handle_t io, void *ctx)
+{
+}
+
+int main(void)
+{
+    static const sim_panel_t ili9342c = {
+        "ILI9342C", { 0x00, 0x93, 0x42 }, true, true, 8, 62 * SIM_MHZ, 62 * SIM_MHZ,
+    };
+    static const sim_panel_t st7789 = {
+        "ST7789", { 0x85, 0x85, 0x52 }, true, false, 1, 80 * SIM_MHZ, 80 * SIM_MHZ,
+    };
+    static const sim_panel_t marginal = {
+        "marginal wiring", { 0x00, 0x93, 0x42 }, true, true, 8, 55 * SIM_MHZ, 75 * SIM_MHZ,
+    };
+    static const sim_panel_t no_readback = {
+        "no readback", { 0x00, 0x93, 0x42 }, false, true, 8, 80 * SIM_MHZ, 80 * SIM_MHZ,
+    };
+    static const sim_panel_t slow = {
+        "ILI9342C, now 50 MHz", { 0x00, 0x93, 0x42 }, true, true, 8, 50 * SIM_MHZ, 50 * SIM_MHZ,
+    };
+#define SIM_FINE_STEPS { 45 * SIM_MHZ, 50 * SIM_MHZ, 55 * SIM_MHZ, 60 * SIM_MHZ, \
+                         65 * SIM_MHZ, 70 * SIM_MHZ, 75 * SIM_MHZ, 80 * SIM_MHZ }, 8
+    // lcd_clock.c's calibration (80 MHz is the S3's only step above 40) and boot check
+    const sim_scenario_t scenarios[] = {
+        { "device steps", &ili9342c, { 80 * SIM_MHZ }, 1, 6, ESP_OK, 40 * SIM_MHZ },
+        { "device steps", &st7789, { 80 * SIM_MHZ }, 1, 6, ESP_OK, 80 * SIM_MHZ },
+        { "5 MHz steps", &ili9342c, SIM_FINE_STEPS, 6, ESP_OK, 60 * SIM_MHZ },
+        { "5 MHz steps", &marginal, SIM_FINE_STEPS, 6, ESP_OK, 55 * SIM_MHZ },
+        { "5 MHz steps", &no_readback, SIM_FINE_STEPS, 6, ESP_ERR_NOT_SUPPORTED, 40 * SIM_MHZ },
+        { "boot check 60", &ili9342c, { 60 * SIM_MHZ }, 1, 3, ESP_OK, 60 * SIM_MHZ },
+        { "boot check 60", &slow, { 60 * SIM_MHZ }, 1, 3, ESP_OK, 40 * SIM_MHZ },
+    };
+
+    int failures = 0;
+    printf("%-22s %-14s %-22s %8s %8s %8s %10s %9s %9s\n", "panel", "scenario", "result", "clock", "failed",
+           "errors", "frame ms", "opens", "KB sent");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        const sim_scenario_t *sc = &scenarios[i];
+        s_panel = sc->panel;
+        s_rng = 0x2545F4914F6CDD1Dull + i;
+        s_opens = 0;
+        s_bytes_written = 0;
+        memset(s_gram, 0, sizeof(s_gram));
+
+        const lcd_clock_cal_config_t config = {
+            .open = sim_open,
+            .close = sim_close,
+            .base_hz = 40 * SIM_MHZ,
+            .read_hz = 2 * SIM_MHZ,
+            .steps_hz = sc->steps_hz,
+            .step_count = sc->step_count,
+            .rounds = sc->rounds,
+        };
+        lcd_clock_cal_result_t result;
+        const esp_err_t err = lcd_clock_calibrate(&config, &result);
+        const uint32_t hz = err == ESP_OK ? result.pclk_hz : config.base_hz;
+        const bool ok = err == sc->expect_err && hz == sc->expect_hz;
+        failures += !ok;
+        // A full 320x240 RGB565 frame at the chosen clock
+        const double frame_ms = SIM_H_RES * SIM_V_RES * 16 * 1000.0 / hz;
+        printf("%-22s %-14s %-22s %5" PRIu32 "MHz %5" PRIu32 "MHz %8" PRIu32 " %10.1f %9" PRIu32 " %9.1f%s\n",
+               sc->panel->name, sc->name, esp_err_to_name(err), hz / SIM_MHZ, result.failed_hz / SIM_MHZ,
+               result.bit_errors, frame_ms, s_opens, s_bytes_written / 1024.0,
+               ok ? "" : "  <-- unexpected");
+    }
+    return failures ? 1 : 0;
+}
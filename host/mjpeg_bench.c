@@ -0,0 +1,324 @@
+/*
+ * MJPEG stream benchmark: the /stream receive and decode loop on the host
+ *
+ * The frames are wrapped in the three containers /stream accepts and split
+ * again with mjpeg_stream, read in 1460-byte pieces like TCP segments:
+ *   - multipart with a Content-Length header per part (stream_mjpeg.py, ffmpeg -f mpjpeg)
+ *   - multipart without Content-Length (scanned for the boundary)
+ *   - length-prefixed
+ * Each frame is then decoded two ways:
+ *   - alloc: a new framebuffer per frame, as /upload does for every image
+ *   - reuse: into two alternating framebuffers, as mjpeg_player does (cfg.fb)
+ * Pixels of both are compared. The frame rates assume the panel write of
+ * one frame overlaps the decode of the next (mjpeg_player's decode and blit
+ * tasks) or that they take turns.
+ *
+ * Usage: mjpeg_bench [--frames N] [--spi-mhz N] [stream.mjpeg | frame.jpg ...]
+ * Without arguments the repo's 320x240 sample JPEGs are cycled.
+ */
+
+#include "mjpeg_stream.h"
+#include "jpeg_stream.h"
+#include "host_heap.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_FRAMES    64
+#define BENCH_SEGMENT       1460
+#define BENCH_FRAME_MAX     (512 * 1024)
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} bench_buf_t;
+
+typedef struct {
+    bench_buf_t data;
+    size_t pos;
+} bench_reader_t;
+
+static int s_frames = 120;
+static double s_spi_mhz = 40;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static bool load(const char *path, bench_buf_t *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out->data = malloc(size > 0 ? size : 1);
+    out->size = size > 0 && fread(out->data, 1, size, f) == (size_t)size ? size : 0;
+    fclose(f);
+    return out->size > 0;
+}
+
+static void append(bench_buf_t *b, const void *p, size_t n)
+{
+    b->data = realloc(b->data, b->size + n);
+    memcpy(b->data + b->size, p, n);
+    b->size += n;
+}
+
+static int bench_read(void *ctx, uint8_t *buf, size_t len)
+{
+    bench_reader_t *r = (bench_reader_t *)ctx;
+    size_t n = r->data.size - r->pos;
+    if (n > len) {
+        n = len;
+    }
+    if (n > BENCH_SEGMENT) {
+        n = BENCH_SEGMENT;
+    }
+    memcpy(buf, r->data.data + r->pos, n);
+    r->pos += n;
+    return (int)n;
+}
+
+/* --- Containers --- */
+
+typedef enum { WRAP_MULTIPART, WRAP_MULTIPART_SCAN, WRAP_LENGTH } wrap_t;
+
+static const char *const s_wrap_names[] = {"multipart", "multipart, no length", "length-prefixed"};
+
+static bench_buf_t wrap(const bench_buf_t *frames, int count, wrap_t how)
+{
+    bench_buf_t out = {0};
+    char hdr[128];
+    for (int i = 0; i < s_frames; i++) {
+        const bench_buf_t *f = &frames[i % count];
+        if (how == WRAP_LENGTH) {
+            uint8_t prefix[4] = {f->size >> 24, f->size >> 16, f->size >> 8, f->size};
+            append(&out, prefix, 4);
+        } else if (how == WRAP_MULTIPART) {
+            int n = snprintf(hdr, sizeof(hdr), "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                             f->size);
+            append(&out, hdr, n);
+        } else {
+            append(&out, "--frame\r\nContent-Type: image/jpeg\r\n\r\n", 37);
+        }
+        append(&out, f->data, f->size);
+        if (how != WRAP_LENGTH) {
+            append(&out, "\r\n", 2);
+        }
+    }
+    if (how == WRAP_LENGTH) {
+        append(&out, "\0\0\0\0", 4);
+    } else {
+        append(&out, "--frame--\r\n", 11);
+    }
+    return out;
+}
+
+/**
+ * @brief Split a stream into frames
+ * @return Number of frames, -1 on a parse error
+ */
+static int split(const bench_buf_t *stream, bench_buf_t *frames, int max, double *ms)
+{
+    bench_reader_t reader = { .data = *stream };
+    mjpeg_stream_cfg_t cfg = { .read = bench_read, .read_ctx = &reader };
+    mjpeg_stream_t *s = NULL;
+    uint8_t *buf = malloc(BENCH_FRAME_MAX);
+    int count = 0;
+    double t0 = now_ms();
+    esp_err_t err = mjpeg_stream_open(&cfg, &s);
+    while (err == ESP_OK) {
+        size_t len;
+        err = mjpeg_stream_next_frame(s, buf, BENCH_FRAME_MAX, &len);
+        if (err == ESP_OK && frames && count < max) {
+            frames[count].data = malloc(len);
+            frames[count].size = len;
+            memcpy(frames[count].data, buf, len);
+        }
+        if (err == ESP_OK) {
+            count++;
+        }
+    }
+    *ms = now_ms() - t0;
+    mjpeg_stream_close(s);
+    if (err != ESP_ERR_NOT_FOUND) {
+        fprintf(stderr, "mjpeg_stream: %s after %d frames\n", esp_err_to_name(err), count);
+        count = -1;
+    }
+    free(buf);
+    return count;
+}
+
+/* --- Decode loops --- */
+
+typedef struct {
+    double ms;
+    double max_ms;
+    size_t peak;
+    uint16_t width;
+    uint16_t height;
+    int failed;
+} bench_result_t;
+
+static jpeg_stream_cfg_t decode_cfg(void)
+{
+    jpeg_stream_cfg_t cfg = {
+        .swap_bytes = true,
+        .max_width = 320,
+        .max_height = 240,
+    };
+    return cfg;
+}
+
+/**
+ * @brief Decode every frame; fbs NULL allocates a framebuffer per frame, otherwise they alternate
+ * @param out Last decoded frame of each input frame, for comparing
+ */
+static bench_result_t decode_loop(const bench_buf_t *frames, int count, uint8_t **fbs, size_t fb_size,
+                                  uint8_t **out)
+{
+    bench_result_t r = {0};
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    for (int i = 0; i < s_frames; i++) {
+        const bench_buf_t *f = &frames[i % count];
+        jpeg_stream_cfg_t cfg = decode_cfg();
+        if (fbs) {
+            cfg.fb = fbs[i & 1];
+            cfg.fb_size = fb_size;
+        }
+        jpeg_stream_image_t img;
+        double t0 = now_ms();
+        esp_err_t err = jpeg_stream_decode_mem(f->data, f->size, &cfg, &img);
+        double ms = now_ms() - t0;
+        if (err != ESP_OK) {
+            r.failed++;
+            continue;
+        }
+        r.ms += ms;
+        if (ms > r.max_ms) {
+            r.max_ms = ms;
+        }
+        r.width = img.width;
+        r.height = img.height;
+        if (out && i < count) {
+            out[i] = malloc(img.size);
+            memcpy(out[i], img.pixels, img.size);
+        }
+        if (!fbs) {
+            heap_caps_free(img.pixels);
+        }
+    }
+    r.peak = host_heap_peak() - base;
+    r.ms /= s_frames - r.failed > 0 ? s_frames - r.failed : 1;
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    bench_buf_t inputs[BENCH_MAX_FRAMES];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        bench_buf_t file;
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            s_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spi-mhz") == 0 && i + 1 < argc) {
+            s_spi_mhz = atof(argv[++i]);
+        } else if (!load(argv[i], &file)) {
+            fprintf(stderr, "Cannot read %s\n", argv[i]);
+        } else if (file.size > 2 && file.data[0] == 0xFF && file.data[1] == 0xD8) {
+            if (count < BENCH_MAX_FRAMES) {
+                inputs[count++] = file;
+            }
+        } else {
+            // A recorded stream (stream_mjpeg.py --save, ffmpeg -f mpjpeg): benchmark its frames
+            double ms;
+            int n = split(&file, inputs + count, BENCH_MAX_FRAMES - count, &ms);
+            if (n < 0) {
+                fprintf(stderr, "%s is neither a JPEG nor an MJPEG stream\n", argv[i]);
+            } else {
+                count += n < BENCH_MAX_FRAMES - count ? n : BENCH_MAX_FRAMES - count;
+            }
+            free(file.data);
+        }
+    }
+    if (count == 0) {
+        static const char *const samples[] = {"hss_320_240.jpg", "mengm.jpg", "mengm2.jpg", "rs2026.jpg"};
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", BENCH_SAMPLES_DIR, samples[i]);
+            if (load(path, &inputs[count])) {
+                count++;
+            }
+        }
+    }
+    if (count == 0) {
+        fprintf(stderr, "No frames\n");
+        return 1;
+    }
+    size_t bytes = 0;
+    for (int i = 0; i < s_frames; i++) {
+        bytes += inputs[i % count].size;
+    }
+    printf("%d frames cycling %d JPEGs, %.1f KB per frame on average\n\n", s_frames, count, bytes / 1024.0 / s_frames);
+
+    printf("%-22s %9s %10s\n", "container", "bytes", "split");
+    for (int how = 0; how < 3; how++) {
+        bench_buf_t stream = wrap(inputs, count, (wrap_t)how);
+        double ms;
+        int n = split(&stream, NULL, 0, &ms);
+        if (n != s_frames) {
+            printf("%-22s %9zu   found %d of %d frames\n", s_wrap_names[how], stream.size, n, s_frames);
+        } else {
+            printf("%-22s %9zu %7.1fus  (%.0f MB/s)\n", s_wrap_names[how], stream.size, ms * 1e3 / n,
+                   stream.size / ms / 1e3);
+        }
+        free(stream.data);
+    }
+
+    const size_t fb_size = 320 * 240 * 2;
+    uint8_t *fbs[2] = { heap_caps_malloc(fb_size, 0), heap_caps_malloc(fb_size, 0) };
+    uint8_t *ref[BENCH_MAX_FRAMES] = {0};
+    uint8_t *got[BENCH_MAX_FRAMES] = {0};
+    bench_result_t alloc = decode_loop(inputs, count, NULL, 0, ref);
+    bench_result_t reuse = decode_loop(inputs, count, fbs, fb_size, got);
+    const size_t out_size = (size_t)reuse.width * reuse.height * 2;
+    int differ = 0;
+    for (int i = 0; i < count && i < s_frames; i++) {
+        differ += ref[i] && got[i] && memcmp(ref[i], got[i], out_size) != 0;
+    }
+
+    // Sending a frame to the panel: RGB565 over the SPI clock
+    const double spi_ms = (double)reuse.width * reuse.height * 16 / (s_spi_mhz * 1e3);
+    printf("\n%-22s %8s %8s %8s %8s %10s %10s\n", "decode", "avg", "max", "heap KB", "failed", "pipelined", "serial");
+    const bench_result_t *rs[2] = {&alloc, &reuse};
+    const char *names[2] = {"alloc (like /upload)", "reuse 2 framebuffers"};
+    for (int i = 0; i < 2; i++) {
+        const bench_result_t *r = rs[i];
+        const double slowest = r->ms > spi_ms ? r->ms : spi_ms;
+        printf("%-22s %6.2fms %6.2fms %8.1f %8d %6.1ffps %6.1ffps\n", names[i], r->ms, r->max_ms,
+               (i == 1 ? r->peak + 2 * fb_size : r->peak) / 1024.0, r->failed, 1e3 / slowest,
+               1e3 / (r->ms + spi_ms));
+    }
+    printf("\n%ux%u output, panel write %.1fms at %.0f MHz; pixels %s\n", reuse.width, reuse.height, spi_ms,
+           s_spi_mhz, differ ? "DIFFER" : "identical");
+    printf("heap KB: decoder allocations plus framebuffers; pipelined: max(decode, panel write), "
+           "serial: decode + panel write\n");
+
+    heap_caps_free(fbs[0]);
+    heap_caps_free(fbs[1]);
+    for (int i = 0; i < count; i++) {
+        free(ref[i]);
+        free(got[i]);
+        free(inputs[i].data);
+    }
+    return differ ? 1 : 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * PNG decode benchmark: png_stream / png_band against lodepng / lv_png
+ *
+ * Each image is decoded the way the device does it, through LVGL's decoder
+ * API with the project's sdkconfig (LV_IMG_CACHE_DEF_SIZE 0, so the image is
+ * reopened for every draw area):
+ *   - lv_png: lodepng inflates the whole file to RGBA8888, lv_png converts it
+ *     to lv_color_t + alpha, again for every area
+ *   - png_band: rows are inflated and unfiltered as LVGL reads lines, and the
+ *     parked session carries on from the previous area
+ * plus the one-shot framebuffer decode display_image.c uses
+ * (png_stream_decode_mem). Pixels of both decoders are compared.
+ *
+ * Usage: png_bench [--area-rows N] [--rounds N] [image.png ...]
+ * Without images, three synthetic UI screenshots are encoded with lodepng.
+ */
+
+#include "png_stream.h"
+#include "png_band.h"
+#include "host_heap.h"
+#include "lvgl.h"
+#include "src/extra/libs/png/lodepng.h"
+#include "src/misc/lv_gc.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    const char *name;
+    uint8_t *data;
+    size_t size;
+} bench_image_t;
+
+typedef struct {
+    double ms;
+    size_t peak;
+} bench_result_t;
+
+static int s_rounds = 20;
+static int s_area_rows = 30;    // CONFIG_DISPLAY_DRAW_BUF_LINES
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* --- Synthetic UI screenshots --- */
+
+static void fill_rect(uint8_t *rgba, int w, int x0, int y0, int x1, int y1, uint32_t c)
+{
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            uint8_t *p = rgba + (y * w + x) * 4;
+            p[0] = c >> 24;
+            p[1] = c >> 16;
+            p[2] = c >> 8;
+            p[3] = c;
+        }
+    }
+}
+
+/**
+ * @brief Status bar, cards with anti-aliased corners, rows of "text" and a gradient chart
+ */
+static uint8_t *make_ui(int w, int h, bool overlay)
+{
+    uint8_t *rgba = calloc((size_t)w * h, 4);
+    srand(w * 31 + h);
+    fill_rect(rgba, w, 0, 0, w, h, overlay ? 0x00000000 : 0x1E1E28FF);
+    fill_rect(rgba, w, 0, 0, w, 20, overlay ? 0x000000A0 : 0x30303CFF);
+    for (int card = 0; card < 3; card++) {
+        const int x0 = 8 + card * (w - 16) / 3, x1 = x0 + (w - 16) / 3 - 8;
+        const int y0 = 28, y1 = h / 2;
+        const uint32_t bg = overlay ? 0xFFFFFFC0 : (card == 1 ? 0x3A6EA5FF : 0x2C2C3AFF);
+        fill_rect(rgba, w, x0, y0, x1, y1, bg);
+        for (int i = 0; i < 3; i++) {  // Soft corners
+            uint8_t *p = rgba + ((y0 + i) * w + x0 + 2 - i) * 4;
+            p[3] /= 2;
+        }
+        for (int line = 0; line < 4; line++) {
+            const int ty = y0 + 8 + line * 12;
+            for (int x = x0 + 6; x < x1 - 6 && ty + 8 < y1; x++) {
+                if (rand() % 5 == 0) {
+                    continue;  // Gaps between glyphs
+                }
+                for (int y = ty; y < ty + 8; y++) {
+                    if (rand() % 3 == 0) {
+                        uint8_t *p = rgba + (y * w + x) * 4;
+                        p[0] = p[1] = p[2] = 0xE8;
+                        p[3] = overlay ? 0xFF : p[3];
+                    }
+                }
+            }
+        }
+    }
+    for (int y = h / 2 + 8; y < h - 8; y++) {
+        for (int x = 8; x < w - 8; x++) {
+            uint8_t *p = rgba + (y * w + x) * 4;
+            const int v = (x * 255) / w;
+            p[0] = v;
+            p[1] = 255 - v;
+            p[2] = (y * 255) / h;
+            p[3] = overlay ? (uint8_t)(x * 255 / w) : 0xFF;
+        }
+    }
+    return rgba;
+}
+
+static bool add_synthetic(bench_image_t *img, const char *name, int w, int h, bool overlay)
+{
+    uint8_t *rgba = make_ui(w, h, overlay);
+    unsigned char *png = NULL;
+    size_t size = 0;
+    // lodepng picks the smallest colour type (palette, RGB or RGBA) like most PNG tools
+    unsigned err = lodepng_encode32(&png, &size, rgba, w, h);
+    free(rgba);
+    if (err) {
+        fprintf(stderr, "lodepng_encode32: %s\n", lodepng_error_text(err));
+        return false;
+    }
+    img->name = name;
+    img->data = png;
+    img->size = size;
+    return true;
+}
+
+static bool load_file(bench_image_t *img, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    img->size = ftell(f);
+    rewind(f);
+    img->data = malloc(img->size);
+    bool ok = img->data && fread(img->data, 1, img->size, f) == img->size;
+    fclose(f);
+    const char *slash = strrchr(path, '/');
+    img->name = slash ? slash + 1 : path;
+    return ok;
+}
+
+/* --- Decoding through LVGL --- */
+
+/**
+ * @brief Draw the image as LVGL would: one decoder session per area of s_area_rows rows
+ * @param out If not NULL, receives width colours then width alpha bytes per row
+ */
+static bool draw_frame(const lv_img_dsc_t *src, uint8_t *out)
+{
+    lv_img_header_t header;
+    if (lv_img_decoder_get_info(src, &header) != LV_RES_OK) {
+        return false;
+    }
+    const int w = header.w, h = header.h;
+    uint8_t *line = malloc((size_t)w * 3);
+    bool ok = true;
+    for (int top = 0; top < h && ok; top += s_area_rows) {
+        lv_img_decoder_dsc_t dsc;
+        if (lv_img_decoder_open(&dsc, src, lv_color_black(), 0) != LV_RES_OK) {
+            ok = false;
+            break;
+        }
+        for (int y = top; y < top + s_area_rows && y < h; y++) {
+            uint8_t *colors = out ? out + (size_t)y * w * 3 : line;
+            uint8_t *alpha = colors + w * 2;
+            if (dsc.img_data) {
+                // lv_png: LV_IMG_CF_TRUE_COLOR_ALPHA, colour and alpha interleaved
+                const uint8_t *p = dsc.img_data + (size_t)y * w * 3;
+                for (int x = 0; x < w; x++, p += 3) {
+                    colors[x * 2] = p[0];
+                    colors[x * 2 + 1] = p[1];
+                    alpha[x] = p[2];
+                }
+            } else if (lv_img_decoder_read_line(&dsc, 0, y, w, line) != LV_RES_OK) {
+                ok = false;
+                break;
+            } else if (out) {
+                memcpy(colors, line, w * 2);
+                if (header.cf == LV_IMG_CF_RGB565A8) {
+                    memcpy(alpha, line + w * 2, w);
+                } else {
+                    memset(alpha, 0xFF, w);
+                }
+            }
+        }
+        lv_img_decoder_close(&dsc);
+    }
+    free(line);
+    return ok;
+}
+
+static bench_result_t bench_frame(const lv_img_dsc_t *src)
+{
+    bench_result_t r = {0};
+    png_band_invalidate(NULL);
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    const double t0 = now_ms();
+    for (int i = 0; i < s_rounds; i++) {
+        png_band_invalidate(NULL);  // Every round starts cold, like a newly shown image
+        if (!draw_frame(src, NULL)) {
+            r.ms = -1;
+            return r;
+        }
+    }
+    r.ms = (now_ms() - t0) / s_rounds;
+    r.peak = host_heap_peak() - base;
+    png_band_invalidate(NULL);
+    return r;
+}
+
+static bench_result_t bench_lodepng(const bench_image_t *img)
+{
+    bench_result_t r = {0};
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    const double t0 = now_ms();
+    for (int i = 0; i < s_rounds; i++) {
+        unsigned char *rgba;
+        unsigned w, h;
+        if (lodepng_decode32(&rgba, &w, &h, img->data, img->size)) {
+            r.ms = -1;
+            return r;
+        }
+        lv_mem_free(rgba);
+    }
+    r.ms = (now_ms() - t0) / s_rounds;
+    r.peak = host_heap_peak() - base;
+    return r;
+}
+
+static bench_result_t bench_png_stream(const bench_image_t *img)
+{
+    bench_result_t r = {0};
+    host_heap_reset_peak();
+    const size_t base = host_heap_used();
+    const double t0 = now_ms();
+    png_stream_cfg_t cfg = {.swap_bytes = LV_COLOR_16_SWAP};
+    for (int i = 0; i < s_rounds; i++) {
+        png_stream_image_t out;
+        if (png_stream_decode_mem(img->data, img->size, &cfg, &out) != ESP_OK) {
+            r.ms = -1;
+            return r;
+        }
+        heap_caps_free(out.pixels);
+    }
+    r.ms = (now_ms() - t0) / s_rounds;
+    r.peak = host_heap_peak() - base;
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    bench_image_t images[32];
+    int count = 0;
+
+    lv_init();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--area-rows") == 0 && i + 1 < argc) {
+            s_area_rows = atoi(argv[++i]);
+        } else if (count < 32 && load_file(&images[count], argv[i])) {
+            count++;
+        } else {
+            return 1;
+        }
+    }
+    if (count == 0) {
+        count += add_synthetic(&images[count], "ui_320x240", 320, 240, false);
+        count += add_synthetic(&images[count], "overlay_320x240", 320, 240, true);
+        count += add_synthetic(&images[count], "icons_96x96", 96, 96, true);
+    }
+    if (s_rounds < 1 || s_area_rows < 1) {
+        return 1;
+    }
+
+    printf("%d rounds, LVGL draw areas of %d rows, LV_COLOR_16_SWAP=%d\n\n", s_rounds, s_area_rows, LV_COLOR_16_SWAP);
+    printf("%-18s %8s | %9s %9s | %9s %9s | %11s %9s | %11s %9s | %s\n", "image", "bytes",
+           "lodepng", "peak KB", "png_strm", "peak KB", "lv_png fr.", "peak KB", "png_band fr.", "peak KB", "pixels");
+    for (int i = 0; i < count; i++) {
+        const bench_image_t *img = &images[i];
+        lv_img_dsc_t src = {
+            .header.always_zero = 0,
+            .header.cf = LV_IMG_CF_UNKNOWN,
+            .data_size = img->size,
+            .data = img->data,
+        };
+
+        // lv_png first: png_band, once registered, is tried before it
+        lv_img_header_t header;
+        if (lv_img_decoder_get_info(&src, &header) != LV_RES_OK) {
+            printf("%-18s not a PNG LVGL can decode\n", img->name);
+            continue;
+        }
+        uint8_t *ref = malloc((size_t)header.w * header.h * 3);
+        bool ref_ok = draw_frame(&src, ref);
+        bench_result_t lv_frame = bench_frame(&src);
+        bench_result_t lode = bench_lodepng(img);
+        bench_result_t stream = bench_png_stream(img);
+
+        // png_band is registered for this image and removed again for the next one
+        png_band_init();
+        lv_img_decoder_t *band = _lv_ll_get_head(&LV_GC_ROOT(_lv_img_decoder_ll));
+        uint8_t *got = malloc((size_t)header.w * header.h * 3);
+        bool got_ok = draw_frame(&src, got);
+        bench_result_t band_frame = bench_frame(&src);
+        png_band_invalidate(NULL);
+        lv_img_decoder_delete(band);
+
+        const char *pixels = !ref_ok || !got_ok ? "decode failed"
+                           : memcmp(ref, got, (size_t)header.w * header.h * 3) == 0 ? "identical" : "DIFFER";
+        printf("%-18s %8zu | %7.3fms %9.1f | %7.3fms %9.1f | %9.3fms %9.1f | %9.3fms %9.1f | %s\n",
+               img->name, img->size, lode.ms, lode.peak / 1024.0, stream.ms, stream.peak / 1024.0,
+               lv_frame.ms, lv_frame.peak / 1024.0, band_frame.ms, band_frame.peak / 1024.0, pixels);
+        free(ref);
+        free(got);
+    }
+    printf("\nlodepng / png_strm: one decode to RGBA8888 / to the RGB565(A8) framebuffer\n"
+           "lv_png fr. / png_band fr.: one full redraw through the LVGL decoder API\n");
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Progressive JPEG (SOF2) test of components/jpeg_stream
+ *
+ * The fixtures in host/testdata come in pairs: a progressive JPEG and a
+ * baseline JPEG of the same image with the same quantization tables, so both
+ * hold the same coefficients. At 1/1 and 1/8 (through cfg->max_width and
+ * max_height) the progressive one must decode to exactly the pixels of the
+ * baseline one. At 1/2 and 1/4 it only keeps the first 25 or 5 zigzag
+ * coefficients of each block while the baseline decode uses all 64, so there
+ * it must stay within TEST_MIN_PSNR of the baseline output. The peak heap of
+ * the progressive decode may only exceed the framebuffer by the coefficient
+ * buffer the README promises for that scale (128/60/20/2 bytes per block)
+ * plus the work buffer.
+ * prog_big.jpg needs more than CONFIG_JPEG_STREAM_PROGRESSIVE_MAX_KB at full
+ * size: it must be refused with ESP_ERR_NO_MEM before anything image-sized is
+ * allocated, and still decode when fitted to the screen. A progressive file
+ * cut off in a later scan must still give an image.
+ *
+ * Usage: progressive_test
+ * Exits with 1 if any check fails.
+ */
+
+#include "jpeg_stream.h"
+#include "jdec.h"
+#include "host_heap.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Lowest PSNR against the baseline twin at 1/2 and 1/4, in dB
+#define TEST_MIN_PSNR       35
+// Anything else the decoder may hold besides the framebuffer, coefficients and work pool
+#define TEST_HEAP_SLACK     1024
+// Band and column sums of the area-average downscale
+#define TEST_DOWNSCALE_SLACK (16 * 1024)
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} test_file_t;
+
+static const char *const s_scale_name[] = {"1/1", "1/2", "1/4", "1/8"};
+// Coefficient bytes kept per block at each scale (components/jpeg_stream/README.md)
+static const size_t s_block_bytes[] = {128, 60, 20, 2};
+
+static bool load_file(test_file_t *f, const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_TESTDATA_DIR, name);
+    FILE *fp = fopen(path, "rb");
+    f->data = NULL;
+    f->size = 0;
+    if (!fp) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    f->data = len > 0 ? malloc(len) : NULL;
+    if (f->data && fread(f->data, 1, len, fp) == (size_t)len) {
+        f->size = len;
+    }
+    fclose(fp);
+    return f->size > 0;
+}
+
+/**
+ * @brief PSNR of two byte-swapped RGB565 images over the 8-bit R, G and B values
+ */
+static double psnr(const uint8_t *a, const uint8_t *b, size_t pixels)
+{
+    double sum = 0;
+    for (size_t i = 0; i < pixels; i++) {
+        const uint16_t ca = a[2 * i] << 8 | a[2 * i + 1], cb = b[2 * i] << 8 | b[2 * i + 1];
+        const int d[3] = {
+            ((ca >> 11) - (cb >> 11)) * 255 / 31,
+            (((ca >> 5) & 0x3F) - ((cb >> 5) & 0x3F)) * 255 / 63,
+            ((ca & 0x1F) - (cb & 0x1F)) * 255 / 31,
+        };
+        sum += d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    }
+    return sum ? 10 * log10(255.0 * 255.0 * pixels * 3 / sum) : INFINITY;
+}
+
+static esp_err_t decode(const test_file_t *f, size_t len, uint16_t max_w, uint16_t max_h, jpeg_stream_image_t *img,
+                        size_t *peak)
+{
+    const jpeg_stream_cfg_t cfg = {
+        .swap_bytes = true,
+        .max_width = max_w,
+        .max_height = max_h,
+    };
+    const size_t base = host_heap_used();
+    host_heap_reset_peak();
+    const esp_err_t err = jpeg_stream_decode_mem(f->data, len, &cfg, img);
+    *peak = host_heap_peak() - base;
+    return err;
+}
+
+/**
+ * @brief Progressive and baseline twins at scale 1 >> scale of a w x h image with `blocks` 8x8 blocks
+ */
+static int test_pair(const char *prog_name, const char *base_name, uint16_t w, uint16_t h, size_t blocks)
+{
+    test_file_t prog, base;
+    int failed = 0;
+    if (!load_file(&prog, prog_name) || !load_file(&base, base_name)) {
+        free(prog.data);
+        free(base.data);
+        return 1;
+    }
+    for (int scale = 0; scale < 4; scale++) {
+        const uint16_t out_w = w >> scale, out_h = h >> scale;
+        jpeg_stream_image_t p = {0}, b = {0};
+        size_t prog_peak, base_peak;
+        const esp_err_t perr = decode(&prog, prog.size, scale ? out_w : 0, scale ? out_h : 0, &p, &prog_peak);
+        const esp_err_t berr = decode(&base, base.size, scale ? out_w : 0, scale ? out_h : 0, &b, &base_peak);
+        const size_t coef = blocks * s_block_bytes[scale];
+        const size_t limit = (size_t)out_w * out_h * 2 + coef + JDEC_WORK_POOL + TEST_HEAP_SLACK;
+        const bool exact = scale == 0 || scale == 3;
+        const char *problem = NULL;
+        double db = 0;
+        if (perr != ESP_OK || berr != ESP_OK) {
+            problem = perr != ESP_OK ? "progressive decode failed" : "baseline decode failed";
+        } else if (p.width != out_w || p.height != out_h || b.width != out_w || b.height != out_h) {
+            problem = "wrong size";
+        } else if (exact && memcmp(p.pixels, b.pixels, p.size)) {
+            problem = "pixels differ from the baseline twin";
+        } else if (!exact && (db = psnr(p.pixels, b.pixels, (size_t)out_w * out_h)) < TEST_MIN_PSNR) {
+            problem = "too far from the baseline twin";
+        } else if (prog_peak > limit) {
+            problem = "peak heap above framebuffer + coefficients + work buffer";
+        }
+        char match[16];
+        snprintf(match, sizeof(match), exact ? "same" : "%.1f dB", db);
+        printf("%-14s %3s %4ux%-4u %8.1f %8.1f %8.1f %9s  %s\n", prog_name, s_scale_name[scale], out_w, out_h,
+               prog_peak / 1024.0, base_peak / 1024.0, coef / 1024.0, problem && exact ? "-" : match,
+               problem ? problem : "ok");
+        failed += problem != NULL;
+        heap_caps_free(p.pixels);
+        heap_caps_free(b.pixels);
+    }
+    free(prog.data);
+    free(base.data);
+    return failed;
+}
+
+/**
+ * @brief prog_big.jpg: refused at full size without allocating it, decoded when fitted to the screen
+ */
+static int test_big(void)
+{
+    test_file_t big;
+    if (!load_file(&big, "prog_big.jpg")) {
+        free(big.data);
+        return 1;
+    }
+    int failed = 0;
+    jpeg_stream_image_t img = {0};
+    size_t peak;
+    // 2048x1152 grayscale: 36864 blocks of 128 bytes at full size
+    const size_t need = (size_t)36864 * s_block_bytes[0];
+    esp_err_t err = decode(&big, big.size, 0, 0, &img, &peak);
+    const bool refused = err == ESP_ERR_NO_MEM && peak <= JDEC_WORK_POOL + TEST_HEAP_SLACK;
+    printf("%-14s %3s %9s %8.1f %8s %8.1f %9s  %s (limit %d KB)\n", "prog_big.jpg", "1/1", "2048x1152",
+           peak / 1024.0, "-", need / 1024.0, "-",
+           refused ? "refused" : err == ESP_ERR_NO_MEM ? "refused after allocating" : "not refused",
+           CONFIG_JPEG_STREAM_PROGRESSIVE_MAX_KB);
+    failed += need > (size_t)CONFIG_JPEG_STREAM_PROGRESSIVE_MAX_KB * 1024 && !refused;
+    heap_caps_free(img.pixels);
+
+    // Fitted to 320x240 it is decoded at 1/4 and area-averaged to 320x180
+    const size_t coef = (size_t)36864 * s_block_bytes[2];
+    err = decode(&big, big.size, 320, 240, &img, &peak);
+    bool flat = err == ESP_OK && img.width == 320 && img.height == 180;
+    for (size_t i = 2; flat && i < img.size; i += 2) {
+        flat = img.pixels[i] == img.pixels[0] && img.pixels[i + 1] == img.pixels[1];
+    }
+    const bool bounded = peak <= img.size + coef + JDEC_WORK_POOL + TEST_DOWNSCALE_SLACK;
+    printf("%-14s %3s %4ux%-4u %8.1f %8s %8.1f %9s  %s\n", "prog_big.jpg", "fit", img.width, img.height,
+           peak / 1024.0, "-", coef / 1024.0, "-", !flat ? "wrong output" : bounded ? "ok" : "peak heap too high");
+    failed += !flat || !bounded;
+    heap_caps_free(img.pixels);
+    free(big.data);
+    return failed;
+}
+
+/**
+ * @brief A progressive file cut off in a later scan still shows the scans that arrived
+ */
+static int test_truncated(void)
+{
+    test_file_t prog;
+    if (!load_file(&prog, "prog_420.jpg")) {
+        free(prog.data);
+        return 1;
+    }
+    jpeg_stream_image_t img = {0};
+    size_t peak;
+    const esp_err_t err = decode(&prog, prog.size * 6 / 10, 0, 0, &img, &peak);
+    const bool ok = err == ESP_OK && img.width == 320 && img.height == 240;
+    printf("%-14s %3s %4ux%-4u %8.1f %8s %8s %9s  %s\n", "prog_420.jpg", "60%", img.width, img.height,
+           peak / 1024.0, "-", "-", "-", ok ? "ok (coarser image)" : "failed");
+    heap_caps_free(img.pixels);
+    free(prog.data);
+    return !ok;
+}
+
+int main(void)
+{
+    printf("%-14s %3s %9s %8s %8s %8s %9s\n", "image", "scl", "output", "peak KB", "base KB", "coef KB", "vs base");
+    int failed = 0;
+    // 320x240: 1200 Y blocks, plus 2 x 300 chroma blocks at 4:2:0
+    failed += test_pair("prog_420.jpg", "base_420.jpg", 320, 240, 1800);
+    failed += test_pair("prog_gray.jpg", "base_gray.jpg", 320, 240, 1200);
+    failed += test_big();
+    failed += test_truncated();
+    printf("\npeak KB: heap above idle during the progressive decode; base KB: the same for the baseline twin\n"
+           "coef KB: coefficient buffer the progressive decode needs at that scale\n"
+           "vs base: output compared with the baseline twin (PSNR where only part of the coefficients is kept)\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Restart-marker slicing benchmark: one core against two (CONFIG_JPEG_STREAM_PARALLEL)
+ *
+ * Every JPEG is decoded at full size twice per round:
+ *   - 1 core: jpeg_stream_decode() reading the same bytes through a callback,
+ *     which never splits the scan
+ *   - 2 cores: jpeg_stream_decode_mem(), which splits a restart-marked scan
+ *     at the middle RSTn marker and decodes the bottom half in a second task
+ * The two framebuffers must be byte-identical and on_band must see every row
+ * exactly once, top to bottom, in both; the program returns 1 otherwise, or
+ * if a JPEG with restart markers was not split at all.
+ * Host threads stand in for the two cores, so the speedup is only an upper
+ * bound for the ESP32-S3, where both cores also share the PSRAM bus.
+ *
+ * Usage: rst_bench [--rounds N] [image.jpg ...]
+ * Without images the restart-marked fixtures in host/testdata are used.
+ */
+
+#include "jpeg_stream.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_IMAGES    32
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} bench_reader_t;
+
+typedef struct {
+    uint16_t next_row;          // First row on_band has not reported yet
+    bool out_of_order;
+} bench_bands_t;
+
+static int s_rounds = 20;
+static int s_slices;            // Slice tasks started by jpeg_stream.c
+
+/*
+ * Linked with -Wl,--wrap=xTaskCreatePinnedToCore to count the slice tasks, so
+ * a scan that was not split shows up as a failure instead of a 1x speedup
+ */
+BaseType_t __real_xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                          UBaseType_t prio, TaskHandle_t *task, BaseType_t core);
+
+BaseType_t __wrap_xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                          UBaseType_t prio, TaskHandle_t *task, BaseType_t core)
+{
+    if (!strcmp(name, "jpeg_slice")) {
+        __atomic_add_fetch(&s_slices, 1, __ATOMIC_RELAXED);
+    }
+    return __real_xTaskCreatePinnedToCore(fn, name, stack, arg, prio, task, core);
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint8_t *load_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = len > 0 ? malloc(len) : NULL;
+    if (data && fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+static int bench_read(void *ctx, uint8_t *buf, size_t len)
+{
+    bench_reader_t *r = ctx;
+    size_t n = r->size - r->pos < len ? r->size - r->pos : len;
+    memcpy(buf, r->data + r->pos, n);
+    r->pos += n;
+    return (int)n;
+}
+
+static void bench_band(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height, uint16_t y, uint16_t rows)
+{
+    bench_bands_t *b = ctx;
+    if (y != b->next_row) {
+        b->out_of_order = true;
+    }
+    b->next_row = y + rows;
+}
+
+/**
+ * @brief Decode data on one core (parallel false) or let jpeg_stream split it
+ * @return Decoded image, pixels NULL on failure or if the bands were wrong
+ */
+static jpeg_stream_image_t decode(const uint8_t *data, size_t size, bool parallel, double *ms)
+{
+    bench_reader_t reader = { .data = data, .size = size };
+    bench_bands_t bands = {0};
+    jpeg_stream_cfg_t cfg = {
+        .read = bench_read,
+        .read_ctx = &reader,
+        .swap_bytes = true,
+        .on_band = bench_band,
+        .band_ctx = &bands,
+    };
+    jpeg_stream_image_t img = {0};
+    const double t0 = now_ms();
+    const esp_err_t err = parallel ? jpeg_stream_decode_mem(data, size, &cfg, &img) : jpeg_stream_decode(&cfg, &img);
+    *ms = now_ms() - t0;
+    if (err != ESP_OK || bands.out_of_order || bands.next_row != img.height) {
+        heap_caps_free(img.pixels);
+        img.pixels = NULL;
+    }
+    return img;
+}
+
+/**
+ * @brief Restart interval from the DRI segment, 0 if there is none
+ */
+static unsigned int restart_interval(const uint8_t *data, size_t size)
+{
+    for (size_t i = 2; i + 5 < size && data[i] == 0xFF; i += 2 + (data[i + 2] << 8 | data[i + 3])) {
+        if (data[i + 1] == 0xDD) {
+            return data[i + 4] << 8 | data[i + 5];
+        }
+        if (data[i + 1] == 0xDA) {
+            break;
+        }
+    }
+    return 0;
+}
+
+static int bench_image(const char *name, const uint8_t *data, size_t size)
+{
+    double one_ms = 0, two_ms = 0;
+    int slices = 0;
+    jpeg_stream_image_t ref = {0};
+    for (int round = 0; round < s_rounds; round++) {
+        double ms;
+        jpeg_stream_image_t one = decode(data, size, false, &ms);
+        one_ms += ms;
+        const int before = s_slices;
+        jpeg_stream_image_t two = decode(data, size, true, &ms);
+        two_ms += ms;
+        slices += s_slices - before;
+        if (!one.pixels || !two.pixels) {
+            printf("%-24s decode or band order failed (%s)\n", name, one.pixels ? "2 cores" : "1 core");
+            heap_caps_free(one.pixels);
+            heap_caps_free(two.pixels);
+            heap_caps_free(ref.pixels);
+            return 1;
+        }
+        if (one.size != two.size || memcmp(one.pixels, two.pixels, one.size)) {
+            size_t i = 0;
+            while (i < one.size && i < two.size && one.pixels[i] == two.pixels[i]) {
+                i++;
+            }
+            printf("%-24s sliced output differs from 1 core at pixel %zu (row %zu)\n", name, i / 2,
+                   i / 2 / (one.width ? one.width : 1));
+            heap_caps_free(one.pixels);
+            heap_caps_free(two.pixels);
+            heap_caps_free(ref.pixels);
+            return 1;
+        }
+        // Both must also be the same every round
+        if (!ref.pixels) {
+            ref = one;
+        } else {
+            if (memcmp(ref.pixels, one.pixels, one.size)) {
+                printf("%-24s output changes between rounds\n", name);
+                heap_caps_free(one.pixels);
+                heap_caps_free(two.pixels);
+                heap_caps_free(ref.pixels);
+                return 1;
+            }
+            heap_caps_free(one.pixels);
+        }
+        heap_caps_free(two.pixels);
+    }
+    const unsigned int dri = restart_interval(data, size);
+    char dims[16];
+    snprintf(dims, sizeof(dims), "%ux%u", ref.width, ref.height);
+    heap_caps_free(ref.pixels);
+    printf("%-24s %8.1f %9s %5u %8.2fms %8.2fms %7.2fx %9s\n", name, size / 1024.0, dims, dri, one_ms / s_rounds,
+           two_ms / s_rounds, two_ms > 0 ? one_ms / two_ms : 0, slices == s_rounds ? "yes" : slices ? "some" : "no");
+    // A restart-marked baseline scan must be split every time
+    return dri && slices != s_rounds;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const fixtures[] = {"rst_420.jpg", "rst_444.jpg"};
+    const char *paths[BENCH_MAX_IMAGES];
+    char fixture_paths[2][512];
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (count < BENCH_MAX_IMAGES) {
+            paths[count++] = argv[i];
+        }
+    }
+    if (count == 0) {
+        for (int i = 0; i < 2; i++) {
+            snprintf(fixture_paths[i], sizeof(fixture_paths[i]), "%s/%s", BENCH_TESTDATA_DIR, fixtures[i]);
+            paths[count++] = fixture_paths[i];
+        }
+    }
+    if (s_rounds < 1) {
+        fprintf(stderr, "Invalid arguments\n");
+        return 1;
+    }
+
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d rounds per image, %ld CPUs%s\n\n", s_rounds, cpus,
+           cpus < 2 ? " (the slices cannot run at the same time, only the output check counts)" : "");
+    printf("%-24s %8s %9s %5s %10s %10s %8s %9s\n", "image", "KB", "size", "DRI",
+           "1 core", "2 cores", "speedup", "split");
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        size_t size;
+        uint8_t *data = load_file(paths[i], &size);
+        const char *name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+        if (!data) {
+            fprintf(stderr, "Cannot read %s\n", paths[i]);
+            failed++;
+            continue;
+        }
+        failed += bench_image(name, data, size);
+        free(data);
+    }
+    printf("\n1 core: jpeg_stream_decode() from a read callback; 2 cores: jpeg_stream_decode_mem()\n"
+           "split: whether the scan was decoded as two slices; output checked byte for byte\n");
+    return failed ? 1 : 0;
+}
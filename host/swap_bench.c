@@ -0,0 +1,255 @@
+/*
+ * RGB565 byte order benchmark: what LV_COLOR_16_SWAP costs per 320x240 frame
+ *
+ * Built twice against the same LVGL sources: swap_bench with the project's
+ * LV_COLOR_16_SWAP=1 (pixels high byte first, as the SPI panel takes them by
+ * default) and swap_bench_native with LV_COLOR_16_SWAP=0 (CPU order, which
+ * the Box-3's SPI panel would have to swap itself; not used on the device).
+ * Per frame:
+ *   - swap pass: a separate per-pixel byte swap over the frame, the loop
+ *     lv_sjpg's decoder_read_line and img565_swap() run (kept scalar, like
+ *     the Xtensa build); 0 without the swap
+ *   - JPEG MCUs to RGB565: jdec_mcu_rgb565_fast() for a frame of 4:2:0 MCUs,
+ *     with the swap folded into the pixel packing as the decoders here do
+ *   - LVGL scenes: full refreshes (render + flush into the in-memory panel)
+ *     of an opaque image, an image at 50 % opacity, an RGB565A8 image, a
+ *     50 % fill over an image and text over an image; with the swap, LVGL's
+ *     lv_color_mix() swaps both inputs and the result of every blended pixel
+ * swap_bench runs swap_bench_native from its own directory when it is there
+ * and prints the time each frame saves without the swap.
+ *
+ * Usage: swap_bench [--rounds N] [--raw]
+ */
+
+#include "host_panel.h"
+#include "jdec_kernels.h"
+#include "bsp/esp-box-3.h"
+#include "lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_PIXELS        (BSP_LCD_H_RES * BSP_LCD_V_RES)
+#define BENCH_MCUS          ((BSP_LCD_H_RES / 16) * (BSP_LCD_V_RES / 16))
+#define BENCH_MCU_SAMPLES   (6 * 64)
+#define BENCH_MAX_SCENES    16
+
+typedef struct {
+    const char *name;
+    double us;
+} bench_scene_t;
+
+static int s_rounds = 20;
+static bench_scene_t s_scenes[BENCH_MAX_SCENES];
+static int s_scene_count;
+static uint32_t s_rng = 0x12345678;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t bench_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void bench_add(const char *name, double us)
+{
+    s_scenes[s_scene_count].name = name;
+    s_scenes[s_scene_count].us = us;
+    s_scene_count++;
+}
+
+/* One byte swap per pixel; not vectorised, as GCC does not vectorise it for Xtensa either */
+__attribute__((noinline, optimize("no-tree-vectorize")))
+static void bench_swap_pass(uint16_t *px, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        px[i] = (uint16_t)(px[i] << 8 | px[i] >> 8);
+    }
+}
+
+static void bench_cpu(void)
+{
+    uint16_t *frame = malloc(BENCH_PIXELS * 2);
+    jd_yuv_t *mcus = malloc(BENCH_MCUS * BENCH_MCU_SAMPLES * sizeof(jd_yuv_t));
+    for (int i = 0; i < BENCH_PIXELS; i++) {
+        frame[i] = (uint16_t)bench_rand();
+    }
+    // Y in 0..255, Cb/Cr around 0, like the IDCT output
+    for (int m = 0; m < BENCH_MCUS; m++) {
+        jd_yuv_t *mcu = mcus + m * BENCH_MCU_SAMPLES;
+        for (int i = 0; i < BENCH_MCU_SAMPLES; i++) {
+            mcu[i] = i < 4 * 64 ? (jd_yuv_t)(bench_rand() & 0xFF) : (jd_yuv_t)((int)(bench_rand() % 200) - 100);
+        }
+    }
+
+    // Without LV_COLOR_16_SWAP nothing needs a separate swap pass
+    double t0 = now_us();
+    for (int r = 0; LV_COLOR_16_SWAP && r < s_rounds; r++) {
+        bench_swap_pass(frame, BENCH_PIXELS);
+    }
+    bench_add("swap pass", LV_COLOR_16_SWAP ? (now_us() - t0) / s_rounds : 0);
+
+    t0 = now_us();
+    for (int r = 0; r < s_rounds; r++) {
+        uint16_t *out = frame;
+        for (int m = 0; m < BENCH_MCUS; m++, out += 256) {
+            jdec_mcu_rgb565_fast(mcus + m * BENCH_MCU_SAMPLES, 2, 2, out, LV_COLOR_16_SWAP);
+        }
+    }
+    bench_add("JPEG MCUs to RGB565", (now_us() - t0) / s_rounds);
+    free(frame);
+    free(mcus);
+}
+
+/* A 320x240 image in lv_color_t order; with alpha, an RGB565A8 alpha plane follows the colours */
+static lv_img_dsc_t *bench_image(bool alpha)
+{
+    lv_img_dsc_t *img = calloc(1, sizeof(*img));
+    uint8_t *data = malloc(BENCH_PIXELS * (alpha ? 3 : 2));
+    lv_color_t *px = (lv_color_t *)data;
+    for (int y = 0; y < BSP_LCD_V_RES; y++) {
+        for (int x = 0; x < BSP_LCD_H_RES; x++) {
+            // Gradient with noise, so neighbouring pixels differ
+            const uint8_t n = bench_rand() & 0x1F;
+            px[y * BSP_LCD_H_RES + x] = lv_color_make((uint8_t)(x * 255 / BSP_LCD_H_RES) ^ n,
+                                                      (uint8_t)(y * 255 / BSP_LCD_V_RES), (uint8_t)(x + y) ^ n);
+            if (alpha) {
+                data[BENCH_PIXELS * 2 + y * BSP_LCD_H_RES + x] = (uint8_t)(x + y);
+            }
+        }
+    }
+    img->header.cf = alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR;
+    img->header.w = BSP_LCD_H_RES;
+    img->header.h = BSP_LCD_V_RES;
+    img->data_size = BENCH_PIXELS * (alpha ? 3 : 2);
+    img->data = data;
+    return img;
+}
+
+static void bench_refresh(const char *name)
+{
+    lv_refr_now(NULL);
+    const double t0 = now_us();
+    for (int r = 0; r < s_rounds; r++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+    }
+    bench_add(name, (now_us() - t0) / s_rounds);
+    lv_obj_clean(lv_scr_act());
+}
+
+static void bench_lvgl(void)
+{
+    if (!host_display_start(CONFIG_DISPLAY_DRAW_BUF_LINES, CONFIG_DISPLAY_DRAW_BUF_COUNT == 2)) {
+        fprintf(stderr, "No memory for the draw buffers\n");
+        exit(1);
+    }
+    lv_img_cache_set_size(0);
+    lv_img_dsc_t *image = bench_image(false);
+    lv_img_dsc_t *alpha = bench_image(true);
+    lv_obj_t *scr = lv_scr_act();
+    lv_obj_set_style_bg_color(scr, lv_color_white(), 0);
+
+    lv_img_set_src(lv_img_create(scr), image);
+    bench_refresh("LVGL opaque image");
+
+    lv_obj_t *img = lv_img_create(scr);
+    lv_img_set_src(img, image);
+    lv_obj_set_style_img_opa(img, LV_OPA_50, 0);
+    bench_refresh("LVGL image, 50% opa");
+
+    lv_img_set_src(lv_img_create(scr), alpha);
+    bench_refresh("LVGL RGB565A8 image");
+
+    lv_img_set_src(lv_img_create(scr), image);
+    lv_obj_t *fill = lv_obj_create(scr);
+    lv_obj_remove_style_all(fill);
+    lv_obj_set_size(fill, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_style_bg_color(fill, lv_color_make(0x20, 0x40, 0xC0), 0);
+    lv_obj_set_style_bg_opa(fill, LV_OPA_50, 0);
+    bench_refresh("LVGL 50% fill on image");
+
+    lv_img_set_src(lv_img_create(scr), image);
+    lv_obj_t *label = lv_label_create(scr);
+    lv_obj_set_width(label, BSP_LCD_H_RES);
+    lv_obj_set_style_text_color(label, lv_color_white(), 0);
+    static char text[2048];
+    for (size_t i = 0; i + 1 < sizeof(text); i++) {
+        text[i] = (i % 7 == 6) ? ' ' : (char)('a' + i % 26);
+    }
+    lv_label_set_text_static(label, text);
+    bench_refresh("LVGL text on image");
+}
+
+/* Times of swap_bench_native, matched to ours by scene order */
+static int bench_run_native(const char *argv0, double *us)
+{
+    char cmd[600];
+    const char *slash = strrchr(argv0, '/');
+    const int dir_len = slash ? (int)(slash - argv0) : 1;
+    snprintf(cmd, sizeof(cmd), "%.*s/swap_bench_native --raw --rounds %d 2>/dev/null", dir_len,
+             slash ? argv0 : ".", s_rounds);
+    FILE *p = popen(cmd, "r");
+    if (!p) {
+        return 0;
+    }
+    int n = 0;
+    while (n < BENCH_MAX_SCENES && fscanf(p, "%lf", &us[n]) == 1) {
+        n++;
+    }
+    return pclose(p) == 0 ? n : 0;
+}
+
+int main(int argc, char **argv)
+{
+    bool raw = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            s_rounds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--raw")) {
+            raw = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--rounds N] [--raw]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (s_rounds < 1) {
+        s_rounds = 1;
+    }
+
+    bench_cpu();
+    bench_lvgl();
+    if (raw) {
+        for (int i = 0; i < s_scene_count; i++) {
+            printf("%.3f\n", s_scenes[i].us);
+        }
+        return 0;
+    }
+
+    double native[BENCH_MAX_SCENES] = {0};
+    const int native_count = LV_COLOR_16_SWAP ? bench_run_native(argv[0], native) : 0;
+    printf("%dx%d frame, %d rounds, LV_COLOR_16_SWAP=%d\n\n", BSP_LCD_H_RES, BSP_LCD_V_RES, s_rounds, LV_COLOR_16_SWAP);
+    if (native_count != s_scene_count) {
+        printf("%-26s %10s %8s\n", "scene", "us/frame", "ns/px");
+        for (int i = 0; i < s_scene_count; i++) {
+            printf("%-26s %10.1f %8.2f\n", s_scenes[i].name, s_scenes[i].us, s_scenes[i].us * 1000 / BENCH_PIXELS);
+        }
+        return 0;
+    }
+    printf("%-26s %12s %12s %12s %7s\n", "scene", "swap us", "native us", "saved us", "saved");
+    for (int i = 0; i < s_scene_count; i++) {
+        const double saved = s_scenes[i].us - native[i];
+        printf("%-26s %12.1f %12.1f %12.1f %6.0f%%\n", s_scenes[i].name, s_scenes[i].us, native[i], saved,
+               s_scenes[i].us > 0 ? saved * 100 / s_scenes[i].us : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Regenerate the fixtures of the host tests: JPEGs from the repo's sample
+images and IMG565 files from img565.py
+Usage: python host/testdata/make_fixtures.py
+
+Needs Pillow. The outputs are committed, so the host build does not need
+Python; rerun this only to change a fixture.
+  rst_420.jpg   mengm.jpg with a restart marker every MCU row (4:2:0)
+  rst_444.jpg   hss_320_240.jpg at 4:4:4, restart interval of 7 MCUs, so the
+                split falls in the middle of an MCU row
+  prog_420.jpg  mengm.jpg as a progressive JPEG (SOF2, 4:2:0), and
+  base_420.jpg  the same image baseline with the same quantization tables:
+                both hold the same coefficients, so they must decode to the
+                same pixels at every scale
+  prog_gray.jpg / base_gray.jpg  the same pair in grayscale
+  prog_big.jpg  2048x1152 progressive grayscale, one flat colour: at full
+                size its coefficients need more than the default
+                JPEG_STREAM_PROGRESSIVE_MAX_KB (4096 KB), fitted to the
+                screen it needs about 720 KB
+  img565_src.bin  67x37 source pixels for the IMG565 fixtures: big-endian
+                RGB565, then one alpha byte per pixel (flat runs, a gradient
+                and noise, so every RLE and LZ4 path is taken)
+  img565_<none|rle|lz4>[_a8].i565  those pixels encoded by img565.py with
+                each compression, 16 rows per tile (the last tile has 5),
+                with and without the alpha plane
+"""
+
+import os
+import sys
+from PIL import Image
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.join(HERE, '..', '..')
+sys.path.insert(0, REPO)
+import img565  # noqa: E402
+
+
+def sample(name):
+    return Image.open(os.path.join(REPO, name)).convert('RGB')
+
+
+def main():
+    sample('mengm.jpg').save(os.path.join(HERE, 'rst_420.jpg'), quality=90, subsampling=2,
+                             restart_marker_rows=1)
+    sample('hss_320_240.jpg').save(os.path.join(HERE, 'rst_444.jpg'), quality=90, subsampling=0,
+                                   restart_marker_blocks=7)
+    rgb = sample('mengm.jpg')
+    gray = rgb.convert('L')
+    for name, im, opts in (('420', rgb, {'subsampling': 2}), ('gray', gray, {})):
+        im.save(os.path.join(HERE, 'prog_%s.jpg' % name), quality=85, progressive=True, **opts)
+        im.save(os.path.join(HERE, 'base_%s.jpg' % name), quality=85, **opts)
+    Image.new('L', (2048, 1152), 140).save(os.path.join(HERE, 'prog_big.jpg'), quality=85, progressive=True)
+
+    w, h = 67, 37
+    colors, alpha = img565._synthetic(w, h, 565)
+    with open(os.path.join(HERE, 'img565_src.bin'), 'wb') as f:
+        f.write(colors + alpha)
+    for comp in img565.COMPRESSIONS:
+        for suffix, a in (('', None), ('_a8', alpha)):
+            with open(os.path.join(HERE, 'img565_%s%s.i565' % (comp, suffix)), 'wb') as f:
+                f.write(img565.encode(w, h, colors, a, comp, 16))
+
+
+if __name__ == '__main__':
+    main()
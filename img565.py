@@ -0,0 +1,387 @@
+#!/usr/bin/env python3
+"""
+IMG565 encoder: convert images into the device-native tiled RGB565 format
+Usage: python img565.py <input> <output.i565> [--compress lz4|rle|none] [--tile-rows N] [--fit WxH]
+       python img565.py --selftest [images...]
+Example: python img565.py screenshot.png screenshot.i565 --fit 320x240
+         curl -X POST --data-binary @screenshot.i565 http://<device_ip>/upload
+
+The file layout is documented in components/img565/img565.h. The device shows
+an IMG565 image without decoding it: raw tiles are copied as they are, RLE
+and LZ4 tiles only need to be decompressed. Images with transparency get an
+alpha plane (LV_IMG_CF_RGB565A8 on the device).
+
+Can also be imported: encode(), decode(), rgb565_to_rgb() work on bytes and
+need no third-party modules; reading and writing image files needs Pillow.
+--selftest encodes synthetic images (and the given files) with every
+compression and tile size, decodes them again and checks the pixels match.
+"""
+
+import sys
+import struct
+import random
+import argparse
+
+MAGIC = b'I565'
+VERSION = 1
+HEADER = struct.Struct('<4sBBBBHHHH')
+FLAG_ALPHA = 0x01
+COMPRESSIONS = {'none': 0, 'rle': 1, 'lz4': 2}
+
+
+# --- RLE: control byte < 0x80: c + 1 literal units; >= 0x80: one unit repeated (c & 0x7F) + 2 times ---
+
+def rle_encode(data, unit):
+    out = bytearray()
+    n = len(data) // unit
+    units = [data[i * unit:(i + 1) * unit] for i in range(n)]
+    min_run = 2 if unit == 2 else 3     # a 2-byte run only pays off for pixels
+    lit_start = 0
+    i = 0
+
+    def flush_literals(end):
+        start = lit_start
+        while start < end:
+            k = min(128, end - start)
+            out.append(k - 1)
+            out.extend(data[start * unit:(start + k) * unit])
+            start += k
+
+    while i < n:
+        run = 1
+        while i + run < n and run < 129 and units[i + run] == units[i]:
+            run += 1
+        if run >= min_run:
+            flush_literals(i)
+            out.append(0x80 | (run - 2))
+            out.extend(units[i])
+            i += run
+            lit_start = i
+        else:
+            i += 1
+    flush_literals(n)
+    return bytes(out)
+
+
+def rle_decode(data, pos, units, unit):
+    out = bytearray()
+    while len(out) < units * unit:
+        c = data[pos]
+        pos += 1
+        if c & 0x80:
+            out.extend(data[pos:pos + unit] * ((c & 0x7F) + 2))
+            pos += unit
+        else:
+            out.extend(data[pos:pos + (c + 1) * unit])
+            pos += (c + 1) * unit
+    if len(out) != units * unit:
+        raise ValueError('RLE plane overruns the tile')
+    return bytes(out), pos
+
+
+# --- LZ4 block format (greedy, one hash probe per position) ---
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5       # the block must end with at least 5 literals
+LZ4_MF_LIMIT = 12           # and the last match must start 12 bytes before the end
+
+
+def _lz4_len(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def _lz4_sequence(out, literals, match_len, offset):
+    lit = len(literals)
+    token = (min(lit, 15) << 4) | (min(match_len - LZ4_MIN_MATCH, 15) if match_len else 0)
+    out.append(token)
+    if lit >= 15:
+        _lz4_len(out, lit - 15)
+    out.extend(literals)
+    if match_len:
+        out.extend(struct.pack('<H', offset))
+        if match_len - LZ4_MIN_MATCH >= 15:
+            _lz4_len(out, match_len - LZ4_MIN_MATCH - 15)
+
+
+def lz4_compress(data):
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    limit = n - LZ4_MF_LIMIT
+    while i < limit:
+        key = data[i:i + 4]
+        ref = table.get(key)
+        table[key] = i
+        if ref is None or i - ref > 0xFFFF:
+            i += 1
+            continue
+        length = 4
+        end = n - LZ4_LAST_LITERALS
+        while i + length < end and data[ref + length] == data[i + length]:
+            length += 1
+        _lz4_sequence(out, data[anchor:i], length, i - ref)
+        i += length
+        anchor = i
+    _lz4_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def lz4_decompress(data, size):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                lit += b
+                if b != 255:
+                    break
+        out.extend(data[pos:pos + lit])
+        pos += lit
+        if pos >= len(data):
+            break
+        offset = data[pos] | data[pos + 1] << 8
+        pos += 2
+        length = token & 15
+        if length == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                length += b
+                if b != 255:
+                    break
+        length += LZ4_MIN_MATCH
+        if offset == 0 or offset > len(out):
+            raise ValueError('LZ4 offset out of range')
+        start = len(out) - offset
+        for k in range(length):
+            out.append(out[start + k])
+    if len(out) != size:
+        raise ValueError('LZ4 block decodes to %d bytes, expected %d' % (len(out), size))
+    return bytes(out)
+
+
+# --- Container ---
+
+def rgb_to_rgb565(rgb):
+    """Packed RGB888 bytes -> big-endian RGB565 bytes (the panel byte order)"""
+    out = bytearray(len(rgb) // 3 * 2)
+    for i in range(len(rgb) // 3):
+        r, g, b = rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]
+        v = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3
+        out[i * 2] = v >> 8
+        out[i * 2 + 1] = v & 0xFF
+    return bytes(out)
+
+
+def rgb565_to_rgb(colors):
+    """Big-endian RGB565 bytes -> packed RGB888 bytes"""
+    out = bytearray(len(colors) // 2 * 3)
+    for i in range(len(colors) // 2):
+        v = colors[i * 2] << 8 | colors[i * 2 + 1]
+        r, g, b = v >> 11, (v >> 5) & 0x3F, v & 0x1F
+        out[i * 3] = r << 3 | r >> 2
+        out[i * 3 + 1] = g << 2 | g >> 4
+        out[i * 3 + 2] = b << 3 | b >> 2
+    return bytes(out)
+
+
+def encode(width, height, colors, alpha=None, compression='lz4', tile_rows=16):
+    """
+    colors: width * height big-endian RGB565 pixels (bytes)
+    alpha: width * height alpha bytes or None
+    """
+    if len(colors) != width * height * 2 or (alpha is not None and len(alpha) != width * height):
+        raise ValueError('plane sizes do not match %dx%d' % (width, height))
+    if not (0 < width < 65536 and 0 < height < 65536 and 0 < tile_rows < 65536):
+        raise ValueError('bad size')
+    comp = COMPRESSIONS[compression]
+    tiles = (height + tile_rows - 1) // tile_rows
+    payloads = []
+    for t in range(tiles):
+        y0 = t * tile_rows
+        rows = min(tile_rows, height - y0)
+        c = colors[y0 * width * 2:(y0 + rows) * width * 2]
+        a = alpha[y0 * width:(y0 + rows) * width] if alpha is not None else None
+        if comp == 0:
+            payloads.append(c + (a or b''))
+        elif comp == 1:
+            payloads.append(rle_encode(c, 2) + (rle_encode(a, 1) if a is not None else b''))
+        else:
+            block = lz4_compress(c)
+            payloads.append(struct.pack('<I', len(block)) + block + (lz4_compress(a) if a is not None else b''))
+    flags = FLAG_ALPHA if alpha is not None else 0
+    out = bytearray(HEADER.pack(MAGIC, VERSION, flags, comp, 0, width, height, tile_rows, 0))
+    end = 0
+    for p in payloads:
+        end += len(p)
+        out.extend(struct.pack('<I', end))
+    for p in payloads:
+        out.extend(p)
+    return bytes(out)
+
+
+def decode(data):
+    """Returns (width, height, colors, alpha or None), the inverse of encode()"""
+    magic, version, flags, comp, _, width, height, tile_rows, _ = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION or comp > 2 or not width or not height or not tile_rows:
+        raise ValueError('not an IMG565 file')
+    tiles = (height + tile_rows - 1) // tile_rows
+    ends = struct.unpack_from('<%dI' % tiles, data, HEADER.size)
+    base = HEADER.size + tiles * 4
+    has_alpha = bool(flags & FLAG_ALPHA)
+    colors = bytearray()
+    alpha = bytearray()
+    prev = 0
+    for t in range(tiles):
+        p = data[base + prev:base + ends[t]]
+        if len(p) != ends[t] - prev:
+            raise ValueError('truncated tile %d' % t)
+        px = width * min(tile_rows, height - t * tile_rows)
+        if comp == 0:
+            if len(p) != px * (3 if has_alpha else 2):
+                raise ValueError('raw tile %d has the wrong size' % t)
+            c, a = p[:px * 2], p[px * 2:]
+        elif comp == 1:
+            c, pos = rle_decode(p, 0, px, 2)
+            a = b''
+            if has_alpha:
+                a, pos = rle_decode(p, pos, px, 1)
+            if pos != len(p):
+                raise ValueError('RLE tile %d has trailing bytes' % t)
+        else:
+            n = struct.unpack_from('<I', p, 0)[0]
+            c = lz4_decompress(p[4:4 + n], px * 2)
+            a = lz4_decompress(p[4 + n:], px) if has_alpha else b''
+        colors.extend(c)
+        alpha.extend(a)
+        prev = ends[t]
+    return width, height, bytes(colors), bytes(alpha) if has_alpha else None
+
+
+# --- Image files (Pillow) ---
+
+def load_image(path, fit=None):
+    """Returns (width, height, colors, alpha or None) for an image file"""
+    from PIL import Image
+    img = Image.open(path)
+    if fit:
+        img.thumbnail(fit)
+    has_alpha = img.mode in ('RGBA', 'LA', 'PA') or (img.mode == 'P' and 'transparency' in img.info)
+    img = img.convert('RGBA' if has_alpha else 'RGB')
+    alpha = None
+    if has_alpha:
+        alpha = img.getchannel('A').tobytes()
+        if alpha == b'\xff' * len(alpha):
+            alpha = None        # fully opaque, no plane needed
+        img = img.convert('RGB')
+    return img.width, img.height, rgb_to_rgb565(img.tobytes()), alpha
+
+
+def save_image(path, width, height, colors, alpha=None):
+    from PIL import Image
+    img = Image.frombytes('RGB', (width, height), rgb565_to_rgb(colors))
+    if alpha is not None:
+        img.putalpha(Image.frombytes('L', (width, height), alpha))
+    img.save(path)
+
+
+# --- Self test ---
+
+def _synthetic(width, height, seed):
+    """Flat areas, gradients, noise and a soft alpha edge: all the paths of both codecs"""
+    rnd = random.Random(seed)
+    colors = bytearray()
+    alpha = bytearray()
+    for y in range(height):
+        for x in range(width):
+            if y < height // 3:
+                v = 0x1234 if (x // 7) % 2 else 0xFFFF                  # runs
+            elif y < 2 * height // 3:
+                v = (x * 2048 // max(width, 1) + y) & 0xFFFF             # gradient
+            else:
+                v = rnd.getrandbits(16)                                  # noise
+            colors += bytes((v >> 8, v & 0xFF))
+            alpha.append(255 if x < width // 2 else min(255, (x * 255) // max(width - 1, 1)))
+    return bytes(colors), bytes(alpha)
+
+
+def selftest(paths):
+    cases = []
+    for (w, h) in ((1, 1), (3, 5), (17, 9), (320, 240), (200, 37)):
+        colors, alpha = _synthetic(w, h, w * h)
+        cases.append(('synthetic %dx%d' % (w, h), w, h, colors, None))
+        cases.append(('synthetic %dx%d + alpha' % (w, h), w, h, colors, alpha))
+    for p in paths:
+        w, h, colors, alpha = load_image(p)
+        cases.append((p, w, h, colors, alpha))
+
+    # Edge cases of the LZ4 codec itself
+    for data in (b'', b'a', b'a' * 13, b'ab' * 5000, bytes(range(256)) * 300, b'\0' * 70000):
+        if lz4_decompress(lz4_compress(data), len(data)) != data:
+            print('FAIL lz4 round trip (%d bytes)' % len(data))
+            return 1
+
+    failures = 0
+    for name, w, h, colors, alpha in cases:
+        sizes = []
+        for comp in COMPRESSIONS:
+            for rows in (1, 16, h):
+                blob = encode(w, h, colors, alpha, comp, rows)
+                got = decode(blob)
+                if got != (w, h, colors, alpha):
+                    print('FAIL %s: %s, %d rows per tile' % (name, comp, rows))
+                    failures += 1
+                if rows == 16:
+                    sizes.append('%s %d' % (comp, len(blob)))
+        print('ok   %-28s %s' % (name, ', '.join(sizes)))
+    print('%d failure(s)' % failures)
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert images to IMG565 for the ESP32-S3-Box3 display')
+    parser.add_argument('input', nargs='?', help='Image file (PNG, JPEG, ...) or, with --decode, an .i565 file')
+    parser.add_argument('output', nargs='?', help='Output file')
+    parser.add_argument('--compress', choices=COMPRESSIONS, default='lz4', help='Tile compression (default: lz4)')
+    parser.add_argument('--tile-rows', type=int, default=16, help='Rows per tile (default: 16)')
+    parser.add_argument('--fit', help='Shrink to fit WxH first, e.g. 320x240')
+    parser.add_argument('--decode', action='store_true', help='Convert an .i565 file back to an image')
+    parser.add_argument('--selftest', nargs='*', metavar='IMAGE', help='Round-trip synthetic images and IMAGEs')
+    args = parser.parse_args()
+
+    if args.selftest is not None:
+        return selftest(args.selftest)
+    if not args.input or not args.output:
+        parser.error('input and output are required')
+
+    if args.decode:
+        with open(args.input, 'rb') as f:
+            w, h, colors, alpha = decode(f.read())
+        save_image(args.output, w, h, colors, alpha)
+        print('%s: %dx%d%s' % (args.output, w, h, ' with alpha' if alpha is not None else ''))
+        return 0
+
+    fit = tuple(int(v) for v in args.fit.lower().split('x')) if args.fit else None
+    w, h, colors, alpha = load_image(args.input, fit)
+    blob = encode(w, h, colors, alpha, args.compress, args.tile_rows)
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+    raw = w * h * (3 if alpha is not None else 2)
+    print('%s: %dx%d%s, %s, %d bytes (%.0f%% of raw)' % (args.output, w, h, ' with alpha' if alpha is not None else '',
+                                                      args.compress, len(blob), 100.0 * len(blob) / raw))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -4,10 +4,14 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "lvgl.h"
 #include <string.h>
+#include <strings.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
 #include "esp_wifi.h"
@@ -17,8 +21,24 @@
 #include "nvs_flash.h"
 #include "esp_heap_caps.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
 #include "cJSON.h"
 #include "windmill_control.h"
+#include "jpeg_stream.h"
+#include "image_buf.h"
+#include "image_cache.h"
+#include "http_pool.h"
+#include "url_cache.h"
+#include "display_settings.h"
+#include "lcd_clock.h"
+#include "display_pipeline.h"
+#include "photo_mode.h"
+#include "img565.h"
+#include "png_stream.h"
+#include "gif_stream.h"
+#include "mjpeg_player.h"
+#include "lvgl_wake.h"
+#include "frame_present.h"
 
 static const char *TAG = "display_image";
 
@@ -26,294 +46,733 @@ static const char *TAG = "display_image";
 #define WIFI_SSID      CONFIG_WIFI_SSID
 #define WIFI_PASSWORD  CONFIG_WIFI_PASSWORD
 
-// 全局 UI 变量
-static lv_obj_t *g_img_obj = NULL;
-static lv_obj_t *g_status_label = NULL;
-
-// LVGL 内存图片描述符
-// 注意：对于JPEG图片，不设置cf，让LVGL自动检测格式
-static lv_img_dsc_t g_mem_img_dsc = {
-    .header.always_zero = 0,
-    .header.w = 0,
-    .header.h = 0,
-    .data_size = 0,
-    .header.cf = LV_IMG_CF_UNKNOWN,  // 让LVGL自动检测格式（JPEG/SJPG等）
-    .data = NULL,
-};
+// 上传接收超时重试次数（httpd_req_recv 单次超时为 recv_wait_timeout）
+#define UPLOAD_RECV_RETRIES 5
+
+// LVGL 任务固定在一个核心上，GIF 的 LZW 解码在另一个核心提前进行
+// /stream 的 MJPEG 帧也在另一个核心解码，写面板的任务和 LVGL 在同一个核心（流期间 LVGL 不刷新）
+#if CONFIG_FREERTOS_UNICORE
+#define LVGL_TASK_CORE      (-1)
+#define DECODE_TASK_CORE    tskNO_AFFINITY
+#define BLIT_TASK_CORE      tskNO_AFFINITY
+#else
+#define LVGL_TASK_CORE      1
+#define DECODE_TASK_CORE    0
+#define BLIT_TASK_CORE      1
+#endif
+
+// /stream 正在播放 MJPEG（同一时间只允许一个流，期间 /upload 被拒绝）
+static atomic_bool s_streaming = false;
+
+// 启动时使用的显示设置（/display_config 修改后重启生效）
+static display_settings_t s_display_settings;
 
 // --- 函数前向声明 ---
-static void display_image_from_buffer(uint8_t *buffer, size_t size);
-static esp_err_t download_image_from_url(const char *url);
+static esp_err_t download_image_from_url(const char *url, uint32_t seq);
 static httpd_handle_t start_webserver(void);
 static esp_err_t upload_post_handler(httpd_req_t *req);
 static esp_err_t upload_url_post_handler(httpd_req_t *req);
+static esp_err_t stream_post_handler(httpd_req_t *req);
+static esp_err_t status_get_handler(httpd_req_t *req);
+static esp_err_t display_config_post_handler(httpd_req_t *req);
+static esp_err_t overlay_post_handler(httpd_req_t *req);
 static void download_image_task(void *pvParameters);
-static void free_old_image_task(void *pvParameters);
+
+// --- 网络下载处理 ---
+// 超过该大小的下载缓冲区放在 PSRAM，避免占用和碎片化内部 RAM
+#define DOWNLOAD_PSRAM_THRESHOLD 50000
+// 没有 Content-Length（chunked）时的初始容量，之后按 2 倍增长
+#define DOWNLOAD_INITIAL_CAPACITY 16384
+// 单次 esp_http_client_read 的最大长度，也是检查取消的粒度
+#define DOWNLOAD_READ_CHUNK 4096
+#define DOWNLOAD_MAX_REDIRECTS 5
+// 等待提交槽位的最长时间，超时时 /upload_url 返回 429
+#define DOWNLOAD_SUBMIT_TIMEOUT_MS 1000
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    uint32_t allocs;    // 本次下载的分配/重新分配次数
+    size_t copied;      // 本次下载拷贝的字节数（realloc 搬移）
+    int64_t ttfb_us;    // 发出请求到收到响应头的时间
+    bool headers_received;
+    bool complete;      // 响应体已完整读取，连接可以继续复用
+    bool not_modified;  // 服务器返回 304，使用 SPIFFS 缓存
+    url_cache_meta_t meta;  // 响应的 ETag/Last-Modified 和内容哈希
+} http_ctx_t;
+
+typedef struct {
+    char *url;          // 由下载任务释放
+    uint32_t seq;       // 提交序号，只有最新的任务会被执行完
+} download_job_t;
+
+// 只有一个槽位：新的 URL 替换还没开始的旧 URL（只有最新的有意义）
+static QueueHandle_t s_download_queue = NULL;
+// 串行化提交：取出旧任务、放入新任务、更新序号之间不能插入别的提交
+static SemaphoreHandle_t s_download_submit = NULL;
+// 最近一次下载的首字节时间和是否复用了连接（/status 统计）
+static int64_t s_last_download_ttfb_us = 0;
+static bool s_last_download_reused = false;
+// 最近一次提交的下载序号，旧序号的任务被取消
+static atomic_uint s_download_seq = 0;
+
+static void http_ctx_reset(http_ctx_t *ctx) {
+    if (ctx->buf) {
+        heap_caps_free(ctx->buf);
+    }
+    memset(ctx, 0, sizeof(*ctx));
+}
 
 /**
- * @brief 核心显示逻辑
- * 注意：不能使用 IRAM_ATTR，因为 LVGL 函数在 Flash 中
+ * @brief 把缓冲区调整为 cap 字节
+ * 容量按需求选择内存类型：大缓冲区直接进 PSRAM，小缓冲区用内部 RAM
  */
-static void display_image_from_buffer(uint8_t *buffer, size_t size) {
-    if (!buffer || size == 0) return;
-
-    // 1. 分配内存 - 使用DMA兼容内存（可缓存），LVGL的JPEG解码器需要可缓存内存
-    // 如果图片太大，尝试使用PSRAM，但需要确保数据可访问
-    uint8_t *copy_buf = NULL;
-    if (size > 50000) {
-        // 大图片使用PSRAM
-        copy_buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    } else {
-        // 小图片使用DMA内存（可缓存）
-        copy_buf = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+static bool http_ctx_resize(http_ctx_t *ctx, size_t cap) {
+    uint8_t *buf = NULL;
+    if (cap > DOWNLOAD_PSRAM_THRESHOLD) {
+        buf = heap_caps_realloc(ctx->buf, cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     }
-    
-    if (!copy_buf) {
-        // 如果DMA内存不足，尝试使用默认内存
-        copy_buf = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+    if (!buf) {
+        buf = heap_caps_realloc(ctx->buf, cap, MALLOC_CAP_DEFAULT);
     }
-    
-    if (!copy_buf) {
-        ESP_LOGE(TAG, "Memory allocation failed for size: %zu!", size);
-        return;
+    if (!buf) {
+        ESP_LOGE(TAG, "Failed to allocate %zu byte download buffer", cap);
+        return false;
     }
-    
-    ESP_LOGI(TAG, "Allocated %zu bytes for image data", size);
-
-    // 2. 拷贝完整数据
-    memcpy(copy_buf, buffer, size);
-
-    // 3. 稳妥逻辑：增加延时，确保系统底层任务(如网络缓冲区清理)完成
-    vTaskDelay(pdMS_TO_TICKS(500));
-
-    // 4. 线程安全地更新 LVGL
-    // 使用 bsp_display_lock 确保线程安全
-    if (bsp_display_lock(pdMS_TO_TICKS(2000))) {
-        // 检查对象是否有效
-        if (g_img_obj == NULL) {
-            ESP_LOGE(TAG, "Image object is NULL!");
-            heap_caps_free(copy_buf);
-            bsp_display_unlock();
-            return;
-        }
-        
-        // 先刷新缓存，确保旧图片数据被清理
-        // 注意：必须在解锁前完成，确保LVGL不再使用旧数据
-        lv_img_cache_invalidate_src(&g_mem_img_dsc);
-        
-        // 先设置新数据，再释放旧数据（确保数据在解码期间有效）
-        void* old_data = NULL;
-        if (g_mem_img_dsc.data) {
-            old_data = (void*)g_mem_img_dsc.data;
-        }
+    ctx->allocs++;
+    if (ctx->buf && ctx->len > 0 && buf != ctx->buf) {
+        ctx->copied += ctx->len;
+    }
+    ctx->buf = buf;
+    ctx->cap = cap;
+    return true;
+}
 
-        // 更新描述符为新数据
-        g_mem_img_dsc.data_size = size;
-        g_mem_img_dsc.data = copy_buf;
-        g_mem_img_dsc.header.cf = LV_IMG_CF_UNKNOWN;  // 让LVGL自动检测格式
-        g_mem_img_dsc.header.w = 0;  // 宽度由解码器自动检测
-        g_mem_img_dsc.header.h = 0;  // 高度由解码器自动检测
-        
-        // 隐藏状态标签
-        if (g_status_label) {
-            lv_obj_add_flag(g_status_label, LV_OBJ_FLAG_HIDDEN);
-        }
+/**
+ * @brief 确保缓冲区至少能容纳 need 字节，容量按 2 倍增长
+ */
+static bool http_ctx_reserve(http_ctx_t *ctx, size_t need) {
+    if (need <= ctx->cap) return true;
 
-        // 设置源并显示（LVGL会自动检测JPEG格式并解码）
-        lv_img_set_src(g_img_obj, &g_mem_img_dsc);
-        lv_obj_clear_flag(g_img_obj, LV_OBJ_FLAG_HIDDEN);
-        
-        // 强制重绘
-        lv_obj_invalidate(g_img_obj);
-        
-        // 解锁后再释放旧数据，给LVGL时间完成解码
-        bsp_display_unlock();
-        
-        ESP_LOGI(TAG, "Image displayed (Size: %zu bytes)", size);
-        
-        // 延迟释放旧数据，确保LVGL解码器不再使用
-        // JPEG解码可能需要一些时间，在解锁后异步释放
-        if (old_data) {
-            // 创建一个任务来延迟释放旧数据
-            xTaskCreate(free_old_image_task, "free_old_img", 2048, old_data, 1, NULL);
-        }
-        
-        ESP_LOGI(TAG, "Image displayed (Size: %zu bytes)", size);
-    } else {
-        heap_caps_free(copy_buf);
-        ESP_LOGE(TAG, "Could not get display lock within timeout!");
+    size_t cap = ctx->cap ? ctx->cap : DOWNLOAD_INITIAL_CAPACITY;
+    while (cap < need) {
+        cap *= 2;
     }
+    return http_ctx_resize(ctx, cap);
 }
 
-// --- 网络下载处理 ---
-typedef struct { uint8_t *buf; size_t len; } http_ctx_t;
-
-static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
+/**
+ * @brief 记录响应的缓存校验头（过长的值不保存，避免截断后永远不匹配）
+ */
+static esp_err_t download_event_handler(esp_http_client_event_t *evt) {
     http_ctx_t *ctx = (http_ctx_t *)evt->user_data;
-    switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            // 使用DMA内存（可缓存），LVGL解码器需要可缓存内存
-            ctx->buf = heap_caps_realloc(ctx->buf, ctx->len + evt->data_len, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
-            if (!ctx->buf && (ctx->len + evt->data_len) > 50000) {
-                // 如果数据太大，尝试使用PSRAM
-                ctx->buf = heap_caps_realloc(ctx->buf, ctx->len + evt->data_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            }
-            if (!ctx->buf) {
-                // 最后尝试默认内存
-                ctx->buf = heap_caps_realloc(ctx->buf, ctx->len + evt->data_len, MALLOC_CAP_DEFAULT);
-            }
-            if (ctx->buf) {
-                memcpy(ctx->buf + ctx->len, evt->data, evt->data_len);
-                ctx->len += evt->data_len;
-            } else {
-                ESP_LOGE(TAG, "Failed to realloc buffer for HTTP data (size: %zu)", ctx->len + evt->data_len);
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            if (ctx->buf && ctx->len > 0) {
-                ESP_LOGI(TAG, "Download finished. Data size: %zu", ctx->len);
-                uint8_t *buf_to_display = ctx->buf;
-                size_t len_to_display = ctx->len;
-                // 先清空 ctx，防止在 display_image_from_buffer 执行期间被其他地方释放
-                ctx->buf = NULL;
-                ctx->len = 0;
-                // 显示图片（会复制数据到新缓冲区）
-                display_image_from_buffer(buf_to_display, len_to_display);
-                // 释放原始缓冲区（display_image_from_buffer 已经复制了数据）
-                free(buf_to_display);
-            } else {
-                ESP_LOGE(TAG, "Download finished but no data received (size: %zu)", ctx->len);
-                if (ctx->buf) {
-                    free(ctx->buf);
-                    ctx->buf = NULL;
-                }
-                ctx->len = 0;
-            }
-            break;
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP_EVENT_ERROR occurred");
-            if (ctx->buf) {
-                free(ctx->buf);
-                ctx->buf = NULL;
-            }
-            ctx->len = 0;
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-            if (ctx->buf) {
-                free(ctx->buf);
-                ctx->buf = NULL;
-            }
-            ctx->len = 0;
+    if (evt->event_id != HTTP_EVENT_ON_HEADER) return ESP_OK;
+
+    char *dst = NULL;
+    size_t dst_len = 0;
+    if (strcasecmp(evt->header_key, "ETag") == 0) {
+        dst = ctx->meta.etag;
+        dst_len = sizeof(ctx->meta.etag);
+    } else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+        dst = ctx->meta.last_modified;
+        dst_len = sizeof(ctx->meta.last_modified);
+    }
+    if (dst && strlen(evt->header_value) < dst_len) {
+        strcpy(dst, evt->header_value);
+    }
+    return ESP_OK;
+}
+
+static bool http_is_redirect(int status_code) {
+    return status_code == 301 || status_code == 302 || status_code == 303 ||
+           status_code == 307 || status_code == 308;
+}
+
+static bool download_superseded(uint32_t seq) {
+    // 任务可能先于序号更新被取出，只有更旧的序号才算被取代
+    return (int32_t)(atomic_load(&s_download_seq) - seq) > 0;
+}
+
+/**
+ * @brief 读取响应体到 ctx，数据直接读入下载缓冲区
+ * 每次读取前检查是否有更新的下载请求，有则中止传输
+ */
+static esp_err_t download_read_body(esp_http_client_handle_t client, http_ctx_t *ctx, uint32_t seq) {
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = esp_http_client_open(client, 0);
+    int64_t content_len = -1;
+    int status_code = 0;
+    for (int redirects = 0; err == ESP_OK; redirects++) {
+        content_len = esp_http_client_fetch_headers(client);
+        if (content_len < 0) {
+            err = ESP_FAIL;
             break;
-        default: break;
+        }
+        if (!ctx->headers_received) {
+            ctx->ttfb_us = esp_timer_get_time() - start;
+            ctx->headers_received = true;
+        }
+        status_code = esp_http_client_get_status_code(client);
+        if (!http_is_redirect(status_code) || redirects == DOWNLOAD_MAX_REDIRECTS) break;
+        // 跟随重定向（同一主机时复用连接）
+        esp_http_client_flush_response(client, NULL);
+        esp_http_client_set_redirection(client);
+        err = esp_http_client_open(client, 0);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (status_code == 304) {
+        ctx->not_modified = true;
+        ctx->complete = esp_http_client_is_complete_data_received(client);
+        return ESP_OK;
+    }
+    if (status_code != 200) {
+        ESP_LOGE(TAG, "HTTP request returned status code: %d", status_code);
+        return ESP_FAIL;
+    }
+
+    // 服务器给出 Content-Length 时一次分配到位
+    if (content_len > 0 && !http_ctx_resize(ctx, (size_t)content_len)) {
+        return ESP_ERR_NO_MEM;
     }
+
+    while (!esp_http_client_is_complete_data_received(client)) {
+        if (download_superseded(seq)) {
+            ESP_LOGW(TAG, "Download superseded by a newer URL, cancelling after %zu bytes", ctx->len);
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (ctx->len == ctx->cap && !http_ctx_reserve(ctx, ctx->len + 1)) {
+            return ESP_ERR_NO_MEM;
+        }
+        size_t want = ctx->cap - ctx->len;
+        if (want > DOWNLOAD_READ_CHUNK) {
+            want = DOWNLOAD_READ_CHUNK;
+        }
+        int n = esp_http_client_read(client, (char *)ctx->buf + ctx->len, want);
+        if (n < 0) {
+            ESP_LOGE(TAG, "HTTP read failed after %zu bytes", ctx->len);
+            return ESP_FAIL;
+        }
+        if (n == 0) break;  // 连接关闭（无 Content-Length）
+        ctx->len += n;
+    }
+    ctx->complete = esp_http_client_is_complete_data_received(client);
     return ESP_OK;
 }
 
-static esp_err_t download_image_from_url(const char *url) {
+/**
+ * @brief 显示 SPIFFS 缓存中的 URL 图片（服务器返回 304）
+ */
+static esp_err_t display_url_cached(const char *url, const url_cache_meta_t *meta) {
+    display_pipeline_lock();
+    // 内存缓存里还有这张图时连 flash 都不用读
+    image_buf_t *buf = image_cache_get(meta->hash);
+    if (!buf) {
+        image_cache_reserve();
+        buf = url_cache_load(url);
+        if (buf) {
+            image_cache_put(meta->hash, buf);
+        }
+    }
+    bool shown = buf && display_pipeline_show(buf);
+    if (shown) {
+        ESP_LOGI(TAG, "Image not modified, displayed cached %ux%u image", buf->width, buf->height);
+    }
+    image_buf_unref(buf);
+    display_pipeline_unlock();
+    return shown ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t download_image_from_url(const char *url, uint32_t seq) {
     ESP_LOGI(TAG, "Starting download from URL: %s", url);
-    http_ctx_t ctx = { .buf = NULL, .len = 0 };
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .user_data = &ctx,
-        .timeout_ms = 30000,  // 增加到30秒
-        .skip_cert_common_name_check = true
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    http_ctx_t ctx = {0};
+    bool reused = false;
+    esp_http_client_handle_t client = http_pool_acquire(url, download_event_handler, &ctx, &reused);
     if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
         return ESP_FAIL;
     }
-    
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
-    
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
-        // 如果请求失败，确保清理内存
-        if (ctx.buf) {
-            free(ctx.buf);
-            ctx.buf = NULL;
+
+    // 之前下载过的 URL 发条件请求，未修改时服务器只回 304
+    url_cache_meta_t cached;
+    bool have_cached = url_cache_lookup(url, &cached);
+    if (have_cached) {
+        if (cached.etag[0]) {
+            esp_http_client_set_header(client, "If-None-Match", cached.etag);
         }
-    } else if (status_code != 200) {
-        ESP_LOGE(TAG, "HTTP request returned status code: %d", status_code);
-        err = ESP_FAIL;
-        // 如果状态码不是200，确保清理内存
-        if (ctx.buf) {
-            free(ctx.buf);
-            ctx.buf = NULL;
+        if (cached.last_modified[0]) {
+            esp_http_client_set_header(client, "If-Modified-Since", cached.last_modified);
         }
+    }
+
+    esp_err_t err = download_read_body(client, &ctx, seq);
+    if (err != ESP_OK && reused && !ctx.headers_received && !download_superseded(seq)) {
+        // 服务器可能已关闭空闲连接，重新连接一次（TLS 通过会话票据恢复）
+        ESP_LOGI(TAG, "Pooled connection went stale, reconnecting");
+        esp_http_client_close(client);
+        reused = false;
+        http_ctx_reset(&ctx);
+        err = download_read_body(client, &ctx, seq);
+    }
+    if (have_cached) {
+        // 客户端留在连接池中，下一个 URL 不能带上这些条件头
+        esp_http_client_delete_header(client, "If-None-Match");
+        esp_http_client_delete_header(client, "If-Modified-Since");
+    }
+    if (err == ESP_OK || ctx.headers_received) {
+        // 未读完的响应会关闭连接，客户端和 TLS 会话仍保留在连接池中
+        http_pool_release(client, ctx.complete);
     } else {
-        ESP_LOGI(TAG, "HTTP request successful, status: %d", status_code);
-        // 成功时，内存应该在 HTTP_EVENT_ON_FINISH 中已释放
-        // 但为了安全，再次检查
-        if (ctx.buf) {
-            ESP_LOGW(TAG, "Buffer not freed in HTTP_EVENT_ON_FINISH, freeing now");
-            free(ctx.buf);
-            ctx.buf = NULL;
+        http_pool_discard(client);
+    }
+    s_last_download_ttfb_us = ctx.ttfb_us;
+    s_last_download_reused = reused;
+    ESP_LOGI(TAG, "Time to first byte: %" PRId64 " ms (%s connection)", ctx.ttfb_us / 1000, reused ? "warm" : "cold");
+
+    if (err == ESP_OK && download_superseded(seq)) {
+        // 已有更新的图片在排队，不再解码这一张
+        ESP_LOGW(TAG, "Download superseded by a newer URL, skipping decode");
+        err = ESP_ERR_INVALID_STATE;
+    }
+    if (err == ESP_OK && ctx.not_modified) {
+        if (!have_cached || display_url_cached(url, &cached) != ESP_OK) {
+            ESP_LOGE(TAG, "Got 304 but the cached image is gone");
+            err = ESP_FAIL;
         }
+        http_ctx_reset(&ctx);
+        return err;
     }
-    
-    esp_http_client_cleanup(client);
+    if (err == ESP_OK && ctx.len == 0) {
+        ESP_LOGE(TAG, "Download finished but no data received");
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Download finished. Data size: %zu (%" PRIu32 " allocs, %zu bytes copied, capacity %zu)",
+                 ctx.len, ctx.allocs, ctx.copied, ctx.cap);
+        image_buf_t *buf = display_pipeline_from_buffer(ctx.buf, ctx.len, ctx.meta.hash);
+        // GIF 动画的画布一直在变，SPIFFS 里只能存下某一帧，不缓存
+        const bool animated = gif_stream_is(ctx.buf, ctx.len);
+        // 下载缓冲区先释放，写 flash 期间只保留解码后的图片
+        http_ctx_t done = ctx;
+        done.buf = NULL;
+        http_ctx_reset(&ctx);
+        if (buf == NULL) {
+            err = ESP_FAIL;
+        } else if (animated || (!done.meta.etag[0] && !done.meta.last_modified[0])) {
+            // 没有校验头就无法发条件请求，不缓存
+            url_cache_remove(url);
+        } else if (!have_cached || memcmp(&cached, &done.meta, sizeof(cached)) != 0) {
+            url_cache_store(url, &done.meta, buf);
+        }
+        image_buf_unref(buf);
+    }
+    http_ctx_reset(&ctx);
     return err;
 }
 
 // --- HTTP 接口 ---
+// 先接收请求体开头这么多字节判断格式（multipart 前导部分加文件头）
+#define UPLOAD_PEEK_SIZE 512
+// 需要完整接收的上传（GIF、交给 LVGL 解码的格式）的上限
+#define UPLOAD_BUFFER_MAX ((size_t)CONFIG_DISPLAY_UPLOAD_BUFFER_MAX_KB * 1024)
+
+typedef struct {
+    httpd_req_t *req;
+    size_t remaining;
+    mbedtls_sha256_context hash;
+    uint8_t peek[UPLOAD_PEEK_SIZE];  // 已接收、还没交给解码器的开头部分
+    size_t peek_pos;
+    size_t peek_len;
+} upload_stream_t;
+
+// 从 HTTP 请求体按块接收数据
+static int upload_stream_recv(upload_stream_t *stream, uint8_t *buf, size_t len) {
+    if (stream->remaining == 0) return 0;
+    if (len > stream->remaining) len = stream->remaining;
+
+    for (int retry = 0; retry < UPLOAD_RECV_RETRIES; retry++) {
+        int ret = httpd_req_recv(stream->req, (char *)buf, len);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "Upload receive failed: %d", ret);
+            return -1;
+        }
+        stream->remaining -= ret;
+        image_cache_key_update(&stream->hash, buf, ret);
+        return ret;
+    }
+    ESP_LOGE(TAG, "Upload receive timed out");
+    return -1;
+}
+
+// 供流式解码器使用：先返回 peek 中剩下的数据，再继续接收
+static int upload_stream_read(void *ctx, uint8_t *buf, size_t len) {
+    upload_stream_t *stream = (upload_stream_t *)ctx;
+    if (stream->peek_pos < stream->peek_len) {
+        size_t n = stream->peek_len - stream->peek_pos;
+        if (n > len) n = len;
+        memcpy(buf, stream->peek + stream->peek_pos, n);
+        stream->peek_pos += n;
+        return n;
+    }
+    return upload_stream_recv(stream, buf, len);
+}
+
+// UPLOAD_LVGL：流式解码器不支持的格式（BMP、隔行扫描的 PNG），完整接收后交给 LVGL 的解码器
+typedef enum { UPLOAD_JPEG, UPLOAD_IMG565, UPLOAD_PNG, UPLOAD_GIF, UPLOAD_LVGL } upload_format_t;
+
+// BMP 文件头："BM" 加 DIB 头的长度（BITMAPCOREHEADER 到 BITMAPV5HEADER）
+static bool upload_is_bmp(const uint8_t *p, size_t n) {
+    if (n < 18 || p[0] != 'B' || p[1] != 'M') return false;
+    const uint32_t dib = p[14] | p[15] << 8 | p[16] << 16 | (uint32_t)p[17] << 24;
+    return dib == 12 || dib == 40 || dib == 52 || dib == 56 || dib == 108 || dib == 124;
+}
+
+// IHDR 的隔行扫描方式在文件第 28 字节
+static bool upload_is_interlaced_png(const uint8_t *p, size_t n) {
+    return n > 28 && p[28] != 0;
+}
+
+/**
+ * @brief 接收请求体开头，查找 IMG565、PNG、GIF 或 BMP 文件头，找到时 peek_pos 指向文件头
+ * 文件头只认请求体开头或 multipart 头部之后（空行之后），避免误认 JPEG 数据里的字节；
+ * 其它数据都交给 JPEG 解码器（它自己跳过 SOI 之前的内容）
+ */
+static upload_format_t upload_detect(upload_stream_t *stream) {
+    while (stream->peek_len < sizeof(stream->peek)) {
+        int n = upload_stream_recv(stream, stream->peek + stream->peek_len, sizeof(stream->peek) - stream->peek_len);
+        if (n <= 0) break;
+        stream->peek_len += n;
+    }
+    img565_header_t hdr;
+    for (size_t i = 0; i + IMG565_HEADER_SIZE <= stream->peek_len; i++) {
+        if (i != 0 && (i < 4 || memcmp(stream->peek + i - 4, "\r\n\r\n", 4) != 0)) continue;
+        const uint8_t *p = stream->peek + i;
+        const size_t n = stream->peek_len - i;
+        if (img565_parse_header(p, n, &hdr) == ESP_OK) {
+            stream->peek_pos = i;
+            return UPLOAD_IMG565;
+        }
+        if (png_stream_is(p, n)) {
+            stream->peek_pos = i;
+            return upload_is_interlaced_png(p, n) ? UPLOAD_LVGL : UPLOAD_PNG;
+        }
+        if (gif_stream_is(p, n)) {
+            stream->peek_pos = i;
+            return UPLOAD_GIF;
+        }
+        if (upload_is_bmp(p, n)) {
+            stream->peek_pos = i;
+            return UPLOAD_LVGL;
+        }
+    }
+    return UPLOAD_JPEG;
+}
+
+/**
+ * @brief GIF 和交给 LVGL 解码的格式：完整接收到 PSRAM 后由 display_pipeline_from_buffer 显示
+ * GIF 循环播放时要反复读取文件，LVGL 的解码器需要整个文件；超过上限的在分配前返回 413
+ */
+static esp_err_t upload_buffered(httpd_req_t *req, upload_stream_t *stream, upload_format_t format) {
+    const size_t size = stream->peek_len - stream->peek_pos + stream->remaining;
+    uint8_t *data = NULL;
+    if (size <= UPLOAD_BUFFER_MAX) {
+        data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!data) {
+            data = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+        }
+    }
+    size_t got = 0;
+    int n = 1;
+    while (data && got < size && (n = upload_stream_read(stream, data + got, size - got)) > 0) {
+        got += n;
+    }
+    // display_pipeline_from_buffer 按文件内容重新计算缓存键，这里只结束流式哈希
+    uint8_t key[IMAGE_CACHE_KEY_LEN];
+    image_cache_key_finish(&stream->hash, key);
+
+    if (size > UPLOAD_BUFFER_MAX) {
+        ESP_LOGE(TAG, "Upload too large to buffer: %zu bytes (max %zu)", size, UPLOAD_BUFFER_MAX);
+        httpd_resp_set_status(req, "413 Payload Too Large");
+        httpd_resp_sendstr(req, "Error: Image too large");
+        return ESP_FAIL;
+    }
+    if (!data || n < 0) {
+        heap_caps_free(data);
+        ESP_LOGE(TAG, "Failed to receive %zu byte upload", size);
+        httpd_resp_sendstr(req, data ? "Error: Upload incomplete" : "Error: Memory allocation failed");
+        return ESP_FAIL;
+    }
+
+    // display_pipeline_from_buffer 自己获取锁
+    image_buf_t *buf = display_pipeline_from_buffer(data, got, key);
+    heap_caps_free(data);
+    if (!buf) {
+        httpd_resp_sendstr(req, format == UPLOAD_GIF ? "Error: Invalid GIF" : "Error: Unsupported image");
+        return ESP_FAIL;
+    }
+    image_buf_unref(buf);
+    httpd_resp_sendstr(req, "OK");
+    return ESP_OK;
+}
+
 static esp_err_t upload_post_handler(httpd_req_t *req) {
-    size_t len = req->content_len;
-    uint8_t *buf = heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (!buf) return ESP_FAIL;
-    if (httpd_req_recv(req, (char *)buf, len) > 0) {
-        display_image_from_buffer(buf, len);
+    if (req->content_len == 0) {
+        httpd_resp_sendstr(req, "Error: No data received");
+        return ESP_FAIL;
+    }
+    if (atomic_load(&s_streaming)) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "Error: Stream active");
+        return ESP_FAIL;
+    }
+
+    // 数据边接收边解码，直接写入 RGB565 帧缓冲区
+    // 整个过程只分配一块图片大小的内存
+    upload_stream_t stream = { .req = req, .remaining = req->content_len };
+    image_cache_key_start(&stream.hash);
+    uint8_t *pixels = NULL;
+    size_t size = 0;
+    uint16_t width = 0, height = 0;
+    lv_img_cf_t cf = LV_IMG_CF_TRUE_COLOR;
+    esp_err_t err;
+
+    // 先接收开头判断格式，之后才获取显示流水线的锁、腾出缓存位置：
+    // 慢速的客户端在第一个字节到达之前不会占住流水线
+    upload_format_t format = upload_detect(&stream);
+    if (format == UPLOAD_GIF || format == UPLOAD_LVGL) {
+        return upload_buffered(req, &stream, format);
     }
-    free(buf);
+    display_pipeline_lock();
+    image_cache_reserve();
+    if (format == UPLOAD_IMG565) {
+        // IMG565：未压缩的分片直接接收到帧缓冲区，不需要解码
+        img565_cfg_t cfg = {
+            .read = upload_stream_read,
+            .read_ctx = &stream,
+            .swap_bytes = LV_COLOR_16_SWAP,
+        };
+        img565_image_t img;
+        err = img565_decode(&cfg, &img);
+        if (err == ESP_OK) {
+            pixels = img.pixels;
+            size = img.size;
+            width = img.width;
+            height = img.height;
+            cf = img.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR;
+        }
+    } else if (format == UPLOAD_PNG) {
+        // PNG：每收到一行的数据就解压、去滤波并写入帧缓冲区（隔行扫描的 PNG 交给 LVGL）
+        png_stream_cfg_t cfg = {
+            .read = upload_stream_read,
+            .read_ctx = &stream,
+            .swap_bytes = LV_COLOR_16_SWAP,
+        };
+        png_stream_image_t img;
+        err = png_stream_decode(&cfg, &img);
+        if (err == ESP_OK) {
+            pixels = img.pixels;
+            size = img.size;
+            width = img.width;
+            height = img.height;
+            cf = img.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR;
+        }
+    } else {
+        // JPEG：MCU 解码后直接写入帧缓冲区
+        jpeg_stream_cfg_t cfg = {
+            .read = upload_stream_read,
+            .read_ctx = &stream,
+            .swap_bytes = LV_COLOR_16_SWAP,
+            .max_width = BSP_LCD_H_RES,   // 大图（例如 1920x1080 照片）缩小到屏幕大小
+            .max_height = BSP_LCD_V_RES,
+        };
+        jpeg_stream_image_t img;
+        err = jpeg_stream_decode(&cfg, &img);
+        if (err == ESP_OK) {
+            pixels = img.pixels;
+            size = img.size;
+            width = img.width;
+            height = img.height;
+        }
+    }
+
+    // 丢弃解码器未读取的剩余数据（例如 multipart 结尾）
+    uint8_t drain[64];
+    while (stream.remaining > 0 && upload_stream_recv(&stream, drain, sizeof(drain)) > 0) {
+    }
+    uint8_t key[IMAGE_CACHE_KEY_LEN];
+    image_cache_key_finish(&stream.hash, key);
+
+    if (err != ESP_OK) {
+        display_pipeline_unlock();
+        ESP_LOGE(TAG, "Failed to decode uploaded image (%zu bytes): %s", req->content_len, esp_err_to_name(err));
+        httpd_resp_sendstr(req, err == ESP_ERR_NO_MEM      ? "Error: Memory allocation failed"
+                                : format == UPLOAD_IMG565 ? "Error: Invalid IMG565 image"
+                                : format == UPLOAD_PNG    ? "Error: Invalid PNG"
+                                                          : "Error: Invalid JPEG");
+        return ESP_FAIL;
+    }
+
+    // 同样的内容已在缓存中时复用旧的帧缓冲区
+    image_buf_t *buf = display_pipeline_cache_decoded(key, pixels, size, cf, width, height);
+    if (buf) {
+        if (display_pipeline_show(buf)) {
+            ESP_LOGI(TAG, "Uploaded image displayed (%ux%u)", buf->width, buf->height);
+        }
+        image_buf_unref(buf);
+    }
+    display_pipeline_unlock();
+
     httpd_resp_sendstr(req, "OK");
     return ESP_OK;
 }
 
-static void free_old_image_task(void *pvParameters) {
-    void* old_data = pvParameters;
-    if (old_data) {
-        vTaskDelay(pdMS_TO_TICKS(2000));  // 等待2秒确保解码完成
-        heap_caps_free(old_data);
-        ESP_LOGI(TAG, "Old image data freed");
+typedef struct {
+    httpd_req_t *req;
+    size_t remaining;
+} stream_src_t;
+
+// mjpeg_stream 的读取回调：请求体读完即流结束
+static int stream_read(void *ctx, uint8_t *buf, size_t len) {
+    stream_src_t *src = (stream_src_t *)ctx;
+    if (src->remaining == 0) return 0;
+    if (len > src->remaining) len = src->remaining;
+
+    for (int retry = 0; retry < UPLOAD_RECV_RETRIES; retry++) {
+        int ret = httpd_req_recv(src->req, (char *)buf, len);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret == 0) {
+            // 客户端发完结束边界后关闭发送方向（Content-Length 只是上限）
+            src->remaining = 0;
+            return 0;
+        }
+        if (ret < 0) {
+            ESP_LOGE(TAG, "Stream receive failed: %d", ret);
+            return -1;
+        }
+        src->remaining -= ret;
+        return ret;
+    }
+    ESP_LOGE(TAG, "Stream receive timed out");
+    return -1;
+}
+
+// 流结束时在写面板的任务中调用（照片模式仍持有显示锁）：最后一帧交给 LVGL 显示
+static void stream_done(void *ctx, image_buf_t *last) {
+    if (last) {
+        display_pipeline_show(last);
+    } else {
+        photo_mode_end(false);
     }
-    vTaskDelete(NULL);
 }
 
-static void download_image_task(void *pvParameters) {
-    char *url = (char *)pvParameters;
-    if (url == NULL) {
-        ESP_LOGE(TAG, "Invalid URL parameter in download task");
-        vTaskDelete(NULL);
-        return;
+/**
+ * @brief 接收 MJPEG 流的任务，httpd 任务在流期间继续处理其它请求（例如 /status）
+ * 持有显示流水线的锁直到流结束，/upload_url 的下载等流结束后再显示
+ */
+static void stream_task(void *arg) {
+    httpd_req_t *req = (httpd_req_t *)arg;
+    stream_src_t src = { .req = req, .remaining = req->content_len };
+
+    display_pipeline_lock();
+    // 停止正在播放的动画，流的帧不会被它覆盖
+    display_pipeline_stop_animation();
+    mjpeg_player_cfg_t cfg = {
+        .read = stream_read,
+        .read_ctx = &src,
+        .decode_core = DECODE_TASK_CORE,
+        .blit_core = BLIT_TASK_CORE,
+        .on_done = stream_done,
+    };
+    esp_err_t err = mjpeg_player_run(&cfg);
+    display_pipeline_unlock();
+
+    // 丢弃结束边界之后的数据（例如客户端没有关闭连接时的剩余部分）
+    uint8_t drain[64];
+    while (src.remaining > 0 && stream_read(&src, drain, sizeof(drain)) > 0) {
     }
-    
-    ESP_LOGI(TAG, "Download task started for URL: %s", url);
-    
-    // 给系统一点时间稳定
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    esp_err_t err = download_image_from_url(url);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to download image from URL: %s (error: %s)", 
-                 url, esp_err_to_name(err));
+
+    mjpeg_player_stats_t stats;
+    mjpeg_player_get_stats(&stats);
+    char msg[96];
+    if (err == ESP_OK) {
+        snprintf(msg, sizeof(msg), "OK: %" PRIu32 " frames shown, %" PRIu32 " dropped", stats.shown, stats.dropped);
     } else {
-        ESP_LOGI(TAG, "Successfully downloaded and displayed image from URL: %s", url);
+        snprintf(msg, sizeof(msg), "Error: %s after %" PRIu32 " frames",
+                 err == ESP_ERR_NO_MEM ? "Memory allocation failed" : err == ESP_FAIL ? "Receive failed"
+                                                                                      : "Not an MJPEG stream",
+                 stats.shown);
     }
-    
-    // 释放URL字符串内存
-    free(url);
-    
-    // 删除任务
+    httpd_resp_sendstr(req, msg);
+    httpd_req_async_handler_complete(req);
+    atomic_store(&s_streaming, false);
     vTaskDelete(NULL);
 }
 
+/**
+ * @brief POST /stream：播放 MJPEG 流（multipart/x-mixed-replace 或长度前缀）
+ * 请求体一直接收到结束边界或客户端关闭发送方向，由单独的任务处理，不占用 httpd 任务
+ */
+static esp_err_t stream_post_handler(httpd_req_t *req) {
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&s_streaming, &expected, true)) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "Error: Stream active");
+        return ESP_FAIL;
+    }
+    httpd_req_t *async_req;
+    if (httpd_req_async_handler_begin(req, &async_req) != ESP_OK) {
+        atomic_store(&s_streaming, false);
+        httpd_resp_sendstr(req, "Error: Memory allocation failed");
+        return ESP_FAIL;
+    }
+    if (xTaskCreate(stream_task, "mjpeg_recv", 4096, async_req, 5, NULL) != pdPASS) {
+        httpd_req_async_handler_complete(async_req);
+        atomic_store(&s_streaming, false);
+        httpd_resp_sendstr(req, "Error: Memory allocation failed");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 常驻下载任务，按顺序处理 /upload_url 队列
+ * 同一时间只有一个下载和一个下载缓冲区；被新 URL 取代的任务直接丢弃
+ */
+static void download_image_task(void *pvParameters) {
+    download_job_t job;
+    while (true) {
+        if (xQueueReceive(s_download_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        if (download_superseded(job.seq)) {
+            ESP_LOGI(TAG, "Skipping superseded URL: %s", job.url);
+        } else {
+            esp_err_t err = download_image_from_url(job.url, job.seq);
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "Successfully downloaded and displayed image from URL: %s", job.url);
+            } else if (err != ESP_ERR_INVALID_STATE) {
+                ESP_LOGE(TAG, "Failed to download image from URL: %s (error: %s)",
+                         job.url, esp_err_to_name(err));
+            }
+        }
+
+        // 释放URL字符串内存
+        free(job.url);
+    }
+}
+
 static esp_err_t upload_url_post_handler(httpd_req_t *req) {
     char buf[512];
-    int ret = httpd_req_recv(req, buf, req->content_len);
+    // 留一个字节给结尾的 '\0'，超长的请求体在接收前拒绝
+    if (req->content_len >= sizeof(buf)) {
+        ESP_LOGE(TAG, "URL request too large: %u bytes", (unsigned)req->content_len);
+        httpd_resp_set_status(req, "413 Payload Too Large");
+        httpd_resp_sendstr(req, "Error: Request too large");
+        return ESP_FAIL;
+    }
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
     if (ret > 0) {
         buf[ret] = '\0';
         ESP_LOGI(TAG, "Received URL request: %s", buf);
@@ -328,36 +787,36 @@ static esp_err_t upload_url_post_handler(httpd_req_t *req) {
             const char *url_str = url_item->valuestring;
             ESP_LOGI(TAG, "Received image URL: %s", url_str);
             
-            // 复制URL字符串到堆内存（任务会释放）
-            char *url_copy = malloc(strlen(url_str) + 1);
+            // 复制URL字符串到堆内存（下载任务会释放）
+            char *url_copy = strdup(url_str);
             if (url_copy == NULL) {
                 ESP_LOGE(TAG, "Failed to allocate memory for URL");
                 httpd_resp_sendstr(req, "Error: Memory allocation failed");
                 cJSON_Delete(json);
                 return ESP_FAIL;
             }
-            strcpy(url_copy, url_str);
-            
-            // 创建任务异步下载图片（不阻塞HTTP响应）
-            // 增加栈大小以处理大图片下载
-            BaseType_t task_result = xTaskCreate(
-                download_image_task,
-                "download_img",
-                16384,  // 16KB stack (增加以处理大图片)
-                url_copy,
-                5,      // 优先级
-                NULL
-            );
-            
-            if (task_result != pdPASS) {
-                ESP_LOGE(TAG, "Failed to create download task");
+
+            // 交给常驻下载任务（不阻塞HTTP响应），新序号让正在进行的旧下载自行取消
+            if (xSemaphoreTake(s_download_submit, pdMS_TO_TICKS(DOWNLOAD_SUBMIT_TIMEOUT_MS)) != pdTRUE) {
+                ESP_LOGW(TAG, "Download slot busy, rejecting URL");
                 free(url_copy);
-                httpd_resp_sendstr(req, "Error: Failed to create download task");
+                httpd_resp_set_status(req, "429 Too Many Requests");
+                httpd_resp_sendstr(req, "Error: Download slot busy");
                 cJSON_Delete(json);
                 return ESP_FAIL;
             }
-            
-            ESP_LOGI(TAG, "Download task created, returning HTTP response");
+            // 还没开始的旧任务已经被取代，直接替换掉并释放它的 URL
+            download_job_t job = { .url = url_copy, .seq = atomic_load(&s_download_seq) + 1 };
+            download_job_t displaced;
+            if (xQueueReceive(s_download_queue, &displaced, 0) == pdTRUE) {
+                ESP_LOGI(TAG, "Download job %" PRIu32 " replaced before it started", displaced.seq);
+                free(displaced.url);
+            }
+            xQueueOverwrite(s_download_queue, &job);
+            atomic_store(&s_download_seq, job.seq);
+            xSemaphoreGive(s_download_submit);
+
+            ESP_LOGI(TAG, "Download job %" PRIu32 " queued, returning HTTP response", job.seq);
         } else {
             ESP_LOGE(TAG, "URL not found in JSON or not a string");
             httpd_resp_sendstr(req, "Error: URL not found");
@@ -376,14 +835,172 @@ static esp_err_t upload_url_post_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+static esp_err_t status_get_handler(httpd_req_t *req) {
+    cJSON *json = cJSON_CreateObject();
+    if (json == NULL) {
+        httpd_resp_sendstr(req, "Error: Memory allocation failed");
+        return ESP_FAIL;
+    }
+
+    char ip_str[16] = "0.0.0.0";
+    esp_netif_ip_info_t ip_info;
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
+        snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&ip_info.ip));
+    }
+
+    cJSON_AddStringToObject(json, "ip", ip_str);
+    cJSON_AddNumberToObject(json, "uptime_ms", (double)(esp_timer_get_time() / 1000));
+    cJSON_AddNumberToObject(json, "free_heap", heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    cJSON_AddNumberToObject(json, "min_free_heap", heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+    cJSON_AddNumberToObject(json, "free_internal", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    cJSON_AddNumberToObject(json, "free_psram", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    // 存活的图片缓冲区数量：空闲时应不超过 缓存条数 + 屏幕上的一张
+    cJSON_AddNumberToObject(json, "image_bufs", image_buf_live_count());
+    cJSON_AddNumberToObject(json, "images_shown", display_pipeline_images_shown());
+    // 发送到面板的像素（LVGL 刷新和照片模式），速率为距上一次 /status 的平均值
+    uint32_t px_per_s = 0;
+    cJSON_AddNumberToObject(json, "panel_pixels", (double)display_pipeline_pixels_pushed(&px_per_s));
+    cJSON_AddNumberToObject(json, "panel_px_per_s", px_per_s);
+    cJSON_AddNumberToObject(json, "draw_buf_lines", s_display_settings.draw_buf_lines);
+    cJSON_AddNumberToObject(json, "draw_buf_count", s_display_settings.draw_buf_count);
+    cJSON_AddNumberToObject(json, "lcd_pclk_hz", lcd_clock_get_hz());
+    // LVGL 任务：唤醒次数、在 lv_timer_handler() 中的总时间、失效到开始刷新的延迟
+    lvgl_wake_stats_t lvgl;
+    lvgl_wake_get_stats(&lvgl);
+    cJSON_AddNumberToObject(json, "lvgl_wakeups", lvgl.wakeups);
+    cJSON_AddNumberToObject(json, "lvgl_busy_ms", (double)(lvgl.busy_us / 1000));
+    cJSON_AddNumberToObject(json, "lvgl_wake_latency_us", lvgl.latency_us);
+    cJSON_AddNumberToObject(json, "lvgl_wake_max_latency_us", lvgl.max_latency_us);
+    // 整帧呈现（DISPLAY_PRESENT_FULL_FRAME）：上一帧的发送时间和超出预算的帧数
+    frame_present_stats_t present;
+    frame_present_get_stats(&present);
+    cJSON_AddNumberToObject(json, "present_frames", present.frames);
+    cJSON_AddNumberToObject(json, "present_late", present.late);
+    cJSON_AddBoolToObject(json, "present_te", present.te);
+    cJSON_AddNumberToObject(json, "present_flush_ms", present.flush_us / 1000.0);
+    cJSON_AddNumberToObject(json, "present_max_flush_ms", present.max_flush_us / 1000.0);
+    cJSON_AddNumberToObject(json, "present_budget_ms", present.budget_us / 1000.0);
+    cJSON_AddNumberToObject(json, "download_ttfb_ms", (double)(s_last_download_ttfb_us / 1000));
+    cJSON_AddBoolToObject(json, "download_reused", s_last_download_reused);
+    // /stream：正在播放或上一个流的统计，帧率和时间为最近一秒的平均值
+    mjpeg_player_stats_t stream;
+    mjpeg_player_get_stats(&stream);
+    cJSON_AddBoolToObject(json, "stream_active", stream.active);
+    cJSON_AddNumberToObject(json, "stream_fps", stream.fps_x10 / 10.0);
+    cJSON_AddNumberToObject(json, "stream_decode_ms", stream.decode_us / 1000.0);
+    cJSON_AddNumberToObject(json, "stream_blit_ms", stream.blit_us / 1000.0);
+    cJSON_AddNumberToObject(json, "stream_frames", stream.shown);
+    cJSON_AddNumberToObject(json, "stream_dropped", stream.dropped);
+
+    char *body = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (body == NULL) {
+        httpd_resp_sendstr(req, "Error: Memory allocation failed");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, body);
+    free(body);
+    return ESP_OK;
+}
+
+// 修改显示设置（保存到 NVS，重启后生效），例如 {"draw_buf_lines": 30, "draw_buf_count": 2}
+// {"lcd_clock_calibrate": true} 在下次启动时标定面板时钟，{"lcd_pclk_hz": 0} 回到 BSP 的时钟
+static esp_err_t display_config_post_handler(httpd_req_t *req) {
+    char buf[128];
+    if (req->content_len == 0 || req->content_len >= sizeof(buf)) {
+        httpd_resp_sendstr(req, "Error: Invalid request size");
+        return ESP_FAIL;
+    }
+    int ret = httpd_req_recv(req, buf, req->content_len);
+    if (ret <= 0) {
+        httpd_resp_sendstr(req, "Error: No data received");
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+    cJSON *json = cJSON_Parse(buf);
+    if (json == NULL) {
+        httpd_resp_sendstr(req, "Error: Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    display_settings_t settings = s_display_settings;
+    cJSON *lines = cJSON_GetObjectItem(json, "draw_buf_lines");
+    cJSON *count = cJSON_GetObjectItem(json, "draw_buf_count");
+    cJSON *calibrate = cJSON_GetObjectItem(json, "lcd_clock_calibrate");
+    cJSON *pclk = cJSON_GetObjectItem(json, "lcd_pclk_hz");
+    if (lines && cJSON_IsNumber(lines)) {
+        settings.draw_buf_lines = lines->valueint;
+    }
+    if (count && cJSON_IsNumber(count)) {
+        settings.draw_buf_count = count->valueint;
+    }
+    if (calibrate && cJSON_IsBool(calibrate)) {
+        settings.lcd_clock_calibrate = cJSON_IsTrue(calibrate);
+    }
+    // 只能清除，时钟由标定得出
+    if (pclk && cJSON_IsNumber(pclk) && pclk->valueint == 0) {
+        settings.lcd_pclk_hz = 0;
+    }
+    cJSON_Delete(json);
+
+    esp_err_t err = display_settings_save(&settings);
+    if (err == ESP_ERR_INVALID_ARG) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "Error: draw_buf_lines must be %d-%d and draw_buf_count 1 or 2",
+                 DISPLAY_DRAW_BUF_LINES_MIN, DISPLAY_DRAW_BUF_LINES_MAX);
+        httpd_resp_sendstr(req, msg);
+        return ESP_FAIL;
+    } else if (err != ESP_OK) {
+        httpd_resp_sendstr(req, "Error: Failed to save settings");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Display settings saved: %u lines x %u buffers", settings.draw_buf_lines, settings.draw_buf_count);
+    httpd_resp_sendstr(req, "OK, restart to apply");
+    return ESP_OK;
+}
+
+// 图片上的状态叠加层：请求体为文字（UTF-8），空请求体隐藏
+static esp_err_t overlay_post_handler(httpd_req_t *req) {
+    char text[96];
+    if (req->content_len >= sizeof(text)) {
+        httpd_resp_sendstr(req, "Error: Text too long");
+        return ESP_FAIL;
+    }
+    int len = 0;
+    while (len < (int)req->content_len) {
+        int ret = httpd_req_recv(req, text + len, req->content_len - len);
+        if (ret <= 0) {
+            httpd_resp_sendstr(req, "Error: No data received");
+            return ESP_FAIL;
+        }
+        len += ret;
+    }
+    text[len] = '\0';
+    display_pipeline_set_overlay(text);
+    httpd_resp_sendstr(req, len ? "OK: Overlay shown" : "OK: Overlay hidden");
+    return ESP_OK;
+}
+
 static httpd_handle_t start_webserver(void) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    // /upload 在 httpd 任务中直接解码 JPEG，默认 4KB 栈不够
+    config.stack_size = 8192;
     httpd_handle_t server = NULL;
     if (httpd_start(&server, &config) == ESP_OK) {
         httpd_uri_t u1 = { "/upload", HTTP_POST, upload_post_handler, NULL };
         httpd_uri_t u2 = { "/upload_url", HTTP_POST, upload_url_post_handler, NULL };
+        httpd_uri_t u3 = { "/status", HTTP_GET, status_get_handler, NULL };
+        httpd_uri_t u4 = { "/display_config", HTTP_POST, display_config_post_handler, NULL };
+        httpd_uri_t u5 = { "/stream", HTTP_POST, stream_post_handler, NULL };
+        httpd_uri_t u6 = { "/overlay", HTTP_POST, overlay_post_handler, NULL };
         httpd_register_uri_handler(server, &u1);
         httpd_register_uri_handler(server, &u2);
+        httpd_register_uri_handler(server, &u3);
+        httpd_register_uri_handler(server, &u4);
+        httpd_register_uri_handler(server, &u5);
+        httpd_register_uri_handler(server, &u6);
     }
     return server;
 }
@@ -409,27 +1026,43 @@ void app_main(void) {
 
     bsp_i2c_init();
     
-    // 稳妥配置：增加缓冲区至 320*60
+    // 两块内部 RAM 的 DMA 缓冲区：LVGL 渲染下一块的同时 SPI 发送上一块
+    // 默认 2 x 30 行，与原来的单缓冲 60 行占用相同的内存
+    display_settings_load(&s_display_settings);
+    ESP_LOGI(TAG, "Draw buffers: %u x %u lines", s_display_settings.draw_buf_count, s_display_settings.draw_buf_lines);
+    lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    port_cfg.task_affinity = LVGL_TASK_CORE;
     bsp_display_cfg_t dcfg = {
-        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = 320 * 60,
-        .double_buffer = 0,
-        .flags = { .buff_dma = true }
+        .lvgl_port_cfg = port_cfg,
+        .buffer_size = BSP_LCD_H_RES * s_display_settings.draw_buf_lines,
+        .double_buffer = s_display_settings.draw_buf_count == 2,
+        .flags = { .buff_dma = true, .buff_spiram = false }
     };
-    bsp_display_start_with_config(&dcfg);
-    
-    bsp_display_lock(0);
-    g_status_label = lv_label_create(lv_scr_act());
-    lv_label_set_text(g_status_label, "System Ready...");
-    lv_obj_center(g_status_label);
-    
-    g_img_obj = lv_img_create(lv_scr_act());
-    lv_obj_set_size(g_img_obj, 320, 240);
-    lv_obj_add_flag(g_img_obj, LV_OBJ_FLAG_HIDDEN);
-    bsp_display_unlock();
+    lv_disp_t *disp = bsp_display_start_with_config(&dcfg);
+    // 标定过的面板时钟（main/lcd_clock.c）：背光打开前写测试图案，之后才能交出面板 IO 句柄
+    lcd_clock_init(disp, &s_display_settings);
     
+    // 图片对象、照片模式和 LVGL 解码器（main/display_pipeline.c）
+    display_pipeline_init(disp, DECODE_TASK_CORE);
+#if CONFIG_DISPLAY_LVGL_EVENT_TASK
+    // LVGL 任务改为按需唤醒（main/lvgl_wake.c）：静止的图片不占用 CPU，新图片不等刷新周期
+    if (lvgl_wake_start(disp, bsp_display_get_input_dev(), &port_cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "Keeping the polling LVGL task");
+    }
+#endif
+#if CONFIG_DISPLAY_PRESENT_FULL_FRAME
+    // 整帧渲染到 PSRAM 帧缓冲区后一次发送，没有 TE 时按节拍发送（main/frame_present.c）
+    if (frame_present_init(disp, CONFIG_DISPLAY_LCD_TE_GPIO) != ESP_OK) {
+        ESP_LOGW(TAG, "Sending draw buffer chunks directly");
+    }
+#endif
     bsp_display_backlight_on();
 
+    url_cache_init();
+    s_download_queue = xQueueCreate(1, sizeof(download_job_t));
+    s_download_submit = xSemaphoreCreateMutex();
+    // 增加栈大小以处理 HTTPS 下载
+    xTaskCreate(download_image_task, "download_img", 16384, NULL, 5, NULL);
     start_webserver();
     
     // 增加网络就绪延时，防止启动时 MCP 客户端 DNS 冲突
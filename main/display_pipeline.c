@@ -0,0 +1,433 @@
+/*
+ * Display pipeline
+ * Encoded image -> decode (or decoded image cache) -> photo mode or LVGL -> panel
+ */
+
+#include "display_pipeline.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "jpeg_stream.h"
+#include "photo_mode.h"
+#include "sjpg_band.h"
+#include "img565.h"
+#include "img565_decoder.h"
+#include "png_stream.h"
+#include "png_band.h"
+#include "gif_stream.h"
+#include "gif_player.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "display_pipeline";
+
+// 全局 UI 变量
+static lv_obj_t *g_img_obj = NULL;
+static lv_obj_t *g_status_label = NULL;
+
+// LVGL 内存图片描述符
+// 注意：对于JPEG图片，不设置cf，让LVGL自动检测格式
+static lv_img_dsc_t g_mem_img_dsc = {
+    .header.always_zero = 0,
+    .header.w = 0,
+    .header.h = 0,
+    .data_size = 0,
+    .header.cf = LV_IMG_CF_UNKNOWN,  // 让LVGL自动检测格式（JPEG/SJPG等）
+    .data = NULL,
+};
+
+// 屏幕上显示的图片（持有一个引用）
+static image_buf_t *s_shown = NULL;
+// 刚被换下的图片，在下一次刷新完成（monitor_cb）时释放引用
+static image_buf_t *s_retired = NULL;
+// 已显示的图片数量（/status 统计）
+static uint32_t s_images_shown = 0;
+// 状态标签作为叠加层显示在图片上（display_pipeline_set_overlay），只在持有显示锁时访问
+static bool s_overlay = false;
+
+// LVGL 刷新发送到面板的像素（monitor_cb），照片模式的像素由 photo_mode 统计
+static portMUX_TYPE s_px_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_lvgl_px = 0;
+// 上一次计算像素速率时的采样
+static int64_t s_px_sample_us = 0;
+static uint64_t s_px_sample = 0;
+static uint32_t s_px_per_s = 0;
+// 正在播放的 GIF 动画（屏幕上的图片是它的画布），只在持有显示锁时访问
+static gif_player_t *s_gif = NULL;
+
+// 串行化解码、缓存访问和描述符切换
+static SemaphoreHandle_t s_image_mutex = NULL;
+// GIF 提前解码任务所在的核心
+static BaseType_t s_decode_core = tskNO_AFFINITY;
+
+/**
+ * @brief LVGL 刷新完成回调（在 LVGL 任务中、持有显示锁时调用）
+ * 此时新图片已经绘制并送到屏幕，换下的旧图片不会再被读取
+ */
+static void display_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px) {
+    taskENTER_CRITICAL(&s_px_lock);
+    s_lvgl_px += px;
+    taskEXIT_CRITICAL(&s_px_lock);
+    if (s_retired) {
+        image_buf_unref(s_retired);
+        s_retired = NULL;
+    }
+}
+
+/**
+ * @brief 线程安全地把 g_mem_img_dsc 切换到 buf，显示模块取得一个引用
+ * 旧图片的引用在下一次刷新完成后释放，不再依赖固定延时
+ * 注意：不能使用 IRAM_ATTR，因为 LVGL 函数在 Flash 中
+ * @param on_panel 照片模式已经把 buf 写到面板上，LVGL 不需要再重绘
+ */
+static bool swap_image_data(image_buf_t *buf, bool on_panel) {
+    // 使用 bsp_display_lock 确保线程安全
+    if (!bsp_display_lock(pdMS_TO_TICKS(2000))) {
+        ESP_LOGE(TAG, "Could not get display lock within timeout!");
+        return false;
+    }
+
+    // 检查对象是否有效
+    if (g_img_obj == NULL) {
+        ESP_LOGE(TAG, "Image object is NULL!");
+        bsp_display_unlock();
+        return false;
+    }
+
+    // 停止正在播放的动画，之后不会再有帧画到旧画布上
+    gif_player_delete(s_gif);
+    s_gif = NULL;
+
+    // 关闭 LVGL 图片缓存中打开的解码器，之后 LVGL 不会再读取旧数据
+    lv_img_cache_invalidate_src(&g_mem_img_dsc);
+    sjpg_band_invalidate(&g_mem_img_dsc);
+    png_band_invalidate(&g_mem_img_dsc);
+
+    // 上一张换下的图片还没来得及刷新就又被替换，说明它从未被绘制，直接释放
+    if (s_retired) {
+        image_buf_unref(s_retired);
+    }
+    s_retired = s_shown;
+    s_shown = image_buf_ref(buf);
+    s_images_shown++;
+
+    // 更新描述符为新数据
+    g_mem_img_dsc.data_size = buf->size;
+    g_mem_img_dsc.data = buf->data;
+    g_mem_img_dsc.header.cf = buf->cf;
+    g_mem_img_dsc.header.w = buf->width;  // LV_IMG_CF_UNKNOWN 时为0，由解码器自动检测
+    g_mem_img_dsc.header.h = buf->height;
+
+    // 隐藏启动时的状态标签（叠加层保留在新图片上）
+    if (g_status_label && !s_overlay) {
+        lv_obj_add_flag(g_status_label, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // 设置源并显示
+    lv_img_set_src(g_img_obj, &g_mem_img_dsc);
+    lv_obj_clear_flag(g_img_obj, LV_OBJ_FLAG_HIDDEN);
+
+    if (on_panel) {
+        // 面板上已经是新图片：先完成布局（尺寸变化也会产生脏区域），再丢弃所有脏区域
+        // 旧图片不会再被绘制，直接释放；之后的叠加层照常由 LVGL 局部刷新
+        lv_obj_update_layout(lv_scr_act());
+        _lv_inv_area(lv_obj_get_disp(g_img_obj), NULL);
+        // 照片模式没有画叠加层，只重绘它所在的区域
+        if (s_overlay) {
+            lv_obj_invalidate(g_status_label);
+        }
+        if (s_retired) {
+            image_buf_unref(s_retired);
+            s_retired = NULL;
+        }
+    } else {
+        // 强制重绘
+        lv_obj_invalidate(g_img_obj);
+    }
+
+    bsp_display_unlock();
+    return true;
+}
+
+/**
+ * @brief 显示一张图片：全屏 RGB565 图片走照片模式直接写面板，其它交给 LVGL 绘制
+ * 解码时已经逐块发送到面板的图片不会重复发送
+ */
+bool display_pipeline_show(image_buf_t *buf) {
+    if (!photo_mode_complete()) {
+        photo_mode_blit(buf);
+    }
+    bool on_panel = photo_mode_complete();
+    bool shown = swap_image_data(buf, on_panel);
+    photo_mode_end(on_panel && shown);
+    return shown;
+}
+
+// 隔行扫描（Adam7）的 PNG 不能逐行解码，仍交给 lv_png：IHDR 的最后一个字节是隔行方式
+static bool is_interlaced_png(const uint8_t *data, size_t size) {
+    return size > 28 && data[28] != 0;
+}
+
+static bool is_jpeg(const uint8_t *data, size_t size) {
+    return size > 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+/**
+ * @brief 把解码结果放入缓存（相同内容已缓存时复用旧的帧缓冲区）
+ * 解码结果 pixels 的所有权转移给缓存
+ * @return 图片的新引用，失败返回 NULL
+ */
+image_buf_t *display_pipeline_cache_decoded(const uint8_t key[IMAGE_CACHE_KEY_LEN], uint8_t *pixels, size_t size,
+                                             lv_img_cf_t cf, uint16_t width, uint16_t height) {
+    image_buf_t *buf = image_cache_get(key);
+    if (buf) {
+        heap_caps_free(pixels);
+        return buf;
+    }
+    buf = image_buf_create(pixels, size, cf, width, height);
+    if (buf) {
+        image_cache_put(key, buf);
+    }
+    return buf;
+}
+
+/**
+ * @brief 核心显示逻辑（调用者保留 buffer 的所有权）
+ * @param[out] key 图片内容的缓存键
+ * @return 已显示图片的新引用（调用者释放），失败返回 NULL
+ */
+image_buf_t *display_pipeline_from_buffer(const uint8_t *buffer, size_t size, uint8_t key[IMAGE_CACHE_KEY_LEN]) {
+    if (!buffer || size == 0) return NULL;
+
+    xSemaphoreTake(s_image_mutex, portMAX_DELAY);
+
+    // 1. 按内容哈希查找已解码的图片，命中时无需再次解码
+    image_cache_key(buffer, size, key);
+    image_buf_t *buf = image_cache_get(key);
+    gif_player_t *gif = NULL;
+    if (buf) {
+        ESP_LOGI(TAG, "Decoded image cache hit (%ux%u)", buf->width, buf->height);
+    } else if (is_jpeg(buffer, size)) {
+        // 2. JPEG 只解码一次，得到与 LV_COLOR_16_SWAP 一致的 RGB565 数据
+        // 大图按比例缩小到屏幕大小；先腾出缓存位置，峰值内存不超过缓存大小
+        image_cache_reserve();
+        jpeg_stream_cfg_t cfg = {
+            .swap_bytes = LV_COLOR_16_SWAP,
+            .max_width = BSP_LCD_H_RES,
+            .max_height = BSP_LCD_V_RES,
+            // 全屏照片每解码完一个 MCU 行就直接发送到面板，解码和 SPI 传输重叠
+            .on_band = photo_mode_band,
+        };
+        jpeg_stream_image_t img;
+        esp_err_t err = jpeg_stream_decode_mem(buffer, size, &cfg, &img);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to decode JPEG (%zu bytes): %s", size, esp_err_to_name(err));
+            photo_mode_end(false);
+            xSemaphoreGive(s_image_mutex);
+            return NULL;
+        }
+        buf = display_pipeline_cache_decoded(key, img.pixels, img.size, LV_IMG_CF_TRUE_COLOR, img.width, img.height);
+        if (!buf) {
+            photo_mode_end(false);
+        }
+    } else if (img565_is(buffer, size)) {
+        // 3. IMG565 本身就是面板字节序的 RGB565，只需要解压分片，不用解码
+        image_cache_reserve();
+        img565_cfg_t cfg = {
+            .swap_bytes = LV_COLOR_16_SWAP,
+            .on_band = photo_mode_band,
+        };
+        img565_image_t img;
+        esp_err_t err = img565_decode_mem(buffer, size, &cfg, &img);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read IMG565 image (%zu bytes): %s", size, esp_err_to_name(err));
+            photo_mode_end(false);
+            xSemaphoreGive(s_image_mutex);
+            return NULL;
+        }
+        buf = display_pipeline_cache_decoded(key, img.pixels, img.size, img.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR,
+                                  img.width, img.height);
+        if (!buf) {
+            photo_mode_end(false);
+        }
+    } else if (png_stream_is(buffer, size) && !is_interlaced_png(buffer, size)) {
+        // 4. PNG 逐行解压、去滤波，直接写成 RGB565（带透明度时为 RGB565A8）
+        // 不再经过 lv_png 的整图 RGBA8888 缓冲区
+        image_cache_reserve();
+        png_stream_cfg_t cfg = {
+            .swap_bytes = LV_COLOR_16_SWAP,
+            .on_band = photo_mode_band,
+        };
+        png_stream_image_t img;
+        esp_err_t err = png_stream_decode_mem(buffer, size, &cfg, &img);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to decode PNG (%zu bytes): %s", size, esp_err_to_name(err));
+            photo_mode_end(false);
+            xSemaphoreGive(s_image_mutex);
+            return NULL;
+        }
+        buf = display_pipeline_cache_decoded(key, img.pixels, img.size, img.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR,
+                                  img.width, img.height);
+        if (!buf) {
+            photo_mode_end(false);
+        }
+    } else if (gif_stream_is(buffer, size)) {
+        // 5. GIF：第一帧画到 RGB565 画布上，和静态图片一样显示；之后的帧由 gif_player
+        // 在另一个核心提前解码，按 GIF 的帧延时只重绘变化的区域。画布一直在变，不放入缓存
+        image_cache_reserve();
+        esp_err_t err = gif_player_create(buffer, size, &gif, &buf);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to decode GIF (%zu bytes): %s", size, esp_err_to_name(err));
+            xSemaphoreGive(s_image_mutex);
+            return NULL;
+        }
+    } else {
+        // 6. 其它格式（隔行扫描的 PNG、BMP 等）仍交给 LVGL 解码器，需要保留一份数据拷贝
+        // 如果图片太大，尝试使用PSRAM，但需要确保数据可访问
+        uint8_t *copy_buf = NULL;
+        if (size > 50000) {
+            // 大图片使用PSRAM
+            copy_buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        } else {
+            // 小图片使用DMA内存（可缓存）
+            copy_buf = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        }
+
+        if (!copy_buf) {
+            // 如果DMA内存不足，尝试使用默认内存
+            copy_buf = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+        }
+
+        if (!copy_buf) {
+            ESP_LOGE(TAG, "Memory allocation failed for size: %zu!", size);
+            xSemaphoreGive(s_image_mutex);
+            return NULL;
+        }
+
+        ESP_LOGI(TAG, "Allocated %zu bytes for image data", size);
+        memcpy(copy_buf, buffer, size);
+        // LVGL会自动检测格式并解码
+        buf = image_buf_create(copy_buf, size, LV_IMG_CF_UNKNOWN, 0, 0);
+    }
+
+    if (buf) {
+        if (display_pipeline_show(buf)) {
+            ESP_LOGI(TAG, "Image displayed (%ux%u, %zu bytes encoded)", buf->width, buf->height, size);
+            if (gif) {
+                bsp_display_lock(0);
+                if (gif_player_start(gif, g_img_obj, s_decode_core) != ESP_OK) {
+                    ESP_LOGW(TAG, "Could not start GIF playback, showing the first frame");
+                    gif_player_delete(gif);
+                    gif = NULL;
+                }
+                s_gif = gif;
+                bsp_display_unlock();
+            }
+        } else {
+            gif_player_delete(gif);
+            image_buf_unref(buf);
+            buf = NULL;
+        }
+    }
+    xSemaphoreGive(s_image_mutex);
+    return buf;
+}
+
+esp_err_t display_pipeline_init(lv_disp_t *disp, BaseType_t decode_core) {
+    s_image_mutex = xSemaphoreCreateMutex();
+    if (!s_image_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_decode_core = decode_core;
+
+    bsp_display_lock(0);
+    // 每次刷新完成后释放被换下的图片
+    disp->driver->monitor_cb = display_monitor_cb;
+    // 全屏照片绕过 LVGL 直接写面板
+    photo_mode_init(disp);
+    // SJPG/JPEG 图片源按条带解码，代替 lv_sjpg 的整帧 RGB888 缓存
+    sjpg_band_init();
+    // IMG565 图片源（C 数组/.i565 文件）：未压缩时直接交给 LVGL，不需要解码
+    img565_decoder_init();
+    // PNG 图片源逐行解压，代替 lv_png 的整图 RGBA8888 解码
+    png_band_init();
+    g_status_label = lv_label_create(lv_scr_act());
+    lv_label_set_text(g_status_label, "System Ready...");
+    lv_obj_center(g_status_label);
+    // 叠加在照片上时用半透明的底色保证可读
+    lv_obj_set_style_bg_color(g_status_label, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(g_status_label, LV_OPA_60, 0);
+    lv_obj_set_style_text_color(g_status_label, lv_color_white(), 0);
+    lv_obj_set_style_pad_hor(g_status_label, 6, 0);
+    lv_obj_set_style_pad_ver(g_status_label, 2, 0);
+    lv_obj_set_style_radius(g_status_label, 4, 0);
+
+    g_img_obj = lv_img_create(lv_scr_act());
+    // 图片大小随内容变化并居中（缩小后的照片可能不是 320x240，固定大小时 LVGL 会平铺）
+    lv_obj_set_size(g_img_obj, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    lv_obj_center(g_img_obj);
+    lv_obj_add_flag(g_img_obj, LV_OBJ_FLAG_HIDDEN);
+    // 状态标签放在图片上面：之后调整层次会让整个屏幕失效，只在启动时做一次
+    lv_obj_move_foreground(g_status_label);
+    bsp_display_unlock();
+    return g_status_label && g_img_obj ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void display_pipeline_lock(void) {
+    xSemaphoreTake(s_image_mutex, portMAX_DELAY);
+}
+
+void display_pipeline_unlock(void) {
+    xSemaphoreGive(s_image_mutex);
+}
+
+void display_pipeline_stop_animation(void) {
+    if (bsp_display_lock(pdMS_TO_TICKS(2000))) {
+        gif_player_delete(s_gif);
+        s_gif = NULL;
+        bsp_display_unlock();
+    }
+}
+
+uint32_t display_pipeline_images_shown(void) {
+    return s_images_shown;
+}
+
+void display_pipeline_set_overlay(const char *text) {
+    if (!bsp_display_lock(pdMS_TO_TICKS(2000))) {
+        ESP_LOGE(TAG, "Could not get display lock within timeout!");
+        return;
+    }
+    // 文字、位置和隐藏标志的变化只让标签新旧两块区域失效，LVGL 从解码后的图片重新混合这两块
+    if (text && text[0]) {
+        if (!s_overlay) {
+            lv_obj_align(g_status_label, LV_ALIGN_BOTTOM_RIGHT, -6, -6);
+            s_overlay = true;
+        }
+        lv_label_set_text(g_status_label, text);
+        lv_obj_clear_flag(g_status_label, LV_OBJ_FLAG_HIDDEN);
+    } else if (s_overlay) {
+        lv_obj_add_flag(g_status_label, LV_OBJ_FLAG_HIDDEN);
+        s_overlay = false;
+    }
+    bsp_display_unlock();
+}
+
+uint64_t display_pipeline_pixels_pushed(uint32_t *per_s) {
+    const int64_t now = esp_timer_get_time();
+    const uint64_t photo_px = photo_mode_pixels_sent();
+    taskENTER_CRITICAL(&s_px_lock);
+    const uint64_t total = s_lvgl_px + photo_px;
+    if (now - s_px_sample_us >= 1000000) {
+        s_px_per_s = (uint32_t)((total - s_px_sample) * 1000000 / (uint64_t)(now - s_px_sample_us));
+        s_px_sample_us = now;
+        s_px_sample = total;
+    }
+    if (per_s) {
+        *per_s = s_px_per_s;
+    }
+    taskEXIT_CRITICAL(&s_px_lock);
+    return total;
+}
@@ -0,0 +1,100 @@
+/*
+ * Display pipeline
+ * Encoded image -> decode (or decoded image cache) -> photo mode or LVGL -> panel
+ */
+
+#ifndef DISPLAY_PIPELINE_H
+#define DISPLAY_PIPELINE_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "lvgl.h"
+#include "image_buf.h"
+#include "image_cache.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the image and status label objects and register the image decoders
+ *
+ * Takes the display lock itself. Call once after the display is started.
+ *
+ * @param disp Display added with lvgl_port_add_disp() (needed by photo mode)
+ * @param decode_core Core of the GIF decode task
+ * @return ESP_ERR_NO_MEM if the mutex or the LVGL objects could not be created
+ */
+esp_err_t display_pipeline_init(lv_disp_t *disp, BaseType_t decode_core);
+
+/**
+ * @brief Serialise decoding, cache access and image switches
+ *
+ * display_pipeline_from_buffer() takes the lock itself; the other functions
+ * must be called with it held.
+ */
+void display_pipeline_lock(void);
+void display_pipeline_unlock(void);
+
+/**
+ * @brief Decode an encoded image (JPEG, PNG, GIF, IMG565, or anything LVGL decodes) and show it
+ *
+ * Decoded images are looked up and stored in the image cache by content hash.
+ * Full-screen images are sent to the panel band by band while decoding.
+ *
+ * @param buffer Encoded image, still owned by the caller
+ * @param[out] key Content hash of the image
+ * @return New reference to the image shown (release with image_buf_unref()), NULL on failure
+ */
+image_buf_t *display_pipeline_from_buffer(const uint8_t *buffer, size_t size, uint8_t key[IMAGE_CACHE_KEY_LEN]);
+
+/**
+ * @brief Put a decoded image in the cache, reusing the cached copy if the content is already there
+ * @param pixels Decoded pixels, ownership passes to the cache (freed on a hit)
+ * @return New reference to the image, NULL if it could not be wrapped
+ */
+image_buf_t *display_pipeline_cache_decoded(const uint8_t key[IMAGE_CACHE_KEY_LEN], uint8_t *pixels, size_t size,
+                                             lv_img_cf_t cf, uint16_t width, uint16_t height);
+
+/**
+ * @brief Show a decoded image: full-screen RGB565 goes through photo mode, the rest is drawn by LVGL
+ *
+ * Also ends a photo mode session started by the decoder bands.
+ */
+bool display_pipeline_show(image_buf_t *buf);
+
+/**
+ * @brief Stop a playing GIF, leaving its current frame on screen
+ */
+void display_pipeline_stop_animation(void);
+
+/**
+ * @brief Number of images shown since boot
+ */
+uint32_t display_pipeline_images_shown(void);
+
+/**
+ * @brief Show text in a badge over the image, NULL or "" hides it
+ *
+ * The badge stays on top of the images shown afterwards. Changing it
+ * invalidates only its old and new areas, which LVGL redraws from the
+ * decoded image and flushes on their own: a few KB of panel traffic
+ * instead of a 150 KB frame.
+ */
+void display_pipeline_set_overlay(const char *text);
+
+/**
+ * @brief Pixels sent to the panel by LVGL refreshes and photo mode
+ * @param[out] per_s Average rate since the previous call (at least one second before; otherwise the last rate)
+ * @return Total since boot
+ */
+uint64_t display_pipeline_pixels_pushed(uint32_t *per_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_PIPELINE_H
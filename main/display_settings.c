@@ -0,0 +1,78 @@
+/*
+ * Display settings
+ * Boot-time display pipeline settings kept in NVS, defaults from menuconfig
+ */
+
+#include "display_settings.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+
+static const char *TAG = "display_settings";
+
+#define DISPLAY_SETTINGS_NAMESPACE "display"
+
+static bool display_settings_valid(const display_settings_t *settings) {
+    return settings->draw_buf_lines >= DISPLAY_DRAW_BUF_LINES_MIN &&
+           settings->draw_buf_lines <= DISPLAY_DRAW_BUF_LINES_MAX &&
+           (settings->draw_buf_count == 1 || settings->draw_buf_count == 2) &&
+           settings->lcd_pclk_hz <= DISPLAY_LCD_PCLK_MAX_HZ;
+}
+
+void display_settings_load(display_settings_t *settings) {
+    const display_settings_t defaults = {
+        .draw_buf_lines = CONFIG_DISPLAY_DRAW_BUF_LINES,
+        .draw_buf_count = CONFIG_DISPLAY_DRAW_BUF_COUNT,
+    };
+    *settings = defaults;
+
+    nvs_handle_t nvs;
+    if (nvs_open(DISPLAY_SETTINGS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;  // 从未保存过，使用默认值
+    }
+    nvs_get_u16(nvs, "draw_lines", &settings->draw_buf_lines);
+    nvs_get_u8(nvs, "draw_bufs", &settings->draw_buf_count);
+    nvs_get_u32(nvs, "lcd_pclk", &settings->lcd_pclk_hz);
+    uint8_t calibrate = 0;
+    nvs_get_u8(nvs, "lcd_cal", &calibrate);
+    settings->lcd_clock_calibrate = calibrate;
+    nvs_close(nvs);
+
+    if (!display_settings_valid(settings)) {
+        ESP_LOGW(TAG, "Invalid stored settings (%u lines x %u, %" PRIu32 " Hz), using defaults",
+                 settings->draw_buf_lines, settings->draw_buf_count, settings->lcd_pclk_hz);
+        *settings = defaults;
+    }
+}
+
+esp_err_t display_settings_save(const display_settings_t *settings) {
+    if (!display_settings_valid(settings)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(DISPLAY_SETTINGS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = nvs_set_u16(nvs, "draw_lines", settings->draw_buf_lines);
+    if (err == ESP_OK) {
+        err = nvs_set_u8(nvs, "draw_bufs", settings->draw_buf_count);
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_u32(nvs, "lcd_pclk", settings->lcd_pclk_hz);
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_u8(nvs, "lcd_cal", settings->lcd_clock_calibrate);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save settings: %s", esp_err_to_name(err));
+    }
+    return err;
+}
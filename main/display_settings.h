@@ -0,0 +1,48 @@
+/*
+ * Display settings
+ * Boot-time display pipeline settings kept in NVS, defaults from menuconfig
+ */
+
+#ifndef DISPLAY_SETTINGS_H
+#define DISPLAY_SETTINGS_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPLAY_DRAW_BUF_LINES_MIN  10
+// The BSP sizes the SPI bus's max_transfer_sz for this many lines
+#define DISPLAY_DRAW_BUF_LINES_MAX  CONFIG_BSP_LCD_DRAW_BUF_HEIGHT
+#define DISPLAY_LCD_PCLK_MAX_HZ     (80 * 1000 * 1000)
+
+/**
+ * @brief Display settings
+ */
+typedef struct {
+    uint16_t draw_buf_lines;    // Height of each LVGL draw buffer in lines
+    uint8_t draw_buf_count;     // 1 or 2 DMA draw buffers (2: render while flushing)
+    uint32_t lcd_pclk_hz;       // Calibrated SPI pixel clock, 0: the BSP's clock
+    bool lcd_clock_calibrate;   // Calibrate the pixel clock at the next boot
+} display_settings_t;
+
+/**
+ * @brief Load settings from NVS, missing or invalid values use the menuconfig defaults
+ */
+void display_settings_load(display_settings_t *settings);
+
+/**
+ * @brief Validate and store settings in NVS, they take effect after a restart
+ * @return ESP_ERR_INVALID_ARG if a value is out of range
+ */
+esp_err_t display_settings_save(const display_settings_t *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_SETTINGS_H
@@ -0,0 +1,404 @@
+/*
+ * Frame presentation
+ * LVGL renders into a full-screen PSRAM framebuffer; when a refresh is
+ * complete a present task sends its dirty areas to the panel in one pass,
+ * started on the panel's TE (tearing effect) signal or on a paced frame grid
+ */
+
+#include "frame_present.h"
+#include "lvgl_port_ctx.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_commands.h"
+#include "driver/gpio.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "frame_present";
+
+// ILI9342C 默认的帧率（FRMCTR1 = 0x00 0x1B）
+#define FRAME_PRESENT_NOMINAL_PERIOD_US 14286
+// FRMCTR1：内部时钟不分频，RTNA = 0x1F 为 61Hz，两个刷新周期足够 40MHz 发送一整帧
+#define FRAME_PRESENT_CMD_FRMCTR1       0xB1
+#define FRAME_PRESENT_TE_RTNA           0x1F
+// 超过这个时间没有 TE 边沿，这一帧按节拍发送
+#define FRAME_PRESENT_TE_TIMEOUT_MS     50
+// 一次刷新中记录的区域（同一块失效区域被 LVGL 分块渲染，相邻的块会合并）
+#define FRAME_PRESENT_MAX_AREAS         LV_INV_BUF_SIZE
+// 发送任务：等 TE 或节拍时不持有显示锁；优先级高于 LVGL 任务，帧一到就开始等待
+#define FRAME_PRESENT_TASK_STACK        3072
+#define FRAME_PRESENT_TASK_PRIO         5
+// LVGL 在 wait_cb 中等待发送完成，每次最多睡眠这么久后重新检查
+#define FRAME_PRESENT_WAIT_MS           10
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    uint8_t *fb;                    // PSRAM 中的整屏 RGB565（与 LVGL 的字节序相同）
+    lv_area_t areas[FRAME_PRESENT_MAX_AREAS];
+    int area_count;
+    SemaphoreHandle_t vsync;        // TE 边沿或节拍定时器
+    SemaphoreHandle_t trans_done;   // 面板 IO 发送完一块颜色数据（只在 sending 时计数）
+    SemaphoreHandle_t idle;         // 一帧发送完毕，LVGL 可以重新使用绘图缓冲区
+    TaskHandle_t task;
+    lv_disp_drv_t *drv;
+    uint8_t *bounce;                // 最后一块所在的 LVGL 绘图缓冲区，分成两半交替发送
+    volatile bool sending;
+    esp_timer_handle_t pace_timer;
+    int te_gpio;
+    int64_t grid_us;                // 上一帧开始的时刻（节拍模式）
+    uint32_t flush_avg_us;          // 整帧发送时间的滑动平均（节拍模式选择帧间隔）
+} frame_present_t;
+
+static frame_present_t s_present;
+static volatile int64_t s_te_last_us;
+static volatile uint32_t s_te_period_us;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static frame_present_stats_t s_stats;
+
+static void IRAM_ATTR frame_present_te_isr(void *arg)
+{
+    const int64_t now = esp_timer_get_time();
+    const int64_t period = now - s_te_last_us;
+    // 过滤掉启动时和长时间没有 TE 之后的间隔
+    if (period > 5000 && period < 50000) {
+        s_te_period_us = s_te_period_us ? (s_te_period_us * 7 + (uint32_t)period) / 8 : (uint32_t)period;
+    }
+    s_te_last_us = now;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_present.vsync, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void frame_present_pace_cb(void *arg)
+{
+    xSemaphoreGive(s_present.vsync);
+}
+
+/**
+ * @brief 代替 esp_lvgl_port 的 on_color_trans_done：每块发送完只通知发送任务
+ * esp_lvgl_port 的回调会对每块调用 lv_disp_flush_ready()，而这里的块不是 LVGL 的 flush
+ */
+static bool IRAM_ATTR frame_present_trans_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata,
+                                               void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    // 照片模式直接写面板时不计数（它和发送任务不会同时写面板）
+    if (s_present.sending) {
+        xSemaphoreGiveFromISR(s_present.trans_done, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief 记录一块刚渲染的区域；和上一块左右对齐、上下相接时合并
+ */
+static void frame_present_add_area(const lv_area_t *area)
+{
+    if (s_present.area_count > 0) {
+        lv_area_t *last = &s_present.areas[s_present.area_count - 1];
+        if (last->x1 == area->x1 && last->x2 == area->x2 && last->y2 + 1 == area->y1) {
+            last->y2 = area->y2;
+            return;
+        }
+        if (s_present.area_count == FRAME_PRESENT_MAX_AREAS) {
+            // 放不下时并到最后一块里（LVGL 的失效区域满了会直接重画整个屏幕，很少走到这里）
+            _lv_area_join(last, last, area);
+            return;
+        }
+    }
+    s_present.areas[s_present.area_count++] = *area;
+}
+
+/**
+ * @brief 等待这一帧可以开始发送的时刻
+ * @return 这一帧的预算（微秒）
+ */
+static uint32_t frame_present_wait(uint32_t *period_us)
+{
+    if (s_present.te_gpio >= 0) {
+        // 丢掉之前的边沿，等下一个 TE：扫描从第 0 行开始，发送紧跟在后面
+        xSemaphoreTake(s_present.vsync, 0);
+        if (xSemaphoreTake(s_present.vsync, pdMS_TO_TICKS(FRAME_PRESENT_TE_TIMEOUT_MS)) == pdTRUE) {
+            *period_us = s_te_period_us ? s_te_period_us : FRAME_PRESENT_NOMINAL_PERIOD_US;
+            return *period_us * 2;
+        }
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_stats.te_timeouts++;
+        taskEXIT_CRITICAL(&s_stats_lock);
+    }
+
+    // 节拍：帧间隔取能容纳平均发送时间的整数个刷新周期，帧在这个网格上开始
+    *period_us = FRAME_PRESENT_NOMINAL_PERIOD_US;
+    const uint32_t periods = s_present.flush_avg_us / FRAME_PRESENT_NOMINAL_PERIOD_US + 1;
+    const int64_t slot = (int64_t)periods * FRAME_PRESENT_NOMINAL_PERIOD_US;
+    const int64_t now = esp_timer_get_time();
+    int64_t start = s_present.grid_us + slot;
+    if (now - s_present.grid_us > slot * 2) {
+        // 空闲了一段时间，马上开始并以现在为网格起点
+        start = now;
+    } else {
+        while (start < now) {
+            start += slot;
+        }
+        xSemaphoreTake(s_present.vsync, 0);
+        if (start - now > 100) {
+            esp_timer_start_once(s_present.pace_timer, start - now);
+            xSemaphoreTake(s_present.vsync, portMAX_DELAY);
+        }
+    }
+    s_present.grid_us = start;
+    return (uint32_t)slot;
+}
+
+/**
+ * @brief 经 LVGL 的 DMA 绘图缓冲区把帧缓冲区中的一块区域发送到面板
+ * 缓冲区分成两半交替使用：与 photo_mode_send() 相同，draw_bitmap 发送 CASET/RASET 时会等待
+ * 之前排队的颜色数据发完，所以要填充的这一半已经空闲，它的完成通知也已经到达
+ * @param pending 已排队、还没有取走完成通知的块数
+ */
+static esp_err_t frame_present_send(const lv_area_t *area, size_t half_px, int *next, int *pending)
+{
+    const uint16_t width = lv_area_get_width(area);
+    const size_t stride = (size_t)width * 2;
+    const uint32_t buf_rows = half_px / width;
+    for (int y = area->y1; y <= area->y2;) {
+        const int rows = LV_MIN((int)buf_rows, area->y2 - y + 1);
+        uint8_t *dst = s_present.bounce + (*next ? half_px * 2 : 0);
+        if (*pending > 1) {
+            xSemaphoreTake(s_present.trans_done, portMAX_DELAY);
+            (*pending)--;
+        }
+        const uint8_t *src = s_present.fb + ((size_t)y * BSP_LCD_H_RES + area->x1) * 2;
+        for (int r = 0; r < rows; r++) {
+            memcpy(dst + r * stride, src, stride);
+            src += BSP_LCD_H_RES * 2;
+        }
+        esp_err_t err = esp_lcd_panel_draw_bitmap(s_present.panel, area->x1, y, area->x2 + 1, y + rows, dst);
+        if (err != ESP_OK) {
+            return err;
+        }
+        (*pending)++;
+        *next ^= 1;
+        y += rows;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 一次刷新渲染完成：按从上到下的顺序在一次发送中送出所有区域（发送任务中调用）
+ */
+static void frame_present_frame(lv_disp_drv_t *drv)
+{
+    // 插入排序：区域很少，而且 LVGL 通常已经按顺序刷新
+    for (int i = 1; i < s_present.area_count; i++) {
+        const lv_area_t a = s_present.areas[i];
+        int j = i - 1;
+        for (; j >= 0 && s_present.areas[j].y1 > a.y1; j--) {
+            s_present.areas[j + 1] = s_present.areas[j];
+        }
+        s_present.areas[j + 1] = a;
+    }
+
+    uint32_t period_us;
+    const uint32_t budget_us = frame_present_wait(&period_us);
+    const int64_t start = esp_timer_get_time();
+    uint32_t bytes = 0;
+    int next = 0;
+    int pending = 0;
+    s_present.sending = true;
+    for (int i = 0; i < s_present.area_count; i++) {
+        if (frame_present_send(&s_present.areas[i], drv->draw_buf->size / 2, &next, &pending) != ESP_OK) {
+            ESP_LOGE(TAG, "draw_bitmap failed");
+            break;
+        }
+        bytes += lv_area_get_size(&s_present.areas[i]) * 2;
+    }
+    // 等所有块发送完毕，之后 LVGL 才能重新使用绘图缓冲区
+    for (; pending > 0; pending--) {
+        xSemaphoreTake(s_present.trans_done, portMAX_DELAY);
+    }
+    s_present.sending = false;
+    const uint32_t flush_us = (uint32_t)(esp_timer_get_time() - start);
+    s_present.area_count = 0;
+
+    if (bytes == BSP_LCD_H_RES * BSP_LCD_V_RES * 2) {
+        s_present.flush_avg_us = s_present.flush_avg_us ? (s_present.flush_avg_us * 7 + flush_us) / 8 : flush_us;
+    }
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.frames++;
+    if (flush_us > budget_us) {
+        s_stats.late++;
+    }
+    s_stats.flush_us = flush_us;
+    if (flush_us > s_stats.max_flush_us) {
+        s_stats.max_flush_us = flush_us;
+    }
+    s_stats.budget_us = budget_us;
+    s_stats.period_us = period_us;
+    s_stats.bytes = bytes;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void frame_present_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        frame_present_frame(s_present.drv);
+        lv_disp_flush_ready(s_present.drv);
+        xSemaphoreGive(s_present.idle);
+    }
+}
+
+/**
+ * @brief 代替 esp_lvgl_port 的 flush 回调：只复制到帧缓冲区，最后一块交给发送任务
+ * 最后一块的 flush 在发送完成后才结束：在这之前 LVGL 不会再调用 flush 回调，也不会渲染到
+ * 这块绘图缓冲区，帧缓冲区和区域列表只由发送任务使用
+ */
+static void frame_present_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const size_t stride = (size_t)lv_area_get_width(area) * 2;
+    const uint8_t *src = (const uint8_t *)color_map;
+    for (int y = area->y1; y <= area->y2; y++) {
+        memcpy(s_present.fb + ((size_t)y * BSP_LCD_H_RES + area->x1) * 2, src, stride);
+        src += stride;
+    }
+    frame_present_add_area(area);
+    if (lv_disp_flush_is_last(drv)) {
+        s_present.bounce = (uint8_t *)color_map;
+        xTaskNotifyGive(s_present.task);
+        return;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+/**
+ * @brief LVGL 等待 flush 完成时睡眠，而不是空转
+ */
+static void frame_present_wait_cb(lv_disp_drv_t *drv)
+{
+    xSemaphoreTake(s_present.idle, pdMS_TO_TICKS(FRAME_PRESENT_WAIT_MS));
+}
+
+static esp_err_t frame_present_te_init(int te_gpio)
+{
+    // 只在垂直消隐期间输出 TE（TEON 参数 0）
+    uint8_t mode = 0;
+    esp_lcd_panel_io_tx_param(s_present.io, LCD_CMD_TEON, &mode, 1);
+    const uint8_t frmctr1[] = { 0x00, FRAME_PRESENT_TE_RTNA };
+    esp_lcd_panel_io_tx_param(s_present.io, FRAME_PRESENT_CMD_FRMCTR1, frmctr1, sizeof(frmctr1));
+
+    const gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << te_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_install_isr_service(0);
+    // 触摸驱动可能已经安装过
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+    return gpio_isr_handler_add(te_gpio, frame_present_te_isr, NULL);
+}
+
+esp_err_t frame_present_init(lv_disp_t *disp, int te_gpio)
+{
+    const lvgl_port_ctx_disp_t *port = lvgl_port_ctx_disp(disp);
+    if (!port) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_present.io = port->io_handle;
+    s_present.panel = port->panel_handle;
+    s_present.te_gpio = te_gpio;
+
+    s_present.fb = heap_caps_calloc(1, BSP_LCD_H_RES * BSP_LCD_V_RES * 2, MALLOC_CAP_SPIRAM);
+    s_present.vsync = xSemaphoreCreateBinary();
+    s_present.trans_done = xSemaphoreCreateCounting(2, 0);
+    s_present.idle = xSemaphoreCreateBinary();
+    s_present.drv = disp->driver;
+    const esp_timer_create_args_t pace_args = {
+        .callback = frame_present_pace_cb,
+        .name = "frame_pace",
+    };
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (!s_present.fb || !s_present.vsync || !s_present.trans_done || !s_present.idle) {
+        goto err;
+    }
+    ret = esp_timer_create(&pace_args, &s_present.pace_timer);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+    if (xTaskCreate(frame_present_task, "frame_present", FRAME_PRESENT_TASK_STACK, NULL, FRAME_PRESENT_TASK_PRIO,
+                    &s_present.task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+
+    if (!bsp_display_lock(0)) {
+        ret = ESP_ERR_TIMEOUT;
+        goto err;
+    }
+    if (te_gpio >= 0) {
+        esp_err_t err = frame_present_te_init(te_gpio);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "TE on GPIO %d not available (%s), pacing frames", te_gpio, esp_err_to_name(err));
+            s_present.te_gpio = -1;
+        }
+    }
+    s_stats.te = s_present.te_gpio >= 0;
+    // 等 LVGL 的最后一块发送完成，之后由发送任务而不是 esp_lvgl_port 处理面板 IO 的完成通知
+    while (disp->driver->draw_buf->flushing) {
+        vTaskDelay(1);
+    }
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = frame_present_trans_done,
+    };
+    esp_lcd_panel_io_register_event_callbacks(s_present.io, &cbs, NULL);
+    disp->driver->flush_cb = frame_present_flush_cb;
+    disp->driver->wait_cb = frame_present_wait_cb;
+    // 帧缓冲区是空的，先完整画一次
+    lv_obj_invalidate(lv_disp_get_scr_act(disp));
+    bsp_display_unlock();
+    ESP_LOGI(TAG, "Full-frame presentation, %s", s_stats.te ? "TE sync" : "paced");
+    return ESP_OK;
+
+err:
+    // 还没有接管 flush 回调，释放已经创建的部分，LVGL 照常直接发送
+    ESP_LOGE(TAG, "Full-frame presentation not started: %s", esp_err_to_name(ret));
+    if (s_present.task) {
+        vTaskDelete(s_present.task);
+    }
+    if (s_present.pace_timer) {
+        esp_timer_delete(s_present.pace_timer);
+    }
+    if (s_present.idle) {
+        vSemaphoreDelete(s_present.idle);
+    }
+    if (s_present.trans_done) {
+        vSemaphoreDelete(s_present.trans_done);
+    }
+    if (s_present.vsync) {
+        vSemaphoreDelete(s_present.vsync);
+    }
+    heap_caps_free(s_present.fb);
+    memset(&s_present, 0, sizeof(s_present));
+    return ret;
+}
+
+void frame_present_get_stats(frame_present_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
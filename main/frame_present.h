@@ -0,0 +1,80 @@
+/*
+ * Frame presentation
+ * LVGL renders into a full-screen PSRAM framebuffer; when a refresh is
+ * complete its dirty areas are sent to the panel in one pass, started on the
+ * panel's TE (tearing effect) signal or on a paced frame grid
+ */
+
+#ifndef FRAME_PRESENT_H
+#define FRAME_PRESENT_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counters since frame_present_init()
+ */
+typedef struct {
+    bool te;                        // Frames start on the TE signal (false: paced)
+    uint32_t frames;                // Refreshes sent to the panel
+    uint32_t late;                  // Frames whose flush did not fit the budget
+    uint32_t te_timeouts;           // TE edges that did not arrive (frame sent paced)
+    uint32_t flush_us;              // Last flush, from the first pixel sent to the last
+    uint32_t max_flush_us;
+    uint32_t budget_us;             // TE: two panel refresh periods; paced: the frame slot
+    uint32_t period_us;             // Panel refresh period (measured from TE, nominal otherwise)
+    uint32_t bytes;                 // Pixel bytes of the last frame
+} frame_present_stats_t;
+
+/**
+ * @brief Replace the flush callback of an esp_lvgl_port display
+ *
+ * The flush callback only copies each rendered chunk into the framebuffer
+ * (LVGL can render the next chunk at once). The last chunk of a refresh is
+ * handed to a present task, which waits for TE or the frame slot without
+ * holding the display lock, sorts the dirty areas top to bottom and sends
+ * them through the two halves of that chunk's DMA draw buffer, so no extra
+ * internal RAM is used; that flush completes when the frame is sent. The
+ * panel IO's transfer-done callback is taken over from esp_lvgl_port (which
+ * would complete LVGL's flush after every bounce transfer), and a wait_cb
+ * lets LVGL sleep while it waits for the present task.
+ *
+ * With a TE GPIO the panel's TE output is enabled and its frame rate set to
+ * 61 Hz: a transfer that starts on the TE edge and takes less than two
+ * refresh periods is never overtaken by the scan (a full 320x240 frame at
+ * 40 MHz takes about 31 ms, two periods are 33 ms). Without TE, frames start
+ * on a grid of whole nominal refresh periods sized to the measured flush
+ * time, so frames are shown at a steady rate; a frame is late when its
+ * flush overruns its slot.
+ *
+ * Call once with the display lock not held, after the display is started.
+ *
+ * @param disp Display added with lvgl_port_add_disp()
+ * @param te_gpio GPIO connected to the panel's TE pin, -1 if not wired
+ * @return
+ *      - ESP_ERR_INVALID_ARG if disp was not added with lvgl_port_add_disp()
+ *      - ESP_ERR_NO_MEM if the framebuffer, a semaphore or the task could not be created
+ *      - esp_timer errors for the pacing timer
+ *      - ESP_ERR_TIMEOUT if the display lock could not be taken
+ *      On failure everything allocated so far is released and the display is
+ *      left as it was. A TE pin that cannot be used is not an error; frames
+ *      are paced instead.
+ */
+esp_err_t frame_present_init(lv_disp_t *disp, int te_gpio);
+
+/**
+ * @brief Copy the counters (safe from any task)
+ */
+void frame_present_get_stats(frame_present_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_PRESENT_H
@@ -0,0 +1,274 @@
+/*
+ * Animated GIF player
+ * Frames are LZW-decoded ahead on the other core and drawn into an RGB565 canvas,
+ * only the changed rectangle is redrawn, at the pace of the GIF's own delays
+ */
+
+#include "gif_player.h"
+#include "gif_stream.h"
+#include "lvgl_wake.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <string.h>
+
+static const char *TAG = "gif_player";
+
+// 提前解码的帧数：一帧在画布上绘制时，另一帧已经在解码
+#define GIF_PLAYER_AHEAD        2
+// 解码没跟上时隔多久再检查
+#define GIF_PLAYER_RETRY_MS     5
+#define GIF_PLAYER_TASK_STACK   4096
+#define GIF_PLAYER_TASK_PRIO    3
+
+struct gif_player {
+    uint8_t *data;                  // GIF 文件的拷贝，循环播放时重复读取
+    gif_stream_t *gif;              // 只由解码任务使用
+    gif_stream_info_t info;
+    gif_stream_canvas_t canvas;     // 只在 LVGL 任务中绘制
+    image_buf_t *buf;               // 画布的引用
+    gif_stream_frame_t slots[GIF_PLAYER_AHEAD];
+    QueueHandle_t ready;            // 已解码、等待显示的帧
+    QueueHandle_t idle;             // 空闲的帧；收到 NULL 时解码任务退出
+    TaskHandle_t task;
+    lv_timer_t *timer;
+    lv_obj_t *obj;
+    atomic_bool finished;           // 播放次数已满或数据损坏，不会再有新帧
+    uint16_t plays;                 // 已完整播放的次数（解码任务）
+    uint16_t first_delay;           // 第一帧的显示时间
+    uint32_t due;                   // 下一帧应显示的时刻（lv_tick）
+    bool waiting;                   // 当前这一帧已记为迟到
+    uint32_t frames;                // 已显示的帧数
+    uint32_t late;                  // 到时间时还没解码好的帧数
+};
+
+static void gif_player_free(gif_player_t *p)
+{
+    for (int i = 0; i < GIF_PLAYER_AHEAD; i++) {
+        heap_caps_free(p->slots[i].indices);
+    }
+    if (p->ready) {
+        vQueueDelete(p->ready);
+    }
+    if (p->idle) {
+        vQueueDelete(p->idle);
+    }
+    gif_stream_close(p->gif);
+    gif_stream_canvas_deinit(&p->canvas);
+    heap_caps_free(p->data);
+    image_buf_unref(p->buf);
+    heap_caps_free(p);
+}
+
+static uint8_t *gif_player_alloc(size_t size)
+{
+    uint8_t *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+}
+
+esp_err_t gif_player_create(const uint8_t *data, size_t size, gif_player_t **player, image_buf_t **canvas)
+{
+    *player = NULL;
+    *canvas = NULL;
+    // 帧描述和调色板很小，放内部 RAM；文件和索引帧放 PSRAM
+    gif_player_t *p = heap_caps_calloc(1, sizeof(*p), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!p) {
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_init(&p->finished, false);
+    p->data = gif_player_alloc(size);
+    if (!p->data) {
+        gif_player_free(p);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(p->data, data, size);
+
+    gif_stream_cfg_t cfg = {
+        .swap_bytes = LV_COLOR_16_SWAP,
+    };
+    esp_err_t err = gif_stream_open(p->data, size, &cfg, &p->gif, &p->info);
+    if (err == ESP_OK) {
+        err = gif_stream_canvas_init(&p->canvas, &p->info, 0);
+    }
+    if (err != ESP_OK) {
+        gif_player_free(p);
+        return err;
+    }
+    // 画布的所有权交给图片缓冲区，播放器另持有一个引用
+    image_buf_t *buf = image_buf_create(p->canvas.pixels, p->canvas.size,
+                                        p->info.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR,
+                                        p->info.width, p->info.height);
+    if (!buf) {
+        gif_player_free(p);
+        return ESP_ERR_NO_MEM;
+    }
+    p->buf = image_buf_ref(buf);
+
+    const size_t px = (size_t)p->info.width * p->info.height;
+    const int slots = p->info.frames > 1 ? GIF_PLAYER_AHEAD : 1;
+    for (int i = 0; i < slots; i++) {
+        p->slots[i].indices = gif_player_alloc(px);
+        if (!p->slots[i].indices) {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    // 第一帧在这里同步解码，和静态图片一样显示
+    if (err == ESP_OK) {
+        err = gif_stream_next_frame(p->gif, &p->slots[0]);
+    }
+    if (err != ESP_OK) {
+        image_buf_unref(buf);
+        gif_player_free(p);
+        return err;
+    }
+    gif_stream_canvas_draw(&p->canvas, &p->slots[0], NULL);
+    p->first_delay = p->slots[0].delay_ms;
+    *canvas = buf;
+
+    if (p->info.frames == 1) {
+        gif_player_free(p);
+        return ESP_OK;
+    }
+
+    p->ready = xQueueCreate(GIF_PLAYER_AHEAD, sizeof(gif_stream_frame_t *));
+    p->idle = xQueueCreate(GIF_PLAYER_AHEAD + 1, sizeof(gif_stream_frame_t *));
+    if (!p->ready || !p->idle) {
+        gif_player_free(p);
+        image_buf_unref(buf);
+        *canvas = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < GIF_PLAYER_AHEAD; i++) {
+        gif_stream_frame_t *frame = &p->slots[i];
+        xQueueSend(p->idle, &frame, 0);
+    }
+    ESP_LOGI(TAG, "GIF %ux%u, %u frames, %u plays (0: forever)%s", p->info.width, p->info.height,
+             p->info.frames, p->info.plays, p->info.has_alpha ? ", with alpha" : "");
+    *player = p;
+    return ESP_OK;
+}
+
+/**
+ * @brief 解码任务：把空闲的帧解码好放进 ready 队列，最多领先 GIF_PLAYER_AHEAD 帧
+ * 退出时释放播放器（删除时的最后一步交给它，避免等它解码完当前帧）
+ */
+static void gif_player_task(void *arg)
+{
+    gif_player_t *p = (gif_player_t *)arg;
+    gif_stream_frame_t *frame;
+    while (xQueueReceive(p->idle, &frame, portMAX_DELAY) == pdTRUE && frame) {
+        if (atomic_load(&p->finished)) {
+            continue;   // 等待删除
+        }
+        if (gif_stream_next_frame(p->gif, frame) != ESP_OK) {
+            atomic_store(&p->finished, true);
+            continue;
+        }
+        if (frame->index == 0) {
+            // 从头开始的这一帧意味着又播完了一遍
+            p->plays++;
+            if (p->info.plays && p->plays >= p->info.plays) {
+                atomic_store(&p->finished, true);
+                continue;
+            }
+        }
+        xQueueSend(p->ready, &frame, portMAX_DELAY);
+    }
+    gif_player_free(p);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 在 LVGL 任务中显示下一帧，定时器周期就是这一帧的延时
+ */
+static void gif_player_timer_cb(lv_timer_t *timer)
+{
+    gif_player_t *p = (gif_player_t *)timer->user_data;
+    const uint32_t now = lv_tick_get();
+    gif_stream_frame_t *frame;
+    if (xQueueReceive(p->ready, &frame, 0) != pdTRUE) {
+        if (atomic_load(&p->finished)) {
+            // 最后一帧留在屏幕上
+            lv_timer_pause(timer);
+            return;
+        }
+        if (!p->waiting) {
+            p->late++;
+            p->waiting = true;
+        }
+        lv_timer_set_period(timer, GIF_PLAYER_RETRY_MS);
+        return;
+    }
+    p->waiting = false;
+
+    gif_stream_rect_t dirty;
+    gif_stream_canvas_draw(&p->canvas, frame, &dirty);
+    const uint16_t delay = frame->delay_ms;
+    xQueueSend(p->idle, &frame, 0);
+    p->frames++;
+
+    if (dirty.w) {
+        // 只重绘变化的矩形，并且马上刷新，不等下一个 LV_DISP_DEF_REFR_PERIOD
+        lv_area_t area;
+        lv_obj_get_coords(p->obj, &area);
+        area.x1 += dirty.x;
+        area.y1 += dirty.y;
+        area.x2 = area.x1 + dirty.w - 1;
+        area.y2 = area.y1 + dirty.h - 1;
+        lv_obj_invalidate_area(p->obj, &area);
+        lv_refr_now(lv_obj_get_disp(p->obj));
+    }
+
+    // 下一帧的时间从这一帧应该出现的时刻算起，绘制和刷新的耗时不会累积；
+    // 落后超过一帧时不追赶，从现在重新计时
+    p->due += delay;
+    if ((int32_t)(p->due - now) <= 0) {
+        p->due = now + delay;
+    }
+    lv_timer_set_period(timer, p->due - now);
+}
+
+esp_err_t gif_player_start(gif_player_t *player, lv_obj_t *obj, BaseType_t decode_core)
+{
+    if (!player) {
+        return ESP_OK;
+    }
+    player->obj = obj;
+    // 定时器不产生失效区域：按需唤醒的 LVGL 任务此时可能正无限期地睡眠（刷新定时器和触摸读取都已暂停），
+    // 需要主动唤醒它来调度这个定时器；同时把 lv_tick 推进到现在，第一帧的延时从现在算起。
+    // 调用者持有显示锁，LVGL 任务要等锁释放后才运行，那时定时器已经创建好了
+    lvgl_wake();
+    player->due = lv_tick_get() + player->first_delay;
+    player->timer = lv_timer_create(gif_player_timer_cb, player->first_delay, player);
+    if (!player->timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(gif_player_task, "gif_decode", GIF_PLAYER_TASK_STACK, player,
+                                GIF_PLAYER_TASK_PRIO, &player->task, decode_core) != pdPASS) {
+        lv_timer_del(player->timer);
+        player->timer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void gif_player_delete(gif_player_t *player)
+{
+    if (!player) {
+        return;
+    }
+    if (player->timer) {
+        lv_timer_del(player->timer);
+        ESP_LOGI(TAG, "GIF stopped after %" PRIu32 " frames, %" PRIu32 " late", player->frames, player->late);
+    }
+    if (player->task) {
+        // 解码任务可能正在解码一帧：发送 NULL 让它之后退出并释放播放器
+        gif_stream_frame_t *stop = NULL;
+        xQueueSend(player->idle, &stop, portMAX_DELAY);
+    } else {
+        gif_player_free(player);
+    }
+}
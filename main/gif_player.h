@@ -0,0 +1,56 @@
+/*
+ * Animated GIF player
+ * Frames are LZW-decoded ahead on the other core and drawn into an RGB565 canvas,
+ * only the changed rectangle is redrawn, at the pace of the GIF's own delays
+ */
+
+#ifndef GIF_PLAYER_H
+#define GIF_PLAYER_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "lvgl.h"
+#include "image_buf.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gif_player gif_player_t;
+
+/**
+ * @brief Open a GIF and draw its first frame
+ *
+ * The file is copied, the caller keeps data. Still images (one frame) give
+ * no player, only the canvas.
+ *
+ * @param[out] player Player to start once the canvas is shown, NULL for a still image
+ * @param[out] canvas New image buffer with the first frame (LV_IMG_CF_TRUE_COLOR or LV_IMG_CF_RGB565A8)
+ * @return gif_stream_open() errors, ESP_ERR_NO_MEM, or ESP_FAIL if the first frame is corrupt
+ */
+esp_err_t gif_player_create(const uint8_t *data, size_t size, gif_player_t **player, image_buf_t **canvas);
+
+/**
+ * @brief Start decoding on decode_core and showing frames on obj (call with the display lock held)
+ *
+ * obj must show the canvas unscaled. Each frame is drawn from an LVGL timer
+ * set to the frame's delay, only its dirty rectangle is invalidated, and the
+ * screen is refreshed right away instead of on the next display refresh
+ * period. NULL is ignored.
+ */
+esp_err_t gif_player_start(gif_player_t *player, lv_obj_t *obj, BaseType_t decode_core);
+
+/**
+ * @brief Stop playback and free the player (call with the display lock held; NULL is ignored)
+ *
+ * The canvas stays valid for as long as the caller holds references to it.
+ */
+void gif_player_delete(gif_player_t *player);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GIF_PLAYER_H
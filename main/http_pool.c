@@ -0,0 +1,121 @@
+/*
+ * HTTP connection pool
+ * Keeps one esp_http_client per origin so repeated downloads from the same
+ * host reuse the HTTP/1.1 connection and, after it drops, the TLS session
+ */
+
+#include "http_pool.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "http_pool";
+
+#define HTTP_POOL_ORIGIN_MAX 128
+
+typedef struct {
+    char origin[HTTP_POOL_ORIGIN_MAX];  // scheme://host[:port]
+    esp_http_client_handle_t client;    // NULL = free slot
+    uint32_t last_used;                 // LRU stamp
+} http_pool_entry_t;
+
+static http_pool_entry_t s_entries[CONFIG_DISPLAY_HTTP_POOL_SIZE];
+static uint32_t s_clock = 0;
+
+/**
+ * @brief Copy the scheme://host[:port] part of url into origin
+ */
+static bool http_pool_origin(const char *url, char origin[HTTP_POOL_ORIGIN_MAX]) {
+    const char *host = strstr(url, "://");
+    if (host == NULL) return false;
+    host += 3;
+    size_t len = (host - url) + strcspn(host, "/?#");
+    if (len >= HTTP_POOL_ORIGIN_MAX) return false;
+    memcpy(origin, url, len);
+    origin[len] = '\0';
+    return true;
+}
+
+static http_pool_entry_t *http_pool_find(esp_http_client_handle_t client) {
+    for (int i = 0; i < CONFIG_DISPLAY_HTTP_POOL_SIZE; i++) {
+        if (s_entries[i].client == client) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_http_client_handle_t http_pool_acquire(const char *url, http_event_handle_cb handler, void *user_data, bool *reused) {
+    char origin[HTTP_POOL_ORIGIN_MAX];
+    *reused = false;
+    if (!http_pool_origin(url, origin)) {
+        ESP_LOGE(TAG, "Invalid URL: %s", url);
+        return NULL;
+    }
+
+    for (int i = 0; i < CONFIG_DISPLAY_HTTP_POOL_SIZE; i++) {
+        http_pool_entry_t *e = &s_entries[i];
+        if (e->client && strcasecmp(e->origin, origin) == 0) {
+            // 同一主机：只换路径，连接和 TLS 会话保留
+            if (esp_http_client_set_url(e->client, url) != ESP_OK) {
+                http_pool_discard(e->client);
+                break;
+            }
+            esp_http_client_set_user_data(e->client, user_data);
+            e->last_used = ++s_clock;
+            *reused = true;
+            return e->client;
+        }
+    }
+
+    // 新主机：优先用空位，否则替换最久未用的连接
+    http_pool_entry_t *slot = &s_entries[0];
+    for (int i = 1; i < CONFIG_DISPLAY_HTTP_POOL_SIZE && slot->client; i++) {
+        http_pool_entry_t *e = &s_entries[i];
+        if (!e->client || e->last_used < slot->last_used) {
+            slot = e;
+        }
+    }
+
+    if (slot->client) {
+        ESP_LOGI(TAG, "Closing idle connection to %s", slot->origin);
+        esp_http_client_cleanup(slot->client);
+        slot->client = NULL;
+    }
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = handler,
+        .user_data = user_data,
+        .timeout_ms = 30000,  // 增加到30秒
+        .skip_cert_common_name_check = true,
+        .keep_alive_enable = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        // 连接断开后重连时用会话票据恢复 TLS，省去完整握手
+        .save_client_session = true,
+#endif
+    };
+    slot->client = esp_http_client_init(&config);
+    if (slot->client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        return NULL;
+    }
+    strcpy(slot->origin, origin);
+    slot->last_used = ++s_clock;
+    return slot->client;
+}
+
+void http_pool_release(esp_http_client_handle_t client, bool keep_alive) {
+    if (client && !keep_alive) {
+        esp_http_client_close(client);
+    }
+}
+
+void http_pool_discard(esp_http_client_handle_t client) {
+    http_pool_entry_t *e = http_pool_find(client);
+    esp_http_client_cleanup(client);
+    if (e) {
+        memset(e, 0, sizeof(*e));
+    }
+}
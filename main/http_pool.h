@@ -0,0 +1,51 @@
+/*
+ * HTTP connection pool
+ * Keeps one esp_http_client per origin so repeated downloads from the same
+ * host reuse the HTTP/1.1 connection and, after it drops, the TLS session
+ * Not thread safe: only the download task uses it
+ */
+
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include "esp_http_client.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get a client for url, reusing the pooled one for the same origin
+ *
+ * The least recently used client is cleaned up when the pool is full.
+ *
+ * @param url Full request URL (http:// or https://)
+ * @param handler Event handler for new clients (e.g. to read response headers)
+ * @param user_data Passed to handler in evt->user_data
+ * @param[out] reused true if the client came from the pool (its connection
+ *             may have been closed by the server in the meantime)
+ * @return Client with url set, or NULL on error
+ */
+esp_http_client_handle_t http_pool_acquire(const char *url, http_event_handle_cb handler, void *user_data, bool *reused);
+
+/**
+ * @brief Return a client to the pool
+ *
+ * @param client Client from http_pool_acquire()
+ * @param keep_alive true if the response was read completely and the
+ *        connection can carry the next request; false closes the socket but
+ *        keeps the client (and its TLS session ticket) for the next request
+ */
+void http_pool_release(esp_http_client_handle_t client, bool keep_alive);
+
+/**
+ * @brief Drop a client whose connection failed, it is cleaned up
+ */
+void http_pool_discard(esp_http_client_handle_t client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_POOL_H
@@ -0,0 +1,62 @@
+/*
+ * Refcounted image buffer
+ * Pixel (or encoded) image data shared by the image cache and the screen
+ */
+
+#include "image_buf.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <assert.h>
+#include <stdlib.h>
+
+static const char *TAG = "image_buf";
+
+static atomic_int s_live_count = 0;
+
+image_buf_t *image_buf_create(uint8_t *data, size_t size, lv_img_cf_t cf, uint16_t width, uint16_t height)
+{
+    image_buf_t *buf = malloc(sizeof(image_buf_t));
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate image buffer");
+        heap_caps_free(data);
+        return NULL;
+    }
+    buf->data = data;
+    buf->size = size;
+    buf->width = width;
+    buf->height = height;
+    buf->cf = cf;
+    atomic_init(&buf->refs, 1);
+    atomic_fetch_add(&s_live_count, 1);
+    return buf;
+}
+
+image_buf_t *image_buf_ref(image_buf_t *buf)
+{
+    if (buf) {
+        int prev = atomic_fetch_add(&buf->refs, 1);
+        assert(prev > 0);  // 不能复活已释放的缓冲区
+        (void)prev;
+    }
+    return buf;
+}
+
+void image_buf_unref(image_buf_t *buf)
+{
+    if (buf == NULL) {
+        return;
+    }
+    int prev = atomic_fetch_sub(&buf->refs, 1);
+    assert(prev > 0);  // 重复释放
+    if (prev == 1) {
+        heap_caps_free(buf->data);
+        buf->data = NULL;
+        free(buf);
+        atomic_fetch_sub(&s_live_count, 1);
+    }
+}
+
+int image_buf_live_count(void)
+{
+    return atomic_load(&s_live_count);
+}
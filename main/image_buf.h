@@ -0,0 +1,56 @@
+/*
+ * Refcounted image buffer
+ * Pixel (or encoded) image data shared by the image cache and the screen
+ */
+
+#ifndef IMAGE_BUF_H
+#define IMAGE_BUF_H
+
+#include "lvgl.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Image buffer, freed together with its data when the last reference is dropped
+ */
+typedef struct image_buf {
+    uint8_t *data;          // heap_caps allocated image data
+    size_t size;            // Size of data in bytes
+    uint16_t width;         // 0 for encoded data (LV_IMG_CF_UNKNOWN)
+    uint16_t height;
+    lv_img_cf_t cf;         // LV_IMG_CF_TRUE_COLOR, LV_IMG_CF_RGB565A8 or LV_IMG_CF_UNKNOWN
+    atomic_int refs;
+} image_buf_t;
+
+/**
+ * @brief Wrap data in a new image buffer with one reference
+ *
+ * Ownership of data moves to the buffer, also when NULL is returned.
+ */
+image_buf_t *image_buf_create(uint8_t *data, size_t size, lv_img_cf_t cf, uint16_t width, uint16_t height);
+
+/**
+ * @brief Take an additional reference
+ */
+image_buf_t *image_buf_ref(image_buf_t *buf);
+
+/**
+ * @brief Drop a reference, the last one frees the buffer and its data
+ */
+void image_buf_unref(image_buf_t *buf);
+
+/**
+ * @brief Number of image buffers currently alive (leak check)
+ */
+int image_buf_live_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMAGE_BUF_H
@@ -0,0 +1,90 @@
+/*
+ * Decoded image cache
+ * Keeps recently shown RGB565 images keyed by a hash of their encoded bytes
+ */
+
+#include "image_cache.h"
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "image_cache";
+
+typedef struct {
+    uint8_t key[IMAGE_CACHE_KEY_LEN];   // Hash of the encoded image
+    image_buf_t *buf;                   // Cache reference, NULL = free slot
+    uint32_t last_used;                 // LRU stamp
+} image_cache_entry_t;
+
+static image_cache_entry_t s_entries[CONFIG_DISPLAY_IMAGE_CACHE_ENTRIES];
+static uint32_t s_clock = 0;
+
+void image_cache_key(const uint8_t *data, size_t len, uint8_t key[IMAGE_CACHE_KEY_LEN])
+{
+    // SHA-256 使用硬件加速，300KB 的 JPEG 只需几毫秒
+    mbedtls_sha256(data, len, key, 0);
+}
+
+void image_cache_key_start(mbedtls_sha256_context *ctx)
+{
+    mbedtls_sha256_init(ctx);
+    mbedtls_sha256_starts(ctx, 0);
+}
+
+void image_cache_key_update(mbedtls_sha256_context *ctx, const uint8_t *data, size_t len)
+{
+    mbedtls_sha256_update(ctx, data, len);
+}
+
+void image_cache_key_finish(mbedtls_sha256_context *ctx, uint8_t key[IMAGE_CACHE_KEY_LEN])
+{
+    mbedtls_sha256_finish(ctx, key);
+    mbedtls_sha256_free(ctx);
+}
+
+image_buf_t *image_cache_get(const uint8_t key[IMAGE_CACHE_KEY_LEN])
+{
+    for (int i = 0; i < CONFIG_DISPLAY_IMAGE_CACHE_ENTRIES; i++) {
+        image_cache_entry_t *e = &s_entries[i];
+        if (e->buf && memcmp(e->key, key, IMAGE_CACHE_KEY_LEN) == 0) {
+            e->last_used = ++s_clock;
+            return image_buf_ref(e->buf);
+        }
+    }
+    return NULL;
+}
+
+void image_cache_reserve(void)
+{
+    image_cache_entry_t *lru = NULL;
+
+    for (int i = 0; i < CONFIG_DISPLAY_IMAGE_CACHE_ENTRIES; i++) {
+        image_cache_entry_t *e = &s_entries[i];
+        if (!e->buf) {
+            return;  // 已有空位
+        }
+        if (!lru || e->last_used < lru->last_used) {
+            lru = e;
+        }
+    }
+
+    // 只释放缓存的引用，屏幕上的图片由显示模块的引用保持有效
+    ESP_LOGI(TAG, "Evicting %ux%u image (%zu bytes)", lru->buf->width, lru->buf->height, lru->buf->size);
+    image_buf_unref(lru->buf);
+    memset(lru, 0, sizeof(*lru));
+}
+
+void image_cache_put(const uint8_t key[IMAGE_CACHE_KEY_LEN], image_buf_t *buf)
+{
+    image_cache_reserve();
+    for (int i = 0; i < CONFIG_DISPLAY_IMAGE_CACHE_ENTRIES; i++) {
+        image_cache_entry_t *e = &s_entries[i];
+        if (!e->buf) {
+            memcpy(e->key, key, IMAGE_CACHE_KEY_LEN);
+            e->buf = image_buf_ref(buf);
+            e->last_used = ++s_clock;
+            return;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Decoded image cache
+ * Keeps recently shown RGB565 images keyed by a hash of their encoded bytes
+ * Not thread safe: callers serialize access (display_image.c holds s_image_mutex)
+ */
+
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include "esp_err.h"
+#include "image_buf.h"
+#include "mbedtls/sha256.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMAGE_CACHE_KEY_LEN 32  // SHA-256
+
+/**
+ * @brief Compute the cache key of an encoded image
+ */
+void image_cache_key(const uint8_t *data, size_t len, uint8_t key[IMAGE_CACHE_KEY_LEN]);
+
+/**
+ * @brief Incremental variant of image_cache_key() for streamed data
+ */
+void image_cache_key_start(mbedtls_sha256_context *ctx);
+void image_cache_key_update(mbedtls_sha256_context *ctx, const uint8_t *data, size_t len);
+void image_cache_key_finish(mbedtls_sha256_context *ctx, uint8_t key[IMAGE_CACHE_KEY_LEN]);
+
+/**
+ * @brief Look up a decoded image and mark it most recently used
+ * @return New reference to the image (release with image_buf_unref) or NULL on miss
+ */
+image_buf_t *image_cache_get(const uint8_t key[IMAGE_CACHE_KEY_LEN]);
+
+/**
+ * @brief Drop the least recently used entry if the cache is full
+ *
+ * Call this before decoding so the evicted image can be freed first. The
+ * data is only released once nothing else (e.g. the screen) holds it.
+ */
+void image_cache_reserve(void);
+
+/**
+ * @brief Insert a decoded image, the cache takes its own reference
+ */
+void image_cache_put(const uint8_t key[IMAGE_CACHE_KEY_LEN], image_buf_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMAGE_CACHE_H
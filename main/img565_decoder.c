@@ -0,0 +1,265 @@
+/*
+ * IMG565 image decoder for LVGL
+ * Shows IMG565 sources (components/img565) with zero copies when the tiles are raw
+ */
+
+#include "img565_decoder.h"
+#include "img565.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "img565_decoder";
+
+typedef struct {
+    img565_header_t hdr;
+    const uint8_t *data;        // C 数组源的整个文件；NULL 时从 file 读取
+    lv_fs_file_t file;
+    uint8_t *table;             // 分片结束偏移表（C 数组源时指向 data 内部）
+    uint32_t payload;           // 第一个分片数据在文件中的偏移
+    uint8_t *tile;              // 当前分片：颜色平面，之后是透明度平面
+    uint8_t *scratch;           // 文件源：一个分片的压缩数据
+    int32_t tile_idx;           // tile 中是哪个分片，-1 表示空
+} img565_dec_t;
+
+static inline uint32_t img565_dec_end(const img565_dec_t *ctx, int tile)
+{
+    const uint8_t *p = ctx->table + tile * 4;
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint32_t img565_dec_start(const img565_dec_t *ctx, int tile)
+{
+    return tile ? img565_dec_end(ctx, tile - 1) : 0;
+}
+
+/**
+ * @brief 读取文件头：C 数组直接解析，文件读取前 16 字节
+ */
+static lv_res_t img565_dec_header(lv_img_src_t type, const void *src, img565_header_t *hdr)
+{
+    if (type == LV_IMG_SRC_VARIABLE) {
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+        // 已知格式的像素数组交给内置解码器
+        if (img->header.cf != LV_IMG_CF_UNKNOWN && img->header.cf != LV_IMG_CF_RAW) {
+            return LV_RES_INV;
+        }
+        return img565_parse_header(img->data, img->data_size, hdr) == ESP_OK ? LV_RES_OK : LV_RES_INV;
+    }
+    if (type != LV_IMG_SRC_FILE || strcmp(lv_fs_get_ext((const char *)src), "i565") != 0) {
+        return LV_RES_INV;
+    }
+
+    lv_fs_file_t file;
+    if (lv_fs_open(&file, (const char *)src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        return LV_RES_INV;
+    }
+    uint8_t head[IMG565_HEADER_SIZE];
+    uint32_t rn = 0;
+    lv_fs_res_t res = lv_fs_read(&file, head, sizeof(head), &rn);
+    lv_fs_close(&file);
+    if (res != LV_FS_RES_OK || rn != sizeof(head)) {
+        return LV_RES_INV;
+    }
+    return img565_parse_header(head, sizeof(head), hdr) == ESP_OK ? LV_RES_OK : LV_RES_INV;
+}
+
+static lv_res_t img565_dec_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    LV_UNUSED(decoder);
+
+    img565_header_t hdr;
+    if (img565_dec_header(lv_img_src_get_type(src), src, &hdr) != LV_RES_OK) {
+        return LV_RES_INV;
+    }
+    // lv_img_header_t 的宽高只有 11 位
+    if (hdr.width > 2047 || hdr.height > 2047) {
+        ESP_LOGW(TAG, "%ux%u is too large for LVGL", hdr.width, hdr.height);
+        return LV_RES_INV;
+    }
+    header->always_zero = 0;
+    header->cf = (hdr.flags & IMG565_FLAG_ALPHA) ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR;
+    header->w = hdr.width;
+    header->h = hdr.height;
+    return LV_RES_OK;
+}
+
+static void img565_dec_free(img565_dec_t *ctx)
+{
+    if (!ctx->data) {
+        if (ctx->file.drv) {
+            lv_fs_close(&ctx->file);
+        }
+        free(ctx->table);
+    }
+    free(ctx->tile);
+    free(ctx->scratch);
+    free(ctx);
+}
+
+/**
+ * @brief 检查分片表：偏移不递减，数据都在文件内
+ * @return 最大的分片数据长度，出错返回 0
+ */
+static size_t img565_dec_check_table(const img565_dec_t *ctx, size_t file_size)
+{
+    size_t max_len = 0;
+    for (int i = 0; i < ctx->hdr.tiles; i++) {
+        uint32_t start = img565_dec_start(ctx, i), end = img565_dec_end(ctx, i);
+        if (end < start) {
+            return 0;
+        }
+        if (end - start > max_len) {
+            max_len = end - start;
+        }
+    }
+    if (ctx->payload + (size_t)img565_dec_end(ctx, ctx->hdr.tiles - 1) > file_size) {
+        return 0;
+    }
+    return max_len;
+}
+
+static lv_res_t img565_dec_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    img565_dec_t *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        return LV_RES_INV;
+    }
+    ctx->tile_idx = -1;
+    if (img565_dec_header(dsc->src_type, dsc->src, &ctx->hdr) != LV_RES_OK) {
+        free(ctx);
+        return LV_RES_INV;
+    }
+    const size_t table_size = img565_table_size(&ctx->hdr);
+    ctx->payload = IMG565_HEADER_SIZE + table_size;
+
+    size_t file_size, max_len;
+    if (dsc->src_type == LV_IMG_SRC_VARIABLE) {
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)dsc->src;
+        ctx->data = img->data;
+        ctx->table = (uint8_t *)img->data + IMG565_HEADER_SIZE;
+        file_size = img->data_size;
+        if (file_size < ctx->payload) {
+            img565_dec_free(ctx);
+            return LV_RES_INV;
+        }
+    } else {
+        uint32_t rn = 0;
+        ctx->table = malloc(table_size);
+        if (!ctx->table || lv_fs_open(&ctx->file, (const char *)dsc->src, LV_FS_MODE_RD) != LV_FS_RES_OK ||
+            lv_fs_seek(&ctx->file, IMG565_HEADER_SIZE, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+            lv_fs_read(&ctx->file, ctx->table, table_size, &rn) != LV_FS_RES_OK || rn != table_size ||
+            lv_fs_seek(&ctx->file, 0, LV_FS_SEEK_END) != LV_FS_RES_OK ||
+            lv_fs_tell(&ctx->file, &rn) != LV_FS_RES_OK) {
+            img565_dec_free(ctx);
+            return LV_RES_INV;
+        }
+        file_size = rn;
+    }
+    max_len = img565_dec_check_table(ctx, file_size);
+    if (!max_len) {
+        ESP_LOGW(TAG, "Corrupt tile table");
+        img565_dec_free(ctx);
+        return LV_RES_INV;
+    }
+
+#if LV_COLOR_16_SWAP
+    // 未压缩的 C 数组已经是 lv_color_t 的字节序：不带透明度时各分片首尾相连就是整张图，
+    // 带透明度时只有单个分片才是 RGB565A8 的平面布局，这两种情况直接交给 LVGL
+    const bool has_alpha = ctx->hdr.flags & IMG565_FLAG_ALPHA;
+    const size_t image_size = (size_t)ctx->hdr.width * ctx->hdr.height * (has_alpha ? 3 : 2);
+    if (ctx->data && ctx->hdr.compression == IMG565_RAW && (!has_alpha || ctx->hdr.tiles == 1) &&
+        img565_dec_end(ctx, ctx->hdr.tiles - 1) == image_size) {
+        dsc->img_data = ctx->data + ctx->payload;
+        dsc->user_data = ctx;
+        return LV_RES_OK;
+    }
+#endif
+
+    ctx->tile = malloc(img565_tile_size(&ctx->hdr, 0));
+    if (!ctx->tile || (!ctx->data && !(ctx->scratch = malloc(max_len)))) {
+        ESP_LOGW(TAG, "No memory for a %u-row tile", ctx->hdr.tile_rows);
+        img565_dec_free(ctx);
+        return LV_RES_INV;
+    }
+    dsc->img_data = NULL;  // 逐行读取
+    dsc->user_data = ctx;
+    return LV_RES_OK;
+}
+
+static lv_res_t img565_dec_load(img565_dec_t *ctx, int tile)
+{
+    const uint32_t start = img565_dec_start(ctx, tile);
+    const uint32_t len = img565_dec_end(ctx, tile) - start;
+    const uint8_t *src;
+    if (ctx->data) {
+        src = ctx->data + ctx->payload + start;
+    } else {
+        uint32_t rn = 0;
+        if (lv_fs_seek(&ctx->file, ctx->payload + start, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+            lv_fs_read(&ctx->file, ctx->scratch, len, &rn) != LV_FS_RES_OK || rn != len) {
+            return LV_RES_INV;
+        }
+        src = ctx->scratch;
+    }
+
+    const size_t px = (size_t)ctx->hdr.width * img565_tile_rows(&ctx->hdr, tile);
+    ctx->tile_idx = -1;
+    esp_err_t err = img565_decode_tile(&ctx->hdr, tile, src, len, ctx->tile, ctx->tile + px * 2, LV_COLOR_16_SWAP);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Tile %d is corrupt: %s", tile, esp_err_to_name(err));
+        return LV_RES_INV;
+    }
+    ctx->tile_idx = tile;
+    return LV_RES_OK;
+}
+
+static lv_res_t img565_dec_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc,
+                                     lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    LV_UNUSED(decoder);
+
+    img565_dec_t *ctx = (img565_dec_t *)dsc->user_data;
+    const int tile = y / ctx->hdr.tile_rows;
+    if (tile != ctx->tile_idx && img565_dec_load(ctx, tile) != LV_RES_OK) {
+        return LV_RES_INV;
+    }
+
+    // RGB565A8 的一行：len 个颜色，之后是 len 个透明度
+    const size_t px = (size_t)ctx->hdr.width * img565_tile_rows(&ctx->hdr, tile);
+    const size_t at = (size_t)(y - tile * ctx->hdr.tile_rows) * ctx->hdr.width + x;
+    memcpy(buf, ctx->tile + at * 2, len * 2);
+    if (ctx->hdr.flags & IMG565_FLAG_ALPHA) {
+        memcpy(buf + len * 2, ctx->tile + px * 2 + at, len);
+    }
+    return LV_RES_OK;
+}
+
+static void img565_dec_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    if (dsc->user_data) {
+        img565_dec_free((img565_dec_t *)dsc->user_data);
+        dsc->user_data = NULL;
+    }
+}
+
+esp_err_t img565_decoder_init(void)
+{
+#if LV_COLOR_DEPTH != 16
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    lv_img_decoder_t *dec = lv_img_decoder_create();
+    if (!dec) {
+        return ESP_ERR_NO_MEM;
+    }
+    lv_img_decoder_set_info_cb(dec, img565_dec_info);
+    lv_img_decoder_set_open_cb(dec, img565_dec_open);
+    lv_img_decoder_set_read_line_cb(dec, img565_dec_read_line);
+    lv_img_decoder_set_close_cb(dec, img565_dec_close);
+    return ESP_OK;
+#endif
+}
@@ -0,0 +1,31 @@
+/*
+ * IMG565 image decoder for LVGL
+ * Shows IMG565 sources (components/img565) with zero copies when the tiles are raw
+ */
+
+#ifndef IMG565_DECODER_H
+#define IMG565_DECODER_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the decoder (call with the display lock held)
+ *
+ * C arrays and .i565 files are accepted. A raw, panel-order array is handed
+ * to LVGL as it is (LV_IMG_CF_TRUE_COLOR or LV_IMG_CF_RGB565A8); compressed
+ * images are decompressed one tile at a time as LVGL reads lines.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED unless LV_COLOR_DEPTH is 16
+ */
+esp_err_t img565_decoder_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMG565_DECODER_H
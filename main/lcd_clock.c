@@ -0,0 +1,291 @@
+/*
+ * LCD pixel clock
+ * Runs a requested pixel clock calibration at boot and reopens the display's
+ * SPI panel IO and panel at the clock stored in the display settings
+ */
+
+#include "lcd_clock.h"
+#include "lcd_clock_cal.h"
+#include "lvgl_port_ctx.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_ili9341.h"
+#include "esp_lcd_touch_tt21100.h"
+#include "esp_lvgl_port.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "freertos/task.h"
+#include <inttypes.h>
+
+static const char *TAG = "lcd_clock";
+
+/*
+ * ESP32-S3 的 SPI 主机时钟是 80MHz APB 时钟的整数分频（80/N MHz），BSP 的 40MHz（N=2）之上只有 N=1 的 80MHz 一档。
+ * 48/53/60MHz 这样的中间值驱动会向下取到可实现的 40MHz（spi_get_actual_clock()），只是把 BSP 的时钟重复标定一遍，
+ * 所以只试 80MHz
+ */
+static const uint32_t s_steps_hz[] = { 80 * 1000 * 1000 };
+// 读 GRAM 的周期比写慢得多（ILI9341 RAMRD 450ns），ID 和像素都以 2MHz 读回
+#define LCD_CLOCK_READ_HZ           (2 * 1000 * 1000)
+// 标定时每个时钟写入的图案数（三种图案各两次），启动时检查保存的时钟各一次
+#define LCD_CLOCK_CAL_ROUNDS        6
+#define LCD_CLOCK_CHECK_ROUNDS      3
+// 与 BSP 的 bsp_display_new() 相同
+#define LCD_CLOCK_CMD_BITS          8
+#define LCD_CLOCK_PARAM_BITS        8
+#define LCD_CLOCK_TRANS_QUEUE_DEPTH 10
+// 探测触摸控制器的 I2C 超时
+#define LCD_CLOCK_PROBE_TICKS       pdMS_TO_TICKS(100)
+
+// ILI9342C 的初始化命令，与 BSP（esp-box-3.c 的 vendor_specific_init）相同
+static const ili9341_lcd_init_cmd_t s_ili9342c_init[] = {
+    {0xC8, (uint8_t []){0xFF, 0x93, 0x42}, 3, 0},
+    {0xC0, (uint8_t []){0x0E, 0x0E}, 2, 0},
+    {0xC5, (uint8_t []){0xD0}, 1, 0},
+    {0xC1, (uint8_t []){0x02}, 1, 0},
+    {0xB4, (uint8_t []){0x02}, 1, 0},
+    {0xE0, (uint8_t []){0x00, 0x03, 0x08, 0x06, 0x13, 0x09, 0x39, 0x39, 0x48, 0x02, 0x0a, 0x08, 0x17, 0x17, 0x0F}, 15, 0},
+    {0xE1, (uint8_t []){0x00, 0x28, 0x29, 0x01, 0x0d, 0x03, 0x3f, 0x33, 0x52, 0x04, 0x0f, 0x0e, 0x37, 0x38, 0x0F}, 15, 0},
+
+    {0xB1, (uint8_t []){00, 0x1B}, 2, 0},
+    {0x36, (uint8_t []){0x08}, 1, 0},
+    {0x3A, (uint8_t []){0x55}, 1, 0},
+    {0xB7, (uint8_t []){0x06}, 1, 0},
+
+    {0x11, (uint8_t []){0}, 0x80, 0},
+    {0x29, (uint8_t []){0}, 0x80, 0},
+
+    {0, (uint8_t []){0}, 0xff, 0},
+};
+
+static uint32_t s_pclk_hz = BSP_LCD_PIXEL_CLOCK_HZ;
+
+/**
+ * @brief 以 pclk_hz 打开面板 IO，除时钟和 sio 外与 BSP 的配置相同
+ * sio：通过 MOSI 一根数据线读写（面板的 SDA 是双向的），用于读回
+ * 新的 IO 挂在 BSP 初始化的 SPI 总线上：总线的 max_transfer_sz 和 DMA 描述符按
+ * BSP_LCD_H_RES x CONFIG_BSP_LCD_DRAW_BUF_HEIGHT x 2 字节（默认 32000）分配，与时钟无关；
+ * 更大的 tx_color（整帧呈现、照片模式）由 esp_lcd 拆成这个大小的传输，80MHz 下每块约 3.2ms
+ */
+static esp_err_t lcd_clock_open_io(uint32_t pclk_hz, bool sio, esp_lcd_panel_io_handle_t *io)
+{
+    const esp_lcd_panel_io_spi_config_t io_config = {
+        .dc_gpio_num = BSP_LCD_DC,
+        .cs_gpio_num = BSP_LCD_CS,
+        .pclk_hz = pclk_hz,
+        .lcd_cmd_bits = LCD_CLOCK_CMD_BITS,
+        .lcd_param_bits = LCD_CLOCK_PARAM_BITS,
+        .spi_mode = 0,
+        .trans_queue_depth = LCD_CLOCK_TRANS_QUEUE_DEPTH,
+        .flags.sio_mode = sio,
+    };
+    return esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)BSP_LCD_SPI_NUM, &io_config, io);
+}
+
+static esp_err_t lcd_clock_cal_open(uint32_t pclk_hz, esp_lcd_panel_io_handle_t *io, void *ctx)
+{
+    return lcd_clock_open_io(pclk_hz, true, io);
+}
+
+static void lcd_clock_cal_close(esp_lcd_panel_io_handle_t io, void *ctx)
+{
+    esp_lcd_panel_io_del(io);
+}
+
+/**
+ * @brief 与 esp_lvgl_port 的回调相同：一块发送完成后通知 LVGL
+ */
+static bool lcd_clock_flush_ready(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    lv_disp_flush_ready((lv_disp_drv_t *)user_ctx);
+    return false;
+}
+
+/**
+ * @brief 与 bsp_display_new() 相同：I2C 上有 TT21100 触摸控制器的是 ST7789 面板，否则是 ILI9342C
+ * BSP 用旧版 I2C 驱动安装了 BSP_I2C_NUM，所以这里也只能用旧版接口探测
+ */
+static bool lcd_clock_is_st7789(void)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (ESP_LCD_TOUCH_IO_I2C_TT21100_ADDRESS << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_stop(cmd);
+    const bool found = i2c_master_cmd_begin(BSP_I2C_NUM, cmd, LCD_CLOCK_PROBE_TICKS) == ESP_OK;
+    i2c_cmd_link_delete(cmd);
+    return found;
+}
+
+/**
+ * @brief 删除 BSP 创建的面板对象（它的 IO 在标定前已经删除）
+ * 驱动的 del 会 gpio_reset_pin() 复位脚（改为输入并上拉），而复位脚与触摸共用、高电平复位：
+ * 删除期间用 gpio_hold_en() 锁住引脚的输出（低电平），再重新设为输出低电平后解除锁定，面板和触摸控制器都不会被复位
+ */
+static void lcd_clock_del_bsp_panel(esp_lcd_panel_handle_t panel)
+{
+    gpio_hold_en(BSP_LCD_RST);
+    esp_lcd_panel_del(panel);
+    gpio_pullup_dis(BSP_LCD_RST);
+    gpio_set_direction(BSP_LCD_RST, GPIO_MODE_OUTPUT);
+    gpio_set_level(BSP_LCD_RST, 0);
+    gpio_hold_dis(BSP_LCD_RST);
+}
+
+/**
+ * @brief 在 io 上创建并初始化面板，除复位外与 bsp_display_new() 相同
+ * 复位脚与触摸共用，所以不交给面板驱动：esp_lcd_panel_reset() 发送软件复位（SWRESET），
+ * 清除错误时钟下写入的数据可能改掉的寄存器
+ */
+static esp_err_t lcd_clock_new_panel(esp_lcd_panel_io_handle_t io, bool st7789, esp_lcd_panel_handle_t *panel)
+{
+    const ili9341_vendor_config_t vendor_config = {
+        .init_cmds = s_ili9342c_init,
+        .init_cmds_size = sizeof(s_ili9342c_init) / sizeof(s_ili9342c_init[0]),
+    };
+    esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = GPIO_NUM_NC,
+        .color_space = BSP_LCD_COLOR_SPACE,
+        .bits_per_pixel = BSP_LCD_BITS_PER_PIXEL,
+    };
+    esp_err_t err;
+    if (st7789) {
+        err = esp_lcd_new_panel_st7789(io, &panel_config, panel);
+    } else {
+        panel_config.vendor_config = (void *)&vendor_config;
+        err = esp_lcd_new_panel_ili9341(io, &panel_config, panel);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    esp_lcd_panel_reset(*panel);
+    esp_lcd_panel_init(*panel);
+    esp_lcd_panel_mirror(*panel, true, true);
+    return esp_lcd_panel_disp_on_off(*panel, true);
+}
+
+/**
+ * @brief 标定或检查，返回要使用的时钟（0 为 BSP 的时钟）
+ */
+static uint32_t lcd_clock_choose(display_settings_t *settings, bool *changed)
+{
+    lcd_clock_cal_config_t config = {
+        .open = lcd_clock_cal_open,
+        .close = lcd_clock_cal_close,
+        .base_hz = BSP_LCD_PIXEL_CLOCK_HZ,
+        .read_hz = LCD_CLOCK_READ_HZ,
+        .steps_hz = s_steps_hz,
+        .step_count = sizeof(s_steps_hz) / sizeof(s_steps_hz[0]),
+        .rounds = LCD_CLOCK_CAL_ROUNDS,
+    };
+    lcd_clock_cal_result_t result;
+    uint32_t pclk_hz = settings->lcd_pclk_hz;
+
+    if (settings->lcd_clock_calibrate) {
+        esp_err_t err = lcd_clock_calibrate(&config, &result);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "Calibrated: %" PRIu32 " Hz stable", result.pclk_hz);
+            pclk_hz = result.pclk_hz;
+        } else {
+            ESP_LOGW(TAG, "Calibration failed (%s), using %d Hz", esp_err_to_name(err), BSP_LCD_PIXEL_CLOCK_HZ);
+            pclk_hz = 0;
+        }
+        settings->lcd_clock_calibrate = false;
+        *changed = true;
+    } else if (pclk_hz > BSP_LCD_PIXEL_CLOCK_HZ) {
+        // 保存的时钟每次启动都再检查一遍，布线或温度变化后回到 BSP 的时钟
+        config.steps_hz = &pclk_hz;
+        config.step_count = 1;
+        config.rounds = LCD_CLOCK_CHECK_ROUNDS;
+        if (lcd_clock_calibrate(&config, &result) != ESP_OK || result.pclk_hz != pclk_hz) {
+            ESP_LOGW(TAG, "Stored %" PRIu32 " Hz failed its check, using %d Hz", pclk_hz, BSP_LCD_PIXEL_CLOCK_HZ);
+            pclk_hz = 0;
+            *changed = true;
+        }
+    }
+    return pclk_hz > BSP_LCD_PIXEL_CLOCK_HZ ? pclk_hz : 0;
+}
+
+uint32_t lcd_clock_init(lv_disp_t *disp, display_settings_t *settings)
+{
+    if (!settings->lcd_clock_calibrate && settings->lcd_pclk_hz <= BSP_LCD_PIXEL_CLOCK_HZ) {
+        return s_pclk_hz;   // 从未标定过，保留 BSP 的面板 IO
+    }
+    lvgl_port_ctx_disp_t *port = lvgl_port_ctx_disp(disp);
+    if (!port) {
+        return s_pclk_hz;
+    }
+
+    // 只在停止 LVGL 的定时器时持锁；之后 LVGL 任务不再刷新，标定期间不占用显示锁
+    bsp_display_lock(0);
+    lvgl_port_stop();
+    bsp_display_unlock();
+    // 等 LVGL 的最后一块发送完成，再删除 BSP 的面板 IO
+    while (disp->driver->draw_buf->flushing) {
+        vTaskDelay(1);
+    }
+    const bool st7789 = lcd_clock_is_st7789();
+    esp_lcd_panel_io_del(port->io_handle);
+    /*
+     * 面板驱动保存了旧的 IO 句柄且没有替换它的接口，所以在新的 IO 上重新创建面板；
+     * 旧的面板对象在 LVGL 换用新的句柄后删除
+     */
+    esp_lcd_panel_handle_t bsp_panel = port->panel_handle;
+    port->io_handle = NULL;
+    port->panel_handle = NULL;
+
+    bool changed = false;
+    const uint32_t stored_hz = lcd_clock_choose(settings, &changed);
+    settings->lcd_pclk_hz = stored_hz;
+    uint32_t pclk_hz = stored_hz ? stored_hz : BSP_LCD_PIXEL_CLOCK_HZ;
+
+    esp_lcd_panel_io_handle_t io = NULL;
+    esp_err_t err = lcd_clock_open_io(pclk_hz, false, &io);
+    if (err != ESP_OK && pclk_hz != BSP_LCD_PIXEL_CLOCK_HZ) {
+        ESP_LOGW(TAG, "No panel IO at %" PRIu32 " Hz (%s)", pclk_hz, esp_err_to_name(err));
+        pclk_hz = BSP_LCD_PIXEL_CLOCK_HZ;
+        settings->lcd_pclk_hz = 0;
+        changed = true;
+        err = lcd_clock_open_io(pclk_hz, false, &io);
+    }
+    esp_lcd_panel_handle_t panel = NULL;
+    if (err == ESP_OK) {
+        err = lcd_clock_new_panel(io, st7789, &panel);
+    }
+    if (err != ESP_OK) {
+        if (io) {
+            esp_lcd_panel_io_del(io);
+        }
+        // LVGL 保持停止，没有面板句柄时不再刷新
+        lcd_clock_del_bsp_panel(bsp_panel);
+        ESP_LOGE(TAG, "No panel at %" PRIu32 " Hz: %s", pclk_hz, esp_err_to_name(err));
+        s_pclk_hz = 0;
+        return 0;
+    }
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = lcd_clock_flush_ready,
+    };
+
+    bsp_display_lock(0);
+    esp_lcd_panel_io_register_event_callbacks(io, &cbs, disp->driver);
+    port->io_handle = io;
+    port->panel_handle = panel;
+    lv_obj_invalidate(lv_scr_act());
+    lvgl_port_resume();
+    bsp_display_unlock();
+    lcd_clock_del_bsp_panel(bsp_panel);
+
+    if (changed) {
+        display_settings_save(settings);
+    }
+    s_pclk_hz = pclk_hz;
+    ESP_LOGI(TAG, "Panel pixel clock %" PRIu32 " Hz (%s)", pclk_hz, st7789 ? "ST7789" : "ILI9342C");
+    return pclk_hz;
+}
+
+uint32_t lcd_clock_get_hz(void)
+{
+    return s_pclk_hz;
+}
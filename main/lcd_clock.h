@@ -0,0 +1,58 @@
+/*
+ * LCD pixel clock
+ * Runs a requested pixel clock calibration at boot and reopens the display's
+ * SPI panel IO and panel at the clock stored in the display settings
+ */
+
+#ifndef LCD_CLOCK_H
+#define LCD_CLOCK_H
+
+#include "display_settings.h"
+#include "lvgl.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Apply the stored pixel clock to an esp_lvgl_port display
+ *
+ * Does nothing while no clock is stored and no calibration is requested.
+ * Otherwise the BSP's panel IO (fixed at BSP_LCD_PIXEL_CLOCK_HZ) is deleted:
+ *   - a requested calibration (settings->lcd_clock_calibrate) tries the
+ *     clocks above the BSP's with lcd_clock_calibrate(), reading back over
+ *     the SPI data line (3-wire mode, the Box-3 has no MISO), and stores the
+ *     highest stable one
+ *   - a stored clock is checked again with a few patterns; if it fails, or
+ *     nothing can be read back, the BSP's clock is used and stored instead
+ * A new panel IO is then opened at the chosen clock and a new panel is
+ * created on it with the BSP's settings, software reset (SWRESET; the reset
+ * line is shared with the touch controller) and initialised; both replace
+ * the BSP's handles in the port. The LVGL lock is only held to stop and
+ * resume the port's timer and to swap the handles, not during calibration.
+ * The BSP's panel is then deleted, with the shared reset line held low while
+ * its driver resets the pin. bsp_display_enter_sleep() and
+ * bsp_display_exit_sleep() still point to that panel and must not be called
+ * afterwards.
+ *
+ * Call once after bsp_display_start_with_config() and before anything keeps
+ * the display's panel IO handle (display_pipeline_init(), frame_present_init()).
+ * Patterns are written to the top rows, so call it before the backlight is on.
+ *
+ * @param disp Display added with lvgl_port_add_disp()
+ * @param settings Loaded settings, updated and saved when the clock changes
+ * @return Pixel clock in use, 0 if no panel IO could be opened
+ */
+uint32_t lcd_clock_init(lv_disp_t *disp, display_settings_t *settings);
+
+/**
+ * @brief Pixel clock in use (BSP_LCD_PIXEL_CLOCK_HZ before lcd_clock_init())
+ */
+uint32_t lcd_clock_get_hz(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LCD_CLOCK_H
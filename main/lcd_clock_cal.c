@@ -0,0 +1,240 @@
+/*
+ * LCD pixel clock calibration
+ * Writes test patterns to the panel at rising SPI clocks and reads them back
+ * at a slow clock to find the highest clock the wiring carries without errors
+ */
+
+#include "lcd_clock_cal.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_commands.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "lcd_clock_cal";
+
+// 测试窗口：屏幕顶部 320x8（标定在打开背光之前进行，之后 LVGL 会重绘整屏）
+#define LCD_CLOCK_CAL_WIDTH         320
+#define LCD_CLOCK_CAL_HEIGHT        8
+#define LCD_CLOCK_CAL_PIXELS        (LCD_CLOCK_CAL_WIDTH * LCD_CLOCK_CAL_HEIGHT)
+// 读回的像素为 RGB666，每个分量一个字节（低位无效）；数据前最多 15 个空位
+// （RAMRD 的 dummy 字节、部分面板串口读取的 dummy 位）
+#define LCD_CLOCK_CAL_MAX_SHIFT     16
+#define LCD_CLOCK_CAL_RX_BYTES      (LCD_CLOCK_CAL_PIXELS * 3 + 4)
+// RDDID（04h）在串口上先有 1 位 dummy，单字节的 RDID1-3 没有，读同样的三个 ID
+#define LCD_CLOCK_CAL_CMD_RDID1     0xDA
+#define LCD_CLOCK_CAL_CMD_RDID2     0xDB
+#define LCD_CLOCK_CAL_CMD_RDID3     0xDC
+
+typedef struct {
+    uint8_t *tx;                    // 写入的 RGB565，高字节在前（面板接收的顺序）
+    uint8_t *rx;                    // RAMRD 读回的原始字节
+    unsigned pattern;               // 已写入的图案数，每次写入的图案都与上一次不同
+    int shift;                      // 读回数据前的空位数
+    bool bgr;                       // 读回顺序为 B、G、R
+} lcd_clock_cal_t;
+
+/**
+ * @brief 生成下一个图案：伪随机、相邻像素每一位都翻转、移动的单个 1 轮流使用
+ * 同一种图案每次的相位或种子不同，一次写入完全丢失也不会读回上一次的内容
+ */
+static void lcd_clock_cal_next_pattern(lcd_clock_cal_t *cal)
+{
+    const unsigned n = cal->pattern++;
+    uint32_t x = 0x9E3779B9u * (n + 1);
+    for (size_t p = 0; p < LCD_CLOCK_CAL_PIXELS; p++) {
+        uint16_t c;
+        switch (n % 3) {
+        case 0:
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            c = (uint16_t)x;
+            break;
+        case 1:
+            c = ((p + n) & 1) ? 0xAAAA : 0x5555;
+            break;
+        default:
+            c = (uint16_t)(1u << ((p + n) % 16));
+            break;
+        }
+        cal->tx[2 * p] = (uint8_t)(c >> 8);
+        cal->tx[2 * p + 1] = (uint8_t)c;
+    }
+}
+
+static esp_err_t lcd_clock_cal_set_window(esp_lcd_panel_io_handle_t io)
+{
+    const uint8_t caset[4] = { 0, 0, (LCD_CLOCK_CAL_WIDTH - 1) >> 8, (LCD_CLOCK_CAL_WIDTH - 1) & 0xFF };
+    const uint8_t raset[4] = { 0, 0, (LCD_CLOCK_CAL_HEIGHT - 1) >> 8, (LCD_CLOCK_CAL_HEIGHT - 1) & 0xFF };
+    esp_err_t err = esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, caset, sizeof(caset));
+    if (err == ESP_OK) {
+        err = esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, raset, sizeof(raset));
+    }
+    return err;
+}
+
+/**
+ * @brief 以 pclk_hz 写入当前图案
+ */
+static esp_err_t lcd_clock_cal_write(const lcd_clock_cal_t *cal, const lcd_clock_cal_config_t *config, uint32_t pclk_hz)
+{
+    esp_lcd_panel_io_handle_t io = NULL;
+    esp_err_t err = config->open(pclk_hz, &io, config->ctx);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = lcd_clock_cal_set_window(io);
+    if (err == ESP_OK) {
+        err = esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, cal->tx, LCD_CLOCK_CAL_PIXELS * 2);
+    }
+    // 关闭时等待发送完成
+    config->close(io, config->ctx);
+    return err;
+}
+
+/**
+ * @brief 以 read_hz 读回 ID 和测试窗口
+ */
+static esp_err_t lcd_clock_cal_read(lcd_clock_cal_t *cal, const lcd_clock_cal_config_t *config, uint8_t id[3])
+{
+    esp_lcd_panel_io_handle_t io = NULL;
+    esp_err_t err = config->open(config->read_hz, &io, config->ctx);
+    if (err != ESP_OK) {
+        return err;
+    }
+    static const int id_cmds[3] = { LCD_CLOCK_CAL_CMD_RDID1, LCD_CLOCK_CAL_CMD_RDID2, LCD_CLOCK_CAL_CMD_RDID3 };
+    for (int i = 0; i < 3 && err == ESP_OK; i++) {
+        err = esp_lcd_panel_io_rx_param(io, id_cmds[i], &id[i], 1);
+    }
+    if (err == ESP_OK) {
+        err = lcd_clock_cal_set_window(io);
+    }
+    if (err == ESP_OK) {
+        memset(cal->rx, 0, LCD_CLOCK_CAL_RX_BYTES);
+        err = esp_lcd_panel_io_rx_param(io, LCD_CMD_RAMRD, cal->rx, LCD_CLOCK_CAL_RX_BYTES);
+    }
+    config->close(io, config->ctx);
+    return err;
+}
+
+/**
+ * @brief 读回数据中的第 i 个字节，前面有 shift 个空位
+ */
+static inline uint8_t lcd_clock_cal_rx_byte(const uint8_t *rx, size_t i, int shift)
+{
+    const size_t at = i + shift / 8;
+    const int bits = shift % 8;
+    return bits ? (uint8_t)((rx[at] << bits) | (rx[at + 1] >> (8 - bits))) : rx[at];
+}
+
+/**
+ * @brief 读回的像素与写入的图案不同的位数，只比较 RGB565 能表示的高位
+ */
+static uint32_t lcd_clock_cal_errors(const lcd_clock_cal_t *cal, int shift, bool bgr)
+{
+    static const uint8_t mask[3] = { 0xF8, 0xFC, 0xF8 };
+    uint32_t errors = 0;
+    for (size_t p = 0; p < LCD_CLOCK_CAL_PIXELS; p++) {
+        const uint16_t c = (uint16_t)(cal->tx[2 * p] << 8 | cal->tx[2 * p + 1]);
+        const uint8_t rgb[3] = { (uint8_t)((c >> 8) & 0xF8), (uint8_t)((c >> 3) & 0xFC), (uint8_t)((c << 3) & 0xF8) };
+        for (int k = 0; k < 3; k++) {
+            const uint8_t got = lcd_clock_cal_rx_byte(cal->rx, p * 3 + k, shift);
+            errors += __builtin_popcount((got ^ rgb[bgr ? 2 - k : k]) & mask[k]);
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief 在基准时钟的读回数据中找到没有错误的分量顺序和空位数
+ */
+static bool lcd_clock_cal_learn(lcd_clock_cal_t *cal)
+{
+    for (int bgr = 0; bgr < 2; bgr++) {
+        for (int shift = 0; shift < LCD_CLOCK_CAL_MAX_SHIFT; shift++) {
+            if (lcd_clock_cal_errors(cal, shift, bgr) == 0) {
+                cal->shift = shift;
+                cal->bgr = bgr;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+esp_err_t lcd_clock_calibrate(const lcd_clock_cal_config_t *config, lcd_clock_cal_result_t *result)
+{
+    if (!config || !config->open || !config->close || !result || (config->step_count && !config->steps_hz)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(result, 0, sizeof(*result));
+    result->pclk_hz = config->base_hz;
+    const uint8_t rounds = config->rounds ? config->rounds : 1;
+
+    lcd_clock_cal_t cal = { 0 };
+    cal.tx = heap_caps_malloc(LCD_CLOCK_CAL_PIXELS * 2, MALLOC_CAP_DMA);
+    cal.rx = heap_caps_malloc(LCD_CLOCK_CAL_RX_BYTES, MALLOC_CAP_DMA);
+    esp_err_t err = ESP_OK;
+    if (!cal.tx || !cal.rx) {
+        err = ESP_ERR_NO_MEM;
+        goto done;
+    }
+
+    // 基准时钟下确认能读回，并学习读回的格式
+    lcd_clock_cal_next_pattern(&cal);
+    err = lcd_clock_cal_write(&cal, config, config->base_hz);
+    if (err == ESP_OK) {
+        err = lcd_clock_cal_read(&cal, config, result->id);
+    }
+    if (err != ESP_OK) {
+        goto done;
+    }
+    if (!lcd_clock_cal_learn(&cal)) {
+        ESP_LOGW(TAG, "Pattern written at %" PRIu32 " Hz does not read back (ID %02x %02x %02x)",
+                 config->base_hz, result->id[0], result->id[1], result->id[2]);
+        err = ESP_ERR_NOT_SUPPORTED;
+        goto done;
+    }
+    ESP_LOGI(TAG, "Panel ID %02x %02x %02x, pixels read back as %s after %d dummy bits",
+             result->id[0], result->id[1], result->id[2], cal.bgr ? "BGR666" : "RGB666", cal.shift);
+
+    for (size_t i = 0; i < config->step_count; i++) {
+        const uint32_t hz = config->steps_hz[i];
+        uint32_t errors = 0;
+        bool id_ok = true;
+        esp_err_t step_err = ESP_OK;
+        for (uint8_t round = 0; round < rounds && step_err == ESP_OK && !errors && id_ok; round++) {
+            uint8_t id[3];
+            lcd_clock_cal_next_pattern(&cal);
+            step_err = lcd_clock_cal_write(&cal, config, hz);
+            if (step_err == ESP_OK) {
+                step_err = lcd_clock_cal_read(&cal, config, id);
+            }
+            if (step_err == ESP_OK) {
+                errors = lcd_clock_cal_errors(&cal, cal.shift, cal.bgr);
+                id_ok = memcmp(id, result->id, sizeof(id)) == 0;
+            }
+        }
+        // 更高的时钟不会更好，第一个失败的时钟结束搜索
+        if (step_err != ESP_OK || errors || !id_ok) {
+            result->failed_hz = hz;
+            result->bit_errors = errors;
+            if (step_err != ESP_OK) {
+                ESP_LOGW(TAG, "%" PRIu32 " Hz: %s", hz, esp_err_to_name(step_err));
+            } else {
+                ESP_LOGW(TAG, "%" PRIu32 " Hz: %" PRIu32 " bit errors%s", hz, errors, id_ok ? "" : ", ID changed");
+            }
+            break;
+        }
+        result->pclk_hz = hz;
+        ESP_LOGI(TAG, "%" PRIu32 " Hz: %u patterns read back without errors", hz, rounds);
+    }
+
+done:
+    heap_caps_free(cal.tx);
+    heap_caps_free(cal.rx);
+    return err;
+}
@@ -0,0 +1,80 @@
+/*
+ * LCD pixel clock calibration
+ * Writes test patterns to the panel at rising SPI clocks and reads them back
+ * at a slow clock to find the highest clock the wiring carries without errors
+ */
+
+#ifndef LCD_CLOCK_CAL_H
+#define LCD_CLOCK_CAL_H
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Open a panel IO at pclk_hz that can also read from the panel
+ */
+typedef esp_err_t (*lcd_clock_cal_open_t)(uint32_t pclk_hz, esp_lcd_panel_io_handle_t *io, void *ctx);
+
+/**
+ * @brief Close a panel IO returned by the open callback
+ */
+typedef void (*lcd_clock_cal_close_t)(esp_lcd_panel_io_handle_t io, void *ctx);
+
+/**
+ * @brief Calibration settings
+ */
+typedef struct {
+    lcd_clock_cal_open_t open;
+    lcd_clock_cal_close_t close;
+    void *ctx;                      // Passed to open and close
+    uint32_t base_hz;               // Known good clock, used to check that readback works
+    uint32_t read_hz;               // Clock for RDID and RAMRD (panels read far slower than they write)
+    const uint32_t *steps_hz;       // Clocks to try above base_hz, ascending
+    size_t step_count;
+    uint8_t rounds;                 // Patterns written at each clock
+} lcd_clock_cal_config_t;
+
+/**
+ * @brief Calibration result
+ */
+typedef struct {
+    uint32_t pclk_hz;               // Highest clock that passed every round (base_hz if none did)
+    uint32_t failed_hz;             // First clock that failed, 0 if all passed
+    uint32_t bit_errors;            // Pixel bits read back wrong at failed_hz
+    uint8_t id[3];                  // RDID1-RDID3 (manufacturer, version, module) read at base_hz
+} lcd_clock_cal_result_t;
+
+/**
+ * @brief Find the highest stable pixel clock
+ *
+ * A reference pass at base_hz writes a pattern to a 320x8 window at the top
+ * of the panel, reads the ID and the window back and learns how the panel
+ * returns pixels (RGB666, RGB or BGR order, dummy bits before the data).
+ * Then each step is tried in turn: a different pattern per round (alternating
+ * bits, a walking one, pseudo-random), written at the step's clock and read
+ * back at read_hz together with the ID. The first step with a wrong bit or
+ * a changed ID ends the search.
+ *
+ * Writes at a bad clock can corrupt panel registers as well as pixels;
+ * re-initialise the panel afterwards. To check a single stored clock, pass
+ * it as the only step.
+ *
+ * @return
+ *      - ESP_ERR_NOT_SUPPORTED if nothing can be read back at base_hz
+ *        (e.g. the panel's SDA line is not bidirectional)
+ *      - ESP_ERR_NO_MEM if the pattern buffers could not be allocated
+ *      - Errors of the open callback or the panel IO
+ */
+esp_err_t lcd_clock_calibrate(const lcd_clock_cal_config_t *config, lcd_clock_cal_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LCD_CLOCK_CAL_H
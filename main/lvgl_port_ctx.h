@@ -0,0 +1,62 @@
+/*
+ * esp_lvgl_port contexts
+ * Handles esp_lvgl_port keeps in the user_data of the displays and touch
+ * input devices it adds
+ */
+
+#ifndef LVGL_PORT_CTX_H
+#define LVGL_PORT_CTX_H
+
+#include "esp_lcd_types.h"
+#include "esp_lcd_touch.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The BSP offers no getter for the panel or touch handles of the display it
+ * creates, and esp_lvgl_port keeps them in private structs. The types below
+ * mirror the first members of esp_lvgl_port 1.4.0's lvgl_port_display_ctx_t
+ * and lvgl_port_touch_ctx_t; main/CMakeLists.txt stops the build when another
+ * esp_lvgl_port version is used, so a layout change cannot go unnoticed.
+ */
+#define LVGL_PORT_CTX_VERSION "1.4.0"
+
+/**
+ * @brief First members of lvgl_port_display_ctx_t (disp->driver->user_data)
+ */
+typedef struct {
+    esp_lcd_panel_io_handle_t io_handle;
+    esp_lcd_panel_handle_t panel_handle;
+} lvgl_port_ctx_disp_t;
+
+/**
+ * @brief First member of lvgl_port_touch_ctx_t (indev->driver->user_data)
+ */
+typedef struct {
+    esp_lcd_touch_handle_t handle;
+} lvgl_port_ctx_touch_t;
+
+/**
+ * @brief Panel handles of a display added with lvgl_port_add_disp(), NULL if disp has none
+ */
+static inline lvgl_port_ctx_disp_t *lvgl_port_ctx_disp(lv_disp_t *disp)
+{
+    return disp && disp->driver ? (lvgl_port_ctx_disp_t *)disp->driver->user_data : NULL;
+}
+
+/**
+ * @brief Touch handle of an input device added with lvgl_port_add_touch(), NULL if indev has none
+ */
+static inline lvgl_port_ctx_touch_t *lvgl_port_ctx_touch(lv_indev_t *indev)
+{
+    return indev && indev->driver ? (lvgl_port_ctx_touch_t *)indev->driver->user_data : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LVGL_PORT_CTX_H
@@ -0,0 +1,258 @@
+/*
+ * Event-driven LVGL task
+ * Replaces the polling loop of esp_lvgl_port: the task sleeps until something
+ * is invalidated, the touch controller raises its interrupt or the next LVGL
+ * timer is due
+ */
+
+#include "lvgl_wake.h"
+#include "lvgl_port_ctx.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_touch.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+
+static const char *TAG = "lvgl_wake";
+
+// 触摸松开后继续读取的时间，之后暂停读取定时器，等下一次触摸中断
+#define LVGL_WAKE_TOUCH_IDLE_US     100000
+// lv_timer_handler() 认为马上有定时器到期时的最短睡眠，和 esp_lvgl_port 的 1ms 下限相同
+#define LVGL_WAKE_MIN_SLEEP_US      1000
+// 等待 esp_lvgl_port 任务运行交出句柄的回调的时间
+#define LVGL_WAKE_CAPTURE_TIMEOUT_MS 1000
+
+static TaskHandle_t s_task;
+static TaskHandle_t volatile s_port_task;
+static esp_timer_handle_t s_deadline;
+static lv_disp_t *s_disp;
+static lv_indev_t *s_touch;
+
+// 以下变量只在持有显示锁时访问（rounder_cb 总是在持锁时调用）
+static int64_t s_tick_us;           // 与当前 lv_tick 对应的 esp_timer 时间
+static bool s_inv_pending;          // 其他任务的失效区域还没有开始刷新
+static int64_t s_inv_us;            // 第一块这样的失效区域的时间
+static int64_t s_touch_last_us;     // 最近一次触摸中断
+
+static atomic_bool s_touch_irq;
+static atomic_uint s_touch_irqs;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static lvgl_wake_stats_t s_stats;
+
+/**
+ * @brief 把 lv_tick 推进到当前时间（持有显示锁时调用）
+ * 余数留在 s_tick_us 中，长时间睡眠后 lv_tick 也不会漂移
+ */
+static void lvgl_wake_tick_sync(void)
+{
+    const int64_t now = esp_timer_get_time();
+    const uint32_t ms = (uint32_t)((now - s_tick_us) / 1000);
+    if (ms) {
+        s_tick_us += (int64_t)ms * 1000;
+        lv_tick_inc(ms);
+    }
+}
+
+/**
+ * @brief LVGL 每记录一块失效区域都调用一次，区域不变
+ * 其他任务（上传、照片模式、GIF）修改界面后唤醒 LVGL 任务；LVGL 任务自己
+ * 刷新时也会调用，这时什么都不做
+ */
+static void lvgl_wake_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area)
+{
+    if (xTaskGetCurrentTaskHandle() == s_task) {
+        return;
+    }
+    // 在 LVGL 任务醒来之前创建的定时器也从当前时间算起
+    lvgl_wake_tick_sync();
+    if (!s_inv_pending) {
+        s_inv_pending = true;
+        s_inv_us = esp_timer_get_time();
+        xTaskNotifyGive(s_task);
+    }
+}
+
+static void IRAM_ATTR lvgl_wake_touch_isr(esp_lcd_touch_handle_t tp)
+{
+    BaseType_t woken = pdFALSE;
+    atomic_store(&s_touch_irq, true);
+    atomic_fetch_add(&s_touch_irqs, 1);
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void lvgl_wake_deadline_cb(void *arg)
+{
+    xTaskNotifyGive(s_task);
+}
+
+/**
+ * @brief 触摸中断恢复读取定时器；松开并空闲一段时间后再暂停（持有显示锁时调用）
+ */
+static void lvgl_wake_touch_update(int64_t now)
+{
+    lv_timer_t *read_timer = s_touch->driver->read_timer;
+    if (atomic_exchange(&s_touch_irq, false)) {
+        s_touch_last_us = now;
+        if (read_timer->paused) {
+            lv_timer_resume(read_timer);
+            lv_timer_ready(read_timer);
+        }
+    } else if (!read_timer->paused && s_touch->proc.state == LV_INDEV_STATE_RELEASED &&
+               now - s_touch_last_us > LVGL_WAKE_TOUCH_IDLE_US) {
+        lv_timer_pause(read_timer);
+    }
+}
+
+static void lvgl_wake_task(void *arg)
+{
+    ESP_LOGI(TAG, "Starting event-driven LVGL task");
+    for (;;) {
+        uint32_t next = LV_NO_TIMER_READY;
+        int64_t deadline = 0;
+        int64_t busy_us = 0;
+        int64_t latency_us = -1;
+        if (bsp_display_lock(0)) {
+            lvgl_wake_tick_sync();
+            const int64_t start = esp_timer_get_time();
+            if (s_inv_pending) {
+                // 新图片不等刷新周期（LV_DISP_DEF_REFR_PERIOD）剩下的时间
+                s_inv_pending = false;
+                latency_us = start - s_inv_us;
+                lv_timer_ready(s_disp->refr_timer);
+            }
+            if (s_touch) {
+                lvgl_wake_touch_update(start);
+            }
+            next = lv_timer_handler();
+            if (next != LV_NO_TIMER_READY) {
+                deadline = s_tick_us + (int64_t)next * 1000;
+            }
+            busy_us = esp_timer_get_time() - start;
+            bsp_display_unlock();
+        }
+
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_stats.wakeups++;
+        s_stats.busy_us += busy_us;
+        if (latency_us >= 0) {
+            s_stats.invalidations++;
+            s_stats.latency_us = (uint32_t)latency_us;
+            if (s_stats.latency_us > s_stats.max_latency_us) {
+                s_stats.max_latency_us = s_stats.latency_us;
+            }
+        }
+        taskEXIT_CRITICAL(&s_stats_lock);
+
+        // 没有定时器在运行（静止的图片、没有触摸）时只等通知
+        esp_timer_stop(s_deadline);
+        if (next != LV_NO_TIMER_READY) {
+            int64_t wait = deadline - esp_timer_get_time();
+            if (wait < LVGL_WAKE_MIN_SLEEP_US) {
+                wait = LVGL_WAKE_MIN_SLEEP_US;
+            }
+            esp_timer_start_once(s_deadline, (uint64_t)wait);
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief 在 esp_lvgl_port 任务中运行一次，记下它的句柄
+ */
+static void lvgl_wake_capture_cb(lv_timer_t *timer)
+{
+    TaskHandle_t *port_task = timer->user_data;
+    *port_task = xTaskGetCurrentTaskHandle();
+    lv_timer_del(timer);
+}
+
+esp_err_t lvgl_wake_start(lv_disp_t *disp, lv_indev_t *touch, const lvgl_port_cfg_t *port_cfg)
+{
+    if (!disp || !port_cfg || s_task) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // esp_lvgl_port 没有提供任务句柄，让它自己在定时器回调中交出来
+    bsp_display_lock(0);
+    lv_timer_t *capture = lv_timer_create(lvgl_wake_capture_cb, 0, (void *)&s_port_task);
+    bsp_display_unlock();
+    if (!capture) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int ms = 0; !s_port_task && ms < LVGL_WAKE_CAPTURE_TIMEOUT_MS; ms += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (!s_port_task) {
+        ESP_LOGE(TAG, "LVGL port task did not run");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    const esp_timer_create_args_t deadline_args = {
+        .callback = lvgl_wake_deadline_cb,
+        .name = "lvgl_wake",
+    };
+    if (esp_timer_create(&deadline_args, &s_deadline) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 持锁时 esp_lvgl_port 任务不在 lv_timer_handler() 中，挂起后再也不会拿锁
+    bsp_display_lock(0);
+    vTaskSuspend(s_port_task);
+    // 只为停止 esp_lvgl_port 的节拍定时器；lvgl_port_stop() 同时调用了 lv_timer_enable(false)，
+    // 不重新打开的话 lv_timer_handler() 不运行任何定时器并总是返回 1，屏幕不再刷新
+    lvgl_port_stop();
+    lv_timer_enable(true);
+    s_tick_us = esp_timer_get_time();
+    s_disp = disp;
+    disp->driver->rounder_cb = lvgl_wake_rounder_cb;
+
+    const BaseType_t core = port_cfg->task_affinity < 0 ? tskNO_AFFINITY : port_cfg->task_affinity;
+    if (xTaskCreatePinnedToCore(lvgl_wake_task, "lvgl_wake", port_cfg->task_stack, NULL,
+                                port_cfg->task_priority, &s_task, core) != pdPASS) {
+        // 交还给 esp_lvgl_port
+        disp->driver->rounder_cb = NULL;
+        lvgl_port_resume();     // 同时 lv_timer_enable(true)
+        vTaskResume(s_port_task);
+        bsp_display_unlock();
+        esp_timer_delete(s_deadline);
+        s_deadline = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 触摸控制器有中断引脚时才暂停读取定时器，否则照常每 LV_INDEV_DEF_READ_PERIOD 读一次
+    const lvgl_port_ctx_touch_t *port = lvgl_port_ctx_touch(touch);
+    if (port) {
+        if (esp_lcd_touch_register_interrupt_callback(port->handle, lvgl_wake_touch_isr) == ESP_OK) {
+            s_touch = touch;
+            lv_timer_pause(touch->driver->read_timer);
+        } else {
+            ESP_LOGW(TAG, "No touch interrupt, polling the touch controller");
+        }
+    }
+    // 启动后先刷新一次
+    s_inv_pending = true;
+    s_inv_us = esp_timer_get_time();
+    xTaskNotifyGive(s_task);
+    bsp_display_unlock();
+    return ESP_OK;
+}
+
+void lvgl_wake(void)
+{
+    if (s_task) {
+        lvgl_wake_tick_sync();
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void lvgl_wake_get_stats(lvgl_wake_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    stats->touch_irqs = atomic_load(&s_touch_irqs);
+}
@@ -0,0 +1,80 @@
+/*
+ * Event-driven LVGL task
+ * Replaces the polling loop of esp_lvgl_port: the task sleeps until something
+ * is invalidated, the touch controller raises its interrupt or the next LVGL
+ * timer is due
+ */
+
+#ifndef LVGL_WAKE_H
+#define LVGL_WAKE_H
+
+#include "esp_err.h"
+#include "esp_lvgl_port.h"
+#include "lvgl.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counters since lvgl_wake_start()
+ */
+typedef struct {
+    uint32_t wakeups;               // lv_timer_handler() calls
+    uint64_t busy_us;               // Time spent in lv_timer_handler()
+    uint32_t invalidations;         // Wakeups requested by invalidations from other tasks
+    uint32_t touch_irqs;            // Touch controller interrupts
+    uint32_t latency_us;            // Last invalidation from another task to the start of lv_timer_handler()
+    uint32_t max_latency_us;
+} lvgl_wake_stats_t;
+
+/**
+ * @brief Take over LVGL timer handling from the esp_lvgl_port task
+ *
+ * The port task is parked (it keeps its stack but never runs again) and its
+ * periodic tick timer is stopped; the new task advances the LVGL tick from
+ * esp_timer_get_time() and sleeps on a task notification. Wakeups come from:
+ *   - invalidations made by other tasks (a rounder_cb on the display), which
+ *     also make the refresh timer ready, so rendering starts as soon as the
+ *     invalidating task gives the display lock back
+ *   - the touch interrupt, which resumes the input read timer; the timer is
+ *     paused again once the touch is released and idle
+ *   - a one-shot esp_timer set to the deadline returned by lv_timer_handler()
+ * With no animation and no touch the task does not run at all.
+ *
+ * Call once after bsp_display_start_with_config(), before anything else
+ * sets a rounder_cb on disp.
+ *
+ * @param disp Display of the port
+ * @param touch Touch input of the port, NULL to keep polling inputs
+ * @param port_cfg Configuration the port was started with (task priority,
+ *                 stack and core are reused)
+ * @return ESP_ERR_NO_MEM if the task or timer could not be created,
+ *         ESP_ERR_TIMEOUT if the port task did not respond
+ */
+esp_err_t lvgl_wake_start(lv_disp_t *disp, lv_indev_t *touch, const lvgl_port_cfg_t *port_cfg);
+
+/**
+ * @brief Bring lv_tick up to date and run lv_timer_handler() soon
+ *
+ * Call with the display lock held. Only needed for LVGL changes from other
+ * tasks that do not invalidate anything, e.g. before creating an lv_timer
+ * (lv_tick only advances while the LVGL task runs or something is
+ * invalidated, so a timer created from a stale tick would fire early), or
+ * after a change that only marks the layout dirty, such as creating an
+ * object that is not laid out yet (LVGL resumes its refresh timer for it
+ * without invalidating anything).
+ */
+void lvgl_wake(void);
+
+/**
+ * @brief Copy the counters (safe from any task)
+ */
+void lvgl_wake_get_stats(lvgl_wake_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LVGL_WAKE_H
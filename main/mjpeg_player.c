@@ -0,0 +1,354 @@
+/*
+ * MJPEG player
+ * Plays a Motion-JPEG stream on the panel: frames are received, decoded into
+ * two alternating framebuffers and written to the panel by three tasks, and
+ * frames the decoder cannot keep up with are dropped
+ */
+
+#include "mjpeg_player.h"
+#include "jpeg_stream.h"
+#include "photo_mode.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <string.h>
+
+static const char *TAG = "mjpeg_player";
+
+// 压缩帧槽位：一个正在接收，一个等待解码，一个正在解码
+#define MJPEG_PLAYER_SLOTS          3
+#define MJPEG_PLAYER_FBS            2
+// jpeg_stream 解码需要较大的栈（与 /upload 的 httpd 任务相同）
+#define MJPEG_PLAYER_DECODE_STACK   8192
+// 结束时的 on_done 回调会调用 LVGL
+#define MJPEG_PLAYER_BLIT_STACK     6144
+#define MJPEG_PLAYER_DECODE_PRIO    3
+#define MJPEG_PLAYER_BLIT_PRIO      4
+// 帧率、解码和发送时间的统计窗口
+#define MJPEG_PLAYER_WINDOW_US      1000000
+
+typedef struct {
+    uint8_t *pixels;                // 帧缓冲区，width 为 0 表示流结束
+    uint16_t width;
+    uint16_t height;
+    uint32_t decode_us;
+} mjpeg_player_frame_t;
+
+typedef struct {
+    const mjpeg_player_cfg_t *cfg;
+    uint8_t *slots[MJPEG_PLAYER_SLOTS];
+    size_t lens[MJPEG_PLAYER_SLOTS];
+    size_t slot_size;
+    portMUX_TYPE lock;              // 保护 pending 和 decoding
+    int pending;                    // 等待解码的槽位，-1 为无
+    int decoding;                   // 正在解码的槽位，-1 为无
+    atomic_bool eos;                // 接收结束，解码完 pending 后退出
+    TaskHandle_t decoder;
+    uint8_t *fbs[MJPEG_PLAYER_FBS];
+    size_t fb_size;
+    QueueHandle_t free_fbs;         // 可以解码的帧缓冲区
+    QueueHandle_t ready;            // 解码完成、等待发送到面板的帧
+    SemaphoreHandle_t done;         // 发送任务已调用 on_done
+} mjpeg_player_t;
+
+static struct {
+    atomic_bool active;
+    atomic_uint received;
+    atomic_uint shown;
+    atomic_uint dropped;
+    atomic_uint fps_x10;
+    atomic_uint decode_us;
+    atomic_uint blit_us;
+} s_stats;
+
+/**
+ * @brief 解码任务：总是取最新的压缩帧，解码到空闲的帧缓冲区后交给发送任务
+ * 先拿到帧缓冲区再取帧，等待期间到达的新帧会替换旧帧
+ */
+static void mjpeg_player_decode_task(void *arg)
+{
+    mjpeg_player_t *p = (mjpeg_player_t *)arg;
+    uint8_t *fb = NULL;
+    while (true) {
+        if (!fb) {
+            xQueueReceive(p->free_fbs, &fb, portMAX_DELAY);
+        }
+        taskENTER_CRITICAL(&p->lock);
+        const int slot = p->pending;
+        p->pending = -1;
+        p->decoding = slot;
+        taskEXIT_CRITICAL(&p->lock);
+        if (slot < 0) {
+            if (atomic_load(&p->eos)) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // 较大的帧按比例缩小到屏幕内，较小的帧由 photo_mode_frame 居中显示
+        jpeg_stream_cfg_t cfg = {
+            .swap_bytes = LV_COLOR_16_SWAP,
+            .max_width = BSP_LCD_H_RES,
+            .max_height = BSP_LCD_V_RES,
+            .fb = fb,
+            .fb_size = p->fb_size,
+        };
+        jpeg_stream_image_t img;
+        const int64_t start = esp_timer_get_time();
+        esp_err_t err = jpeg_stream_decode_mem(p->slots[slot], p->lens[slot], &cfg, &img);
+        const uint32_t decode_us = esp_timer_get_time() - start;
+
+        taskENTER_CRITICAL(&p->lock);
+        p->decoding = -1;
+        taskEXIT_CRITICAL(&p->lock);
+        if (err != ESP_OK) {
+            atomic_fetch_add(&s_stats.dropped, 1);
+            continue;
+        }
+        mjpeg_player_frame_t frame = { .pixels = fb, .width = img.width, .height = img.height, .decode_us = decode_us };
+        xQueueSend(p->ready, &frame, portMAX_DELAY);
+        fb = NULL;
+    }
+    mjpeg_player_frame_t end = {0};
+    xQueueSend(p->ready, &end, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 发送任务：经照片模式把帧写到面板，整个流期间持有显示锁，LVGL 不刷新
+ * 收到新帧时上一帧已经在面板上，它的缓冲区马上还给解码任务，发送和解码下一帧同时进行
+ */
+static void mjpeg_player_blit_task(void *arg)
+{
+    mjpeg_player_t *p = (mjpeg_player_t *)arg;
+    mjpeg_player_frame_t frame;
+    mjpeg_player_frame_t shown = {0};
+    int64_t window_start = esp_timer_get_time();
+    uint32_t window_frames = 0;
+    uint64_t window_decode_us = 0;
+    uint64_t window_blit_us = 0;
+    bool failed = false;
+
+    while (xQueueReceive(p->ready, &frame, portMAX_DELAY) == pdTRUE && frame.width) {
+        if (shown.pixels) {
+            xQueueSend(p->free_fbs, &shown.pixels, 0);
+        }
+        shown = frame;
+        const int64_t start = esp_timer_get_time();
+        esp_err_t err = photo_mode_frame(frame.pixels, frame.width, frame.height);
+        const int64_t now = esp_timer_get_time();
+        if (err != ESP_OK) {
+            if (!failed) {
+                ESP_LOGE(TAG, "Could not write %ux%u frame to the panel: %s", frame.width, frame.height,
+                         esp_err_to_name(err));
+                failed = true;
+            }
+            atomic_fetch_add(&s_stats.dropped, 1);
+            continue;
+        }
+        atomic_fetch_add(&s_stats.shown, 1);
+        window_frames++;
+        window_decode_us += frame.decode_us;
+        window_blit_us += now - start;
+        if (now - window_start >= MJPEG_PLAYER_WINDOW_US) {
+            atomic_store(&s_stats.fps_x10, (uint32_t)(window_frames * 10000000ULL / (now - window_start)));
+            atomic_store(&s_stats.decode_us, (uint32_t)(window_decode_us / window_frames));
+            atomic_store(&s_stats.blit_us, (uint32_t)(window_blit_us / window_frames));
+            window_start = now;
+            window_frames = 0;
+            window_decode_us = window_blit_us = 0;
+        }
+    }
+
+    // 最后一帧的缓冲区交给图片缓冲区，之后由 LVGL 显示，播放器不再释放它
+    image_buf_t *last = NULL;
+    if (shown.pixels) {
+        for (int i = 0; i < MJPEG_PLAYER_FBS; i++) {
+            if (p->fbs[i] == shown.pixels) {
+                p->fbs[i] = NULL;
+            }
+        }
+        last = image_buf_create(shown.pixels, (size_t)shown.width * shown.height * 2, LV_IMG_CF_TRUE_COLOR,
+                                shown.width, shown.height);
+    }
+    p->cfg->on_done(p->cfg->done_ctx, last);
+    image_buf_unref(last);
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+static void mjpeg_player_free(mjpeg_player_t *p)
+{
+    for (int i = 0; i < MJPEG_PLAYER_SLOTS; i++) {
+        heap_caps_free(p->slots[i]);
+    }
+    for (int i = 0; i < MJPEG_PLAYER_FBS; i++) {
+        heap_caps_free(p->fbs[i]);
+    }
+    if (p->free_fbs) {
+        vQueueDelete(p->free_fbs);
+    }
+    if (p->ready) {
+        vQueueDelete(p->ready);
+    }
+    if (p->done) {
+        vSemaphoreDelete(p->done);
+    }
+    heap_caps_free(p);
+}
+
+static uint8_t *mjpeg_player_alloc(size_t size)
+{
+    uint8_t *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+}
+
+static mjpeg_player_t *mjpeg_player_create(const mjpeg_player_cfg_t *cfg)
+{
+    mjpeg_player_t *p = heap_caps_calloc(1, sizeof(*p), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!p) {
+        return NULL;
+    }
+    p->cfg = cfg;
+    p->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    p->pending = p->decoding = -1;
+    atomic_init(&p->eos, false);
+    p->slot_size = (size_t)CONFIG_DISPLAY_STREAM_FRAME_MAX_KB * 1024;
+    p->fb_size = (size_t)BSP_LCD_H_RES * BSP_LCD_V_RES * 2;
+    bool ok = true;
+    for (int i = 0; i < MJPEG_PLAYER_SLOTS; i++) {
+        ok &= (p->slots[i] = mjpeg_player_alloc(p->slot_size)) != NULL;
+    }
+    for (int i = 0; i < MJPEG_PLAYER_FBS; i++) {
+        ok &= (p->fbs[i] = mjpeg_player_alloc(p->fb_size)) != NULL;
+    }
+    p->free_fbs = xQueueCreate(MJPEG_PLAYER_FBS, sizeof(uint8_t *));
+    p->ready = xQueueCreate(1, sizeof(mjpeg_player_frame_t));
+    p->done = xSemaphoreCreateBinary();
+    if (!ok || !p->free_fbs || !p->ready || !p->done) {
+        mjpeg_player_free(p);
+        return NULL;
+    }
+    for (int i = 0; i < MJPEG_PLAYER_FBS; i++) {
+        xQueueSend(p->free_fbs, &p->fbs[i], 0);
+    }
+    return p;
+}
+
+esp_err_t mjpeg_player_run(const mjpeg_player_cfg_t *cfg)
+{
+    mjpeg_stream_cfg_t stream_cfg = { .read = cfg->read, .read_ctx = cfg->read_ctx };
+    mjpeg_stream_t *stream;
+    esp_err_t err = mjpeg_stream_open(&stream_cfg, &stream);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Not an MJPEG stream: %s", esp_err_to_name(err));
+        return err;
+    }
+    mjpeg_player_t *p = mjpeg_player_create(cfg);
+    if (!p) {
+        ESP_LOGE(TAG, "No memory for %d x %d KB frame slots and %d framebuffers", MJPEG_PLAYER_SLOTS,
+                 CONFIG_DISPLAY_STREAM_FRAME_MAX_KB, MJPEG_PLAYER_FBS);
+        mjpeg_stream_close(stream);
+        return ESP_ERR_NO_MEM;
+    }
+
+    atomic_store(&s_stats.received, 0);
+    atomic_store(&s_stats.shown, 0);
+    atomic_store(&s_stats.dropped, 0);
+    atomic_store(&s_stats.fps_x10, 0);
+    atomic_store(&s_stats.decode_us, 0);
+    atomic_store(&s_stats.blit_us, 0);
+    atomic_store(&s_stats.active, true);
+    // 每帧的解码日志会拖慢串口和帧率
+    const esp_log_level_t jpeg_level = esp_log_level_get("jpeg_stream");
+    esp_log_level_set("jpeg_stream", ESP_LOG_WARN);
+
+    if (xTaskCreatePinnedToCore(mjpeg_player_blit_task, "mjpeg_blit", MJPEG_PLAYER_BLIT_STACK, p,
+                                MJPEG_PLAYER_BLIT_PRIO, NULL, cfg->blit_core) != pdPASS) {
+        err = ESP_ERR_NO_MEM;
+    } else if (xTaskCreatePinnedToCore(mjpeg_player_decode_task, "mjpeg_decode", MJPEG_PLAYER_DECODE_STACK, p,
+                                       MJPEG_PLAYER_DECODE_PRIO, &p->decoder, cfg->decode_core) != pdPASS) {
+        // 发送任务已经在等帧：让它直接结束
+        mjpeg_player_frame_t end = {0};
+        xQueueSend(p->ready, &end, portMAX_DELAY);
+        xSemaphoreTake(p->done, portMAX_DELAY);
+        err = ESP_ERR_NO_MEM;
+    }
+    if (err != ESP_OK) {
+        esp_log_level_set("jpeg_stream", jpeg_level);
+        atomic_store(&s_stats.active, false);
+        mjpeg_player_free(p);
+        mjpeg_stream_close(stream);
+        return err;
+    }
+
+    const int64_t start = esp_timer_get_time();
+    int recv = 0;
+    while (true) {
+        size_t len;
+        err = mjpeg_stream_next_frame(stream, p->slots[recv], p->slot_size, &len);
+        if (err == ESP_ERR_INVALID_SIZE) {
+            atomic_fetch_add(&s_stats.dropped, 1);
+            continue;
+        }
+        if (err != ESP_OK) {
+            break;
+        }
+        atomic_fetch_add(&s_stats.received, 1);
+
+        // 新帧替换还没开始解码的旧帧；接收改用空出来的槽位
+        taskENTER_CRITICAL(&p->lock);
+        const int old = p->pending;
+        p->pending = recv;
+        p->lens[recv] = len;
+        if (old >= 0) {
+            recv = old;
+        } else {
+            for (int i = 0; i < MJPEG_PLAYER_SLOTS; i++) {
+                if (i != p->pending && i != p->decoding) {
+                    recv = i;
+                    break;
+                }
+            }
+        }
+        taskEXIT_CRITICAL(&p->lock);
+        if (old >= 0) {
+            atomic_fetch_add(&s_stats.dropped, 1);
+        }
+        xTaskNotifyGive(p->decoder);
+    }
+
+    // 解码完最后一帧，发送任务把它交给 on_done 后才释放缓冲区
+    atomic_store(&p->eos, true);
+    xTaskNotifyGive(p->decoder);
+    xSemaphoreTake(p->done, portMAX_DELAY);
+    esp_log_level_set("jpeg_stream", jpeg_level);
+    atomic_store(&s_stats.active, false);
+
+    const int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+    const unsigned shown = atomic_load(&s_stats.shown);
+    ESP_LOGI(TAG, "Stream ended (%s): %u frames received, %u shown, %u dropped, %.1f fps",
+             err == ESP_ERR_NOT_FOUND ? "end of stream" : esp_err_to_name(err), atomic_load(&s_stats.received),
+             shown, atomic_load(&s_stats.dropped), elapsed_ms > 0 ? shown * 1000.0 / elapsed_ms : 0.0);
+    mjpeg_player_free(p);
+    mjpeg_stream_close(stream);
+    return err == ESP_ERR_NOT_FOUND ? ESP_OK : err;
+}
+
+void mjpeg_player_get_stats(mjpeg_player_stats_t *stats)
+{
+    stats->active = atomic_load(&s_stats.active);
+    stats->received = atomic_load(&s_stats.received);
+    stats->shown = atomic_load(&s_stats.shown);
+    stats->dropped = atomic_load(&s_stats.dropped);
+    stats->fps_x10 = atomic_load(&s_stats.fps_x10);
+    stats->decode_us = atomic_load(&s_stats.decode_us);
+    stats->blit_us = atomic_load(&s_stats.blit_us);
+}
@@ -0,0 +1,82 @@
+/*
+ * MJPEG player
+ * Plays a Motion-JPEG stream on the panel: frames are received, decoded into
+ * two alternating framebuffers and written to the panel by three tasks, and
+ * frames the decoder cannot keep up with are dropped
+ */
+
+#ifndef MJPEG_PLAYER_H
+#define MJPEG_PLAYER_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "image_buf.h"
+#include "mjpeg_stream.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called in the blit task after the last frame, while photo mode still holds the panel
+ *
+ * Must end photo mode, e.g. with display_pipeline_show(last) or photo_mode_end(false).
+ *
+ * @param last Last frame shown as a new image buffer (the callback takes a
+ *             reference if it keeps it), NULL if no frame was shown
+ */
+typedef void (*mjpeg_player_done_cb_t)(void *ctx, image_buf_t *last);
+
+/**
+ * @brief Player configuration
+ */
+typedef struct {
+    mjpeg_stream_read_cb_t read;    // Source of the stream bytes
+    void *read_ctx;                 // Passed to read()
+    BaseType_t decode_core;         // Core of the decode task
+    BaseType_t blit_core;           // Core of the task writing frames to the panel
+    mjpeg_player_done_cb_t on_done;
+    void *done_ctx;                 // Passed to on_done()
+} mjpeg_player_cfg_t;
+
+/**
+ * @brief Counters of the running (or last) stream
+ */
+typedef struct {
+    bool active;
+    uint32_t received;              // Complete frames read from the stream
+    uint32_t shown;                 // Frames written to the panel
+    uint32_t dropped;               // Frames replaced by a newer one before decoding, too large or corrupt
+    uint32_t fps_x10;               // Frames shown per second over the last second, times 10
+    uint32_t decode_us;             // Average decode time over the last second
+    uint32_t blit_us;               // Average panel write time over the last second
+} mjpeg_player_stats_t;
+
+/**
+ * @brief Play a stream until it ends, receiving in the calling task
+ *
+ * Frames are read into one of three compressed slots (CONFIG_DISPLAY_STREAM_FRAME_MAX_KB
+ * each). A frame that arrives while the previous one is still waiting for
+ * the decoder replaces it, so the screen shows the newest frame instead of
+ * falling further behind.
+ *
+ * @return
+ *      - ESP_OK when the stream ended normally
+ *      - mjpeg_stream_open() errors
+ *      - ESP_ERR_NO_MEM if the buffers or tasks could not be created
+ *      - ESP_FAIL on a read error
+ */
+esp_err_t mjpeg_player_run(const mjpeg_player_cfg_t *cfg);
+
+/**
+ * @brief Copy the counters (safe from any task)
+ */
+void mjpeg_player_get_stats(mjpeg_player_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJPEG_PLAYER_H
@@ -0,0 +1,208 @@
+/*
+ * Photo mode
+ * Full-screen RGB565 images go straight to the panel, bypassing LVGL rendering
+ */
+
+#include "photo_mode.h"
+#include "lvgl_port_ctx.h"
+#include "bsp/esp-box-3.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_commands.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "photo_mode";
+
+// 每块 DMA 缓冲区的行数（2 x 320x16 RGB565 = 20KB 内部 RAM，只在发送照片时分配）
+#define PHOTO_MODE_BUF_LINES 16
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    lv_disp_t *disp;
+    bool active;                // 持有显示锁，正在直接写面板
+    bool failed;                // 本张图片不走照片模式（尺寸不符、内存不足或发送失败）
+    uint8_t *bufs[2];           // 乒乓 DMA 缓冲区
+    int next;                   // 下一块要填充的缓冲区
+    uint16_t rows_sent;         // 当前这张全屏图片已发送的行数
+    uint16_t frame_w;           // 视频帧的尺寸，变化时清屏
+    uint16_t frame_h;
+} photo_mode_t;
+
+static photo_mode_t s_photo;
+// 直接写到面板的像素（/status 的像素速率）
+static portMUX_TYPE s_pixels_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_pixels_sent;
+
+esp_err_t photo_mode_init(lv_disp_t *disp)
+{
+    const lvgl_port_ctx_disp_t *port = lvgl_port_ctx_disp(disp);
+    if (!port) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_photo.io = port->io_handle;
+    s_photo.panel = port->panel_handle;
+    s_photo.disp = disp;
+    return ESP_OK;
+}
+
+/**
+ * @brief 第一块到达时分配缓冲区并暂停 LVGL 刷新
+ */
+static bool photo_mode_start(void)
+{
+    if (!s_photo.panel) {
+        return false;
+    }
+    const size_t size = BSP_LCD_H_RES * PHOTO_MODE_BUF_LINES * 2;
+    for (int i = 0; i < 2; i++) {
+        s_photo.bufs[i] = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!s_photo.bufs[i]) {
+            ESP_LOGW(TAG, "No DMA memory for photo mode, drawing through LVGL");
+            heap_caps_free(s_photo.bufs[0]);
+            s_photo.bufs[0] = NULL;
+            return false;
+        }
+    }
+    // 持锁期间 LVGL 任务不会刷新，也不会调用 flush 回调
+    if (!bsp_display_lock(2000)) {
+        ESP_LOGE(TAG, "Could not get display lock within timeout!");
+        heap_caps_free(s_photo.bufs[0]);
+        heap_caps_free(s_photo.bufs[1]);
+        s_photo.bufs[0] = s_photo.bufs[1] = NULL;
+        return false;
+    }
+    // 整帧呈现的发送任务不持有显示锁，等它发送完上一帧（flush 结束）再写面板
+    while (s_photo.disp->driver->draw_buf->flushing) {
+        vTaskDelay(1);
+    }
+    s_photo.active = true;
+    s_photo.next = 0;
+    s_photo.rows_sent = 0;
+    s_photo.frame_w = s_photo.frame_h = 0;
+    return true;
+}
+
+/**
+ * @brief 经两块 DMA 缓冲区把 rows 行像素发送到面板的 (x, y) 处，pixels 为 NULL 时发送黑色
+ */
+static esp_err_t photo_mode_send(const uint8_t *pixels, uint16_t x, uint16_t y, uint16_t width, uint16_t rows)
+{
+    const size_t stride = (size_t)width * 2;
+    while (rows > 0) {
+        uint16_t n = rows < PHOTO_MODE_BUF_LINES ? rows : PHOTO_MODE_BUF_LINES;
+        uint8_t *dst = s_photo.bufs[s_photo.next];
+        // SPI 面板的 draw_bitmap 先用轮询方式发送 CASET/RASET，这会等待之前排队的颜色数据发完，
+        // 所以两块之前用过的这块缓冲区此时已经空闲，解码下一块和 DMA 发送上一块可以重叠
+        if (pixels) {
+            memcpy(dst, pixels, n * stride);
+            pixels += n * stride;
+        } else {
+            memset(dst, 0, n * stride);
+        }
+        esp_err_t err = esp_lcd_panel_draw_bitmap(s_photo.panel, x, y, x + width, y + n, dst);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "draw_bitmap failed at row %u: %s", y, esp_err_to_name(err));
+            return err;
+        }
+        taskENTER_CRITICAL(&s_pixels_lock);
+        s_pixels_sent += (uint32_t)width * n;
+        taskEXIT_CRITICAL(&s_pixels_lock);
+        s_photo.next ^= 1;
+        y += n;
+        rows -= n;
+    }
+    return ESP_OK;
+}
+
+void photo_mode_band(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height, uint16_t y, uint16_t rows)
+{
+    if (s_photo.failed) {
+        return;
+    }
+    if (width != BSP_LCD_H_RES || height != BSP_LCD_V_RES || (!s_photo.active && (y != 0 || !photo_mode_start()))) {
+        s_photo.failed = true;
+        return;
+    }
+    if (y == 0) {
+        // 同一次照片模式中的下一张图片（视频流结束时把最后一帧交给 LVGL）
+        s_photo.rows_sent = 0;
+    }
+    if (photo_mode_send(pixels, 0, y, width, rows) != ESP_OK) {
+        s_photo.failed = true;
+        return;
+    }
+    s_photo.rows_sent += rows;
+}
+
+esp_err_t photo_mode_frame(const uint8_t *pixels, uint16_t width, uint16_t height)
+{
+    if (width > BSP_LCD_H_RES || height > BSP_LCD_V_RES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (s_photo.failed || (!s_photo.active && !photo_mode_start())) {
+        s_photo.failed = true;
+        return ESP_FAIL;
+    }
+    const bool full = width == BSP_LCD_H_RES && height == BSP_LCD_V_RES;
+    s_photo.rows_sent = 0;
+    if (width != s_photo.frame_w || height != s_photo.frame_h) {
+        // 尺寸变化时清屏一次，较小的帧居中，四周留黑边
+        if (!full && photo_mode_send(NULL, 0, 0, BSP_LCD_H_RES, BSP_LCD_V_RES) != ESP_OK) {
+            s_photo.failed = true;
+            return ESP_FAIL;
+        }
+        s_photo.frame_w = width;
+        s_photo.frame_h = height;
+    }
+    if (photo_mode_send(pixels, (BSP_LCD_H_RES - width) / 2, (BSP_LCD_V_RES - height) / 2, width, height) != ESP_OK) {
+        s_photo.failed = true;
+        return ESP_FAIL;
+    }
+    if (full) {
+        s_photo.rows_sent = height;
+    }
+    return ESP_OK;
+}
+
+void photo_mode_blit(const image_buf_t *buf)
+{
+    if (buf->cf != LV_IMG_CF_TRUE_COLOR) {
+        return;
+    }
+    photo_mode_band(NULL, buf->data, buf->width, buf->height, 0, buf->height);
+}
+
+uint64_t photo_mode_pixels_sent(void)
+{
+    taskENTER_CRITICAL(&s_pixels_lock);
+    const uint64_t pixels = s_pixels_sent;
+    taskEXIT_CRITICAL(&s_pixels_lock);
+    return pixels;
+}
+
+bool photo_mode_complete(void)
+{
+    return s_photo.active && !s_photo.failed && s_photo.rows_sent == BSP_LCD_V_RES;
+}
+
+void photo_mode_end(bool keep)
+{
+    if (s_photo.active) {
+        // NOP 命令同样会先等待队列中的颜色数据发送完毕，之后才能释放 DMA 缓冲区
+        esp_lcd_panel_io_tx_param(s_photo.io, LCD_CMD_NOP, NULL, 0);
+        heap_caps_free(s_photo.bufs[0]);
+        heap_caps_free(s_photo.bufs[1]);
+        s_photo.bufs[0] = s_photo.bufs[1] = NULL;
+        if (!keep) {
+            // 面板上是未完成或未采用的图片，让 LVGL 重画整个屏幕
+            lv_obj_invalidate(lv_disp_get_scr_act(s_photo.disp));
+        }
+        s_photo.active = false;
+        bsp_display_unlock();
+    }
+    s_photo.failed = false;
+}
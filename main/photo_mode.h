@@ -0,0 +1,72 @@
+/*
+ * Photo mode
+ * Full-screen RGB565 images go straight to the panel, bypassing LVGL rendering
+ */
+
+#ifndef PHOTO_MODE_H
+#define PHOTO_MODE_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "image_buf.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Remember the panel behind an esp_lvgl_port display
+ * @return ESP_ERR_INVALID_ARG if disp was not added with lvgl_port_add_disp()
+ */
+esp_err_t photo_mode_init(lv_disp_t *disp);
+
+/**
+ * @brief jpeg_stream_band_cb_t that sends finished bands to the panel
+ *
+ * Only full-screen images are drawn. The first band takes the display lock,
+ * so LVGL does not refresh until photo_mode_end(); other sizes are ignored
+ * and left to LVGL.
+ */
+void photo_mode_band(void *ctx, const uint8_t *pixels, uint16_t width, uint16_t height, uint16_t y, uint16_t rows);
+
+/**
+ * @brief Send an already decoded image to the panel (same rules as photo_mode_band())
+ */
+void photo_mode_blit(const image_buf_t *buf);
+
+/**
+ * @brief Send one video frame of at most the screen size, centred
+ *
+ * Like photo_mode_band(), the first frame takes the display lock until
+ * photo_mode_end(). The screen is cleared to black whenever the frame size
+ * changes, so smaller frames are letterboxed. pixels is copied before this
+ * returns.
+ *
+ * @return ESP_ERR_INVALID_SIZE for frames larger than the screen, ESP_FAIL
+ *         if photo mode could not start or the panel write failed
+ */
+esp_err_t photo_mode_frame(const uint8_t *pixels, uint16_t width, uint16_t height);
+
+/**
+ * @brief Pixels sent to the panel by photo mode since boot (safe from any task)
+ */
+uint64_t photo_mode_pixels_sent(void);
+
+/**
+ * @brief Whether the last image sent since photo_mode_end() covers the whole screen
+ */
+bool photo_mode_complete(void);
+
+/**
+ * @brief Wait for the last band, free the DMA buffers and give LVGL the display back
+ * @param keep Panel content matches what LVGL shows now; false makes LVGL redraw the screen
+ */
+void photo_mode_end(bool keep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHOTO_MODE_H
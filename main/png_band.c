@@ -0,0 +1,283 @@
+/*
+ * Row-streaming PNG image decoder for LVGL
+ * Replaces lv_png's whole-image lodepng decode with one scanline in lv_color_t / RGB565A8
+ */
+
+#include "png_band.h"
+#include "png_stream.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "png_band";
+
+// lv_img_header_t 的宽高只有 11 位
+#define PNG_BAND_MAX_SIZE       2047
+
+typedef struct {
+    const uint8_t *data;        // C 数组源；NULL 时从 file 读取
+    lv_fs_file_t file;
+    uint32_t size;
+    uint32_t pos;
+    png_stream_t *png;
+    png_stream_info_t info;
+    uint8_t *row;               // 一行：width 个 lv_color_t，带透明度时后面是 width 个透明度
+    int32_t row_y;              // row 中是哪一行，-1 表示空
+    bool failed;
+    lv_img_src_t src_type;      // 以下用于判断再次打开的是不是同一张图
+    const void *src;
+    const uint8_t *src_data;
+    char *path;
+} png_band_t;
+
+// 与 sjpg_band 相同：LVGL 每画完一块区域就关闭解码器，关闭的会话留在这里，
+// 下一块区域从上次解码到的行继续，而不是每块区域都从头解压整张图
+static png_band_t *s_parked;
+
+static int png_band_read(void *ctx, uint8_t *buf, size_t len)
+{
+    png_band_t *band = (png_band_t *)ctx;
+    if (band->data) {
+        size_t n = band->size - band->pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(buf, band->data + band->pos, n);
+        band->pos += n;
+        return n;
+    }
+    uint32_t rn = 0;
+    if (lv_fs_read(&band->file, buf, len, &rn) != LV_FS_RES_OK) {
+        return -1;
+    }
+    return rn;
+}
+
+/**
+ * @brief 从文件头开始（重新）打开 PNG，停在第 0 行之前
+ */
+static lv_res_t png_band_rewind(png_band_t *band)
+{
+    png_stream_close(band->png);
+    band->png = NULL;
+    band->row_y = -1;
+    band->pos = 0;
+    if (!band->data && lv_fs_seek(&band->file, 0, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return LV_RES_INV;
+    }
+
+    png_stream_cfg_t cfg = {
+        .read = png_band_read,
+        .read_ctx = band,
+        .swap_bytes = LV_COLOR_16_SWAP,
+    };
+    esp_err_t err = png_stream_open(&cfg, &band->png, &band->info);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "Leaving PNG to other decoders: %s", esp_err_to_name(err));
+        return LV_RES_INV;
+    }
+    return LV_RES_OK;
+}
+
+static void png_band_free(png_band_t *band)
+{
+    if (!band) {
+        return;
+    }
+    png_stream_close(band->png);
+    if (!band->data && band->file.drv) {
+        lv_fs_close(&band->file);
+    }
+    free(band->row);
+    free(band->path);
+    free(band);
+}
+
+/**
+ * @brief 打开图片源并读取 PNG 头；with_row 为 true 时同时分配行缓冲区
+ */
+static png_band_t *png_band_load(lv_img_src_t type, const void *src, bool with_row)
+{
+    png_band_t *band = calloc(1, sizeof(*band));
+    if (!band) {
+        return NULL;
+    }
+    band->src_type = type;
+    band->src = src;
+    if (type == LV_IMG_SRC_VARIABLE) {
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+        band->data = band->src_data = img->data;
+        band->size = img->data_size;
+        if (!png_stream_is(img->data, img->data_size)) {
+            free(band);
+            return NULL;
+        }
+    } else {
+        band->path = strdup((const char *)src);
+        if (!band->path || lv_fs_open(&band->file, (const char *)src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+            png_band_free(band);
+            return NULL;
+        }
+    }
+
+    if (png_band_rewind(band) != LV_RES_OK ||
+        band->info.width > PNG_BAND_MAX_SIZE || band->info.height > PNG_BAND_MAX_SIZE) {
+        png_band_free(band);
+        return NULL;
+    }
+    if (with_row) {
+        band->row = malloc((size_t)band->info.width * (band->info.has_alpha ? 3 : 2));
+        if (!band->row) {
+            ESP_LOGW(TAG, "No memory for a %u pixel row", band->info.width);
+            png_band_free(band);
+            return NULL;
+        }
+    }
+    return band;
+}
+
+static bool png_band_match(const png_band_t *band, lv_img_src_t type, const void *src)
+{
+    if (!band || band->src_type != type) {
+        return false;
+    }
+    if (type == LV_IMG_SRC_FILE) {
+        return strcmp(band->path, (const char *)src) == 0;
+    }
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+    return band->src == src && band->src_data == img->data && band->size == img->data_size;
+}
+
+static bool png_band_accepts(lv_img_src_t type, const void *src)
+{
+    if (type == LV_IMG_SRC_FILE) {
+        return strcmp(lv_fs_get_ext((const char *)src), "png") == 0;
+    }
+    if (type == LV_IMG_SRC_VARIABLE) {
+        // 已知格式的像素数组交给内置解码器
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+        return img->header.cf == LV_IMG_CF_UNKNOWN || img->header.cf == LV_IMG_CF_RAW;
+    }
+    return false;
+}
+
+static lv_res_t png_band_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    LV_UNUSED(decoder);
+
+    lv_img_src_t type = lv_img_src_get_type(src);
+    if (!png_band_accepts(type, src)) {
+        return LV_RES_INV;
+    }
+    png_band_t *band = png_band_match(s_parked, type, src) ? s_parked : png_band_load(type, src, false);
+    if (!band) {
+        return LV_RES_INV;
+    }
+    header->always_zero = 0;
+    header->cf = band->info.has_alpha ? LV_IMG_CF_RGB565A8 : LV_IMG_CF_TRUE_COLOR;
+    header->w = band->info.width;
+    header->h = band->info.height;
+    if (band != s_parked) {
+        png_band_free(band);
+    }
+    return LV_RES_OK;
+}
+
+static lv_res_t png_band_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    png_band_t *band;
+    if (png_band_match(s_parked, dsc->src_type, dsc->src)) {
+        band = s_parked;
+        s_parked = NULL;
+    } else {
+        // 一次只保留一个会话，先释放别的图片留下的
+        png_band_free(s_parked);
+        s_parked = NULL;
+        band = png_band_load(dsc->src_type, dsc->src, true);
+        if (!band) {
+            return LV_RES_INV;
+        }
+    }
+
+    dsc->img_data = NULL;  // 只能逐行读取
+    dsc->user_data = band;
+    return LV_RES_OK;
+}
+
+static lv_res_t png_band_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc,
+                                   lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    LV_UNUSED(decoder);
+
+    png_band_t *band = (png_band_t *)dsc->user_data;
+    const uint16_t w = band->info.width;
+    // PNG 只能顺序解压：往下的行从当前位置继续，往回的行从头重新解压
+    if (y < band->row_y || !band->png) {
+        if (png_band_rewind(band) != LV_RES_OK) {
+            band->failed = true;
+            return LV_RES_INV;
+        }
+    }
+    while (band->row_y < y) {
+        esp_err_t err = png_stream_read_row(band->png, band->row, band->row + w * 2);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "PNG decode failed at row %d: %s", (int)band->row_y + 1, esp_err_to_name(err));
+            band->failed = true;
+            return LV_RES_INV;
+        }
+        band->row_y++;
+    }
+
+    // RGB565A8 的一行：len 个颜色，之后是 len 个透明度
+    memcpy(buf, band->row + x * 2, len * 2);
+    if (band->info.has_alpha) {
+        memcpy(buf + len * 2, band->row + w * 2 + x, len);
+    }
+    return LV_RES_OK;
+}
+
+static void png_band_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    png_band_t *band = (png_band_t *)dsc->user_data;
+    dsc->user_data = NULL;
+    if (!band) {
+        return;
+    }
+    if (band->failed) {
+        png_band_free(band);
+        return;
+    }
+    png_band_free(s_parked);
+    s_parked = band;
+}
+
+esp_err_t png_band_init(void)
+{
+#if LV_COLOR_DEPTH != 16
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    // 新建的解码器排在链表最前，比 lv_png 先被尝试
+    lv_img_decoder_t *dec = lv_img_decoder_create();
+    if (!dec) {
+        return ESP_ERR_NO_MEM;
+    }
+    lv_img_decoder_set_info_cb(dec, png_band_info);
+    lv_img_decoder_set_open_cb(dec, png_band_open);
+    lv_img_decoder_set_read_line_cb(dec, png_band_read_line);
+    lv_img_decoder_set_close_cb(dec, png_band_close);
+    return ESP_OK;
+#endif
+}
+
+void png_band_invalidate(const void *src)
+{
+    if (s_parked && (!src || s_parked->src == src ||
+                     (s_parked->path && s_parked->src_type == LV_IMG_SRC_FILE && strcmp(s_parked->path, src) == 0))) {
+        png_band_free(s_parked);
+        s_parked = NULL;
+    }
+}
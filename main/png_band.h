@@ -0,0 +1,37 @@
+/*
+ * Row-streaming PNG image decoder for LVGL
+ * Replaces lv_png's whole-image lodepng decode with one scanline in lv_color_t / RGB565A8
+ */
+
+#ifndef PNG_BAND_H
+#define PNG_BAND_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the decoder ahead of lv_png (call with the display lock held)
+ *
+ * PNG sources (C arrays and .png files) are inflated one row at a time as
+ * LVGL asks for lines, as LV_IMG_CF_TRUE_COLOR or, with an alpha channel or
+ * tRNS chunk, LV_IMG_CF_RGB565A8. Interlaced PNGs are left to lv_png.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED unless LV_COLOR_DEPTH is 16
+ */
+esp_err_t png_band_init(void);
+
+/**
+ * @brief Drop the decode position kept for src after its data changed
+ * @param src Image source passed to lv_img_set_src(), NULL for all sources
+ */
+void png_band_invalidate(const void *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PNG_BAND_H
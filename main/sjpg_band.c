@@ -0,0 +1,475 @@
+/*
+ * Banded JPEG / SJPG image decoder for LVGL
+ * Replaces lv_sjpg's whole-frame RGB888 cache with a rolling band in lv_color_t
+ */
+
+#include "sjpg_band.h"
+#include "jdec.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "sjpg_band";
+
+// SJPG 头：魔数 "_SJPG__\0"、版本、宽、高、分片数、分片高度（小端），之后是每个分片的长度
+#define SJPG_BAND_MAGIC         "_SJPG__"
+#define SJPG_BAND_HEADER_SIZE   22
+// lv_img_header_t 的宽高只有 11 位
+#define SJPG_BAND_MAX_SIZE      2047
+
+// 解码器直接输出 lv_color_t 的字节序，16 位色深时不需要再转换
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP
+#define SJPG_BAND_FORMAT        JDEC_RGB565_SWAP
+#elif LV_COLOR_DEPTH == 16
+#define SJPG_BAND_FORMAT        JDEC_RGB565
+#else
+#define SJPG_BAND_FORMAT        JDEC_RGB888
+#endif
+
+typedef struct {
+    const uint8_t *data;        // C 数组源；NULL 时从 file 读取
+    lv_fs_file_t file;
+    uint32_t size;              // 整个源的字节数
+    uint32_t end;               // 当前 JPEG（整张图或一个 SJPG 分片）的结束偏移
+    uint32_t pos;
+} sjpg_band_io_t;
+
+typedef struct {
+    sjpg_band_io_t io;
+    JDEC jd;
+    uint8_t *pool;              // jdec 工作区
+    lv_color_t *band;           // width x band_h
+    uint16_t width;
+    uint16_t height;
+    uint16_t band_h;            // 条带行数：一行 MCU 或一个 SJPG 分片
+    int32_t band_top;           // 条带第 0 行在图片中的行号，-1 表示条带为空
+    uint16_t out_top;           // 正在解码的条带第 0 行（输出矩形的行号减去它）
+    uint32_t mcux;              // 每行 MCU 数（普通 JPEG）
+    bool fresh;                 // jd 刚准备好，停在第一个 MCU 之前
+    bool failed;
+    uint16_t frames;            // SJPG 分片数，0 表示普通 JPEG
+    uint32_t *frame_off;        // 每个分片的起始偏移，末尾多一项为数据结束位置
+    lv_img_src_t src_type;      // 以下用于判断再次打开的是不是同一张图
+    const void *src;
+    const uint8_t *src_data;
+    char *path;
+} sjpg_band_t;
+
+// LV_IMG_CACHE_DEF_SIZE 为 0 时 LVGL 每画完一块区域就关闭解码器；
+// 关闭的会话留在这里，下一块区域接着从当前条带往下解码，而不是从头开始
+static sjpg_band_t *s_parked;
+
+static bool sjpg_band_io_open(sjpg_band_io_t *io, lv_img_src_t type, const void *src)
+{
+    memset(io, 0, sizeof(*io));
+    if (type == LV_IMG_SRC_VARIABLE) {
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+        io->data = img->data;
+        io->size = io->end = img->data_size;
+        return io->data != NULL;
+    }
+    if (lv_fs_open(&io->file, (const char *)src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        return false;
+    }
+    if (lv_fs_seek(&io->file, 0, LV_FS_SEEK_END) != LV_FS_RES_OK ||
+        lv_fs_tell(&io->file, &io->size) != LV_FS_RES_OK ||
+        lv_fs_seek(&io->file, 0, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return false;
+    }
+    io->end = io->size;
+    return true;
+}
+
+static void sjpg_band_io_close(sjpg_band_io_t *io)
+{
+    if (!io->data && io->file.drv) {
+        lv_fs_close(&io->file);
+    }
+}
+
+/**
+ * @brief 把读取位置移到 [start, end)
+ */
+static bool sjpg_band_io_range(sjpg_band_io_t *io, uint32_t start, uint32_t end)
+{
+    io->pos = start;
+    io->end = end;
+    return io->data || lv_fs_seek(&io->file, start, LV_FS_SEEK_SET) == LV_FS_RES_OK;
+}
+
+/**
+ * @brief 读取（buf 为 NULL 时跳过）最多 n 个字节，不越过当前范围
+ */
+static size_t sjpg_band_io_read(sjpg_band_io_t *io, uint8_t *buf, size_t n)
+{
+    if (n > io->end - io->pos) {
+        n = io->end - io->pos;
+    }
+    if (io->data) {
+        if (buf) {
+            memcpy(buf, io->data + io->pos, n);
+        }
+    } else if (buf) {
+        uint32_t rn = 0;
+        if (lv_fs_read(&io->file, buf, n, &rn) != LV_FS_RES_OK) {
+            return 0;
+        }
+        n = rn;
+    } else if (lv_fs_seek(&io->file, io->pos + n, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return 0;
+    }
+    io->pos += n;
+    return n;
+}
+
+static size_t sjpg_band_in_cb(JDEC *jd, uint8_t *buff, size_t nbyte)
+{
+    sjpg_band_t *ctx = (sjpg_band_t *)jd->device;
+    return sjpg_band_io_read(&ctx->io, buff, nbyte);
+}
+
+static int sjpg_band_out_cb(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    sjpg_band_t *ctx = (sjpg_band_t *)jd->device;
+    if (rect->bottom - ctx->out_top >= ctx->band_h || rect->right >= ctx->width) {
+        return 0;  // SJPG 分片比头里写的大
+    }
+
+    const size_t w = rect->right - rect->left + 1;
+    lv_color_t *dst = ctx->band + (size_t)(rect->top - ctx->out_top) * ctx->width + rect->left;
+#if LV_COLOR_DEPTH == 16
+    const lv_color_t *in = (const lv_color_t *)bitmap;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        memcpy(dst, in, w * sizeof(lv_color_t));
+        in += w;
+        dst += ctx->width;
+    }
+#else
+    const uint8_t *in = (const uint8_t *)bitmap;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        for (size_t x = 0; x < w; x++, in += 3) {
+            dst[x] = lv_color_make(in[0], in[1], in[2]);
+        }
+        dst += ctx->width;
+    }
+#endif
+    return 1;
+}
+
+/**
+ * @brief 从 io 的当前范围开始准备一个 JPEG
+ */
+static JRESULT sjpg_band_prepare(sjpg_band_t *ctx)
+{
+    JRESULT rc = jdec_prepare(&ctx->jd, sjpg_band_in_cb, ctx->pool, JDEC_WORK_POOL, ctx);
+    ctx->jd.format = SJPG_BAND_FORMAT;
+    return rc;
+}
+
+static void sjpg_band_release(sjpg_band_t *ctx)
+{
+    sjpg_band_io_close(&ctx->io);
+    free(ctx->pool);
+    free(ctx->band);
+    free(ctx->frame_off);
+    free(ctx->path);
+}
+
+static void sjpg_band_free(sjpg_band_t *ctx)
+{
+    if (ctx) {
+        sjpg_band_release(ctx);
+        free(ctx);
+    }
+}
+
+/**
+ * @brief 读取图片头；header_only 为 false 时同时分配条带
+ */
+static lv_res_t sjpg_band_load(sjpg_band_t *ctx, lv_img_src_t type, const void *src, bool header_only)
+{
+    uint8_t head[SJPG_BAND_HEADER_SIZE];
+
+    ctx->band_top = -1;
+    if (!sjpg_band_io_open(&ctx->io, type, src)) {
+        return LV_RES_INV;
+    }
+    size_t n = sjpg_band_io_read(&ctx->io, head, sizeof(head));
+    bool split = n == sizeof(head) && memcmp(head, SJPG_BAND_MAGIC, sizeof(SJPG_BAND_MAGIC)) == 0;
+    if (!split && (n < 3 || head[0] != 0xFF || head[1] != 0xD8 || head[2] != 0xFF)) {
+        return LV_RES_INV;
+    }
+    if (!split || !header_only) {
+        ctx->pool = malloc(JDEC_WORK_POOL);
+        if (!ctx->pool) {
+            return LV_RES_INV;
+        }
+    }
+
+    if (split) {
+        ctx->width = head[14] | head[15] << 8;
+        ctx->height = head[16] | head[17] << 8;
+        ctx->frames = head[18] | head[19] << 8;
+        ctx->band_h = head[20] | head[21] << 8;
+        if (!ctx->frames || !ctx->band_h || (uint32_t)ctx->frames * ctx->band_h < ctx->height) {
+            return LV_RES_INV;
+        }
+    } else {
+        sjpg_band_io_range(&ctx->io, 0, ctx->io.size);
+        JRESULT rc = sjpg_band_prepare(ctx);
+        if (rc != JDR_OK || ctx->jd.progressive) {
+            ESP_LOGD(TAG, "Leaving JPEG to other decoders (rc=%d, progressive=%d)", rc, ctx->jd.progressive);
+            return LV_RES_INV;
+        }
+        ctx->width = ctx->jd.width;
+        ctx->height = ctx->jd.height;
+        ctx->band_h = ctx->jd.msy * 8;
+        ctx->mcux = (ctx->width + ctx->jd.msx * 8 - 1) / (ctx->jd.msx * 8);
+        ctx->fresh = true;
+    }
+    if (!ctx->width || !ctx->height || ctx->width > SJPG_BAND_MAX_SIZE || ctx->height > SJPG_BAND_MAX_SIZE) {
+        return LV_RES_INV;
+    }
+    if (header_only) {
+        return LV_RES_OK;
+    }
+
+    if (split) {
+        // 分片长度表紧跟在头后面，换算成每个分片的起始偏移
+        ctx->frame_off = malloc((ctx->frames + 1) * sizeof(uint32_t));
+        if (!ctx->frame_off) {
+            return LV_RES_INV;
+        }
+        uint32_t off = SJPG_BAND_HEADER_SIZE + ctx->frames * 2;
+        for (int i = 0; i < ctx->frames; i++) {
+            uint8_t len[2];
+            if (sjpg_band_io_read(&ctx->io, len, 2) != 2) {
+                return LV_RES_INV;
+            }
+            ctx->frame_off[i] = off;
+            off += len[0] | len[1] << 8;
+        }
+        ctx->frame_off[ctx->frames] = off;
+        if (off > ctx->io.size) {
+            return LV_RES_INV;
+        }
+    }
+
+    ctx->band = malloc((size_t)ctx->width * ctx->band_h * sizeof(lv_color_t));
+    if (!ctx->band) {
+        ESP_LOGW(TAG, "No memory for a %ux%u band", ctx->width, ctx->band_h);
+        return LV_RES_INV;
+    }
+    return LV_RES_OK;
+}
+
+/**
+ * @brief 解码包含第 y 行的条带
+ *
+ * SJPG 的分片各自独立，直接解码对应分片；普通 JPEG 只能顺序解码，
+ * 往下的行从当前位置继续，往回的行从头重新解码
+ */
+static lv_res_t sjpg_band_fill(sjpg_band_t *ctx, lv_coord_t y)
+{
+    const uint32_t row = y / ctx->band_h;
+    JRESULT rc;
+
+    if (ctx->frames) {
+        ctx->band_top = -1;
+        if (row >= ctx->frames || !sjpg_band_io_range(&ctx->io, ctx->frame_off[row], ctx->frame_off[row + 1])) {
+            return LV_RES_INV;
+        }
+        rc = sjpg_band_prepare(ctx);
+        if (rc == JDR_OK && (ctx->jd.width != ctx->width || ctx->jd.height > ctx->band_h)) {
+            rc = JDR_FMT1;
+        }
+        if (rc == JDR_OK) {
+            ctx->out_top = 0;
+            rc = jdec_decomp(&ctx->jd, sjpg_band_out_cb, 0);
+        }
+        if (rc != JDR_OK) {
+            ESP_LOGW(TAG, "SJPG fragment %u failed: %d", (unsigned)row, rc);
+            return LV_RES_INV;
+        }
+        ctx->band_top = row * ctx->band_h;
+        return LV_RES_OK;
+    }
+
+    uint32_t next = ctx->band_top < 0 ? 0 : ctx->band_top / ctx->band_h + 1;
+    if (next == 0 || row < next) {
+        ctx->band_top = -1;
+        if (!ctx->fresh) {
+            if (!sjpg_band_io_range(&ctx->io, 0, ctx->io.size)) {
+                return LV_RES_INV;
+            }
+            rc = sjpg_band_prepare(ctx);
+            if (rc != JDR_OK) {
+                return LV_RES_INV;
+            }
+        }
+        ctx->fresh = false;
+        ctx->out_top = 0;
+        rc = jdec_decomp_range(&ctx->jd, sjpg_band_out_cb, 0, 0, ctx->mcux);
+        if (rc != JDR_OK) {
+            ESP_LOGW(TAG, "JPEG decode failed at row 0: %d", rc);
+            return LV_RES_INV;
+        }
+        next = 1;
+    }
+    for (; next <= row; next++) {
+        ctx->band_top = -1;
+        ctx->out_top = next * ctx->band_h;
+        rc = jdec_decomp_resume(&ctx->jd, sjpg_band_out_cb, ctx->mcux);
+        if (rc != JDR_OK) {
+            ESP_LOGW(TAG, "JPEG decode failed at row %u: %d", ctx->out_top, rc);
+            return LV_RES_INV;
+        }
+    }
+    ctx->band_top = row * ctx->band_h;
+    return LV_RES_OK;
+}
+
+static bool sjpg_band_match(const sjpg_band_t *ctx, lv_img_src_t type, const void *src)
+{
+    if (!ctx || ctx->src_type != type) {
+        return false;
+    }
+    if (type == LV_IMG_SRC_FILE) {
+        return strcmp(ctx->path, (const char *)src) == 0;
+    }
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+    return ctx->src == src && ctx->src_data == img->data && ctx->io.size == img->data_size;
+}
+
+static lv_res_t sjpg_band_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    LV_UNUSED(decoder);
+
+    lv_img_src_t type = lv_img_src_get_type(src);
+    if (type == LV_IMG_SRC_FILE) {
+        const char *ext = lv_fs_get_ext((const char *)src);
+        if (strcmp(ext, "jpg") != 0 && strcmp(ext, "jpeg") != 0 && strcmp(ext, "sjpg") != 0) {
+            return LV_RES_INV;
+        }
+    } else if (type == LV_IMG_SRC_VARIABLE) {
+        // 已知格式的像素数组交给内置解码器
+        const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+        if (img->header.cf != LV_IMG_CF_UNKNOWN && img->header.cf != LV_IMG_CF_RAW) {
+            return LV_RES_INV;
+        }
+    } else {
+        return LV_RES_INV;
+    }
+
+    sjpg_band_t probe;
+    const sjpg_band_t *ctx = &probe;
+    lv_res_t res = LV_RES_OK;
+    if (sjpg_band_match(s_parked, type, src)) {
+        ctx = s_parked;
+    } else {
+        memset(&probe, 0, sizeof(probe));
+        res = sjpg_band_load(&probe, type, src, true);
+    }
+    if (res == LV_RES_OK) {
+        header->always_zero = 0;
+        header->cf = LV_IMG_CF_RAW;
+        header->w = ctx->width;
+        header->h = ctx->height;
+    }
+    if (ctx == &probe) {
+        sjpg_band_release(&probe);
+    }
+    return res;
+}
+
+static lv_res_t sjpg_band_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    sjpg_band_t *ctx;
+    if (sjpg_band_match(s_parked, dsc->src_type, dsc->src)) {
+        ctx = s_parked;
+        s_parked = NULL;
+    } else {
+        // 一次只保留一个会话，先释放别的图片留下的
+        sjpg_band_free(s_parked);
+        s_parked = NULL;
+
+        ctx = calloc(1, sizeof(*ctx));
+        if (!ctx) {
+            return LV_RES_INV;
+        }
+        ctx->src_type = dsc->src_type;
+        ctx->src = dsc->src;
+        if (dsc->src_type == LV_IMG_SRC_FILE) {
+            ctx->path = strdup((const char *)dsc->src);
+        } else {
+            ctx->src_data = ((const lv_img_dsc_t *)dsc->src)->data;
+        }
+        if ((dsc->src_type == LV_IMG_SRC_FILE && !ctx->path) ||
+            sjpg_band_load(ctx, dsc->src_type, dsc->src, false) != LV_RES_OK) {
+            sjpg_band_free(ctx);
+            return LV_RES_INV;
+        }
+    }
+
+    dsc->img_data = NULL;  // 只能逐行读取
+    dsc->user_data = ctx;
+    return LV_RES_OK;
+}
+
+static lv_res_t sjpg_band_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc,
+                                    lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    LV_UNUSED(decoder);
+
+    sjpg_band_t *ctx = (sjpg_band_t *)dsc->user_data;
+    if (ctx->band_top < 0 || y < ctx->band_top || y >= ctx->band_top + ctx->band_h) {
+        if (sjpg_band_fill(ctx, y) != LV_RES_OK) {
+            ctx->failed = true;
+            return LV_RES_INV;
+        }
+    }
+    memcpy(buf, ctx->band + (size_t)(y - ctx->band_top) * ctx->width + x, len * sizeof(lv_color_t));
+    return LV_RES_OK;
+}
+
+static void sjpg_band_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+
+    sjpg_band_t *ctx = (sjpg_band_t *)dsc->user_data;
+    dsc->user_data = NULL;
+    if (!ctx) {
+        return;
+    }
+    if (ctx->failed) {
+        sjpg_band_free(ctx);
+        return;
+    }
+    sjpg_band_free(s_parked);
+    s_parked = ctx;
+}
+
+esp_err_t sjpg_band_init(void)
+{
+    // 新建的解码器排在链表最前，比 lv_sjpg 先被尝试
+    lv_img_decoder_t *dec = lv_img_decoder_create();
+    if (!dec) {
+        return ESP_ERR_NO_MEM;
+    }
+    lv_img_decoder_set_info_cb(dec, sjpg_band_info);
+    lv_img_decoder_set_open_cb(dec, sjpg_band_open);
+    lv_img_decoder_set_read_line_cb(dec, sjpg_band_read_line);
+    lv_img_decoder_set_close_cb(dec, sjpg_band_close);
+    return ESP_OK;
+}
+
+void sjpg_band_invalidate(const void *src)
+{
+    if (s_parked && (!src || s_parked->src == src ||
+                     (s_parked->path && s_parked->src_type == LV_IMG_SRC_FILE && strcmp(s_parked->path, src) == 0))) {
+        sjpg_band_free(s_parked);
+        s_parked = NULL;
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * Banded JPEG / SJPG image decoder for LVGL
+ * Replaces lv_sjpg's whole-frame RGB888 cache with a rolling band in lv_color_t
+ */
+
+#ifndef SJPG_BAND_H
+#define SJPG_BAND_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the decoder ahead of lv_sjpg (call with the display lock held)
+ *
+ * JPEG and SJPG sources (C arrays and .jpg/.jpeg/.sjpg files) are decoded one
+ * MCU row or one SJPG fragment at a time, as LVGL asks for lines. Progressive
+ * JPEGs are left to the other decoders.
+ */
+esp_err_t sjpg_band_init(void);
+
+/**
+ * @brief Drop the decode position kept for src after its data changed
+ * @param src Image source passed to lv_img_set_src(), NULL for all sources
+ */
+void sjpg_band_invalidate(const void *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SJPG_BAND_H
@@ -0,0 +1,267 @@
+/*
+ * URL image cache on SPIFFS
+ * Keeps the decoded RGB565 image and the ETag/Last-Modified validators of
+ * recently downloaded URLs, so an unchanged image is not downloaded or
+ * decoded again
+ */
+
+#include "url_cache.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_spiffs.h"
+#include "mbedtls/sha256.h"
+#include "sdkconfig.h"
+#include <dirent.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "url_cache";
+
+#define URL_CACHE_BASE_PATH     "/spiffs"
+// 像素与 lv_color_t 的字节序相同，修改 LV_COLOR_16_SWAP 后旧文件按无效文件删除
+#if CONFIG_LV_COLOR_16_SWAP
+#define URL_CACHE_MAGIC         0x474d4955  // "UIMG"
+#else
+#define URL_CACHE_MAGIC         0x4c4d4955  // "UIML"
+#endif
+#define URL_CACHE_MAX_FILES     16
+#define URL_CACHE_IO_CHUNK      4096
+#define URL_CACHE_MAX_BYTES     ((size_t)CONFIG_DISPLAY_URL_CACHE_SIZE_KB * 1024)
+
+/**
+ * @brief File header, followed by size bytes of RGB565 pixels
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t last_used;                     // LRU stamp, rewritten on hits
+    uint8_t url_hash[32];                   // SHA-256 of the URL
+    url_cache_meta_t meta;
+    uint16_t width;
+    uint16_t height;
+    uint32_t size;
+} url_cache_hdr_t;
+
+typedef struct {
+    uint8_t url_hash[32];
+    url_cache_meta_t meta;
+    uint32_t file_size;                     // Header + pixels
+    uint32_t last_used;                     // 0 = free slot
+} url_cache_entry_t;
+
+static url_cache_entry_t s_entries[URL_CACHE_MAX_FILES];
+static uint32_t s_clock = 0;
+static bool s_mounted = false;
+
+static void url_cache_path(const uint8_t url_hash[32], char path[32]) {
+    // SPIFFS 文件名最长 CONFIG_SPIFFS_OBJ_NAME_LEN，只用哈希前 8 字节
+    snprintf(path, 32, URL_CACHE_BASE_PATH "/u_%02x%02x%02x%02x%02x%02x%02x%02x.img",
+             url_hash[0], url_hash[1], url_hash[2], url_hash[3],
+             url_hash[4], url_hash[5], url_hash[6], url_hash[7]);
+}
+
+static url_cache_entry_t *url_cache_find(const char *url) {
+    uint8_t url_hash[32];
+    mbedtls_sha256((const uint8_t *)url, strlen(url), url_hash, 0);
+    for (int i = 0; i < URL_CACHE_MAX_FILES; i++) {
+        url_cache_entry_t *e = &s_entries[i];
+        if (e->last_used && memcmp(e->url_hash, url_hash, sizeof(url_hash)) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void url_cache_drop(url_cache_entry_t *e) {
+    char path[32];
+    url_cache_path(e->url_hash, path);
+    unlink(path);
+    memset(e, 0, sizeof(*e));
+}
+
+static size_t url_cache_used_bytes(void) {
+    size_t used = 0;
+    for (int i = 0; i < URL_CACHE_MAX_FILES; i++) {
+        if (s_entries[i].last_used) {
+            used += s_entries[i].file_size;
+        }
+    }
+    return used;
+}
+
+esp_err_t url_cache_init(void) {
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = URL_CACHE_BASE_PATH,
+        .partition_label = NULL,
+        .max_files = 4,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount SPIFFS: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_mounted = true;
+
+    DIR *dir = opendir(URL_CACHE_BASE_PATH);
+    if (dir == NULL) {
+        return ESP_OK;
+    }
+    struct dirent *ent;
+    int count = 0;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "u_", 2) != 0) continue;  // 其它文件（例如 mengm.jpg）不属于缓存
+
+        char path[300];
+        snprintf(path, sizeof(path), URL_CACHE_BASE_PATH "/%s", ent->d_name);
+        url_cache_hdr_t hdr;
+        FILE *f = fopen(path, "rb");
+        bool valid = f && fread(&hdr, 1, sizeof(hdr), f) == sizeof(hdr) && hdr.magic == URL_CACHE_MAGIC;
+        if (f) fclose(f);
+        if (!valid || count == URL_CACHE_MAX_FILES) {
+            ESP_LOGW(TAG, "Removing stale cache file %s", ent->d_name);
+            unlink(path);
+            continue;
+        }
+
+        url_cache_entry_t *e = &s_entries[count++];
+        memcpy(e->url_hash, hdr.url_hash, sizeof(e->url_hash));
+        e->meta = hdr.meta;
+        e->file_size = sizeof(hdr) + hdr.size;
+        e->last_used = hdr.last_used ? hdr.last_used : 1;
+        if (e->last_used > s_clock) {
+            s_clock = e->last_used;
+        }
+    }
+    closedir(dir);
+
+    ESP_LOGI(TAG, "%d cached images, %zu bytes", count, url_cache_used_bytes());
+    return ESP_OK;
+}
+
+bool url_cache_lookup(const char *url, url_cache_meta_t *meta) {
+    url_cache_entry_t *e = s_mounted ? url_cache_find(url) : NULL;
+    if (e == NULL) return false;
+    *meta = e->meta;
+    return true;
+}
+
+image_buf_t *url_cache_load(const char *url) {
+    url_cache_entry_t *e = s_mounted ? url_cache_find(url) : NULL;
+    if (e == NULL) return NULL;
+
+    char path[32];
+    url_cache_path(e->url_hash, path);
+    FILE *f = fopen(path, "r+b");
+    url_cache_hdr_t hdr;
+    uint8_t *pixels = NULL;
+    if (f == NULL || fread(&hdr, 1, sizeof(hdr), f) != sizeof(hdr) || hdr.magic != URL_CACHE_MAGIC ||
+        hdr.size != (uint32_t)hdr.width * hdr.height * 2) {
+        goto err;
+    }
+    pixels = heap_caps_malloc(hdr.size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (pixels == NULL || fread(pixels, 1, hdr.size, f) != hdr.size) {
+        goto err;
+    }
+
+    // 更新 LRU 时间戳（只改写文件头中的 4 字节）
+    e->last_used = ++s_clock;
+    fseek(f, offsetof(url_cache_hdr_t, last_used), SEEK_SET);
+    fwrite(&e->last_used, 1, sizeof(e->last_used), f);
+    fclose(f);
+
+    ESP_LOGI(TAG, "Loaded %ux%u image from %s", hdr.width, hdr.height, path);
+    return image_buf_create(pixels, hdr.size, LV_IMG_CF_TRUE_COLOR, hdr.width, hdr.height);
+
+err:
+    ESP_LOGE(TAG, "Failed to read %s, dropping it", path);
+    if (f) fclose(f);
+    heap_caps_free(pixels);
+    url_cache_drop(e);
+    return NULL;
+}
+
+esp_err_t url_cache_store(const char *url, const url_cache_meta_t *meta, const image_buf_t *buf) {
+    if (!s_mounted || buf->cf != LV_IMG_CF_TRUE_COLOR) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    url_cache_hdr_t hdr = {
+        .magic = URL_CACHE_MAGIC,
+        .meta = *meta,
+        .width = buf->width,
+        .height = buf->height,
+        .size = buf->size,
+    };
+    size_t file_size = sizeof(hdr) + buf->size;
+    if (file_size > URL_CACHE_MAX_BYTES) {
+        ESP_LOGW(TAG, "%zu byte image does not fit the cache", file_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    mbedtls_sha256((const uint8_t *)url, strlen(url), hdr.url_hash, 0);
+
+    url_cache_entry_t *e = url_cache_find(url);
+    if (e) {
+        url_cache_drop(e);
+    }
+
+    // 按 LRU 淘汰，直到总大小和文件数都在限制内，并且分区有足够空间
+    while (true) {
+        size_t total = 0, used = 0;
+        esp_spiffs_info(NULL, &total, &used);
+        url_cache_entry_t *lru = NULL, *free_slot = NULL;
+        for (int i = 0; i < URL_CACHE_MAX_FILES; i++) {
+            url_cache_entry_t *c = &s_entries[i];
+            if (!c->last_used) {
+                free_slot = free_slot ? free_slot : c;
+            } else if (!lru || c->last_used < lru->last_used) {
+                lru = c;
+            }
+        }
+        if (free_slot && url_cache_used_bytes() + file_size <= URL_CACHE_MAX_BYTES && used + file_size <= total) {
+            e = free_slot;
+            break;
+        }
+        if (lru == NULL) {
+            ESP_LOGW(TAG, "Not enough SPIFFS space for %zu bytes", file_size);
+            return ESP_ERR_NO_MEM;
+        }
+        ESP_LOGI(TAG, "Evicting cached image (%" PRIu32 " bytes)", lru->file_size);
+        url_cache_drop(lru);
+    }
+
+    hdr.last_used = ++s_clock;
+    char path[32];
+    url_cache_path(hdr.url_hash, path);
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    for (size_t off = 0; ok && off < buf->size; off += URL_CACHE_IO_CHUNK) {
+        size_t n = buf->size - off < URL_CACHE_IO_CHUNK ? buf->size - off : URL_CACHE_IO_CHUNK;
+        ok = fwrite(buf->data + off, 1, n, f) == n;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        unlink(path);
+        return ESP_FAIL;
+    }
+
+    memcpy(e->url_hash, hdr.url_hash, sizeof(e->url_hash));
+    e->meta = *meta;
+    e->file_size = file_size;
+    e->last_used = hdr.last_used;
+    ESP_LOGI(TAG, "Cached %ux%u image as %s", buf->width, buf->height, path);
+    return ESP_OK;
+}
+
+void url_cache_remove(const char *url) {
+    url_cache_entry_t *e = s_mounted ? url_cache_find(url) : NULL;
+    if (e) {
+        url_cache_drop(e);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * URL image cache on SPIFFS
+ * Keeps the decoded RGB565 image and the ETag/Last-Modified validators of
+ * recently downloaded URLs, so an unchanged image is not downloaded or
+ * decoded again
+ * Not thread safe: only the download task uses it
+ */
+
+#ifndef URL_CACHE_H
+#define URL_CACHE_H
+
+#include "esp_err.h"
+#include "image_buf.h"
+#include "image_cache.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define URL_CACHE_ETAG_MAX  64
+#define URL_CACHE_DATE_MAX  32
+
+/**
+ * @brief Validators and content hash of a cached URL
+ */
+typedef struct {
+    char etag[URL_CACHE_ETAG_MAX];              // ETag response header ("" if none)
+    char last_modified[URL_CACHE_DATE_MAX];     // Last-Modified response header ("" if none)
+    uint8_t hash[IMAGE_CACHE_KEY_LEN];          // image_cache key of the encoded image
+} url_cache_meta_t;
+
+/**
+ * @brief Mount the SPIFFS partition and index the cached images on it
+ */
+esp_err_t url_cache_init(void);
+
+/**
+ * @brief Find the validators of a cached URL
+ * @return true if url is cached
+ */
+bool url_cache_lookup(const char *url, url_cache_meta_t *meta);
+
+/**
+ * @brief Read the cached image of url into a new PSRAM image buffer
+ * @return New reference or NULL (the entry is dropped if it is unreadable)
+ */
+image_buf_t *url_cache_load(const char *url);
+
+/**
+ * @brief Store a decoded image, evicting least recently used URLs to stay
+ *        within CONFIG_DISPLAY_URL_CACHE_SIZE_KB
+ */
+esp_err_t url_cache_store(const char *url, const url_cache_meta_t *meta, const image_buf_t *buf);
+
+/**
+ * @brief Drop url from the cache
+ */
+void url_cache_remove(const char *url);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // URL_CACHE_H
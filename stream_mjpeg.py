@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Play a Motion-JPEG stream on the device through POST /stream
+Usage: python stream_mjpeg.py <device_ip> [images...] [--fps N] [--loop N] [--format multipart|length]
+       python stream_mjpeg.py <device_ip> --synthetic [--frames N]
+       ffmpeg -i clip.mp4 -vf scale=320:240 -q:v 5 -f mpjpeg - | python stream_mjpeg.py <device_ip> --stdin
+Example: python stream_mjpeg.py 192.168.1.100 mengm.jpg mengm2.jpg rs2026.jpg --fps 25 --loop 20
+
+The device splits the request body into frames (multipart parts with a
+Content-Length header, or a 4-byte big-endian length before each frame),
+decodes them into two alternating framebuffers and drops frames it cannot
+keep up with. The body is sent with a large Content-Length (esp_http_server
+does not accept chunked requests) and ends with the closing boundary or a
+zero length, after which the sending side of the socket is closed.
+
+Images are scaled to fit 320x240 and re-encoded with Pillow. --synthetic
+draws moving test frames instead. --save writes the stream to a file, which
+host/build/mjpeg_bench can replay. --status polls /status while streaming.
+"""
+
+import io
+import sys
+import time
+import socket
+import struct
+import argparse
+import threading
+import requests
+
+BOUNDARY = 'frame'
+# Upper bound sent as Content-Length; the stream ends with its own terminator
+STREAM_CONTENT_LENGTH = 0x7FFFFFFF
+SCREEN = (320, 240)
+
+def encode_jpeg(img, quality, restart_rows):
+    out = io.BytesIO()
+    options = {'quality': quality}
+    if restart_rows:
+        # Restart markers let the device decode one frame on both cores
+        options['restart_marker_rows'] = restart_rows
+    img.convert('RGB').save(out, 'JPEG', **options)
+    return out.getvalue()
+
+def image_frames(paths, quality, restart_rows):
+    from PIL import Image
+    frames = []
+    for path in paths:
+        img = Image.open(path)
+        img.thumbnail(SCREEN)
+        frames.append(encode_jpeg(img, quality, restart_rows))
+    return frames
+
+def synthetic_frames(count, quality, restart_rows):
+    """A box moving over a gradient, with the frame number"""
+    from PIL import Image, ImageDraw
+    frames = []
+    w, h = SCREEN
+    for i in range(count):
+        img = Image.new('RGB', SCREEN)
+        draw = ImageDraw.Draw(img)
+        for y in range(0, h, 8):
+            draw.rectangle([0, y, w, y + 7], fill=(y * 255 // h, (i * 4) % 256, 255 - y * 255 // h))
+        x = (i * 6) % (w - 60)
+        draw.rectangle([x, h // 2 - 30, x + 60, h // 2 + 30], fill=(255, 255, 255))
+        draw.text((8, 8), f"frame {i}", fill=(255, 255, 255))
+        frames.append(encode_jpeg(img, quality, restart_rows))
+    return frames
+
+def stdin_chunks():
+    """Forward stdin as it is (already an MJPEG stream, e.g. ffmpeg -f mpjpeg)"""
+    while True:
+        chunk = sys.stdin.buffer.read(16384)
+        if not chunk:
+            return
+        yield chunk
+
+def wrap(frames, fmt, fps):
+    """Yield the stream bytes frame by frame, paced to fps (0 = as fast as possible)"""
+    start = time.monotonic()
+    for i, frame in enumerate(frames):
+        if fps:
+            delay = start + i / fps - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        if fmt == 'length':
+            yield struct.pack('>I', len(frame)) + frame
+        else:
+            yield (f"--{BOUNDARY}\r\nContent-Type: image/jpeg\r\n"
+                   f"Content-Length: {len(frame)}\r\n\r\n").encode() + frame + b"\r\n"
+    yield b"\0\0\0\0" if fmt == 'length' else f"--{BOUNDARY}--\r\n".encode()
+
+def stream(device_ip, chunks, save=None):
+    """Send the stream and return the device's reply"""
+    sock = socket.create_connection((device_ip, 80), timeout=30)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    sock.sendall((f"POST /stream HTTP/1.1\r\nHost: {device_ip}\r\n"
+                  f"Content-Type: multipart/x-mixed-replace; boundary={BOUNDARY}\r\n"
+                  f"Content-Length: {STREAM_CONTENT_LENGTH}\r\n\r\n").encode())
+    sent = 0
+    try:
+        for chunk in chunks:
+            sock.sendall(chunk)
+            sent += len(chunk)
+            if save:
+                save.write(chunk)
+        sock.shutdown(socket.SHUT_WR)
+        reply = b''
+        while True:
+            data = sock.recv(4096)
+            if not data:
+                break
+            reply += data
+    finally:
+        sock.close()
+    head, _, body = reply.partition(b"\r\n\r\n")
+    status = head.split(b"\r\n", 1)[0].decode(errors='replace')
+    return sent, status, body.decode(errors='replace')
+
+def poll_status(device_ip, stop):
+    while not stop.wait(1.0):
+        try:
+            s = requests.get(f"http://{device_ip}/status", timeout=2).json()
+        except requests.exceptions.RequestException:
+            continue
+        if s.get('stream_active'):
+            print(f"  {s['stream_fps']:5.1f} fps  decode {s['stream_decode_ms']:5.1f}ms  "
+                  f"blit {s['stream_blit_ms']:5.1f}ms  shown {s['stream_frames']}  dropped {s['stream_dropped']}")
+
+def main():
+    parser = argparse.ArgumentParser(description='Play an MJPEG stream on the device')
+    parser.add_argument('device_ip', help='Device IP address')
+    parser.add_argument('images', nargs='*', help='Frames (any format Pillow reads)')
+    parser.add_argument('--synthetic', action='store_true', help='Send generated test frames')
+    parser.add_argument('--stdin', action='store_true', help='Forward an MJPEG stream from stdin')
+    parser.add_argument('--frames', type=int, default=300, help='Synthetic frame count (default: 300)')
+    parser.add_argument('--loop', type=int, default=1, help='Repeat the images N times (default: 1)')
+    parser.add_argument('--fps', type=float, default=0, help='Frame rate, 0 = as fast as possible (default: 0)')
+    parser.add_argument('--format', choices=['multipart', 'length'], default='multipart',
+                        help='Container (default: multipart)')
+    parser.add_argument('--quality', type=int, default=80, help='JPEG quality (default: 80)')
+    parser.add_argument('--restart-rows', type=int, default=0,
+                        help='Restart marker every N MCU rows, 0 = none (default: 0)')
+    parser.add_argument('--save', metavar='FILE', help='Also write the stream to FILE')
+    parser.add_argument('--status', action='store_true', help='Print /status stream counters every second')
+    args = parser.parse_args()
+
+    if args.stdin:
+        chunks = stdin_chunks()
+        count = None
+    else:
+        if args.synthetic:
+            frames = synthetic_frames(args.frames, args.quality, args.restart_rows)
+        elif args.images:
+            frames = image_frames(args.images, args.quality, args.restart_rows) * args.loop
+        else:
+            parser.error('give images, --synthetic or --stdin')
+        count = len(frames)
+        print(f"Streaming {count} frames, {sum(map(len, frames)) / count / 1024:.1f} KB on average")
+        chunks = wrap(frames, args.format, args.fps)
+
+    save = open(args.save, 'wb') if args.save else None
+    stop = threading.Event()
+    if args.status:
+        threading.Thread(target=poll_status, args=(args.device_ip, stop), daemon=True).start()
+    start = time.monotonic()
+    try:
+        sent, status, body = stream(args.device_ip, chunks, save)
+    except OSError as e:
+        print(f"✗ {e}")
+        return 1
+    finally:
+        stop.set()
+        if save:
+            save.close()
+    elapsed = time.monotonic() - start
+
+    rate = f", {count / elapsed:.1f} fps sent" if count else ""
+    print(f"Sent {sent / 1024:.0f} KB in {elapsed:.1f}s ({sent * 8 / elapsed / 1e6:.1f} Mbit/s{rate})")
+    print(f"{status}: {body}")
+    return 0 if ' 200 ' in status and body.startswith('OK') else 1
+
+if __name__ == '__main__':
+    sys.exit(main())
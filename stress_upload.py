@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Stress test: push images back-to-back to ESP32-S3-Box3 and check for leaks
+Usage: python stress_upload.py <device_ip> [--count N] [--max-bufs N] [images...]
+Example: python stress_upload.py 192.168.1.100 --count 100
+
+Every upload waits for the previous "OK" only, there is no delay between images.
+After the run the device must not have rebooted (a refcount underflow asserts),
+the number of live image buffers must be back to cache entries + the one on
+screen, and free heap must be back near the value after the warm-up round.
+"""
+
+import sys
+import time
+import argparse
+import requests
+
+DEFAULT_IMAGES = ['mengm.jpg', 'mengm2.jpg', 'rs2026.jpg', 'hss_320_240.jpg']
+
+def get_status(device_ip):
+    """Get device status as dict"""
+    response = requests.get(f"http://{device_ip}/status", timeout=5)
+    response.raise_for_status()
+    return response.json()
+
+def upload(session, device_ip, name, data):
+    """Upload one image, return True on success"""
+    files = {'image': (name, data, 'image/jpeg')}
+    response = session.post(f"http://{device_ip}/upload", files=files, timeout=30)
+    return response.status_code == 200 and response.text == 'OK'
+
+def main():
+    parser = argparse.ArgumentParser(description='Upload images back-to-back and check for leaks')
+    parser.add_argument('device_ip', help='Device IP address')
+    parser.add_argument('images', nargs='*', default=DEFAULT_IMAGES, help='Images to rotate through')
+    parser.add_argument('--count', type=int, default=100, help='Number of uploads (default: 100)')
+    parser.add_argument('--max-bufs', type=int, default=3,
+                        help='Allowed live image buffers when idle: cache entries + 1 (default: 3)')
+    parser.add_argument('--heap-slack', type=int, default=16 * 1024,
+                        help='Allowed free heap drop in bytes after warm-up (default: 16KB)')
+    args = parser.parse_args()
+
+    images = []
+    for path in args.images:
+        with open(path, 'rb') as f:
+            images.append((path, f.read()))
+
+    session = requests.Session()
+    try:
+        # 先把每张图片上传一次，让缓存和 LVGL 进入稳定状态
+        for name, data in images:
+            if not upload(session, args.device_ip, name, data):
+                print(f"✗ Warm-up upload of {name} failed")
+                return 1
+        time.sleep(1)
+        before = get_status(args.device_ip)
+        print(f"Before: {before}")
+
+        failed = 0
+        start = time.time()
+        for i in range(args.count):
+            name, data = images[i % len(images)]
+            if not upload(session, args.device_ip, name, data):
+                failed += 1
+                print(f"✗ Upload {i + 1}/{args.count} ({name}) failed")
+        elapsed = time.time() - start
+        print(f"{args.count} uploads in {elapsed:.1f}s ({args.count / elapsed:.1f} images/s), {failed} failed")
+
+        time.sleep(1)
+        after = get_status(args.device_ip)
+        print(f"After:  {after}")
+    except requests.exceptions.RequestException as e:
+        print(f"✗ Error talking to device: {e}")
+        return 1
+
+    ok = failed == 0
+    if after['uptime_ms'] < before['uptime_ms']:
+        print("✗ Device rebooted during the run")
+        ok = False
+    if after['image_bufs'] > args.max_bufs:
+        print(f"✗ {after['image_bufs']} image buffers alive, expected at most {args.max_bufs}")
+        ok = False
+    if after['images_shown'] - before['images_shown'] != args.count:
+        print(f"✗ {after['images_shown'] - before['images_shown']} images shown, expected {args.count}")
+        ok = False
+    heap_drop = before['free_heap'] - after['free_heap']
+    if heap_drop > args.heap_slack:
+        print(f"✗ Free heap dropped by {heap_drop} bytes")
+        ok = False
+
+    print("✓ No leaks detected" if ok else "✗ Stress test failed")
+    return 0 if ok else 1
+
+if __name__ == '__main__':
+    sys.exit(main())